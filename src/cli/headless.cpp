@@ -0,0 +1,636 @@
+#include "cli/headless.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cctype>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <set>
+
+#include "model/bounds.hpp"
+#include "model/model.hpp"
+#include "model/obj_writer.hpp"
+#include "model/parallel.hpp"
+#include "model/trace.hpp"
+
+namespace viewer3d {
+
+namespace {
+
+namespace fs = std::filesystem;
+
+// Warnings listed per file, in a validate result or on stderr; the rest are
+// only counted.
+constexpr std::size_t kMaxListedWarnings = 10;
+
+enum class Command { kStats, kTransform, kValidate };
+
+struct HeadlessOptions {
+    Command command{Command::kStats};
+    unsigned jobs{1};
+    LoadOptions load;
+    std::array<float, 3> translate{0.0f, 0.0f, 0.0f};
+    std::array<float, 3> rotate{0.0f, 0.0f, 0.0f};
+    float scale{1.0f};
+    std::string output;
+    std::string output_dir;
+    std::string trace_file;
+    std::vector<std::string> files;
+};
+
+void PrintUsage(std::ostream& out) {
+    out << "Usage: viewer --headless <command> [options] <file>...\n"
+        << "Prints one JSON object per file and line.\n\n"
+        << "Commands:\n"
+        << "  stats      vertex, face and edge counts, bounds and load time\n"
+        << "  transform  applies --translate, --rotate and --scale and "
+           "writes OBJ files\n"
+        << "  validate   reports malformed records and degenerate faces\n\n"
+        << "Options:\n"
+        << "  -j, --jobs <n>         files processed in parallel, 0 for one "
+           "per hardware thread\n"
+        << "  --files-from <list>    reads more input paths, one per line, "
+           "from <list> (- for stdin)\n"
+        << "  --cache-dir <dir>      reads and writes model caches in <dir>\n"
+        << "  --rebuild-cache        overwrites the caches in --cache-dir\n"
+        << "  --quantize             stores positions as 16 bits per axis and "
+           "reports the error\n"
+        << "  --translate <x,y,z>    translation (transform)\n"
+        << "  --rotate <x,y,z>       rotation in degrees (transform)\n"
+        << "  --scale <s>            uniform scale (transform)\n"
+        << "  -o, --output <file>    .obj output for a single input "
+           "(transform)\n"
+        << "  --output-dir <dir>     output directory, files are named after "
+           "the inputs with .obj (transform)\n"
+        << "  --trace <file>         writes a Chrome trace of the run\n";
+}
+
+// Transform always writes OBJ, whatever the input format.
+bool HasObjExtension(const fs::path& path) {
+    std::string extension = path.extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(),
+                   [](unsigned char c) { return std::tolower(c); });
+    return extension == ".obj";
+}
+
+std::string OutputName(const std::string& file) {
+    return fs::path(file).filename().replace_extension(".obj").string();
+}
+
+bool ParseFloats(const std::string& text, float* values, std::size_t count) {
+    const char* p = text.data();
+    const char* end = p + text.size();
+    for (std::size_t i = 0; i < count; ++i) {
+        if (i > 0) {
+            if (p == end || *p != ',') {
+                return false;
+            }
+            ++p;
+        }
+        const auto result = std::from_chars(p, end, values[i]);
+        if (result.ec != std::errc()) {
+            return false;
+        }
+        p = result.ptr;
+    }
+    return p == end;
+}
+
+bool ParseJobs(const std::string& text, unsigned& jobs) {
+    const auto result =
+        std::from_chars(text.data(), text.data() + text.size(), jobs);
+    return result.ec == std::errc() &&
+           result.ptr == text.data() + text.size();
+}
+
+bool ReadFileList(const std::string& list, std::vector<std::string>& files) {
+    std::ifstream file;
+    if (list != "-") {
+        file.open(list);
+        if (!file) {
+            return false;
+        }
+    }
+    std::istream& in = list == "-" ? std::cin : file;
+    std::string line;
+    while (std::getline(in, line)) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (!line.empty()) {
+            files.push_back(line);
+        }
+    }
+    return true;
+}
+
+bool ParseArguments(const std::vector<std::string>& args,
+                    HeadlessOptions& options, std::ostream& err) {
+    if (args.empty()) {
+        err << "Error: missing command" << std::endl;
+        return false;
+    }
+    if (args[0] == "stats") {
+        options.command = Command::kStats;
+    } else if (args[0] == "transform") {
+        options.command = Command::kTransform;
+    } else if (args[0] == "validate") {
+        options.command = Command::kValidate;
+    } else {
+        err << "Error: unknown command " << args[0] << std::endl;
+        return false;
+    }
+
+    bool use_cache = false;
+    bool rebuild_cache = false;
+    for (std::size_t i = 1; i < args.size(); ++i) {
+        const std::string& arg = args[i];
+        if (arg.empty() || arg[0] != '-') {
+            options.files.push_back(arg);
+            continue;
+        }
+        if (arg == "--rebuild-cache") {
+            rebuild_cache = true;
+            continue;
+        }
+        if (arg == "--quantize") {
+            options.load.storage = PositionStorage::kQuantized16;
+            continue;
+        }
+        if (i + 1 >= args.size()) {
+            err << "Error: " << arg << " needs a value" << std::endl;
+            return false;
+        }
+        const std::string& value = args[++i];
+        bool valid = true;
+        if (arg == "-j" || arg == "--jobs") {
+            valid = ParseJobs(value, options.jobs);
+        } else if (arg == "--files-from") {
+            valid = ReadFileList(value, options.files);
+        } else if (arg == "--cache-dir") {
+            use_cache = true;
+            options.load.cache_dir = value;
+        } else if (arg == "--translate") {
+            valid = ParseFloats(value, options.translate.data(), 3);
+        } else if (arg == "--rotate") {
+            valid = ParseFloats(value, options.rotate.data(), 3);
+        } else if (arg == "--scale") {
+            valid = ParseFloats(value, &options.scale, 1);
+        } else if (arg == "-o" || arg == "--output") {
+            options.output = value;
+        } else if (arg == "--output-dir") {
+            options.output_dir = value;
+        } else if (arg == "--trace") {
+            options.trace_file = value;
+        } else {
+            err << "Error: unknown option " << arg << std::endl;
+            return false;
+        }
+        if (!valid) {
+            err << "Error: invalid value for " << arg << ": " << value
+                << std::endl;
+            return false;
+        }
+    }
+
+    if (options.files.empty()) {
+        err << "Error: no input files" << std::endl;
+        return false;
+    }
+    if (rebuild_cache && !use_cache) {
+        err << "Error: --rebuild-cache needs --cache-dir" << std::endl;
+        return false;
+    }
+    // Validation has to see the text, so it never reads a cache.
+    if (use_cache && options.command != Command::kValidate) {
+        options.load.cache =
+            rebuild_cache ? CacheMode::kRebuild : CacheMode::kUse;
+    }
+
+    if (options.command == Command::kTransform) {
+        if (!options.output.empty() && options.files.size() != 1) {
+            err << "Error: --output takes a single input, use --output-dir"
+                << std::endl;
+            return false;
+        }
+        if (options.output.empty() && options.output_dir.empty()) {
+            err << "Error: transform needs --output or --output-dir"
+                << std::endl;
+            return false;
+        }
+        if (!options.output.empty() && !HasObjExtension(options.output)) {
+            err << "Error: --output must name an .obj file" << std::endl;
+            return false;
+        }
+        std::set<std::string> names;
+        for (const std::string& file : options.files) {
+            if (options.output.empty() &&
+                !names.insert(OutputName(file)).second) {
+                err << "Error: more than one input is written to "
+                    << OutputName(file) << std::endl;
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Builds one JSON object. Keys are literals and never need escaping.
+class JsonObject {
+   public:
+    JsonObject& String(const char* key, const std::string& value) {
+        Key(key);
+        AppendString(value);
+        return *this;
+    }
+
+    JsonObject& Bool(const char* key, bool value) {
+        Key(key);
+        text_ += value ? "true" : "false";
+        return *this;
+    }
+
+    JsonObject& Count(const char* key, std::uint64_t value) {
+        Key(key);
+        char buffer[24];
+        const auto result =
+            std::to_chars(buffer, buffer + sizeof(buffer), value);
+        text_.append(buffer, result.ptr);
+        return *this;
+    }
+
+    JsonObject& Milliseconds(const char* key, double value) {
+        Key(key);
+        char buffer[32];
+        const auto result = std::to_chars(buffer, buffer + sizeof(buffer),
+                                          value, std::chars_format::fixed, 3);
+        text_.append(buffer, result.ptr);
+        return *this;
+    }
+
+    JsonObject& Bounds(const char* key, const viewer3d::Bounds& bounds) {
+        Key(key);
+        if (bounds.empty()) {
+            text_ += "null";
+            return *this;
+        }
+        text_ += "{\"min\":";
+        AppendVertex(bounds.min);
+        text_ += ",\"max\":";
+        AppendVertex(bounds.max);
+        text_ += '}';
+        return *this;
+    }
+
+    JsonObject& Error(const char* key, const QuantizationError& error) {
+        Key(key);
+        text_ += "{\"max\":";
+        AppendFloat(error.max);
+        text_ += ",\"rms\":";
+        AppendFloat(error.rms);
+        text_ += ",\"bound\":";
+        AppendFloat(error.bound);
+        text_ += '}';
+        return *this;
+    }
+
+    JsonObject& Strings(const char* key, const std::vector<std::string>& list) {
+        Key(key);
+        text_ += '[';
+        for (std::size_t i = 0; i < list.size(); ++i) {
+            if (i > 0) {
+                text_ += ',';
+            }
+            AppendString(list[i]);
+        }
+        text_ += ']';
+        return *this;
+    }
+
+    std::string Finish() { return text_ + '}'; }
+
+   private:
+    void Key(const char* key) {
+        text_ += text_.size() > 1 ? ",\"" : "\"";
+        text_ += key;
+        text_ += "\":";
+    }
+
+    void AppendString(const std::string& value) {
+        text_ += '"';
+        for (const char c : value) {
+            if (c == '"' || c == '\\') {
+                text_ += '\\';
+                text_ += c;
+            } else if (static_cast<unsigned char>(c) < 0x20) {
+                char escaped[8];
+                std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                text_ += escaped;
+            } else {
+                text_ += c;
+            }
+        }
+        text_ += '"';
+    }
+
+    void AppendVertex(const Vertex& vertex) {
+        const float values[3] = {vertex.x, vertex.y, vertex.z};
+        text_ += '[';
+        for (int i = 0; i < 3; ++i) {
+            if (i > 0) {
+                text_ += ',';
+            }
+            AppendFloat(values[i]);
+        }
+        text_ += ']';
+    }
+
+    void AppendFloat(float value) {
+        char buffer[32];
+        const auto result =
+            std::to_chars(buffer, buffer + sizeof(buffer), value);
+        text_.append(buffer, result.ptr);
+    }
+
+    std::string text_{"{"};
+};
+
+// Prints results in input order as soon as all earlier ones are done, each
+// after the warnings of its file, so parallel files never mix their output.
+class OrderedPrinter {
+   public:
+    OrderedPrinter(std::ostream& out, std::ostream& err, std::size_t count)
+        : out_(out), err_(err), lines_(count), ready_(count, false) {}
+
+    void Print(std::size_t index, std::string line, std::string warnings) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        lines_[index] = {std::move(line), std::move(warnings)};
+        ready_[index] = true;
+        while (next_ < lines_.size() && ready_[next_]) {
+            if (!lines_[next_].warnings.empty()) {
+                err_ << lines_[next_].warnings;
+                err_.flush();
+            }
+            out_ << lines_[next_].result << '\n';
+            lines_[next_] = Entry();
+            ++next_;
+        }
+        out_.flush();
+    }
+
+   private:
+    struct Entry {
+        std::string result;
+        std::string warnings;
+    };
+
+    std::ostream& out_;
+    std::ostream& err_;
+    std::mutex mutex_;
+    std::vector<Entry> lines_;
+    std::vector<bool> ready_;
+    std::size_t next_{0};
+};
+
+// Parser warnings of one file. The parsers would print them to std::cerr
+// as they go, interleaved with those of the other files.
+struct FileWarnings {
+    std::vector<std::string> listed;
+    std::size_t count{0};
+
+    void Add(int line_number, const std::string& message) {
+        if (listed.size() < kMaxListedWarnings) {
+            listed.push_back("line " + std::to_string(line_number) + ": " +
+                             message);
+        }
+        ++count;
+    }
+
+    // "Warning: <file>: line 3: incorrect vertex data" lines for stderr.
+    std::string Format(const std::string& file) const {
+        std::string text;
+        for (const std::string& warning : listed) {
+            text += "Warning: " + file + ": " + warning + '\n';
+        }
+        if (count > listed.size()) {
+            text += "Warning: " + file + ": " +
+                    std::to_string(count - listed.size()) +
+                    " more warnings\n";
+        }
+        return text;
+    }
+};
+
+using Clock = std::chrono::steady_clock;
+
+double MillisecondsSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start)
+        .count();
+}
+
+std::string OutputPath(const HeadlessOptions& options,
+                       const std::string& file) {
+    if (!options.output.empty()) {
+        return options.output;
+    }
+    return (fs::path(options.output_dir) / OutputName(file)).string();
+}
+
+std::size_t CountDegenerateFaces(const FaceList& faces) {
+    std::size_t count = 0;
+    std::vector<int> sorted;
+    for (const FaceView face : faces) {
+        sorted.assign(face.begin(), face.end());
+        std::sort(sorted.begin(), sorted.end());
+        if (sorted.size() < 3 ||
+            std::adjacent_find(sorted.begin(), sorted.end()) != sorted.end()) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+std::size_t CountUnreferencedVertices(const FaceList& faces,
+                                      std::size_t vertex_count) {
+    std::vector<char> referenced(vertex_count, 0);
+    for (const int index : faces.Indices()) {
+        referenced[index] = 1;
+    }
+    return std::count(referenced.begin(), referenced.end(), 0);
+}
+
+// Returns false when the file failed, or for validate, is not valid.
+bool ProcessFile(const HeadlessOptions& options, const std::string& file,
+                 JsonObject& result, FileWarnings& warnings) {
+    VIEWER3D_TRACE_ZONE("ProcessFile");
+    result.String("file", file);
+
+    LoadOptions load = options.load;
+    load.control.on_warning = [&warnings](int line_number,
+                                          const std::string& message) {
+        warnings.Add(line_number, message);
+    };
+
+    Model model;
+    model.SetTransformMode(TransformMode::kGpu);
+    const Clock::time_point load_start = Clock::now();
+    const bool loaded = model.LoadFromFile(file, load);
+    const double load_ms = MillisecondsSince(load_start);
+    if (!loaded) {
+        std::error_code error;
+        result.Bool("ok", false)
+            .String("error", fs::is_regular_file(file, error)
+                                 ? "cannot load the model"
+                                 : "file not found");
+        if (options.command == Command::kValidate) {
+            result.Bool("valid", false).Count("warnings", warnings.count);
+            result.Strings("messages", warnings.listed);
+        }
+        return false;
+    }
+
+    result.Bool("ok", true)
+        .Count("vertices", model.GetVertexCount())
+        .Count("faces", model.GetFaces().size());
+
+    switch (options.command) {
+        case Command::kStats:
+            result.Count("edges", model.GetEdgeCount())
+                .Count("boundary_edges", model.GetBoundaryEdgeCount())
+                .Count("non_manifold_edges", model.GetNonManifoldEdgeCount())
+                .Bounds("bounds", model.GetBounds())
+                .Milliseconds("load_ms", load_ms)
+                .Bool("cached", model.WasLoadedFromCache())
+                .Count("position_bytes", model.GetPositionBytes());
+            if (model.GetPositionStorage() == PositionStorage::kQuantized16) {
+                result.Error("quantization_error",
+                             model.GetQuantizationError());
+            }
+            return true;
+
+        case Command::kTransform: {
+            const Clock::time_point transform_start = Clock::now();
+            if (!model.SetTransform(options.translate, options.rotate,
+                                    options.scale)) {
+                result.String("error", "the scale is too small");
+                return false;
+            }
+            const std::vector<Vertex>& vertices = model.GetVertices();
+            const double transform_ms = MillisecondsSince(transform_start);
+
+            const std::string output = OutputPath(options, file);
+            const Clock::time_point write_start = Clock::now();
+            const bool written =
+                WriteObjFile(output, vertices, model.GetFaces());
+            result.String("output", output)
+                .Milliseconds("load_ms", load_ms)
+                .Milliseconds("transform_ms", transform_ms)
+                .Milliseconds("write_ms", MillisecondsSince(write_start));
+            if (!written) {
+                result.String("error", "cannot write the output");
+            }
+            return written;
+        }
+
+        case Command::kValidate: {
+            const std::size_t degenerate =
+                CountDegenerateFaces(model.GetFaces());
+            const bool valid = warnings.count == 0 && degenerate == 0;
+            result.Bool("valid", valid)
+                .Count("warnings", warnings.count)
+                .Strings("messages", warnings.listed)
+                .Count("degenerate_faces", degenerate)
+                .Count("unreferenced_vertices",
+                       CountUnreferencedVertices(model.GetFaces(),
+                                                 model.GetVertexCount()))
+                .Count("boundary_edges", model.GetBoundaryEdgeCount())
+                .Count("non_manifold_edges", model.GetNonManifoldEdgeCount())
+                .Milliseconds("load_ms", load_ms);
+            return valid;
+        }
+    }
+    return false;
+}
+
+}  // namespace
+
+int RunHeadless(const std::vector<std::string>& args, std::ostream& out,
+                std::ostream& err) {
+    if (!args.empty() && (args[0] == "-h" || args[0] == "--help")) {
+        PrintUsage(out);
+        return 0;
+    }
+    HeadlessOptions options;
+    if (!ParseArguments(args, options, err)) {
+        PrintUsage(err);
+        return 2;
+    }
+
+    if (options.command == Command::kTransform && options.output.empty()) {
+        std::error_code error;
+        fs::create_directories(options.output_dir, error);
+        if (error) {
+            err << "Error: cannot create " << options.output_dir << ": "
+                << error.message() << std::endl;
+            return 2;
+        }
+    }
+
+    if (!options.trace_file.empty() && !trace::Start()) {
+        return 2;
+    }
+
+    // Threads left over by the file-level parallelism go to each parse.
+    // The workers cover -j beyond the hardware threads too.
+    const unsigned jobs = ResolveThreadCount(options.jobs);
+    options.load.threads = std::max(1u, ResolveThreadCount(0) / jobs);
+    JobSystem job_system(std::max(jobs, ResolveThreadCount(0)) - 1);
+    JobSystem::Scope job_scope(job_system);
+
+    OrderedPrinter printer(out, err, options.files.size());
+    std::atomic<std::size_t> failures{0};
+    RunOnWorkers(options.files.size(), jobs, [&](std::size_t i) {
+        const std::string& file = options.files[i];
+        JsonObject result;
+        FileWarnings warnings;
+        bool ok = false;
+        // A file that runs out of memory fails alone; the batch goes on.
+        try {
+            ok = ProcessFile(options, file, result, warnings);
+        } catch (const std::exception& e) {
+            result = JsonObject();
+            result.String("file", file)
+                .Bool("ok", false)
+                .String("error", e.what());
+        }
+        if (!ok) {
+            failures++;
+        }
+        printer.Print(i, result.Finish(),
+                      options.command == Command::kValidate
+                          ? std::string()
+                          : warnings.Format(file));
+    });
+
+    if (!options.trace_file.empty()) {
+        trace::Stop();
+        trace::WriteChromeTrace(options.trace_file);
+    }
+
+    if (failures > 0) {
+        err << failures << " of " << options.files.size()
+            << " files failed" << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+}  // namespace viewer3d
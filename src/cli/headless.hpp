@@ -0,0 +1,24 @@
+#ifndef HEADLESS_H
+#define HEADLESS_H
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace viewer3d {
+
+// Batch mode that needs neither a display server nor a GL context:
+//
+//   viewer --headless <stats|transform|validate> [options] <file>...
+//
+// `args` are the arguments after --headless. Every input file produces one
+// JSON object on its own line of `out` (JSON Lines), in input order even
+// when files are processed in parallel. Returns the exit code: 0 when every
+// file succeeded (and, for validate, is valid), 1 otherwise and 2 for
+// usage errors.
+int RunHeadless(const std::vector<std::string>& args, std::ostream& out,
+                std::ostream& err);
+
+}  // namespace viewer3d
+
+#endif
@@ -1,37 +1,328 @@
 #include "controller/controller.hpp"
 
+#include <exception>
+#include <iostream>
+#include <utility>
+
 namespace viewer3d {
 
+namespace {
+// Levels of detail are simplified from float positions, so a quantized
+// model is decoded for the duration of the triangulation.
+TriangleMesh TriangulateSource(const Model& model) {
+    if (model.GetPositionStorage() == PositionStorage::kFloat) {
+        return Triangulate(model.GetSourcePositions(), model.GetFaces());
+    }
+    PositionsSoA positions;
+    model.GetQuantizedPositions().Decode(positions);
+    return Triangulate(positions, model.GetFaces());
+}
+}  // namespace
+
 Controller::Controller(Model& model) : model_(model) {}
 
+Controller::~Controller() {
+    WaitForPublish();
+    CancelLoad();
+    CancelLodBuild();
+}
+
 bool Controller::LoadModel(const std::string& filename) {
-    return model_.LoadFromFile(filename);
+    CancelLoad();
+    CancelLodBuild();
+    WaitForPublish();
+    if (!model_.LoadFromFile(filename, load_options_)) {
+        return false;
+    }
+    if (lod_options_.enabled) {
+        StartLodBuild(TriangulateSource(model_));
+    }
+    return true;
+}
+
+void Controller::SetLoadOptions(const LoadOptions& options) {
+    load_options_ = options;
+}
+
+void Controller::SetDispatcher(Dispatcher dispatcher) {
+    dispatcher_ = std::move(dispatcher);
 }
 
-void Controller::ClearModel() { model_.Clear(); }
+std::size_t Controller::RunPendingCompletions() {
+    std::vector<std::function<void()>> tasks;
+    {
+        std::lock_guard<std::mutex> lock(pending_mutex_);
+        tasks.swap(pending_);
+    }
+    // A task may cancel a build and so run later completions itself.
+    for (std::function<void()>& task : tasks) {
+        task();
+    }
+    return tasks.size();
+}
+
+void Controller::LoadModelAsync(const std::string& filename,
+                                ProgressCallback progress, LoadCallback done,
+                                std::shared_ptr<GeometryStream> stream) {
+    CancelLoad();
+    CancelLodBuild();
+
+    auto job = std::make_shared<LoadJob>();
+    job->staging.SetTransformMode(model_.GetTransformMode());
+    job->options = load_options_;
+    job->lod_options = lod_options_;
+    job->options.control.progress = std::move(progress);
+    job->options.control.cancel = &job->cancel;
+    if (stream) {
+        job->options.control.on_batch =
+            [stream](const std::vector<Vertex>& vertices,
+                     const FaceList& faces) {
+                stream->Append(vertices, faces);
+            };
+    }
+    load_job_ = job;
+
+    load_thread_ = std::thread([this, job, filename, done]() {
+        const bool loaded = job->staging.LoadFromFile(filename, job->options);
+        if (loaded && !job->cancel && job->lod_options.enabled) {
+            job->lod_input = TriangulateSource(job->staging);
+        }
+        auto complete = [this, job, loaded, done]() {
+            LoadStatus status = loaded ? LoadStatus::kLoaded
+                                       : LoadStatus::kFailed;
+            if (job->cancel) {
+                status = LoadStatus::kCancelled;
+            }
+            if (load_job_ == job) {
+                load_job_.reset();
+            }
+            if (status == LoadStatus::kLoaded) {
+                WaitForPublish();
+                model_.Adopt(job->staging);
+                if (job->lod_options.enabled) {
+                    StartLodBuild(std::move(job->lod_input));
+                }
+            }
+            if (done) {
+                done(status);
+            }
+        };
+        Dispatch(std::move(complete));
+    });
+}
+
+void Controller::CancelLoad() {
+    if (load_job_) {
+        load_job_->cancel = true;
+    }
+    if (load_thread_.joinable()) {
+        load_thread_.join();
+    }
+    RunPendingCompletions();
+}
+
+void Controller::ClearModel() {
+    CancelLodBuild();
+    WaitForPublish();
+    model_.Clear();
+}
+
+void Controller::SetLodOptions(const LodOptions& options) {
+    lod_options_ = options;
+}
+
+void Controller::SetLodCallback(LodCallback callback) {
+    lod_callback_ = std::move(callback);
+}
+
+std::shared_ptr<const LodChain> Controller::GetLods() const {
+    return lods_revision_ == model_.GetGeometryRevision() ? lods_ : nullptr;
+}
+
+// The mesh is simplified on a worker thread; the levels are published
+// through the dispatcher only if the geometry is still the one they were
+// built from.
+void Controller::StartLodBuild(TriangleMesh mesh) {
+    CancelLodBuild();
+    lods_.reset();
+    if (mesh.triangles.size() < lod_options_.min_triangles) {
+        return;
+    }
+
+    auto job = std::make_shared<LodJob>();
+    job->geometry_revision = model_.GetGeometryRevision();
+    lod_job_ = job;
+    const LodOptions options = lod_options_;
+
+    lod_thread_ = std::thread([this, job, options,
+                               mesh = std::move(mesh)]() mutable {
+        auto lods = std::make_shared<LodChain>();
+        const bool built = lods->Build(std::move(mesh), options, &job->cancel);
+        Dispatch([this, job, lods, built]() {
+            if (lod_job_ == job) {
+                lod_job_.reset();
+            }
+            if (!built || job->cancel ||
+                job->geometry_revision != model_.GetGeometryRevision()) {
+                return;
+            }
+            lods_ = lods;
+            lods_revision_ = job->geometry_revision;
+            if (lod_callback_) {
+                lod_callback_(*lods);
+            }
+        });
+    });
+}
+
+void Controller::CancelLodBuild() {
+    if (lod_job_) {
+        lod_job_->cancel = true;
+    }
+    if (lod_thread_.joinable()) {
+        lod_thread_.join();
+    }
+    RunPendingCompletions();
+}
+
+// Completions touch the model and the job handles, so they never run on
+// the worker threads themselves.
+void Controller::Dispatch(std::function<void()> task) {
+    if (dispatcher_) {
+        dispatcher_(std::move(task));
+        return;
+    }
+    std::lock_guard<std::mutex> lock(pending_mutex_);
+    pending_.push_back(std::move(task));
+}
+
+// The model is published on a worker thread while this one goes on; the
+// calls below that change the model or read what Publish() writes wait for
+// it first.
+void Controller::PublishSnapshotAsync(std::function<void()> done) {
+    WaitForPublish();
+    publishing_ = true;
+    publish_thread_ = std::thread([this, done]() {
+        try {
+            model_.Publish();
+        } catch (const std::exception& e) {
+            // The latest snapshot stays; the next publish tries again.
+            std::cerr << "Error: couldn't publish the model: " << e.what()
+                      << std::endl;
+        }
+        Dispatch([this, done]() {
+            publishing_ = false;
+            if (done) {
+                done();
+            }
+        });
+    });
+}
+
+void Controller::WaitForPublish() const {
+    if (publish_thread_.joinable()) {
+        publish_thread_.join();
+    }
+}
 
 void Controller::TranslateModel(float dx, float dy, float dz) {
+    WaitForPublish();
     model_.Translate(dx, dy, dz);
 }
 
 void Controller::RotateModel(float angleX, float angleY, float angleZ) {
+    WaitForPublish();
     model_.Rotate(angleX, angleY, angleZ);
 }
 
-void Controller::ScaleModel(float factor) { model_.Scale(factor); }
+void Controller::ScaleModel(float factor) {
+    WaitForPublish();
+    model_.Scale(factor);
+}
+
+bool Controller::SetTransform(const std::array<float, 3>& translate,
+                              const std::array<float, 3>& rotate,
+                              float scale) {
+    WaitForPublish();
+    return model_.SetTransform(translate, rotate, scale);
+}
+
+void Controller::SetTransformMode(TransformMode mode) {
+    WaitForPublish();
+    model_.SetTransformMode(mode);
+}
+
+TransformMode Controller::GetTransformMode() const {
+    return model_.GetTransformMode();
+}
 
 const std::vector<Vertex>& Controller::GetVertices() const {
+    WaitForPublish();
     return model_.GetVertices();
 }
 
-const std::vector<Face>& Controller::GetFaces() const {
+const PositionsSoA& Controller::GetSourcePositions() const {
+    return model_.GetSourcePositions();
+}
+
+const FaceList& Controller::GetFaces() const {
     return model_.GetFaces();
 }
 
+const Bounds& Controller::GetBounds() const { return model_.GetBounds(); }
+
+const EdgeList& Controller::GetEdges() const {
+    return model_.GetEdges();
+}
+
+const EdgeBvh& Controller::GetEdgeBvh() const { return model_.GetEdgeBvh(); }
+
+bool Controller::Pick(const Ray& ray, PickResult& result) const {
+    return model_.Pick(ray, result);
+}
+
+std::array<float, 16> Controller::GetModelMatrix() const {
+    return model_.GetModelMatrix();
+}
+
+std::shared_ptr<const ModelSnapshot> Controller::PublishSnapshot() const {
+    WaitForPublish();
+    return model_.Publish();
+}
+
+std::shared_ptr<const ModelSnapshot> Controller::GetLatestSnapshot() const {
+    return model_.LatestSnapshot();
+}
+
+std::uint64_t Controller::GetGeometryRevision() const {
+    return model_.GetGeometryRevision();
+}
+
+std::uint64_t Controller::GetTransformRevision() const {
+    return model_.GetTransformRevision();
+}
+
 std::string Controller::GetFilename() const { return model_.GetFilename(); }
 
 int Controller::GetVertexCount() const { return model_.GetVertexCount(); }
 
 int Controller::GetEdgeCount() const { return model_.GetEdgeCount(); }
 
+int Controller::GetBoundaryEdgeCount() const {
+    return model_.GetBoundaryEdgeCount();
+}
+
+int Controller::GetNonManifoldEdgeCount() const {
+    return model_.GetNonManifoldEdgeCount();
+}
+
+bool Controller::WasLoadedFromCache() const {
+    return model_.WasLoadedFromCache();
+}
+
+const PhaseTimings& Controller::GetLastPhases() const {
+    WaitForPublish();
+    return model_.GetLastPhases();
+}
+
 }  // namespace viewer3d
\ No newline at end of file
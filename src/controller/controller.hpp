@@ -1,33 +1,162 @@
 #ifndef CONTROLLER_H
 #define CONTROLLER_H
 
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <vector>
 
+#include "model/geometry_stream.hpp"
+#include "model/lod_chain.hpp"
 #include "model/model.hpp"
 
 namespace viewer3d {
 
+enum class LoadStatus { kLoaded, kFailed, kCancelled };
+
+using LoadCallback = std::function<void(LoadStatus status)>;
+using LodCallback = std::function<void(const LodChain& lods)>;
+// Runs a task on the thread that owns the model, e.g. by posting it to an
+// event loop. Tasks must not run after the controller is destroyed.
+using Dispatcher = std::function<void(std::function<void()> task)>;
+
 class Controller {
    public:
     Controller(Model& model);
-    ~Controller() = default;
+    ~Controller();
 
+    // Cancels a pending asynchronous load first, so it cannot replace the
+    // model loaded here when it completes.
     bool LoadModel(const std::string& filename);
+    // Options used by every subsequent LoadModel and LoadModelAsync call.
+    void SetLoadOptions(const LoadOptions& options);
+    const LoadOptions& GetLoadOptions() const { return load_options_; }
+
+    // Without a dispatcher completions are queued until the owning thread
+    // calls RunPendingCompletions(), CancelLoad() or CancelLodBuild().
+    void SetDispatcher(Dispatcher dispatcher);
+    // Runs the completions queued without a dispatcher and returns how many
+    // ran. Must be called on the thread that owns the controller.
+    std::size_t RunPendingCompletions();
+    // Loads `filename` on a worker thread into a staging model. `progress`
+    // is called from that thread. Completion goes through the dispatcher:
+    // the model is replaced only if the load succeeded, then `done` runs.
+    // Starting another load cancels the current one. With a `stream` the
+    // parse also publishes its geometry there in batches as it goes.
+    void LoadModelAsync(const std::string& filename,
+                        ProgressCallback progress, LoadCallback done,
+                        std::shared_ptr<GeometryStream> stream = nullptr);
+    // Stops the current load; its completion reports kCancelled. Blocks
+    // until the worker thread has finished.
+    void CancelLoad();
+    // True from LoadModelAsync until its completion has run.
+    bool IsLoading() const { return load_job_ != nullptr; }
     void ClearModel();
 
+    // While options.enabled, levels of detail are built on a worker thread
+    // after every successful load. Starting a load or clearing the model
+    // stops a build that is still running.
+    void SetLodOptions(const LodOptions& options);
+    const LodOptions& GetLodOptions() const { return lod_options_; }
+    // Runs through the dispatcher once the levels of the current model are
+    // ready.
+    void SetLodCallback(LodCallback callback);
+    // Levels of the current geometry; nullptr until they are built.
+    std::shared_ptr<const LodChain> GetLods() const;
+    bool IsBuildingLods() const { return lod_job_ != nullptr; }
+    // Blocks until the current build has finished; its completion still
+    // goes through the dispatcher.
+    void CancelLodBuild();
+
     void TranslateModel(float dx, float dy, float dz);
     void RotateModel(float angleX, float angleY, float angleZ);
     void ScaleModel(float factor);
+    // Translation, rotation in degrees and scale in one change, so the
+    // vertices are transformed once. Returns false when the scale is too
+    // small.
+    bool SetTransform(const std::array<float, 3>& translate,
+                      const std::array<float, 3>& rotate, float scale);
+
+    void SetTransformMode(TransformMode mode);
+    TransformMode GetTransformMode() const;
 
     const std::vector<Vertex>& GetVertices() const;
-    const std::vector<Face>& GetFaces() const;
+    const PositionsSoA& GetSourcePositions() const;
+    const FaceList& GetFaces() const;
+    const Bounds& GetBounds() const;
+    const EdgeList& GetEdges() const;
+    const EdgeBvh& GetEdgeBvh() const;
+    std::array<float, 16> GetModelMatrix() const;
+    // Nearest face under `ray`, in the coordinates the model is drawn in,
+    // and its vertex closest to the hit. See Model::Pick.
+    bool Pick(const Ray& ray, PickResult& result) const;
+    // See Model::Publish and Model::LatestSnapshot. Only
+    // GetLatestSnapshot() may be called from another thread, one at a time.
+    std::shared_ptr<const ModelSnapshot> PublishSnapshot() const;
+    std::shared_ptr<const ModelSnapshot> GetLatestSnapshot() const;
+    // Publishes on a worker thread, so a kCpu transform does not hold up
+    // the owning thread, then runs `done` through the dispatcher. Calls
+    // that change the model, GetVertices() and GetLastPhases() wait for a
+    // publish that is still running.
+    void PublishSnapshotAsync(std::function<void()> done);
+    // True from PublishSnapshotAsync until its completion has run.
+    bool IsPublishing() const { return publishing_; }
+    // Blocks until the worker thread has published; its completion still
+    // goes through the dispatcher.
+    void WaitForPublish() const;
+    std::uint64_t GetGeometryRevision() const;
+    std::uint64_t GetTransformRevision() const;
 
     std::string GetFilename() const;
     int GetVertexCount() const;
     int GetEdgeCount() const;
+    int GetBoundaryEdgeCount() const;
+    int GetNonManifoldEdgeCount() const;
+    bool WasLoadedFromCache() const;
+    const PhaseTimings& GetLastPhases() const;
 
    private:
+    struct LoadJob {
+        Model staging;
+        LoadOptions options;
+        // Copied at the start, SetLodOptions() may run during the load.
+        LodOptions lod_options;
+        std::atomic<bool> cancel{false};
+        // Triangulated copy of the staging model for the level of detail
+        // build, made on the loading thread.
+        TriangleMesh lod_input;
+    };
+
+    struct LodJob {
+        std::uint64_t geometry_revision{0};
+        std::atomic<bool> cancel{false};
+    };
+
+    void StartLodBuild(TriangleMesh mesh);
+    void Dispatch(std::function<void()> task);
+
     Model& model_;
+    LoadOptions load_options_;
+    Dispatcher dispatcher_;
+    std::mutex pending_mutex_;
+    std::vector<std::function<void()>> pending_;
+    std::shared_ptr<LoadJob> load_job_;
+    std::thread load_thread_;
+
+    LodOptions lod_options_;
+    LodCallback lod_callback_;
+    std::shared_ptr<LodJob> lod_job_;
+    std::thread lod_thread_;
+    std::shared_ptr<const LodChain> lods_;
+    std::uint64_t lods_revision_{0};
+
+    bool publishing_{false};
+    mutable std::thread publish_thread_;
 };
 
 }  // namespace viewer3d
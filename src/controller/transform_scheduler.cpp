@@ -0,0 +1,46 @@
+#include "controller/transform_scheduler.hpp"
+
+namespace viewer3d {
+
+namespace {
+constexpr std::chrono::nanoseconds kDefaultFrameInterval{1000000000 / 60};
+}  // namespace
+
+TransformScheduler::TransformScheduler(Controller& controller)
+    : controller_(controller), frame_interval_(kDefaultFrameInterval) {}
+
+bool TransformScheduler::Request(const TransformParams& params,
+                                 Clock::time_point now) {
+    ++stats_.requests;
+    params_ = params;
+    if (pending_) {
+        ++stats_.coalesced;
+        return false;
+    }
+    pending_ = true;
+    pending_since_ = now;
+    return true;
+}
+
+bool TransformScheduler::Flush(Clock::time_point now) {
+    if (!pending_) {
+        return false;
+    }
+    pending_ = false;
+    if (now > pending_since_) {
+        stats_.dropped_frames += (now - pending_since_) / frame_interval_;
+    }
+    if (!controller_.SetTransform(params_.translate, params_.rotate,
+                                  params_.scale)) {
+        ++stats_.rejected;
+        return false;
+    }
+    ++stats_.applied;
+    return true;
+}
+
+void TransformScheduler::SetFrameInterval(std::chrono::nanoseconds interval) {
+    frame_interval_ = interval.count() > 0 ? interval : kDefaultFrameInterval;
+}
+
+}  // namespace viewer3d
\ No newline at end of file
@@ -0,0 +1,75 @@
+#ifndef TRANSFORM_SCHEDULER_H
+#define TRANSFORM_SCHEDULER_H
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+
+#include "controller/controller.hpp"
+
+namespace viewer3d {
+
+// Absolute transform of the model, as taken by Controller::SetTransform.
+struct TransformParams {
+    std::array<float, 3> translate{0.0f, 0.0f, 0.0f};
+    // Degrees.
+    std::array<float, 3> rotate{0.0f, 0.0f, 0.0f};
+    float scale{1.0f};
+};
+
+struct TransformSchedulerStats {
+    std::uint64_t requests{0};
+    // Transforms handed to the controller, at most one per publish.
+    std::uint64_t applied{0};
+    // Requests replaced by a later one before a publish applied them.
+    std::uint64_t coalesced{0};
+    // Display refreshes that passed while an update was waiting, beyond the
+    // one it was requested for.
+    std::uint64_t dropped_frames{0};
+    // Requests the controller refused, e.g. for a too small scale.
+    std::uint64_t rejected{0};
+};
+
+// Coalesces live transform changes so that however many input events
+// arrive, the model is transformed at most once per published snapshot.
+// Input handlers call Request() for every event; the owner calls Flush()
+// before it publishes the model, once the previous publish has finished.
+class TransformScheduler {
+   public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit TransformScheduler(Controller& controller);
+
+    // Replaces the pending transform. Returns true when nothing was pending
+    // before, i.e. when the caller has to schedule a publish.
+    bool Request(const TransformParams& params,
+                 Clock::time_point now = Clock::now());
+    // Applies the pending transform, if any. Returns true when the model
+    // changed.
+    bool Flush(Clock::time_point now = Clock::now());
+    bool HasPending() const { return pending_; }
+    // Drops the pending transform without applying it.
+    void Cancel() { pending_ = false; }
+
+    // Refresh period of the display, used to count dropped frames. Defaults
+    // to 60 Hz.
+    void SetFrameInterval(std::chrono::nanoseconds interval);
+    std::chrono::nanoseconds GetFrameInterval() const {
+        return frame_interval_;
+    }
+
+    const TransformSchedulerStats& GetStats() const { return stats_; }
+    void ResetStats() { stats_ = TransformSchedulerStats(); }
+
+   private:
+    Controller& controller_;
+    std::chrono::nanoseconds frame_interval_;
+    bool pending_{false};
+    TransformParams params_;
+    Clock::time_point pending_since_;
+    TransformSchedulerStats stats_;
+};
+
+}  // namespace viewer3d
+
+#endif
\ No newline at end of file
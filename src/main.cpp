@@ -1,12 +1,25 @@
 #include <QApplication>
 #include <QCommandLineParser>
 #include <QDebug>
+#include <QStandardPaths>
+#include <cstring>
+#include <iostream>
 
+#include "cli/headless.hpp"
 #include "controller/controller.hpp"
+#include "model/job_system.hpp"
 #include "model/model.hpp"
+#include "model/trace.hpp"
 #include "view/mainwindow.hpp"
 
 int main(int argc, char* argv[]) {
+    // Batch mode runs before QApplication exists, so it needs no display.
+    if (argc > 1 && std::strcmp(argv[1], "--headless") == 0) {
+        return viewer3d::RunHeadless(
+            std::vector<std::string>(argv + 2, argv + argc), std::cout,
+            std::cerr);
+    }
+
     QApplication app(argc, argv);
 
     QApplication::setApplicationName("3DViewer");
@@ -20,31 +33,146 @@ int main(int argc, char* argv[]) {
     parser.addOption(helpOption);
     parser.addVersionOption();
 
-    QCommandLineOption fileOption(QStringList() << "f" << "file",
-                                  "Uploads the model file at startup.",
-                                  "filename");
+    QCommandLineOption fileOption(
+        QStringList() << "f" << "file",
+        "Uploads the model file (OBJ, PLY or STL) at startup.", "filename");
     parser.addOption(fileOption);
 
+    QCommandLineOption cpuTransformsOption(
+        "cpu-transforms",
+        "Transforms the vertices on the CPU instead of in the vertex shader.");
+    parser.addOption(cpuTransformsOption);
+
+    QCommandLineOption noCacheOption(
+        "no-cache", "Parses model files without reading or writing the cache.");
+    parser.addOption(noCacheOption);
+    QCommandLineOption rebuildCacheOption(
+        "rebuild-cache", "Parses model files and overwrites their cache.");
+    parser.addOption(rebuildCacheOption);
+    QCommandLineOption cacheDirOption(
+        "cache-dir",
+        "Stores model caches in <directory> instead of the user cache "
+        "location. Pass an empty string to write them beside the models.",
+        "directory");
+    parser.addOption(cacheDirOption);
+    QCommandLineOption progressiveOption(
+        "progressive",
+        "Draws models while they are loading, as the file is parsed.");
+    parser.addOption(progressiveOption);
+    QCommandLineOption noLodsOption(
+        "no-lods",
+        "Always draws the full model instead of building simplified levels "
+        "of detail for distant views.");
+    parser.addOption(noLodsOption);
+    QCommandLineOption traceOption(
+        "trace",
+        "Records trace zones from startup and writes them as a Chrome trace "
+        "to <file> on exit. Tools > Save trace writes one at any time.",
+        "file");
+    parser.addOption(traceOption);
+    QCommandLineOption frameStatsOption(
+        "frame-stats",
+        "Shows frame times and draw statistics over the viewport (F3).");
+    parser.addOption(frameStatsOption);
+    QCommandLineOption frameStatsLogOption(
+        "frame-stats-log",
+        "Appends the times and draw statistics of every frame to the CSV "
+        "<file>.",
+        "file");
+    parser.addOption(frameStatsLogOption);
+    QCommandLineOption liveTransformsOption(
+        "live-transforms",
+        "Applies the movement, rotation and scale boxes as they change, at "
+        "most once per display refresh (F4).");
+    parser.addOption(liveTransformsOption);
+    QCommandLineOption quantizeOption(
+        "quantize",
+        "Stores vertex positions as 16 bits per axis within the model bounds, "
+        "halving their memory at a small loss of precision.");
+    parser.addOption(quantizeOption);
+    QCommandLineOption threadsOption(
+        "threads",
+        "Runs loads, transforms and levels of detail on <n> threads, the "
+        "calling one included. 0, the default, uses every hardware thread.",
+        "n");
+    parser.addOption(threadsOption);
+
     parser.process(app);
 
     if (parser.isSet(helpOption)) {
         parser.showHelp();
         return 0;
     }
+    unsigned threads = 0;
+    if (parser.isSet(threadsOption)) {
+        bool valid = false;
+        threads = parser.value(threadsOption).toUInt(&valid);
+        if (!valid) {
+            std::cerr << "Error: invalid value for --threads: "
+                      << parser.value(threadsOption).toStdString()
+                      << std::endl;
+            return 1;
+        }
+    }
+    // Outlives the model and the controller, whose passes run on it.
+    viewer3d::JobSystem jobs(threads == 0
+                                 ? viewer3d::JobSystem::DefaultWorkerCount()
+                                 : threads - 1);
+    viewer3d::JobSystem::Scope jobScope(jobs);
+
+    // Before anything is loaded, so the trace covers the startup load.
+    const bool tracing =
+        parser.isSet(traceOption) && viewer3d::trace::Start();
 
     viewer3d::Model model;
+    model.SetTransformMode(parser.isSet(cpuTransformsOption)
+                               ? viewer3d::TransformMode::kCpu
+                               : viewer3d::TransformMode::kGpu);
     viewer3d::Controller controller(model);
+
+    viewer3d::LoadOptions loadOptions;
+    if (parser.isSet(noCacheOption)) {
+        loadOptions.cache = viewer3d::CacheMode::kBypass;
+    } else if (parser.isSet(rebuildCacheOption)) {
+        loadOptions.cache = viewer3d::CacheMode::kRebuild;
+    } else {
+        loadOptions.cache = viewer3d::CacheMode::kUse;
+    }
+    loadOptions.cache_dir =
+        parser.isSet(cacheDirOption)
+            ? parser.value(cacheDirOption).toStdString()
+            : QStandardPaths::writableLocation(QStandardPaths::CacheLocation)
+                  .toStdString();
+    if (parser.isSet(quantizeOption)) {
+        loadOptions.storage = viewer3d::PositionStorage::kQuantized16;
+    }
+    controller.SetLoadOptions(loadOptions);
+
+    viewer3d::LodOptions lodOptions;
+    lodOptions.enabled = !parser.isSet(noLodsOption);
+    controller.SetLodOptions(lodOptions);
     viewer3d::MainWindow mainWindow(controller);
+    mainWindow.setProgressiveLoading(parser.isSet(progressiveOption));
+    if (tracing) {
+        mainWindow.setTraceRecording(true);
+    }
 
     if (parser.isSet(fileOption)) {
-        QString filename = parser.value(fileOption);
-        if (controller.LoadModel(filename.toStdString())) {
-            mainWindow.onModelLoaded();
-        } else {
-            qWarning() << "Failed to upload file:" << filename;
-        }
+        mainWindow.loadFile(parser.value(fileOption));
+    }
+
+    mainWindow.setFrameStatsVisible(parser.isSet(frameStatsOption));
+    mainWindow.setLiveTransforms(parser.isSet(liveTransformsOption));
+    if (parser.isSet(frameStatsLogOption) &&
+        !mainWindow.logFrameStats(parser.value(frameStatsLogOption))) {
+        return 1;
     }
 
     mainWindow.show();
-    return app.exec();
+    const int result = app.exec();
+    if (parser.isSet(traceOption)) {
+        viewer3d::trace::WriteChromeTrace(
+            parser.value(traceOption).toStdString());
+    }
+    return result;
 }
@@ -0,0 +1,56 @@
+#ifndef ARENA_LIST_H
+#define ARENA_LIST_H
+
+#include <cstddef>
+#include <memory_resource>
+#include <type_traits>
+#include <vector>
+
+namespace viewer3d {
+
+// Append-only sequence for scratch data that lives only during a load.
+// Elements are stored in fixed-size blocks taken from a monotonic arena, so
+// growing never moves them and the storage goes away with the arena in one
+// step instead of one free per reallocation. The list must not be used once
+// its arena is released.
+template <typename T>
+class ArenaList {
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "blocks are never destroyed element by element");
+
+   public:
+    static constexpr std::size_t kBlockShift = 14;
+    static constexpr std::size_t kBlockSize = std::size_t{1} << kBlockShift;
+
+    ArenaList() = default;
+    explicit ArenaList(std::pmr::monotonic_buffer_resource& arena)
+        : arena_(&arena) {}
+
+    void push_back(const T& value) {
+        if (next_ == block_end_) {
+            next_ = static_cast<T*>(
+                arena_->allocate(kBlockSize * sizeof(T), alignof(T)));
+            block_end_ = next_ + kBlockSize;
+            blocks_.push_back(next_);
+        }
+        *next_++ = value;
+        size_++;
+    }
+
+    const T& operator[](std::size_t i) const {
+        return blocks_[i >> kBlockShift][i & (kBlockSize - 1)];
+    }
+    std::size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+   private:
+    std::pmr::monotonic_buffer_resource* arena_{nullptr};
+    std::vector<T*> blocks_;
+    T* next_{nullptr};
+    T* block_end_{nullptr};
+    std::size_t size_{0};
+};
+
+}  // namespace viewer3d
+
+#endif
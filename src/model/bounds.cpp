@@ -0,0 +1,50 @@
+#include "model/bounds.hpp"
+
+#include <algorithm>
+
+#include "model/parallel.hpp"
+
+namespace viewer3d {
+
+namespace {
+
+// Smaller models are measured on the calling thread.
+constexpr std::size_t kVerticesPerTask = 1 << 17;
+
+void AxisRange(const std::vector<float>& values, std::size_t begin,
+               std::size_t end, float& low, float& high) {
+    const auto range =
+        std::minmax_element(values.begin() + begin, values.begin() + end);
+    low = *range.first;
+    high = *range.second;
+}
+
+Bounds Merge(const Bounds& a, const Bounds& b) {
+    if (a.empty()) {
+        return b;
+    }
+    if (b.empty()) {
+        return a;
+    }
+    return {{std::min(a.min.x, b.min.x), std::min(a.min.y, b.min.y),
+             std::min(a.min.z, b.min.z)},
+            {std::max(a.max.x, b.max.x), std::max(a.max.y, b.max.y),
+             std::max(a.max.z, b.max.z)}};
+}
+
+}  // namespace
+
+Bounds ComputeBounds(const PositionsSoA& positions) {
+    return ParallelReduce(
+        positions.size(), kVerticesPerTask, 0, Bounds(),
+        [&positions](std::size_t begin, std::size_t end) {
+            Bounds bounds;
+            AxisRange(positions.x, begin, end, bounds.min.x, bounds.max.x);
+            AxisRange(positions.y, begin, end, bounds.min.y, bounds.max.y);
+            AxisRange(positions.z, begin, end, bounds.min.z, bounds.max.z);
+            return bounds;
+        },
+        Merge);
+}
+
+}  // namespace viewer3d
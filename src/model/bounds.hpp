@@ -0,0 +1,21 @@
+#ifndef BOUNDS_H
+#define BOUNDS_H
+
+#include "model/transform_kernel.hpp"
+#include "model/vertex.hpp"
+
+namespace viewer3d {
+
+// Axis-aligned bounding box. An empty box has min > max.
+struct Bounds {
+    Vertex min{1.0f, 1.0f, 1.0f};
+    Vertex max{-1.0f, -1.0f, -1.0f};
+
+    bool empty() const { return min.x > max.x; }
+};
+
+Bounds ComputeBounds(const PositionsSoA& positions);
+
+}  // namespace viewer3d
+
+#endif
@@ -0,0 +1,207 @@
+#include "model/edge_bvh.hpp"
+
+#include <algorithm>
+#include <utility>
+
+#include "model/morton.hpp"
+#include "model/parallel.hpp"
+#include "model/trace.hpp"
+
+namespace viewer3d {
+
+namespace {
+
+constexpr std::size_t kChunkSize = 1 << 16;
+// Deep enough for any tree over 2^32 clusters.
+constexpr int kMaxStackDepth = 64;
+
+template <typename Task>
+void ForEachChunk(std::size_t count, unsigned threads, Task task) {
+    const std::size_t chunks = (count + kChunkSize - 1) / kChunkSize;
+    RunOnWorkers(chunks, threads, [&](std::size_t chunk) {
+        task(chunk * kChunkSize, std::min(count, (chunk + 1) * kChunkSize));
+    });
+}
+
+}  // namespace
+
+void EdgeBvh::Build(const PositionsSoA& positions, const Bounds& bounds,
+                    EdgeList& edges, unsigned threads) {
+    VIEWER3D_TRACE_ZONE("EdgeBvh::Build");
+    clear();
+    edge_count_ = edges.size();
+    if (edge_count_ == 0 || bounds.empty()) {
+        edge_count_ = 0;
+        return;
+    }
+
+    const MortonEncoder encode(bounds);
+    const std::vector<Edge>& source = edges.Edges();
+    std::vector<std::uint64_t> keys(edge_count_);
+    ForEachChunk(edge_count_, threads, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; ++i) {
+            const Edge& edge = source[i];
+            const float x = 0.5f * (positions.x[edge.a] + positions.x[edge.b]);
+            const float y = 0.5f * (positions.y[edge.a] + positions.y[edge.b]);
+            const float z = 0.5f * (positions.z[edge.a] + positions.z[edge.b]);
+            keys[i] = (static_cast<std::uint64_t>(encode(x, y, z)) << 32) | i;
+        }
+    });
+    SortByMortonCode(keys);
+
+    std::vector<Edge> sorted(edge_count_);
+    ForEachChunk(edge_count_, threads, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; ++i) {
+            sorted[i] = source[keys[i] & 0xFFFFFFFFu];
+        }
+    });
+    keys = std::vector<std::uint64_t>();
+    edges.Assign(std::move(sorted), edges.BoundaryCount(),
+                 edges.NonManifoldCount(), edges.WireCount());
+    BuildClustered(positions, bounds, edges, threads);
+}
+
+void EdgeBvh::BuildClustered(const PositionsSoA& positions,
+                             const Bounds& bounds, const EdgeList& edges,
+                             unsigned threads) {
+    VIEWER3D_TRACE_ZONE("EdgeBvh::BuildClustered");
+    clear();
+    edge_count_ = edges.size();
+    if (edge_count_ == 0 || bounds.empty()) {
+        edge_count_ = 0;
+        return;
+    }
+
+    cluster_count_ = (edge_count_ + kEdgesPerCluster - 1) / kEdgesPerCluster;
+    std::vector<Node> clusters(cluster_count_);
+    const std::vector<Edge>& clustered = edges.Edges();
+    RunOnWorkers(cluster_count_, threads, [&](std::size_t c) {
+        Node& cluster = clusters[c];
+        cluster.first_edge = c * kEdgesPerCluster;
+        cluster.last_edge =
+            std::min(edge_count_, cluster.first_edge + kEdgesPerCluster);
+        cluster.left = -1;
+        cluster.right = -1;
+        const Edge& first = clustered[cluster.first_edge];
+        cluster.min[0] = cluster.max[0] = positions.x[first.a];
+        cluster.min[1] = cluster.max[1] = positions.y[first.a];
+        cluster.min[2] = cluster.max[2] = positions.z[first.a];
+        for (std::size_t i = cluster.first_edge; i < cluster.last_edge; ++i) {
+            for (int index : {clustered[i].a, clustered[i].b}) {
+                const float p[3] = {positions.x[index], positions.y[index],
+                                    positions.z[index]};
+                for (int axis = 0; axis < 3; ++axis) {
+                    cluster.min[axis] = std::min(cluster.min[axis], p[axis]);
+                    cluster.max[axis] = std::max(cluster.max[axis], p[axis]);
+                }
+            }
+        }
+    });
+
+    nodes_.reserve(2 * cluster_count_ - 1);
+    BuildNode(clusters, 0, cluster_count_);
+}
+
+// Splits the Morton ordered clusters in halves, so every node covers
+// consecutive clusters.
+std::int32_t EdgeBvh::BuildNode(const std::vector<Node>& clusters,
+                                std::size_t first, std::size_t last) {
+    const auto index = static_cast<std::int32_t>(nodes_.size());
+    if (last - first == 1) {
+        nodes_.push_back(clusters[first]);
+        return index;
+    }
+    nodes_.emplace_back();
+    const std::size_t middle = first + (last - first) / 2;
+    const std::int32_t left = BuildNode(clusters, first, middle);
+    const std::int32_t right = BuildNode(clusters, middle, last);
+
+    Node& node = nodes_[index];
+    for (int axis = 0; axis < 3; ++axis) {
+        node.min[axis] =
+            std::min(nodes_[left].min[axis], nodes_[right].min[axis]);
+        node.max[axis] =
+            std::max(nodes_[left].max[axis], nodes_[right].max[axis]);
+    }
+    node.first_edge = nodes_[left].first_edge;
+    node.last_edge = nodes_[right].last_edge;
+    node.left = left;
+    node.right = right;
+    return index;
+}
+
+void EdgeBvh::clear() {
+    nodes_.clear();
+    cluster_count_ = 0;
+    edge_count_ = 0;
+}
+
+// Planes are taken from the rows of the clip matrix (Gribb and Hartmann),
+// so boxes are tested in source space. A box is outside when its corner
+// furthest along a plane normal is behind the plane, and entirely inside
+// when its nearest corner is in front of every plane.
+CullStats EdgeBvh::Cull(const std::array<float, 16>& clip,
+                        std::vector<EdgeRange>& visible) const {
+    VIEWER3D_TRACE_ZONE("EdgeBvh::Cull");
+    visible.clear();
+    CullStats stats;
+    if (nodes_.empty()) {
+        return stats;
+    }
+
+    float planes[6][4];
+    for (int axis = 0; axis < 3; ++axis) {
+        for (int j = 0; j < 4; ++j) {
+            planes[2 * axis][j] = clip[12 + j] + clip[4 * axis + j];
+            planes[2 * axis + 1][j] = clip[12 + j] - clip[4 * axis + j];
+        }
+    }
+
+    std::int32_t stack[kMaxStackDepth];
+    int depth = 0;
+    stack[depth++] = 0;
+    while (depth > 0) {
+        const Node& node = nodes_[stack[--depth]];
+        bool outside = false;
+        bool inside = true;
+        for (const float* plane : planes) {
+            float farthest = plane[3];
+            float nearest = plane[3];
+            for (int axis = 0; axis < 3; ++axis) {
+                const float a = plane[axis] * node.min[axis];
+                const float b = plane[axis] * node.max[axis];
+                farthest += std::max(a, b);
+                nearest += std::min(a, b);
+            }
+            if (farthest < 0.0f) {
+                outside = true;
+                break;
+            }
+            if (nearest < 0.0f) {
+                inside = false;
+            }
+        }
+        if (outside) {
+            continue;
+        }
+        if (!inside && node.left >= 0) {
+            // Left first, so ranges come out in order and can be merged.
+            stack[depth++] = node.right;
+            stack[depth++] = node.left;
+            continue;
+        }
+
+        stats.visible_clusters +=
+            (node.last_edge - node.first_edge + kEdgesPerCluster - 1) /
+            kEdgesPerCluster;
+        stats.visible_edges += node.last_edge - node.first_edge;
+        if (!visible.empty() && visible.back().last == node.first_edge) {
+            visible.back().last = node.last_edge;
+        } else {
+            visible.push_back({node.first_edge, node.last_edge});
+        }
+    }
+    return stats;
+}
+
+}  // namespace viewer3d
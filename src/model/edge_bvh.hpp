@@ -0,0 +1,76 @@
+#ifndef EDGE_BVH_H
+#define EDGE_BVH_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "model/bounds.hpp"
+#include "model/edge_list.hpp"
+#include "model/transform_kernel.hpp"
+
+namespace viewer3d {
+
+// Half-open range [first, last) of edges in EdgeList order.
+struct EdgeRange {
+    std::size_t first;
+    std::size_t last;
+};
+
+struct CullStats {
+    std::size_t visible_clusters{0};
+    std::size_t visible_edges{0};
+};
+
+// Bounding volume hierarchy over clusters of nearby edges. Build() sorts
+// the edges along a Morton curve, so every cluster and every node covers a
+// contiguous range of the edge list, and therefore of an index buffer
+// uploaded from it. Culling yields those ranges; nothing is rebuilt per
+// frame.
+class EdgeBvh {
+   public:
+    static constexpr std::size_t kEdgesPerCluster = 2048;
+
+    // Reorders `edges` by cluster and builds the hierarchy over the source
+    // positions. threads == 0 means one per hardware thread.
+    void Build(const PositionsSoA& positions, const Bounds& bounds,
+               EdgeList& edges, unsigned threads = 0);
+    // Same for edges that are already in the order Build() leaves them,
+    // such as edges read back from the model cache.
+    void BuildClustered(const PositionsSoA& positions, const Bounds& bounds,
+                        const EdgeList& edges, unsigned threads = 0);
+    void clear();
+
+    bool empty() const { return nodes_.empty(); }
+    std::size_t ClusterCount() const { return cluster_count_; }
+    std::size_t EdgeCount() const { return edge_count_; }
+
+    // Replaces `visible` with the ranges of the clusters that intersect the
+    // frustum of `clip`, a row-major matrix from source positions to clip
+    // space. Adjacent ranges are merged.
+    CullStats Cull(const std::array<float, 16>& clip,
+                   std::vector<EdgeRange>& visible) const;
+
+   private:
+    struct Node {
+        float min[3];
+        float max[3];
+        std::size_t first_edge;
+        std::size_t last_edge;
+        // Children, or -1 for a cluster.
+        std::int32_t left;
+        std::int32_t right;
+    };
+
+    std::int32_t BuildNode(const std::vector<Node>& clusters,
+                           std::size_t first, std::size_t last);
+
+    std::vector<Node> nodes_;
+    std::size_t cluster_count_{0};
+    std::size_t edge_count_{0};
+};
+
+}  // namespace viewer3d
+
+#endif
@@ -0,0 +1,154 @@
+#include "model/edge_list.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <utility>
+
+#include "model/parallel.hpp"
+#include "model/trace.hpp"
+
+namespace viewer3d {
+
+namespace {
+
+// Each face edge becomes a 64-bit key (a << 33 | b << 1 | from_polygon), so
+// one sort groups every use of an undirected edge together.
+using EdgeKey = std::uint64_t;
+constexpr EdgeKey kNoEdge = std::numeric_limits<EdgeKey>::max();
+
+// Below this many keys sorting on one thread is faster than splitting.
+constexpr std::size_t kMinKeysPerSortChunk = 1 << 16;
+
+EdgeKey MakeKey(int a, int b, bool from_polygon) {
+    if (a == b) {
+        return kNoEdge;
+    }
+    if (a > b) {
+        std::swap(a, b);
+    }
+    return (static_cast<EdgeKey>(a) << 33) | (static_cast<EdgeKey>(b) << 1) |
+           (from_polygon ? 1 : 0);
+}
+
+// One key slot per face index, so the face offsets double as key offsets.
+void FillKeys(const FaceList& faces, std::size_t face_begin,
+              std::size_t face_end, EdgeKey* keys) {
+    const std::vector<int>& indices = faces.Indices();
+    const std::vector<std::size_t>& offsets = faces.Offsets();
+    for (std::size_t f = face_begin; f < face_end; ++f) {
+        const std::size_t first = offsets[f];
+        const std::size_t size = offsets[f + 1] - first;
+        const int* face = indices.data() + first;
+        EdgeKey* face_keys = keys + first;
+        if (size == 2) {
+            face_keys[0] = MakeKey(face[0], face[1], false);
+            face_keys[1] = kNoEdge;
+        } else if (size >= 3) {
+            for (std::size_t i = 0; i + 1 < size; ++i) {
+                face_keys[i] = MakeKey(face[i], face[i + 1], true);
+            }
+            face_keys[size - 1] = MakeKey(face[size - 1], face[0], true);
+        } else if (size == 1) {
+            face_keys[0] = kNoEdge;
+        }
+    }
+}
+
+// Sorts runs in parallel, then merges neighbouring runs pairwise.
+void ParallelSort(std::vector<EdgeKey>& keys, unsigned threads) {
+    VIEWER3D_TRACE_ZONE("EdgeList::Sort");
+    std::size_t run_count =
+        std::min<std::size_t>(ResolveThreadCount(threads),
+                              keys.size() / kMinKeysPerSortChunk);
+    if (run_count <= 1) {
+        std::sort(keys.begin(), keys.end());
+        return;
+    }
+
+    std::vector<std::size_t> bounds(run_count + 1);
+    for (std::size_t i = 0; i <= run_count; ++i) {
+        bounds[i] = keys.size() / run_count * i;
+    }
+    bounds[run_count] = keys.size();
+
+    RunOnWorkers(run_count, threads, [&](std::size_t i) {
+        std::sort(keys.begin() + bounds[i], keys.begin() + bounds[i + 1]);
+    });
+
+    for (std::size_t width = 1; width < run_count; width *= 2) {
+        const std::size_t merge_count =
+            (run_count + 2 * width - 1) / (2 * width);
+        RunOnWorkers(merge_count, threads, [&](std::size_t i) {
+            const std::size_t first = 2 * width * i;
+            const std::size_t middle = std::min(first + width, run_count);
+            const std::size_t last = std::min(first + 2 * width, run_count);
+            if (middle < last) {
+                std::inplace_merge(keys.begin() + bounds[first],
+                                   keys.begin() + bounds[middle],
+                                   keys.begin() + bounds[last]);
+            }
+        });
+    }
+}
+
+}  // namespace
+
+void EdgeList::Build(const FaceList& faces, unsigned threads) {
+    VIEWER3D_TRACE_ZONE("EdgeList::Build");
+    clear();
+    if (faces.empty()) {
+        return;
+    }
+
+    std::vector<EdgeKey> keys(faces.IndexCount());
+    const std::size_t face_count = faces.size();
+    const std::size_t task_count = std::min<std::size_t>(
+        ResolveThreadCount(threads) * 4,
+        std::max<std::size_t>(1, keys.size() / kMinKeysPerSortChunk));
+    RunOnWorkers(task_count, threads, [&](std::size_t i) {
+        FillKeys(faces, face_count * i / task_count,
+                 face_count * (i + 1) / task_count, keys.data());
+    });
+
+    ParallelSort(keys, threads);
+
+    // Invalid slots sort to the end.
+    const std::size_t valid =
+        std::lower_bound(keys.begin(), keys.end(), kNoEdge) - keys.begin();
+    edges_.reserve(valid / 2);
+    for (std::size_t i = 0; i < valid;) {
+        const EdgeKey edge = keys[i] >> 1;
+        std::size_t polygon_uses = 0;
+        for (; i < valid && keys[i] >> 1 == edge; ++i) {
+            polygon_uses += keys[i] & 1;
+        }
+
+        edges_.push_back({static_cast<int>(edge >> 32),
+                          static_cast<int>(edge & 0xffffffffu)});
+        if (polygon_uses == 0) {
+            wire_count_++;
+        } else if (polygon_uses == 1) {
+            boundary_count_++;
+        } else if (polygon_uses > 2) {
+            non_manifold_count_++;
+        }
+    }
+}
+
+void EdgeList::Assign(std::vector<Edge> edges, std::size_t boundary_count,
+                      std::size_t non_manifold_count, std::size_t wire_count) {
+    edges_ = std::move(edges);
+    boundary_count_ = boundary_count;
+    non_manifold_count_ = non_manifold_count;
+    wire_count_ = wire_count;
+}
+
+void EdgeList::clear() {
+    edges_.clear();
+    boundary_count_ = 0;
+    non_manifold_count_ = 0;
+    wire_count_ = 0;
+}
+
+}  // namespace viewer3d
@@ -0,0 +1,51 @@
+#ifndef EDGE_LIST_H
+#define EDGE_LIST_H
+
+#include <cstddef>
+#include <vector>
+
+#include "model/face_list.hpp"
+
+namespace viewer3d {
+
+// Undirected edge between two vertex indices, always stored with a < b.
+struct Edge {
+    int a;
+    int b;
+};
+
+// Deduplicated edges of a face list together with how many polygons use
+// each one. Two-vertex faces contribute wire edges, which count as edges
+// but not as polygon uses.
+class EdgeList {
+   public:
+    // Rebuilds the list from `faces`. threads == 0 means one per hardware
+    // thread.
+    void Build(const FaceList& faces, unsigned threads = 0);
+    // Restores a list produced by Build, e.g. from the model cache.
+    void Assign(std::vector<Edge> edges, std::size_t boundary_count,
+                std::size_t non_manifold_count, std::size_t wire_count);
+    void clear();
+
+    std::size_t size() const { return edges_.size(); }
+    bool empty() const { return edges_.empty(); }
+    const Edge& operator[](std::size_t i) const { return edges_[i]; }
+    const std::vector<Edge>& Edges() const { return edges_; }
+
+    // Edges used by exactly one polygon.
+    std::size_t BoundaryCount() const { return boundary_count_; }
+    // Edges shared by more than two polygons.
+    std::size_t NonManifoldCount() const { return non_manifold_count_; }
+    // Edges that only come from two-vertex faces.
+    std::size_t WireCount() const { return wire_count_; }
+
+   private:
+    std::vector<Edge> edges_;
+    std::size_t boundary_count_{0};
+    std::size_t non_manifold_count_{0};
+    std::size_t wire_count_{0};
+};
+
+}  // namespace viewer3d
+
+#endif
@@ -0,0 +1,324 @@
+#include "model/face_bvh.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "model/morton.hpp"
+#include "model/parallel.hpp"
+#include "model/trace.hpp"
+
+namespace viewer3d {
+
+namespace {
+
+constexpr std::size_t kChunkSize = 1 << 16;
+constexpr std::size_t kFacesPerLeaf = 4;
+// Splits at differing code bits give at most 30 levels and the middle
+// splits of equal codes at most 32 more; deeper ranges become leaves.
+constexpr int kMaxDepth = 64;
+
+template <typename Task>
+void ForEachChunk(std::size_t count, unsigned threads, Task task) {
+    const std::size_t chunks = (count + kChunkSize - 1) / kChunkSize;
+    RunOnWorkers(chunks, threads, [&](std::size_t chunk) {
+        task(chunk * kChunkSize, std::min(count, (chunk + 1) * kChunkSize));
+    });
+}
+
+bool IsPickable(const FaceView& face, std::size_t vertex_count) {
+    return face.size() >= 3 &&
+           std::all_of(face.begin(), face.end(), [vertex_count](int index) {
+               return index >= 0 &&
+                      static_cast<std::size_t>(index) < vertex_count;
+           });
+}
+
+// Möller-Trumbore; both sides of the triangle count.
+bool IntersectTriangle(const Ray& ray, const float* a, const float* b,
+                       const float* c, float& t) {
+    const float e1[3] = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+    const float e2[3] = {c[0] - a[0], c[1] - a[1], c[2] - a[2]};
+    const Vertex& d = ray.direction;
+    const float p[3] = {d.y * e2[2] - d.z * e2[1], d.z * e2[0] - d.x * e2[2],
+                        d.x * e2[1] - d.y * e2[0]};
+    const float det = e1[0] * p[0] + e1[1] * p[1] + e1[2] * p[2];
+    if (std::fabs(det) < std::numeric_limits<float>::min()) {
+        return false;
+    }
+    const float inv_det = 1.0f / det;
+    const float s[3] = {ray.origin.x - a[0], ray.origin.y - a[1],
+                        ray.origin.z - a[2]};
+    const float u = (s[0] * p[0] + s[1] * p[1] + s[2] * p[2]) * inv_det;
+    if (u < 0.0f || u > 1.0f) {
+        return false;
+    }
+    const float q[3] = {s[1] * e1[2] - s[2] * e1[1],
+                        s[2] * e1[0] - s[0] * e1[2],
+                        s[0] * e1[1] - s[1] * e1[0]};
+    const float v = (d.x * q[0] + d.y * q[1] + d.z * q[2]) * inv_det;
+    if (v < 0.0f || u + v > 1.0f) {
+        return false;
+    }
+    t = (e2[0] * q[0] + e2[1] * q[1] + e2[2] * q[2]) * inv_det;
+    return t >= 0.0f;
+}
+
+}  // namespace
+
+void FaceBvh::Build(const PositionsSoA& positions, const FaceList& faces,
+                    const Bounds& bounds, unsigned threads) {
+    VIEWER3D_TRACE_ZONE("FaceBvh::Build");
+    clear();
+    if (faces.empty() || bounds.empty()) {
+        return;
+    }
+
+    const MortonEncoder encode(bounds);
+    const std::size_t vertex_count = positions.size();
+    const std::size_t face_count = faces.size();
+    // Unpickable faces are marked with a bit above any code and dropped
+    // before sorting.
+    constexpr std::uint64_t kSkipped = std::uint64_t{1} << 62;
+    std::vector<std::uint64_t> keys(face_count);
+    ForEachChunk(face_count, threads, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; ++i) {
+            const FaceView face = faces[i];
+            if (!IsPickable(face, vertex_count)) {
+                keys[i] = kSkipped | i;
+                continue;
+            }
+            float x = 0.0f;
+            float y = 0.0f;
+            float z = 0.0f;
+            for (int index : face) {
+                x += positions.x[index];
+                y += positions.y[index];
+                z += positions.z[index];
+            }
+            const float scale = 1.0f / static_cast<float>(face.size());
+            keys[i] = (static_cast<std::uint64_t>(
+                           encode(x * scale, y * scale, z * scale))
+                       << 32) |
+                      i;
+        }
+    });
+    keys.erase(std::remove_if(keys.begin(), keys.end(),
+                              [](std::uint64_t key) {
+                                  return (key & kSkipped) != 0;
+                              }),
+               keys.end());
+    if (keys.empty()) {
+        return;
+    }
+    SortByMortonCode(keys);
+
+    order_.resize(keys.size());
+    std::vector<std::uint32_t> codes(keys.size());
+    for (std::size_t i = 0; i < keys.size(); ++i) {
+        order_[i] = static_cast<std::uint32_t>(keys[i]);
+        codes[i] = static_cast<std::uint32_t>(keys[i] >> 32);
+    }
+    keys = std::vector<std::uint64_t>();
+
+    nodes_.reserve(order_.size());
+    BuildNode(codes, 0, order_.size(), 0);
+    nodes_.shrink_to_fit();
+
+    // Leaf boxes read the scattered face vertices, so they are computed in
+    // parallel once the layout is known. Children follow their parents, so
+    // a reverse sweep then sees both children of a node before the node.
+    RunOnWorkers(nodes_.size(), threads, [&](std::size_t i) {
+        Node& leaf = nodes_[i];
+        if (leaf.count == 0) {
+            return;
+        }
+        for (int axis = 0; axis < 3; ++axis) {
+            leaf.min[axis] = std::numeric_limits<float>::max();
+            leaf.max[axis] = std::numeric_limits<float>::lowest();
+        }
+        for (std::uint32_t f = leaf.index; f < leaf.index + leaf.count; ++f) {
+            for (int v : faces[order_[f]]) {
+                const float p[3] = {positions.x[v], positions.y[v],
+                                    positions.z[v]};
+                for (int axis = 0; axis < 3; ++axis) {
+                    leaf.min[axis] = std::min(leaf.min[axis], p[axis]);
+                    leaf.max[axis] = std::max(leaf.max[axis], p[axis]);
+                }
+            }
+        }
+    });
+    for (std::size_t i = nodes_.size(); i-- > 0;) {
+        Node& node = nodes_[i];
+        if (node.count > 0) {
+            continue;
+        }
+        const Node& left = nodes_[i + 1];
+        const Node& right = nodes_[node.index];
+        for (int axis = 0; axis < 3; ++axis) {
+            node.min[axis] = std::min(left.min[axis], right.min[axis]);
+            node.max[axis] = std::max(left.max[axis], right.max[axis]);
+        }
+    }
+}
+
+// Splits where the highest differing bit of the sorted codes flips, which
+// halves the space along the next Morton axis, and in the middle when all
+// codes are equal. Boxes are filled in by Build().
+std::uint32_t FaceBvh::BuildNode(const std::vector<std::uint32_t>& codes,
+                                 std::size_t first, std::size_t last,
+                                 int depth) {
+    const auto index = static_cast<std::uint32_t>(nodes_.size());
+    nodes_.emplace_back();
+
+    if (last - first <= kFacesPerLeaf || depth >= kMaxDepth) {
+        nodes_[index].index = static_cast<std::uint32_t>(first);
+        nodes_[index].count = static_cast<std::uint32_t>(last - first);
+        return index;
+    }
+
+    std::size_t split = first + (last - first) / 2;
+    const std::uint32_t differing = codes[first] ^ codes[last - 1];
+    if (differing != 0) {
+        std::uint32_t bit = 1u << 31;
+        while ((differing & bit) == 0) {
+            bit >>= 1;
+        }
+        split = std::partition_point(codes.begin() + first,
+                                     codes.begin() + last,
+                                     [bit](std::uint32_t code) {
+                                         return (code & bit) == 0;
+                                     }) -
+                codes.begin();
+    }
+    BuildNode(codes, first, split, depth + 1);
+    const std::uint32_t right = BuildNode(codes, split, last, depth + 1);
+    nodes_[index].index = right;
+    nodes_[index].count = 0;
+    return index;
+}
+
+void FaceBvh::clear() {
+    nodes_ = std::vector<Node>();
+    order_ = std::vector<std::uint32_t>();
+}
+
+std::size_t FaceBvh::MemoryBytes() const {
+    return nodes_.capacity() * sizeof(Node) +
+           order_.capacity() * sizeof(std::uint32_t);
+}
+
+bool FaceBvh::Intersect(const PositionsSoA& positions, const FaceList& faces,
+                        const Ray& ray, FaceHit& hit) const {
+    return IntersectWith(
+        faces, ray,
+        [&positions](int index, float* xyz) {
+            xyz[0] = positions.x[index];
+            xyz[1] = positions.y[index];
+            xyz[2] = positions.z[index];
+        },
+        hit);
+}
+
+bool FaceBvh::Intersect(const QuantizedPositions& positions,
+                        const FaceList& faces, const Ray& ray,
+                        FaceHit& hit) const {
+    return IntersectWith(
+        faces, ray,
+        [&positions](int index, float* xyz) {
+            const Vertex v = positions.Decode(index);
+            xyz[0] = v.x;
+            xyz[1] = v.y;
+            xyz[2] = v.z;
+        },
+        hit);
+}
+
+template <typename LoadPosition>
+bool FaceBvh::IntersectWith(const FaceList& faces, const Ray& ray,
+                            LoadPosition load, FaceHit& hit) const {
+    if (nodes_.empty()) {
+        return false;
+    }
+
+    const float origin[3] = {ray.origin.x, ray.origin.y, ray.origin.z};
+    const float inv_dir[3] = {1.0f / ray.direction.x, 1.0f / ray.direction.y,
+                              1.0f / ray.direction.z};
+    float best = std::numeric_limits<float>::infinity();
+    // Entry parameter of the ray into the box of `node`, or infinity.
+    auto enter = [&](const Node& node) {
+        float t_near = 0.0f;
+        float t_far = best;
+        for (int axis = 0; axis < 3; ++axis) {
+            float t0 = (node.min[axis] - origin[axis]) * inv_dir[axis];
+            float t1 = (node.max[axis] - origin[axis]) * inv_dir[axis];
+            if (t0 > t1) {
+                std::swap(t0, t1);
+            }
+            t_near = std::max(t_near, t0);
+            t_far = std::min(t_far, t1);
+        }
+        return t_near <= t_far ? t_near
+                               : std::numeric_limits<float>::infinity();
+    };
+
+    bool found = false;
+    std::uint32_t stack[kMaxDepth + 1];
+    int depth = 0;
+    if (enter(nodes_[0]) < best) {
+        stack[depth++] = 0;
+    }
+    while (depth > 0) {
+        const std::uint32_t index = stack[--depth];
+        const Node& node = nodes_[index];
+        if (node.count > 0) {
+            for (std::uint32_t i = node.index; i < node.index + node.count;
+                 ++i) {
+                const FaceView face = faces[order_[i]];
+                float a[3];
+                float b[3];
+                float c[3];
+                load(face[0], a);
+                load(face[1], c);
+                for (std::size_t k = 1; k + 1 < face.size(); ++k) {
+                    std::copy(c, c + 3, b);
+                    load(face[k + 1], c);
+                    float t;
+                    if (IntersectTriangle(ray, a, b, c, t) && t < best) {
+                        best = t;
+                        hit.face = order_[i];
+                        found = true;
+                    }
+                }
+            }
+            continue;
+        }
+
+        // Visit the nearer child first; boxes beyond the best hit are
+        // skipped.
+        std::uint32_t near_child = index + 1;
+        std::uint32_t far_child = node.index;
+        float near_t = enter(nodes_[near_child]);
+        float far_t = enter(nodes_[far_child]);
+        if (far_t < near_t) {
+            std::swap(near_child, far_child);
+            std::swap(near_t, far_t);
+        }
+        if (far_t < best) {
+            stack[depth++] = far_child;
+        }
+        if (near_t < best) {
+            stack[depth++] = near_child;
+        }
+    }
+
+    if (found) {
+        hit.t = best;
+        hit.point = {ray.origin.x + best * ray.direction.x,
+                     ray.origin.y + best * ray.direction.y,
+                     ray.origin.z + best * ray.direction.z};
+    }
+    return found;
+}
+
+}  // namespace viewer3d
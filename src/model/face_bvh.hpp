@@ -0,0 +1,78 @@
+#ifndef FACE_BVH_H
+#define FACE_BVH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "model/bounds.hpp"
+#include "model/face_list.hpp"
+#include "model/transform_kernel.hpp"
+#include "model/vertex.hpp"
+
+namespace viewer3d {
+
+// Points at origin + t * direction for t >= 0. The direction need not be
+// normalized.
+struct Ray {
+    Vertex origin;
+    Vertex direction;
+};
+
+struct FaceHit {
+    std::size_t face{0};
+    // Ray parameter of the hit, in units of the ray direction.
+    float t{0.0f};
+    Vertex point;
+};
+
+// Bounding volume hierarchy over the faces of a model for ray queries.
+// Faces are ordered along a Morton curve of their centroids and split where
+// the codes first differ, so the tree follows the spatial layout without a
+// cost model. Polygons are tested as triangle fans; faces with fewer than
+// three vertices or invalid indices are left out. The hierarchy keeps only
+// face indices, so the positions and faces must outlive it unchanged.
+class FaceBvh {
+   public:
+    // `bounds` encloses the positions. threads == 0 means one per hardware
+    // thread.
+    void Build(const PositionsSoA& positions, const FaceList& faces,
+               const Bounds& bounds, unsigned threads = 0);
+    void clear();
+
+    bool empty() const { return nodes_.empty(); }
+    std::size_t NodeCount() const { return nodes_.size(); }
+    std::size_t MemoryBytes() const;
+
+    // Finds the nearest face hit by `ray`, in the space of `positions`.
+    bool Intersect(const PositionsSoA& positions, const FaceList& faces,
+                   const Ray& ray, FaceHit& hit) const;
+    // Same for quantized positions, in their decoded space. The hierarchy
+    // must have been built from the decoded positions.
+    bool Intersect(const QuantizedPositions& positions, const FaceList& faces,
+                   const Ray& ray, FaceHit& hit) const;
+
+   private:
+    // An inner node's left child follows it; `index` is its right child.
+    // A leaf holds order_[index, index + count).
+    struct Node {
+        float min[3];
+        float max[3];
+        std::uint32_t index;
+        std::uint32_t count;
+    };
+
+    // `load(index, xyz)` writes the position of vertex `index` to xyz.
+    template <typename LoadPosition>
+    bool IntersectWith(const FaceList& faces, const Ray& ray,
+                       LoadPosition load, FaceHit& hit) const;
+    std::uint32_t BuildNode(const std::vector<std::uint32_t>& codes,
+                            std::size_t first, std::size_t last, int depth);
+
+    std::vector<Node> nodes_;
+    std::vector<std::uint32_t> order_;
+};
+
+}  // namespace viewer3d
+
+#endif
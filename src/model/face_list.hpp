@@ -0,0 +1,123 @@
+#ifndef FACE_LIST_H
+#define FACE_LIST_H
+
+#include <cstddef>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+namespace viewer3d {
+
+// Non-owning view of the vertex indices of one face.
+class FaceView {
+   public:
+    FaceView() = default;
+    FaceView(const int* indices, std::size_t size)
+        : indices_(indices), size_(size) {}
+
+    const int* begin() const { return indices_; }
+    const int* end() const { return indices_ + size_; }
+    std::size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    int operator[](std::size_t i) const { return indices_[i]; }
+
+   private:
+    const int* indices_{nullptr};
+    std::size_t size_{0};
+};
+
+// All faces of a model in compressed sparse row layout: the indices of face
+// i are indices_[offsets_[i]] .. indices_[offsets_[i + 1] - 1].
+class FaceList {
+   public:
+    class Iterator {
+       public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = FaceView;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = FaceView;
+
+        Iterator(const FaceList* list, std::size_t face)
+            : list_(list), face_(face) {}
+
+        FaceView operator*() const { return (*list_)[face_]; }
+        Iterator& operator++() {
+            ++face_;
+            return *this;
+        }
+        Iterator operator++(int) {
+            Iterator copy = *this;
+            ++face_;
+            return copy;
+        }
+        bool operator==(const Iterator& other) const {
+            return face_ == other.face_;
+        }
+        bool operator!=(const Iterator& other) const {
+            return face_ != other.face_;
+        }
+
+       private:
+        const FaceList* list_;
+        std::size_t face_;
+    };
+
+    FaceList() : offsets_{0} {}
+
+    std::size_t size() const { return offsets_.size() - 1; }
+    bool empty() const { return offsets_.size() == 1; }
+
+    FaceView operator[](std::size_t i) const {
+        return FaceView(indices_.data() + offsets_[i],
+                        offsets_[i + 1] - offsets_[i]);
+    }
+
+    Iterator begin() const { return Iterator(this, 0); }
+    Iterator end() const { return Iterator(this, size()); }
+
+    template <typename InputIt>
+    void AddFace(InputIt first, InputIt last) {
+        indices_.insert(indices_.end(), first, last);
+        offsets_.push_back(indices_.size());
+    }
+
+    void Append(const FaceList& other) {
+        const std::size_t base = indices_.size();
+        indices_.insert(indices_.end(), other.indices_.begin(),
+                        other.indices_.end());
+        offsets_.reserve(offsets_.size() + other.size());
+        for (std::size_t i = 1; i < other.offsets_.size(); ++i) {
+            offsets_.push_back(base + other.offsets_[i]);
+        }
+    }
+
+    // Takes prebuilt CSR arrays: offsets must start at 0, never decrease and
+    // end at indices.size().
+    void Assign(std::vector<int> indices, std::vector<std::size_t> offsets) {
+        indices_ = std::move(indices);
+        offsets_ = std::move(offsets);
+    }
+
+    void reserve(std::size_t faces, std::size_t indices) {
+        offsets_.reserve(faces + 1);
+        indices_.reserve(indices);
+    }
+
+    void clear() {
+        indices_.clear();
+        offsets_.assign(1, 0);
+    }
+
+    const std::vector<int>& Indices() const { return indices_; }
+    const std::vector<std::size_t>& Offsets() const { return offsets_; }
+    std::size_t IndexCount() const { return indices_.size(); }
+
+   private:
+    std::vector<int> indices_;
+    std::vector<std::size_t> offsets_;
+};
+
+}  // namespace viewer3d
+
+#endif
@@ -0,0 +1,116 @@
+#include "model/frame_stats.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+
+namespace viewer3d {
+
+namespace {
+
+double NearestRank(std::vector<double>& values, double percent) {
+    if (values.empty()) {
+        return 0.0;
+    }
+    const double clamped = std::clamp(percent, 0.0, 100.0);
+    std::size_t rank = static_cast<std::size_t>(
+        std::ceil(clamped / 100.0 * static_cast<double>(values.size())));
+    rank = std::max<std::size_t>(rank, 1);
+    std::nth_element(values.begin(), values.begin() + (rank - 1),
+                     values.end());
+    return values[rank - 1];
+}
+
+}  // namespace
+
+FrameStats::FrameStats(std::size_t window)
+    : window_(std::max<std::size_t>(window, 1)) {
+    samples_.reserve(window_);
+}
+
+void FrameStats::Add(const FrameSample& sample) {
+    if (samples_.size() < window_) {
+        samples_.push_back(sample);
+    } else {
+        samples_[next_] = sample;
+        next_ = (next_ + 1) % window_;
+    }
+    frame_count_++;
+
+    if (!csv_.is_open()) {
+        return;
+    }
+    char gpu[32] = "";
+    if (sample.gpu_ms >= 0.0) {
+        std::snprintf(gpu, sizeof(gpu), "%.4f", sample.gpu_ms);
+    }
+    char row[160];
+    std::snprintf(row, sizeof(row), "%llu,%.4f,%s,%llu,%llu,%llu,%llu\n",
+                  static_cast<unsigned long long>(frame_count_),
+                  sample.cpu_ms, gpu,
+                  static_cast<unsigned long long>(sample.draw_calls),
+                  static_cast<unsigned long long>(sample.vertices),
+                  static_cast<unsigned long long>(sample.lines),
+                  static_cast<unsigned long long>(sample.culled_lines));
+    csv_ << row;
+    if (!csv_) {
+        std::cerr << "Error: cannot write the frame log " << csv_filename_
+                  << std::endl;
+        csv_.close();
+    }
+}
+
+void FrameStats::Clear() {
+    samples_.clear();
+    next_ = 0;
+}
+
+const FrameSample& FrameStats::Last() const {
+    if (samples_.size() < window_ || next_ == 0) {
+        return samples_.back();
+    }
+    return samples_[next_ - 1];
+}
+
+double FrameStats::CpuPercentile(double percent) const {
+    std::vector<double> values;
+    values.reserve(samples_.size());
+    for (const FrameSample& sample : samples_) {
+        values.push_back(sample.cpu_ms);
+    }
+    return NearestRank(values, percent);
+}
+
+double FrameStats::GpuPercentile(double percent) const {
+    std::vector<double> values;
+    values.reserve(samples_.size());
+    for (const FrameSample& sample : samples_) {
+        if (sample.gpu_ms >= 0.0) {
+            values.push_back(sample.gpu_ms);
+        }
+    }
+    return values.empty() ? -1.0 : NearestRank(values, percent);
+}
+
+bool FrameStats::StartCsvLog(const std::string& filename) {
+    StopCsvLog();
+    csv_.open(filename, std::ios::trunc);
+    csv_ << "frame,cpu_ms,gpu_ms,draw_calls,vertices,lines,culled_lines\n";
+    if (!csv_) {
+        std::cerr << "Error: cannot write the frame log " << filename
+                  << std::endl;
+        csv_.close();
+        return false;
+    }
+    csv_filename_ = filename;
+    return true;
+}
+
+void FrameStats::StopCsvLog() {
+    if (csv_.is_open()) {
+        csv_.close();
+    }
+}
+
+}  // namespace viewer3d
@@ -0,0 +1,69 @@
+#ifndef FRAME_STATS_H
+#define FRAME_STATS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace viewer3d {
+
+// What one rendered frame cost and submitted.
+struct FrameSample {
+    double cpu_ms = 0.0;
+    // Negative when the GPU time is unknown, e.g. without timer queries.
+    double gpu_ms = -1.0;
+    std::uint64_t draw_calls = 0;
+    std::uint64_t vertices = 0;
+    std::uint64_t lines = 0;
+    // Lines outside the view frustum that were not submitted.
+    std::uint64_t culled_lines = 0;
+};
+
+// Rolling statistics over the most recent frames, optionally logging every
+// frame to a CSV file.
+class FrameStats {
+   public:
+    static constexpr std::size_t kDefaultWindow = 240;
+
+    explicit FrameStats(std::size_t window = kDefaultWindow);
+
+    void Add(const FrameSample& sample);
+    // Forgets the window; the CSV log and the frame numbering continue.
+    void Clear();
+
+    // Frames in the window, at most the window size.
+    std::size_t size() const { return samples_.size(); }
+    bool empty() const { return samples_.empty(); }
+    std::size_t window() const { return window_; }
+    // Frames added since construction.
+    std::uint64_t FrameCount() const { return frame_count_; }
+    // The most recent frame; the window must not be empty.
+    const FrameSample& Last() const;
+
+    // Nearest-rank percentile (0-100) of the frames in the window, 0 when it
+    // is empty.
+    double CpuPercentile(double percent) const;
+    // Same over the frames with a GPU time, negative when there are none.
+    double GpuPercentile(double percent) const;
+
+    // Writes a header and then one row per added frame; a previous log is
+    // closed first.
+    bool StartCsvLog(const std::string& filename);
+    void StopCsvLog();
+    bool IsLogging() const { return csv_.is_open(); }
+
+   private:
+    std::size_t window_;
+    std::vector<FrameSample> samples_;
+    // Index of the oldest sample once the window is full.
+    std::size_t next_ = 0;
+    std::uint64_t frame_count_ = 0;
+    std::ofstream csv_;
+    std::string csv_filename_;
+};
+
+}  // namespace viewer3d
+
+#endif
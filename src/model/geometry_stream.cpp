@@ -0,0 +1,44 @@
+#include "model/geometry_stream.hpp"
+
+#include <algorithm>
+#include <utility>
+
+namespace viewer3d {
+
+namespace {
+
+Edge MakeEdge(int a, int b) { return {std::min(a, b), std::max(a, b)}; }
+
+}  // namespace
+
+void GeometryStream::Append(const std::vector<Vertex>& vertices,
+                            const FaceList& faces) {
+    auto batch = std::make_shared<Batch>();
+    batch->vertices = vertices;
+    std::vector<Edge>& edges = batch->edges;
+    edges.reserve(faces.IndexCount());
+    for (FaceView face : faces) {
+        if (face.size() == 2) {
+            edges.push_back(MakeEdge(face[0], face[1]));
+        } else if (face.size() >= 3) {
+            for (std::size_t i = 0; i < face.size(); ++i) {
+                edges.push_back(
+                    MakeEdge(face[i], face[(i + 1) % face.size()]));
+            }
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    batches_.push_back(std::move(batch));
+    revision_++;
+}
+
+void GeometryStream::ReadNewBatches(BatchList& batches) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (batches.size() < batches_.size()) {
+        batches.insert(batches.end(), batches_.begin() + batches.size(),
+                       batches_.end());
+    }
+}
+
+}  // namespace viewer3d
@@ -0,0 +1,49 @@
+#ifndef GEOMETRY_STREAM_H
+#define GEOMETRY_STREAM_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "model/edge_list.hpp"
+#include "model/face_list.hpp"
+#include "model/vertex.hpp"
+
+namespace viewer3d {
+
+// Geometry published by a streaming load while it is still running, for
+// preview rendering. The loading thread appends batches, the render thread
+// reads them. Edges are the face sides in file order and are not
+// deduplicated.
+class GeometryStream {
+   public:
+    // What one Append call added. Edge indices count the vertices of all
+    // earlier batches. Batches never change once appended, so they are read
+    // without the lock.
+    struct Batch {
+        std::vector<Vertex> vertices;
+        std::vector<Edge> edges;
+    };
+    using BatchList = std::vector<std::shared_ptr<const Batch>>;
+
+    void Append(const std::vector<Vertex>& vertices, const FaceList& faces);
+
+    // Adds the batches appended after the first batches.size() ones to
+    // `batches`. Only the pointers are copied under the lock, so uploading
+    // or drawing the geometry never holds up Append.
+    void ReadNewBatches(BatchList& batches) const;
+
+    // Number of Append calls so far.
+    std::uint64_t Revision() const { return revision_.load(); }
+
+   private:
+    mutable std::mutex mutex_;
+    BatchList batches_;
+    std::atomic<std::uint64_t> revision_{0};
+};
+
+}  // namespace viewer3d
+
+#endif
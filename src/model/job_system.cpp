@@ -0,0 +1,149 @@
+#include "model/job_system.hpp"
+
+#include <algorithm>
+
+namespace viewer3d {
+
+namespace {
+
+std::atomic<JobSystem*> g_installed{nullptr};
+
+}  // namespace
+
+JobSystem::JobSystem(unsigned worker_count) {
+    for (unsigned i = 0; i < worker_count; ++i) {
+        queues_.push_back(std::make_unique<Queue>());
+    }
+    workers_.reserve(worker_count);
+    for (unsigned i = 0; i < worker_count; ++i) {
+        workers_.emplace_back([this, i]() { WorkerLoop(i); });
+    }
+}
+
+JobSystem::~JobSystem() {
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+}
+
+unsigned JobSystem::DefaultWorkerCount() {
+    const unsigned hardware = std::thread::hardware_concurrency();
+    return hardware > 1 ? hardware - 1 : 1u;
+}
+
+JobSystem::Scope::Scope(JobSystem& jobs)
+    : previous_(g_installed.exchange(&jobs, std::memory_order_acq_rel)) {}
+
+JobSystem::Scope::~Scope() {
+    g_installed.store(previous_, std::memory_order_release);
+}
+
+JobSystem& JobSystem::Current() {
+    if (JobSystem* installed = g_installed.load(std::memory_order_acquire)) {
+        return *installed;
+    }
+    static JobSystem fallback;
+    return fallback;
+}
+
+void JobSystem::Execute(const std::shared_ptr<Batch>& batch,
+                        unsigned helpers) {
+    helpers = std::min(helpers, WorkerCount());
+    if (helpers > 0) {
+        // Spread the invitations so that idle workers pick them up from
+        // their own queues before they need to steal.
+        const std::size_t first = next_queue_.fetch_add(helpers);
+        for (unsigned i = 0; i < helpers; ++i) {
+            Queue& queue = *queues_[(first + i) % queues_.size()];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            queue.batches.push_back(batch);
+        }
+        {
+            std::lock_guard<std::mutex> lock(wake_mutex_);
+            queued_ += helpers;
+        }
+        if (helpers == 1) {
+            wake_.notify_one();
+        } else {
+            wake_.notify_all();
+        }
+    }
+
+    Work(*batch);
+    std::unique_lock<std::mutex> lock(batch->mutex);
+    batch->done.wait(lock, [&batch]() {
+        return batch->finished.load() == batch->count;
+    });
+    if (batch->error) {
+        std::rethrow_exception(batch->error);
+    }
+}
+
+// An exception escaping a worker thread would terminate the process, so it
+// is kept in the batch for Execute() to rethrow.
+void JobSystem::Work(Batch& batch) {
+    for (std::size_t i = batch.next++; i < batch.count; i = batch.next++) {
+        if (!batch.failed.load(std::memory_order_relaxed)) {
+            try {
+                batch.invoke(batch.task, i);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(batch.mutex);
+                if (!batch.error) {
+                    batch.error = std::current_exception();
+                }
+                batch.failed = true;
+            }
+        }
+        if (++batch.finished == batch.count) {
+            std::lock_guard<std::mutex> lock(batch.mutex);
+            batch.done.notify_all();
+        }
+    }
+}
+
+// Own queue first, oldest invitation first; others from the back.
+std::shared_ptr<JobSystem::Batch> JobSystem::Take(std::size_t index) {
+    for (std::size_t k = 0; k < queues_.size(); ++k) {
+        Queue& queue = *queues_[(index + k) % queues_.size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.batches.empty()) {
+            continue;
+        }
+        std::shared_ptr<Batch> batch;
+        if (k == 0) {
+            batch = std::move(queue.batches.front());
+            queue.batches.pop_front();
+        } else {
+            batch = std::move(queue.batches.back());
+            queue.batches.pop_back();
+        }
+        return batch;
+    }
+    return nullptr;
+}
+
+void JobSystem::WorkerLoop(std::size_t index) {
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(wake_mutex_);
+            wake_.wait(lock, [this]() { return stopping_ || queued_ > 0; });
+            if (stopping_) {
+                return;
+            }
+            --queued_;
+        }
+        // The count reserved one invitation, which is in some queue by now.
+        std::shared_ptr<Batch> batch;
+        while (!(batch = Take(index))) {
+            std::this_thread::yield();
+        }
+        Work(*batch);
+    }
+}
+
+}  // namespace viewer3d
@@ -0,0 +1,111 @@
+#ifndef JOB_SYSTEM_H
+#define JOB_SYSTEM_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace viewer3d {
+
+// Persistent worker threads shared by every parallel pass, so a pass costs
+// queue operations rather than thread starts. The application owns one and
+// installs it with a JobSystem::Scope for its lifetime. Each worker has its
+// own queue and steals from the others when it runs dry. A batch of tasks
+// is also worked on by the thread that submits it, which claims whatever
+// the workers have not, so nested batches and batches submitted from
+// several threads at once cannot deadlock.
+class JobSystem {
+   public:
+    // Without workers every batch runs on the thread that submits it.
+    explicit JobSystem(unsigned worker_count = DefaultWorkerCount());
+    ~JobSystem();
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    // Makes `jobs` the instance parallel passes run on until destruction,
+    // when the previous one is restored. Install it before the first pass
+    // and keep `jobs` alive as long as the scope.
+    class Scope {
+       public:
+        explicit Scope(JobSystem& jobs);
+        ~Scope();
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+       private:
+        JobSystem* previous_;
+    };
+
+    // The installed instance. Without one, such as in tests, a default
+    // instance is started on first use.
+    static JobSystem& Current();
+
+    // One per hardware thread besides the caller, and at least one.
+    static unsigned DefaultWorkerCount();
+
+    unsigned WorkerCount() const {
+        return static_cast<unsigned>(workers_.size());
+    }
+
+    // Runs task(i) for every i in [0, count) on the calling thread and up
+    // to `helpers` workers, and returns once all have finished. The first
+    // exception a task throws is rethrown here, on the calling thread; the
+    // tasks not started by then are skipped.
+    template <typename Task>
+    void Run(std::size_t count, unsigned helpers, Task& task) {
+        auto batch = std::make_shared<Batch>();
+        batch->count = count;
+        batch->task = &task;
+        batch->invoke = [](void* task, std::size_t i) {
+            (*static_cast<Task*>(task))(i);
+        };
+        Execute(batch, helpers);
+    }
+
+   private:
+    struct Batch {
+        std::size_t count{0};
+        void* task{nullptr};
+        void (*invoke)(void* task, std::size_t i){nullptr};
+        std::atomic<std::size_t> next{0};
+        std::atomic<std::size_t> finished{0};
+        std::atomic<bool> failed{false};
+        // The first exception of a task, guarded by `mutex`.
+        std::exception_ptr error;
+        std::mutex mutex;
+        std::condition_variable done;
+    };
+
+    // Invitations for a worker to join a batch; they are stale once every
+    // task of the batch has been claimed.
+    struct Queue {
+        std::mutex mutex;
+        std::deque<std::shared_ptr<Batch>> batches;
+    };
+
+    void Execute(const std::shared_ptr<Batch>& batch, unsigned helpers);
+    static void Work(Batch& batch);
+    void WorkerLoop(std::size_t index);
+    std::shared_ptr<Batch> Take(std::size_t index);
+
+    std::vector<std::unique_ptr<Queue>> queues_;
+    std::vector<std::thread> workers_;
+    std::atomic<std::size_t> next_queue_{0};
+
+    std::mutex wake_mutex_;
+    std::condition_variable wake_;
+    std::size_t queued_{0};
+    bool stopping_{false};
+};
+
+}  // namespace viewer3d
+
+#endif
@@ -0,0 +1,129 @@
+#include "model/lod_chain.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+#include "model/trace.hpp"
+
+namespace viewer3d {
+
+namespace {
+
+double MsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(
+               std::chrono::steady_clock::now() - start)
+        .count();
+}
+
+FaceList ToFaceList(const std::vector<std::array<int, 3>>& triangles) {
+    std::vector<int> indices;
+    indices.reserve(triangles.size() * 3);
+    std::vector<std::size_t> offsets;
+    offsets.reserve(triangles.size() + 1);
+    offsets.push_back(0);
+    for (const std::array<int, 3>& triangle : triangles) {
+        indices.insert(indices.end(), triangle.begin(), triangle.end());
+        offsets.push_back(indices.size());
+    }
+    FaceList faces;
+    faces.Assign(std::move(indices), std::move(offsets));
+    return faces;
+}
+
+}  // namespace
+
+bool LodChain::Build(TriangleMesh mesh, const LodOptions& options,
+                     const std::atomic<bool>* cancel) {
+    VIEWER3D_TRACE_ZONE("LodChain::Build");
+    const auto start = std::chrono::steady_clock::now();
+    levels_.clear();
+    build_ms_ = 0.0;
+    peak_build_bytes_ = mesh.vertices.capacity() * sizeof(Vertex) +
+                        mesh.triangles.capacity() * sizeof(mesh.triangles[0]);
+
+    SimplifyOptions simplify;
+    simplify.threads = options.threads;
+    simplify.cancel = cancel;
+
+    const std::size_t source_triangles = mesh.triangles.size();
+    for (double ratio : options.ratios) {
+        const auto target = static_cast<std::size_t>(
+            ratio * static_cast<double>(source_triangles));
+        const std::size_t previous = levels_.empty()
+                                         ? source_triangles
+                                         : levels_.back().triangle_count;
+        if (target < options.min_triangles) {
+            break;
+        }
+        if (target >= previous) {
+            continue;
+        }
+
+        const auto level_start = std::chrono::steady_clock::now();
+        SimplifyStats stats;
+        if (!SimplifyMesh(mesh, target, simplify, &stats)) {
+            return false;
+        }
+        // The simplifier ran out of cheap collapses; coarser levels would
+        // not get any smaller either.
+        if (mesh.triangles.size() >= previous) {
+            break;
+        }
+        peak_build_bytes_ =
+            std::max(peak_build_bytes_, MemoryBytes() + stats.peak_bytes);
+
+        LodLevel level;
+        level.ratio = ratio;
+        level.vertices = mesh.vertices;
+        level.edges.Build(ToFaceList(mesh.triangles), options.threads);
+        level.triangle_count = mesh.triangles.size();
+        level.build_ms = MsSince(level_start);
+        levels_.push_back(std::move(level));
+
+        if (cancel != nullptr && cancel->load()) {
+            return false;
+        }
+    }
+    build_ms_ = MsSince(start);
+    return true;
+}
+
+std::size_t LodChain::MemoryBytes() const {
+    std::size_t bytes = 0;
+    for (const LodLevel& level : levels_) {
+        bytes += level.vertices.capacity() * sizeof(Vertex) +
+                 level.edges.Edges().capacity() * sizeof(Edge);
+    }
+    return bytes;
+}
+
+std::size_t SelectLod(const std::vector<std::size_t>& edge_counts,
+                      double projected_pixels, std::size_t current,
+                      double edges_per_pixel, double hysteresis) {
+    if (edge_counts.empty()) {
+        return 0;
+    }
+    current = std::min(current, edge_counts.size() - 1);
+    const double budget = edges_per_pixel * projected_pixels;
+
+    // The most detailed level within `limit`, or the coarsest one.
+    auto finest_within = [&edge_counts](double limit) {
+        for (std::size_t i = 0; i < edge_counts.size(); ++i) {
+            if (static_cast<double>(edge_counts[i]) <= limit) {
+                return i;
+            }
+        }
+        return edge_counts.size() - 1;
+    };
+
+    if (static_cast<double>(edge_counts[current]) > budget * hysteresis) {
+        return finest_within(budget);
+    }
+    if (current > 0 &&
+        static_cast<double>(edge_counts[current - 1]) * hysteresis <= budget) {
+        return finest_within(budget / hysteresis);
+    }
+    return current;
+}
+
+}  // namespace viewer3d
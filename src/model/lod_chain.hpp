@@ -0,0 +1,79 @@
+#ifndef LOD_CHAIN_H
+#define LOD_CHAIN_H
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+#include "model/edge_list.hpp"
+#include "model/mesh_simplifier.hpp"
+#include "model/vertex.hpp"
+
+namespace viewer3d {
+
+// Edges drawn per pixel of the model's projected area before a coarser
+// level is preferred, and how far past that a level must move before the
+// choice changes again.
+constexpr double kLodEdgesPerPixel = 1.0;
+constexpr double kLodHysteresis = 1.5;
+
+struct LodOptions {
+    bool enabled{false};
+    // Triangle count of each level relative to the triangulated model, from
+    // the finest to the coarsest.
+    std::vector<double> ratios{0.5, 0.25, 0.1, 0.02};
+    // Levels with fewer triangles are not built, so small models have none.
+    std::size_t min_triangles{20000};
+    // 0 means one per hardware thread.
+    unsigned threads{0};
+};
+
+// A simplified copy of the model, in the same space as its source
+// positions. Polygons are triangulated, so the wireframe shows triangles.
+struct LodLevel {
+    double ratio{1.0};
+    std::vector<Vertex> vertices;
+    EdgeList edges;
+    std::size_t triangle_count{0};
+    double build_ms{0.0};
+};
+
+// Successively coarser levels of detail of one model.
+class LodChain {
+   public:
+    // Simplifies `mesh` to each ratio in turn, every level starting from
+    // the previous one. Stops early when a level would be below
+    // min_triangles or no smaller than the previous one. Returns false when
+    // cancelled.
+    bool Build(TriangleMesh mesh, const LodOptions& options,
+               const std::atomic<bool>* cancel = nullptr);
+
+    std::size_t size() const { return levels_.size(); }
+    bool empty() const { return levels_.empty(); }
+    const LodLevel& operator[](std::size_t i) const { return levels_[i]; }
+
+    double BuildMs() const { return build_ms_; }
+    // Memory held by the levels.
+    std::size_t MemoryBytes() const;
+    // Largest memory use while building, the levels included.
+    std::size_t PeakBuildBytes() const { return peak_build_bytes_; }
+
+   private:
+    std::vector<LodLevel> levels_;
+    double build_ms_{0.0};
+    std::size_t peak_build_bytes_{0};
+};
+
+// Picks the level to draw for a model covering `projected_pixels`.
+// edge_counts[0] is the full model and later entries are ever coarser
+// levels; the result indexes edge_counts. Levels change only once the edge
+// budget is exceeded, or undercut, by a factor of `hysteresis`, so small
+// zoom changes around a threshold do not switch back and forth.
+std::size_t SelectLod(const std::vector<std::size_t>& edge_counts,
+                      double projected_pixels, std::size_t current,
+                      double edges_per_pixel = kLodEdgesPerPixel,
+                      double hysteresis = kLodHysteresis);
+
+}  // namespace viewer3d
+
+#endif
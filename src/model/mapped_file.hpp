@@ -0,0 +1,37 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace viewer3d {
+
+// Read-only view of a whole file. Uses mmap where available and falls back
+// to reading the file into memory otherwise.
+class MappedFile {
+   public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool Open(const std::string& filename);
+    void Close();
+
+    bool IsOpen() const { return open_; }
+    const char* Data() const { return data_; }
+    std::size_t Size() const { return size_; }
+
+   private:
+    const char* data_{nullptr};
+    std::size_t size_{0};
+    bool open_{false};
+    bool mapped_{false};
+    std::vector<char> buffer_;
+};
+
+}  // namespace viewer3d
+
+#endif
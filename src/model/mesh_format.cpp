@@ -0,0 +1,72 @@
+#include "model/mesh_format.hpp"
+
+#include <cstring>
+#include <fstream>
+
+namespace viewer3d {
+
+namespace {
+constexpr std::uint64_t kStlHeaderBytes = 80;
+constexpr std::uint64_t kStlTriangleBytes = 50;
+
+bool IsSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\v' ||
+           c == '\f';
+}
+
+bool StartsWithWord(const char* p, const char* end, const char* word) {
+    const std::size_t length = std::strlen(word);
+    return static_cast<std::size_t>(end - p) > length &&
+           std::memcmp(p, word, length) == 0 && IsSpace(p[length]);
+}
+}  // namespace
+
+MeshFormat DetectMeshFormat(const char* head, std::size_t head_size,
+                            std::uint64_t file_size) {
+    const char* const end = head + head_size;
+    if (StartsWithWord(head, end, "ply")) {
+        return MeshFormat::kPly;
+    }
+
+    if (IsBinaryStl(head, head_size, file_size)) {
+        return MeshFormat::kStl;
+    }
+
+    const char* p = head;
+    while (p < end && IsSpace(*p)) {
+        ++p;
+    }
+    if (StartsWithWord(p, end, "solid")) {
+        return MeshFormat::kStl;
+    }
+    return MeshFormat::kObj;
+}
+
+bool IsBinaryStl(const char* head, std::size_t head_size,
+                 std::uint64_t file_size) {
+    if (head_size < kMeshFormatHeadBytes) {
+        return false;
+    }
+    const auto* bytes =
+        reinterpret_cast<const unsigned char*>(head + kStlHeaderBytes);
+    const std::uint64_t triangles =
+        std::uint64_t{bytes[0]} | std::uint64_t{bytes[1]} << 8 |
+        std::uint64_t{bytes[2]} << 16 | std::uint64_t{bytes[3]} << 24;
+    return file_size == kMeshFormatHeadBytes + triangles * kStlTriangleBytes;
+}
+
+MeshFormat DetectMeshFormat(const std::string& filename) {
+    std::ifstream file(filename, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) {
+        return MeshFormat::kObj;
+    }
+    const std::uint64_t file_size = static_cast<std::uint64_t>(file.tellg());
+    file.seekg(0, std::ios::beg);
+
+    char head[kMeshFormatHeadBytes];
+    file.read(head, sizeof(head));
+    return DetectMeshFormat(head, static_cast<std::size_t>(file.gcount()),
+                            file_size);
+}
+
+}  // namespace viewer3d
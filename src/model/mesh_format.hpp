@@ -0,0 +1,32 @@
+#ifndef MESH_FORMAT_H
+#define MESH_FORMAT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace viewer3d {
+
+enum class MeshFormat { kObj, kPly, kStl };
+
+// Bytes DetectMeshFormat() looks at: the 80-byte header and the triangle
+// count of a binary STL file.
+constexpr std::size_t kMeshFormatHeadBytes = 84;
+
+// Recognizes PLY by its "ply" magic line, binary STL by a triangle count
+// that matches the file size (its header is free-form and often starts
+// with "solid"), and ASCII STL by its "solid" keyword. Anything else is
+// read as OBJ, which has no signature.
+MeshFormat DetectMeshFormat(const char* head, std::size_t head_size,
+                            std::uint64_t file_size);
+// True when the head holds a binary STL triangle count that matches
+// `file_size`, whatever the header text says.
+bool IsBinaryStl(const char* head, std::size_t head_size,
+                 std::uint64_t file_size);
+// Reads the head of `filename`; unreadable files are reported as kObj and
+// fail later in the OBJ parser.
+MeshFormat DetectMeshFormat(const std::string& filename);
+
+}  // namespace viewer3d
+
+#endif
@@ -0,0 +1,590 @@
+#include "model/mesh_simplifier.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <utility>
+
+#include "model/parallel.hpp"
+#include "model/trace.hpp"
+
+namespace viewer3d {
+
+namespace {
+
+// Setup passes split their elements into chunks of this size.
+constexpr std::size_t kChunkSize = 1 << 16;
+// The triangle arrays are compacted and the references rebuilt every this
+// many iterations.
+constexpr int kCompactInterval = 5;
+// Base of the per-iteration error threshold, for a mesh scaled to a unit
+// bounding box diagonal.
+constexpr double kThresholdScale = 1e-9;
+// A collapse is rejected when it leaves a triangle this close to a line,
+// or turns its normal further than acos(kMinNormalDot).
+constexpr double kMaxEdgeDot = 0.999;
+constexpr double kMinNormalDot = 0.2;
+// Optimal positions further than this many edge lengths from the edge are
+// numerically unreliable, so an endpoint or the midpoint is used instead.
+constexpr double kMaxOptimalDistance = 2.0;
+
+struct Vec3 {
+    double x{0.0};
+    double y{0.0};
+    double z{0.0};
+};
+
+Vec3 operator+(const Vec3& a, const Vec3& b) {
+    return {a.x + b.x, a.y + b.y, a.z + b.z};
+}
+Vec3 operator-(const Vec3& a, const Vec3& b) {
+    return {a.x - b.x, a.y - b.y, a.z - b.z};
+}
+Vec3 operator*(const Vec3& a, double s) { return {a.x * s, a.y * s, a.z * s}; }
+double Dot(const Vec3& a, const Vec3& b) {
+    return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+Vec3 Cross(const Vec3& a, const Vec3& b) {
+    return {a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z,
+            a.x * b.y - a.y * b.x};
+}
+Vec3 Normalized(const Vec3& a) {
+    const double length = std::sqrt(Dot(a, a));
+    return length > 0.0 ? a * (1.0 / length) : Vec3{};
+}
+
+// Symmetric 4x4 matrix summing the squared distances to a set of planes,
+// stored as its upper triangle.
+struct Quadric {
+    double m[10]{};
+
+    static Quadric Plane(double a, double b, double c, double d) {
+        Quadric q;
+        q.m[0] = a * a;
+        q.m[1] = a * b;
+        q.m[2] = a * c;
+        q.m[3] = a * d;
+        q.m[4] = b * b;
+        q.m[5] = b * c;
+        q.m[6] = b * d;
+        q.m[7] = c * c;
+        q.m[8] = c * d;
+        q.m[9] = d * d;
+        return q;
+    }
+
+    Quadric& operator+=(const Quadric& other) {
+        for (int i = 0; i < 10; ++i) {
+            m[i] += other.m[i];
+        }
+        return *this;
+    }
+
+    double Det(int a11, int a12, int a13, int a21, int a22, int a23, int a31,
+               int a32, int a33) const {
+        return m[a11] * m[a22] * m[a33] + m[a13] * m[a21] * m[a32] +
+               m[a12] * m[a23] * m[a31] - m[a13] * m[a22] * m[a31] -
+               m[a11] * m[a23] * m[a32] - m[a12] * m[a21] * m[a33];
+    }
+
+    double Error(const Vec3& p) const {
+        return m[0] * p.x * p.x + 2 * m[1] * p.x * p.y +
+               2 * m[2] * p.x * p.z + 2 * m[3] * p.x + m[4] * p.y * p.y +
+               2 * m[5] * p.y * p.z + 2 * m[6] * p.y + m[7] * p.z * p.z +
+               2 * m[8] * p.z + m[9];
+    }
+};
+
+struct Triangle {
+    int v[3];
+    // Collapse error of the edges v[i]-v[i+1], then their minimum.
+    float error[4];
+    float normal[3];
+    bool deleted;
+    bool dirty;
+};
+
+struct SimplifierVertex {
+    Vec3 position;
+    Quadric quadric;
+    // References of the triangles using this vertex in refs_.
+    std::size_t first_ref;
+    int ref_count;
+    bool border;
+};
+
+struct Ref {
+    int triangle;
+    // Which corner of the triangle this vertex is.
+    int corner;
+};
+
+template <typename Task>
+void ForEachChunk(std::size_t count, unsigned threads, Task task) {
+    const std::size_t chunks = (count + kChunkSize - 1) / kChunkSize;
+    RunOnWorkers(chunks, threads, [&](std::size_t chunk) {
+        task(chunk * kChunkSize, std::min(count, (chunk + 1) * kChunkSize));
+    });
+}
+
+class Simplifier {
+   public:
+    Simplifier(TriangleMesh& mesh, const SimplifyOptions& options)
+        : mesh_(mesh), options_(options) {}
+
+    bool Run(std::size_t target, SimplifyStats& stats) {
+        Load();
+        std::size_t deleted = 0;
+        int iteration = 0;
+        for (; iteration < options_.max_iterations; ++iteration) {
+            if (options_.cancel != nullptr && options_.cancel->load()) {
+                return false;
+            }
+            if (triangles_.size() - deleted <= target) {
+                break;
+            }
+            if (iteration % kCompactInterval == 0) {
+                Update(iteration == 0);
+                deleted = 0;
+                stats.peak_bytes = std::max(stats.peak_bytes, WorkingSet());
+            }
+            for (Triangle& triangle : triangles_) {
+                triangle.dirty = false;
+            }
+
+            const double threshold =
+                kThresholdScale *
+                std::pow(iteration + 3.0, options_.aggressiveness);
+            CollapseBelow(threshold, target, deleted);
+        }
+        stats.iterations = iteration;
+        stats.peak_bytes = std::max(stats.peak_bytes, WorkingSet());
+        Store();
+        return true;
+    }
+
+   private:
+    // Copies the mesh into the working arrays, scaled to a unit diagonal so
+    // that the error thresholds do not depend on the model size.
+    void Load() {
+        if (!mesh_.vertices.empty()) {
+            Vec3 min = {mesh_.vertices[0].x, mesh_.vertices[0].y,
+                        mesh_.vertices[0].z};
+            Vec3 max = min;
+            for (const Vertex& v : mesh_.vertices) {
+                min = {std::min<double>(min.x, v.x),
+                       std::min<double>(min.y, v.y),
+                       std::min<double>(min.z, v.z)};
+                max = {std::max<double>(max.x, v.x),
+                       std::max<double>(max.y, v.y),
+                       std::max<double>(max.z, v.z)};
+            }
+            center_ = (min + max) * 0.5;
+            const double diagonal = std::sqrt(Dot(max - min, max - min));
+            scale_ = diagonal > 0.0 ? diagonal : 1.0;
+        }
+
+        vertices_.resize(mesh_.vertices.size());
+        for (std::size_t i = 0; i < vertices_.size(); ++i) {
+            const Vertex& v = mesh_.vertices[i];
+            vertices_[i].position = (Vec3{v.x, v.y, v.z} - center_) *
+                                    (1.0 / scale_);
+        }
+        triangles_.resize(mesh_.triangles.size());
+        for (std::size_t i = 0; i < triangles_.size(); ++i) {
+            Triangle& triangle = triangles_[i];
+            std::copy(mesh_.triangles[i].begin(), mesh_.triangles[i].end(),
+                      triangle.v);
+            triangle.deleted = false;
+            triangle.dirty = false;
+        }
+        mesh_.vertices = std::vector<Vertex>();
+        mesh_.triangles = std::vector<std::array<int, 3>>();
+    }
+
+    // Writes the surviving triangles and the vertices they use back.
+    void Store() {
+        std::vector<int> remap(vertices_.size(), -1);
+        for (const Triangle& triangle : triangles_) {
+            if (triangle.deleted) {
+                continue;
+            }
+            std::array<int, 3> indices;
+            for (int j = 0; j < 3; ++j) {
+                int& index = remap[triangle.v[j]];
+                if (index < 0) {
+                    index = static_cast<int>(mesh_.vertices.size());
+                    const Vec3 p =
+                        vertices_[triangle.v[j]].position * scale_ + center_;
+                    mesh_.vertices.push_back({static_cast<float>(p.x),
+                                              static_cast<float>(p.y),
+                                              static_cast<float>(p.z)});
+                }
+                indices[j] = index;
+            }
+            mesh_.triangles.push_back(indices);
+        }
+        triangles_ = std::vector<Triangle>();
+        vertices_ = std::vector<SimplifierVertex>();
+        refs_ = std::vector<Ref>();
+    }
+
+    std::size_t WorkingSet() const {
+        return triangles_.capacity() * sizeof(Triangle) +
+               vertices_.capacity() * sizeof(SimplifierVertex) +
+               refs_.capacity() * sizeof(Ref);
+    }
+
+    // Drops deleted triangles and rebuilds the vertex to triangle
+    // references. The first time, also computes normals, borders, quadrics
+    // and edge errors.
+    void Update(bool first) {
+        if (!first) {
+            triangles_.erase(
+                std::remove_if(
+                    triangles_.begin(), triangles_.end(),
+                    [](const Triangle& triangle) { return triangle.deleted; }),
+                triangles_.end());
+        }
+        if (first) {
+            ComputeNormals();
+        }
+        RebuildRefs();
+        if (first) {
+            FindBorders();
+            ComputeQuadrics();
+            ComputeErrors();
+        }
+    }
+
+    void ComputeNormals() {
+        ForEachChunk(triangles_.size(), options_.threads,
+                     [this](std::size_t begin, std::size_t end) {
+                         for (std::size_t i = begin; i < end; ++i) {
+                             Triangle& triangle = triangles_[i];
+                             SetNormal(triangle, Normal(triangle));
+                         }
+                     });
+    }
+
+    Vec3 Normal(const Triangle& triangle) const {
+        const Vec3& p0 = vertices_[triangle.v[0]].position;
+        const Vec3& p1 = vertices_[triangle.v[1]].position;
+        const Vec3& p2 = vertices_[triangle.v[2]].position;
+        return Normalized(Cross(p1 - p0, p2 - p0));
+    }
+
+    static void SetNormal(Triangle& triangle, const Vec3& normal) {
+        triangle.normal[0] = static_cast<float>(normal.x);
+        triangle.normal[1] = static_cast<float>(normal.y);
+        triangle.normal[2] = static_cast<float>(normal.z);
+    }
+
+    static Vec3 GetNormal(const Triangle& triangle) {
+        return {triangle.normal[0], triangle.normal[1], triangle.normal[2]};
+    }
+
+    void RebuildRefs() {
+        for (SimplifierVertex& vertex : vertices_) {
+            vertex.ref_count = 0;
+        }
+        for (const Triangle& triangle : triangles_) {
+            for (int j = 0; j < 3; ++j) {
+                vertices_[triangle.v[j]].ref_count++;
+            }
+        }
+        std::size_t first = 0;
+        for (SimplifierVertex& vertex : vertices_) {
+            vertex.first_ref = first;
+            first += vertex.ref_count;
+            vertex.ref_count = 0;
+        }
+        refs_.resize(first);
+        for (std::size_t i = 0; i < triangles_.size(); ++i) {
+            for (int j = 0; j < 3; ++j) {
+                SimplifierVertex& vertex = vertices_[triangles_[i].v[j]];
+                refs_[vertex.first_ref + vertex.ref_count] = {
+                    static_cast<int>(i), j};
+                vertex.ref_count++;
+            }
+        }
+    }
+
+    // A vertex is on a border when one of its edges is used by a single
+    // triangle.
+    void FindBorders() {
+        ForEachChunk(
+            vertices_.size(), options_.threads,
+            [this](std::size_t begin, std::size_t end) {
+                std::vector<std::pair<int, int>> neighbours;
+                for (std::size_t i = begin; i < end; ++i) {
+                    SimplifierVertex& vertex = vertices_[i];
+                    neighbours.clear();
+                    for (int k = 0; k < vertex.ref_count; ++k) {
+                        const Ref& ref = refs_[vertex.first_ref + k];
+                        const Triangle& triangle = triangles_[ref.triangle];
+                        for (int step = 1; step <= 2; ++step) {
+                            const int id = triangle.v[(ref.corner + step) % 3];
+                            auto found = std::find_if(
+                                neighbours.begin(), neighbours.end(),
+                                [id](const std::pair<int, int>& neighbour) {
+                                    return neighbour.first == id;
+                                });
+                            if (found == neighbours.end()) {
+                                neighbours.push_back({id, 1});
+                            } else {
+                                found->second++;
+                            }
+                        }
+                    }
+                    vertex.border = std::any_of(
+                        neighbours.begin(), neighbours.end(),
+                        [](const std::pair<int, int>& neighbour) {
+                            return neighbour.second == 1;
+                        });
+                }
+            });
+    }
+
+    void ComputeQuadrics() {
+        ForEachChunk(
+            vertices_.size(), options_.threads,
+            [this](std::size_t begin, std::size_t end) {
+                for (std::size_t i = begin; i < end; ++i) {
+                    SimplifierVertex& vertex = vertices_[i];
+                    vertex.quadric = Quadric();
+                    for (int k = 0; k < vertex.ref_count; ++k) {
+                        const Triangle& triangle =
+                            triangles_[refs_[vertex.first_ref + k].triangle];
+                        const Vec3 n = GetNormal(triangle);
+                        const Vec3& p0 = vertices_[triangle.v[0]].position;
+                        vertex.quadric +=
+                            Quadric::Plane(n.x, n.y, n.z, -Dot(n, p0));
+                    }
+                }
+            });
+    }
+
+    void ComputeErrors() {
+        ForEachChunk(triangles_.size(), options_.threads,
+                     [this](std::size_t begin, std::size_t end) {
+                         for (std::size_t i = begin; i < end; ++i) {
+                             UpdateErrors(triangles_[i]);
+                         }
+                     });
+    }
+
+    void UpdateErrors(Triangle& triangle) const {
+        Vec3 unused;
+        for (int j = 0; j < 3; ++j) {
+            triangle.error[j] = static_cast<float>(CollapseError(
+                triangle.v[j], triangle.v[(j + 1) % 3], unused));
+        }
+        triangle.error[3] = std::min(
+            {triangle.error[0], triangle.error[1], triangle.error[2]});
+    }
+
+    // Error of collapsing a-b into `result`: the optimal position when the
+    // summed quadric can be solved, otherwise the best endpoint or midpoint.
+    double CollapseError(int a, int b, Vec3& result) const {
+        const SimplifierVertex& va = vertices_[a];
+        const SimplifierVertex& vb = vertices_[b];
+        Quadric q = va.quadric;
+        q += vb.quadric;
+
+        const double det = q.Det(0, 1, 2, 1, 4, 5, 2, 5, 7);
+        if (det != 0.0 && !(va.border && vb.border)) {
+            const Vec3 optimal = {-q.Det(1, 2, 3, 4, 5, 6, 5, 7, 8) / det,
+                                  q.Det(0, 2, 3, 1, 5, 6, 2, 7, 8) / det,
+                                  -q.Det(0, 1, 3, 1, 4, 6, 2, 5, 8) / det};
+            const Vec3 edge = vb.position - va.position;
+            const Vec3 offset =
+                optimal - (va.position + vb.position) * 0.5;
+            if (Dot(offset, offset) <= kMaxOptimalDistance *
+                                           kMaxOptimalDistance *
+                                           Dot(edge, edge)) {
+                result = optimal;
+                return q.Error(optimal);
+            }
+        }
+
+        const Vec3 candidates[] = {va.position, vb.position,
+                                   (va.position + vb.position) * 0.5};
+        double best = q.Error(candidates[0]);
+        result = candidates[0];
+        for (int i = 1; i < 3; ++i) {
+            const double error = q.Error(candidates[i]);
+            if (error < best) {
+                best = error;
+                result = candidates[i];
+            }
+        }
+        return best;
+    }
+
+    // One pass over the triangles, collapsing every edge whose error is
+    // below `threshold` until at most `target` triangles remain.
+    void CollapseBelow(double threshold, std::size_t target,
+                       std::size_t& deleted) {
+        std::vector<char> deleted0;
+        std::vector<char> deleted1;
+        for (std::size_t i = 0; i < triangles_.size(); ++i) {
+            Triangle& triangle = triangles_[i];
+            if (triangle.error[3] > threshold || triangle.deleted ||
+                triangle.dirty) {
+                continue;
+            }
+            for (int j = 0; j < 3; ++j) {
+                if (triangle.error[j] > threshold) {
+                    continue;
+                }
+                const int i0 = triangle.v[j];
+                const int i1 = triangle.v[(j + 1) % 3];
+                SimplifierVertex& v0 = vertices_[i0];
+                SimplifierVertex& v1 = vertices_[i1];
+                if (v0.border != v1.border) {
+                    continue;
+                }
+
+                Vec3 position;
+                CollapseError(i0, i1, position);
+                deleted0.assign(v0.ref_count, 0);
+                deleted1.assign(v1.ref_count, 0);
+                if (Flips(position, i1, v0, deleted0) ||
+                    Flips(position, i0, v1, deleted1)) {
+                    continue;
+                }
+
+                v0.position = position;
+                v0.quadric += v1.quadric;
+                const std::size_t first = refs_.size();
+                Relink(i0, v0, deleted0, deleted);
+                Relink(i0, v1, deleted1, deleted);
+                const std::size_t count = refs_.size() - first;
+                if (count <= static_cast<std::size_t>(v0.ref_count)) {
+                    // Reuse the old slot so that the references do not grow.
+                    std::memmove(&refs_[v0.first_ref], &refs_[first],
+                                 count * sizeof(Ref));
+                    refs_.resize(first);
+                } else {
+                    v0.first_ref = first;
+                }
+                v0.ref_count = static_cast<int>(count);
+                break;
+            }
+            if (triangles_.size() - deleted <= target) {
+                break;
+            }
+        }
+    }
+
+    // Whether moving `vertex` to `position` flips or squashes one of its
+    // triangles. Marks the triangles shared with `other`, which the
+    // collapse removes.
+    bool Flips(const Vec3& position, int other,
+               const SimplifierVertex& vertex,
+               std::vector<char>& deleted) const {
+        for (int k = 0; k < vertex.ref_count; ++k) {
+            const Ref& ref = refs_[vertex.first_ref + k];
+            const Triangle& triangle = triangles_[ref.triangle];
+            if (triangle.deleted) {
+                continue;
+            }
+            const int id1 = triangle.v[(ref.corner + 1) % 3];
+            const int id2 = triangle.v[(ref.corner + 2) % 3];
+            if (id1 == other || id2 == other) {
+                deleted[k] = 1;
+                continue;
+            }
+            const Vec3 d1 = Normalized(vertices_[id1].position - position);
+            const Vec3 d2 = Normalized(vertices_[id2].position - position);
+            if (std::fabs(Dot(d1, d2)) > kMaxEdgeDot) {
+                return true;
+            }
+            const Vec3 normal = Normalized(Cross(d1, d2));
+            if (Dot(normal, GetNormal(triangle)) < kMinNormalDot) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Points the surviving triangles of `vertex` at `target` and appends
+    // their references.
+    void Relink(int target, const SimplifierVertex& vertex,
+                const std::vector<char>& deleted, std::size_t& deleted_count) {
+        for (int k = 0; k < vertex.ref_count; ++k) {
+            const Ref ref = refs_[vertex.first_ref + k];
+            Triangle& triangle = triangles_[ref.triangle];
+            if (triangle.deleted) {
+                continue;
+            }
+            if (deleted[k]) {
+                triangle.deleted = true;
+                deleted_count++;
+                continue;
+            }
+            triangle.v[ref.corner] = target;
+            triangle.dirty = true;
+            SetNormal(triangle, Normal(triangle));
+            UpdateErrors(triangle);
+            refs_.push_back(ref);
+        }
+    }
+
+    TriangleMesh& mesh_;
+    const SimplifyOptions& options_;
+    Vec3 center_;
+    double scale_{1.0};
+    std::vector<SimplifierVertex> vertices_;
+    std::vector<Triangle> triangles_;
+    std::vector<Ref> refs_;
+};
+
+}  // namespace
+
+TriangleMesh Triangulate(const PositionsSoA& positions,
+                         const FaceList& faces) {
+    VIEWER3D_TRACE_ZONE("Triangulate");
+    TriangleMesh mesh;
+    const std::size_t vertex_count = positions.size();
+    mesh.vertices.resize(vertex_count);
+    for (std::size_t i = 0; i < vertex_count; ++i) {
+        mesh.vertices[i] = {positions.x[i], positions.y[i], positions.z[i]};
+    }
+
+    mesh.triangles.reserve(faces.IndexCount() > 2 * faces.size()
+                               ? faces.IndexCount() - 2 * faces.size()
+                               : 0);
+    for (const FaceView face : faces) {
+        if (face.size() < 3 ||
+            std::any_of(face.begin(), face.end(), [&](int index) {
+                return index < 0 ||
+                       static_cast<std::size_t>(index) >= vertex_count;
+            })) {
+            continue;
+        }
+        for (std::size_t i = 1; i + 1 < face.size(); ++i) {
+            const std::array<int, 3> triangle = {face[0], face[i], face[i + 1]};
+            if (triangle[0] != triangle[1] && triangle[1] != triangle[2] &&
+                triangle[0] != triangle[2]) {
+                mesh.triangles.push_back(triangle);
+            }
+        }
+    }
+    return mesh;
+}
+
+bool SimplifyMesh(TriangleMesh& mesh, std::size_t target_triangles,
+                  const SimplifyOptions& options, SimplifyStats* stats) {
+    VIEWER3D_TRACE_ZONE("SimplifyMesh");
+    SimplifyStats local_stats;
+    Simplifier simplifier(mesh, options);
+    const bool done = simplifier.Run(target_triangles, local_stats);
+    if (stats != nullptr) {
+        *stats = local_stats;
+    }
+    return done;
+}
+
+}  // namespace viewer3d
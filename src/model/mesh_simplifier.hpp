@@ -0,0 +1,52 @@
+#ifndef MESH_SIMPLIFIER_H
+#define MESH_SIMPLIFIER_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+#include "model/face_list.hpp"
+#include "model/transform_kernel.hpp"
+#include "model/vertex.hpp"
+
+namespace viewer3d {
+
+struct TriangleMesh {
+    std::vector<Vertex> vertices;
+    std::vector<std::array<int, 3>> triangles;
+};
+
+// Fan-triangulates the polygons of `faces`. Faces with fewer than three
+// vertices or out-of-range indices and degenerate triangles are skipped.
+TriangleMesh Triangulate(const PositionsSoA& positions, const FaceList& faces);
+
+struct SimplifyOptions {
+    // How strictly the cheapest collapses go first; higher is slower and
+    // preserves shape better.
+    double aggressiveness{7.0};
+    int max_iterations{100};
+    // Threads for the setup passes, 0 means one per hardware thread. The
+    // collapses themselves run on the calling thread.
+    unsigned threads{0};
+    const std::atomic<bool>* cancel{nullptr};
+};
+
+struct SimplifyStats {
+    int iterations{0};
+    // Largest working set of the simplifier, the mesh itself included.
+    std::size_t peak_bytes{0};
+};
+
+// Collapses edges of `mesh` in order of their quadric error (Garland and
+// Heckbert) until at most `target_triangles` remain or no collapse is cheap
+// enough. Open borders only collapse along themselves, and collapses that
+// would flip a triangle are skipped. Unreferenced vertices are removed.
+// Returns false when cancelled, leaving `mesh` unspecified.
+bool SimplifyMesh(TriangleMesh& mesh, std::size_t target_triangles,
+                  const SimplifyOptions& options = SimplifyOptions(),
+                  SimplifyStats* stats = nullptr);
+
+}  // namespace viewer3d
+
+#endif
@@ -1,110 +1,79 @@
 #include "model/model.hpp"
 
-#include <cmath>
-#include <fstream>
+#include <atomic>
 #include <iostream>
-#include <sstream>
+#include <limits>
 #include <stdexcept>
+#include <utility>
+
+#include "model/mesh_format.hpp"
+#include "model/obj_parser.hpp"
+#include "model/parallel.hpp"
+#include "model/ply_parser.hpp"
+#include "model/stl_parser.hpp"
 
 namespace viewer3d {
 
 namespace {
-constexpr float kDegToRad = M_PI / 180.0f;
 constexpr float kMinScaleFactor = 0.1f;
+// Smaller models are transformed on the calling thread.
+constexpr std::size_t kVerticesPerTransformTask = 1 << 16;
+
+// Leaves the decoded values in the float positions, so the edge hierarchy
+// built from them matches what is drawn later.
+void QuantizePositions(ModelGeometry& geometry) {
+    geometry.quantized.Encode(geometry.positions, geometry.bounds.min,
+                              geometry.bounds.max);
+    geometry.quantization_error =
+        geometry.quantized.MeasureError(geometry.positions);
+    geometry.quantized.Decode(geometry.positions);
+}
 }  // namespace
 
-bool Model::LoadFromFile(const std::string& filename) {
-    Clear();
-
-    std::ifstream file(filename);
-    if (!file.is_open()) {
-        std::cerr << "Error: couldn't open the file " << filename << std::endl;
-        return false;
-    }
-
-    filename_ = filename;
-    std::string line;
-    int line_number = 0;
-
-    try {
-        while (std::getline(file, line)) {
-            line_number++;
-            std::istringstream iss(line);
-            std::string token;
-            iss >> token;
-
-            if (token == "v") {
-                Vertex vertex;
-                if (!(iss >> vertex.x >> vertex.y >> vertex.z)) {
-                    std::cerr << "Warning: incorrect vertex data in the row "
-                              << line_number << std::endl;
-                    continue;
-                }
-                vertices_.push_back(vertex);
-            } else if (token == "f") {
-                Face face;
-                std::string vertex_index;
-                while (iss >> vertex_index) {
-                    std::istringstream vertex_stream(vertex_index);
-                    int v_index;
-                    if (!(vertex_stream >> v_index)) {
-                        std::cerr
-                            << "Warning: incorrect vertex index in the row "
-                            << line_number << std::endl;
-                        continue;
-                    }
-
-                    if (v_index < 0) {
-                        v_index = vertices_.size() + v_index + 1;
-                    }
-
-                    if (v_index <= 0 ||
-                        v_index > static_cast<int>(vertices_.size())) {
-                        std::cerr << "Warning: the index of the vertex is out "
-                                     "of range in "
-                                     "the row "
-                                  << line_number << std::endl;
-                        continue;
-                    }
-
-                    face.vertexIndices.push_back(v_index - 1);
-                }
-                if (face.vertexIndices.size() >= 2) {
-                    faces_.push_back(face);
-                }
-            }
-        }
-    } catch (const std::exception& e) {
-        std::cerr << "Error reading the file: " << e.what() << std::endl;
-        Clear();
+bool Model::LoadFromFile(const std::string& filename,
+                         const LoadOptions& options) {
+    VIEWER3D_TRACE_ZONE("Model::LoadFromFile");
+    Model staging;
+    staging.transform_mode_ = transform_mode_;
+    if (!staging.LoadInPlace(filename, options)) {
         return false;
     }
+    Adopt(staging);
+    return true;
+}
 
-    if (vertices_.empty()) {
-        std::cerr << "Warning: the file does not contain vertices" << std::endl;
-        return false;
+void Model::Adopt(Model& staging) {
+    std::swap(vertices_, staging.vertices_);
+    std::swap(spare_vertices_, staging.spare_vertices_);
+    std::swap(vertices_dirty_, staging.vertices_dirty_);
+    std::swap(geometry_, staging.geometry_);
+    std::swap(filename_, staging.filename_);
+    std::swap(loaded_from_cache_, staging.loaded_from_cache_);
+    std::swap(last_phases_, staging.last_phases_);
+
+    std::swap(current_translate_x_, staging.current_translate_x_);
+    std::swap(current_translate_y_, staging.current_translate_y_);
+    std::swap(current_translate_z_, staging.current_translate_z_);
+    std::swap(current_rotate_x_, staging.current_rotate_x_);
+    std::swap(current_rotate_y_, staging.current_rotate_y_);
+    std::swap(current_rotate_z_, staging.current_rotate_z_);
+    std::swap(current_scale_, staging.current_scale_);
+
+    if (staging.transform_mode_ != transform_mode_) {
+        SyncVerticesWithMode();
     }
-
-    original_vertices_ = vertices_;
-
-    current_translate_x_ = 0.0f;
-    current_translate_y_ = 0.0f;
-    current_translate_z_ = 0.0f;
-    current_rotate_x_ = 0.0f;
-    current_rotate_y_ = 0.0f;
-    current_rotate_z_ = 0.0f;
-    current_scale_ = 1.0f;
-
-    CalculateEdgeCount();
-    return true;
+    geometry_revision_++;
+    transform_revision_++;
 }
 
 void Model::Clear() {
-    vertices_.clear();
-    original_vertices_.clear();
-    faces_.clear();
+    geometry_revision_++;
+    ReleaseVertices();
+    vertices_dirty_ = false;
+    geometry_ = std::make_shared<ModelGeometry>();
     filename_.clear();
-    edge_count_ = 0;
+    loaded_from_cache_ = false;
+    last_phases_.clear();
 
     current_translate_x_ = 0.0f;
     current_translate_y_ = 0.0f;
@@ -120,7 +89,7 @@ void Model::Translate(float dx, float dy, float dz) {
     current_translate_y_ = dy;
     current_translate_z_ = dz;
 
-    ApplyAllTransformations();
+    OnTransformChanged();
 }
 
 void Model::Rotate(float angleX, float angleY, float angleZ) {
@@ -128,7 +97,7 @@ void Model::Rotate(float angleX, float angleY, float angleZ) {
     current_rotate_y_ = angleY;
     current_rotate_z_ = angleZ;
 
-    ApplyAllTransformations();
+    OnTransformChanged();
 }
 
 void Model::Scale(float factor) {
@@ -139,81 +108,384 @@ void Model::Scale(float factor) {
 
     current_scale_ = factor;
 
-    ApplyAllTransformations();
+    OnTransformChanged();
+}
+
+bool Model::SetTransform(const std::array<float, 3>& translate,
+                         const std::array<float, 3>& rotate, float scale) {
+    if (scale <= kMinScaleFactor) {
+        std::cerr << "Warning: The zoom level is too small" << std::endl;
+        return false;
+    }
+
+    current_translate_x_ = translate[0];
+    current_translate_y_ = translate[1];
+    current_translate_z_ = translate[2];
+    current_rotate_x_ = rotate[0];
+    current_rotate_y_ = rotate[1];
+    current_rotate_z_ = rotate[2];
+    current_scale_ = scale;
+
+    OnTransformChanged();
+    return true;
 }
 
-void Model::ApplyAllTransformations() {
-    vertices_ = original_vertices_;
+void Model::SetTransformMode(TransformMode mode) {
+    if (mode == transform_mode_) {
+        return;
+    }
+    transform_mode_ = mode;
+    SyncVerticesWithMode();
+}
 
-    if (current_scale_ != 1.0f) {
-        for (auto& vertex : vertices_) {
-            vertex.x *= current_scale_;
-            vertex.y *= current_scale_;
-            vertex.z *= current_scale_;
+const std::vector<Vertex>& Model::GetVertices() const {
+    if (vertices_dirty_) {
+        ApplyAllTransformations();
+    }
+    return *vertices_;
+}
+
+std::array<float, 16> Model::GetModelMatrix() const {
+    const VertexTransform transform = CurrentTransform();
+    const float* m = transform.linear;
+    const float* t = transform.translate;
+    return {m[0], m[1], m[2], t[0], m[3], m[4], m[5], t[1],
+            m[6], m[7], m[8], t[2], 0.0f, 0.0f, 0.0f, 1.0f};
+}
+
+// Quantized positions are decoded for the build, as the hierarchy is
+// searched in their decoded space.
+const FaceBvh& ModelGeometry::PickIndex() const {
+    std::call_once(face_bvh_built_, [this] {
+        if (!IsQuantized()) {
+            face_bvh_.Build(positions, faces, bounds, threads);
+            return;
         }
+        PositionsSoA decoded;
+        quantized.Decode(decoded);
+        face_bvh_.Build(decoded, faces, bounds, threads);
+    });
+    return face_bvh_;
+}
+
+bool Model::Pick(const Ray& ray, PickResult& result) const {
+    VIEWER3D_TRACE_ZONE("Model::Pick");
+    const VertexTransform transform = CurrentTransform();
+    const float* m = transform.linear;
+    const float* t = transform.translate;
+    // Inverse of the linear part by its adjugate.
+    const float cofactors[9] = {
+        m[4] * m[8] - m[5] * m[7], m[2] * m[7] - m[1] * m[8],
+        m[1] * m[5] - m[2] * m[4], m[5] * m[6] - m[3] * m[8],
+        m[0] * m[8] - m[2] * m[6], m[2] * m[3] - m[0] * m[5],
+        m[3] * m[7] - m[4] * m[6], m[1] * m[6] - m[0] * m[7],
+        m[0] * m[4] - m[1] * m[3]};
+    const float det =
+        m[0] * cofactors[0] + m[1] * cofactors[3] + m[2] * cofactors[6];
+    if (det == 0.0f) {
+        return false;
+    }
+    auto to_source = [&cofactors, det](float x, float y, float z) {
+        return Vertex{
+            (cofactors[0] * x + cofactors[1] * y + cofactors[2] * z) / det,
+            (cofactors[3] * x + cofactors[4] * y + cofactors[5] * z) / det,
+            (cofactors[6] * x + cofactors[7] * y + cofactors[8] * z) / det};
+    };
+    Ray source_ray;
+    source_ray.origin = to_source(ray.origin.x - t[0], ray.origin.y - t[1],
+                                  ray.origin.z - t[2]);
+    source_ray.direction =
+        to_source(ray.direction.x, ray.direction.y, ray.direction.z);
+
+    const ModelGeometry& geometry = *geometry_;
+    const FaceBvh& pick_index = geometry.PickIndex();
+    FaceHit hit;
+    const bool hit_face =
+        geometry.IsQuantized()
+            ? pick_index.Intersect(geometry.quantized, geometry.faces,
+                                   source_ray, hit)
+            : pick_index.Intersect(geometry.positions, geometry.faces,
+                                   source_ray, hit);
+    if (!hit_face) {
+        return false;
     }
 
-    if (current_rotate_x_ != 0.0f || current_rotate_y_ != 0.0f ||
-        current_rotate_z_ != 0.0f) {
-        float radX = current_rotate_x_ * kDegToRad;
-        float radY = current_rotate_y_ * kDegToRad;
-        float radZ = current_rotate_z_ * kDegToRad;
-
-        float sinX = sin(radX);
-        float cosX = cos(radX);
-        float sinY = sin(radY);
-        float cosY = cos(radY);
-        float sinZ = sin(radZ);
-        float cosZ = cos(radZ);
-
-        for (auto& vertex : vertices_) {
-            float x = vertex.x;
-            float y = vertex.y;
-            float z = vertex.z;
-
-            if (current_rotate_x_ != 0) {
-                float y1 = y * cosX - z * sinX;
-                float z1 = y * sinX + z * cosX;
-                y = y1;
-                z = z1;
-            }
+    // The transform scales uniformly, so the nearest vertex is the same in
+    // both spaces.
+    const FaceView face = geometry.faces[hit.face];
+    float best = std::numeric_limits<float>::max();
+    for (int index : face) {
+        const Vertex p = geometry.SourcePosition(index);
+        const float dx = p.x - hit.point.x;
+        const float dy = p.y - hit.point.y;
+        const float dz = p.z - hit.point.z;
+        const float distance = dx * dx + dy * dy + dz * dz;
+        if (distance < best) {
+            best = distance;
+            result.vertex = index;
+        }
+    }
+    const Vertex v = geometry.SourcePosition(result.vertex);
+    result.face = hit.face;
+    result.t = hit.t;
+    result.point = {ray.origin.x + hit.t * ray.direction.x,
+                    ray.origin.y + hit.t * ray.direction.y,
+                    ray.origin.z + hit.t * ray.direction.z};
+    result.vertex_position = {m[0] * v.x + m[1] * v.y + m[2] * v.z + t[0],
+                              m[3] * v.x + m[4] * v.y + m[5] * v.z + t[1],
+                              m[6] * v.x + m[7] * v.y + m[8] * v.z + t[2]};
+    return true;
+}
 
-            if (current_rotate_y_ != 0) {
-                float x1 = x * cosY + z * sinY;
-                float z1 = -x * sinY + z * cosY;
-                x = x1;
-                z = z1;
-            }
+// Loads into this freshly constructed model.
+bool Model::LoadInPlace(const std::string& filename,
+                        const LoadOptions& options) {
+    geometry_ = std::make_shared<ModelGeometry>();
+    ModelGeometry& geometry = *geometry_;
+    geometry.threads = options.threads;
+    SourceStamp stamp;
+    std::string cache_path;
+    if (options.cache != CacheMode::kBypass) {
+        PhaseScope phase(last_phases_, "cache lookup");
+        if (StampSourceFile(filename, stamp)) {
+            cache_path = ModelCachePath(filename, options.cache_dir);
+            loaded_from_cache_ =
+                options.cache == CacheMode::kUse &&
+                ReadModelCache(cache_path, stamp, geometry.positions,
+                               geometry.faces, geometry.edges,
+                               geometry.bounds);
+        }
+    }
 
-            if (current_rotate_z_ != 0) {
-                float x1 = x * cosZ - y * sinZ;
-                float y1 = x * sinZ + y * cosZ;
-                x = x1;
-                y = y1;
-            }
+    if (!loaded_from_cache_ && !ParseFile(filename, options)) {
+        return false;
+    }
+    const bool quantize = options.storage == PositionStorage::kQuantized16;
+    if (quantize) {
+        PhaseScope phase(last_phases_, "quantize");
+        QuantizePositions(geometry);
+    }
+    {
+        // The cache stores the edges in cluster order, so only the boxes
+        // are rebuilt for them.
+        PhaseScope phase(last_phases_, "clusters");
+        if (loaded_from_cache_) {
+            geometry.edge_bvh.BuildClustered(geometry.positions,
+                                             geometry.bounds, geometry.edges,
+                                             options.threads);
+        } else {
+            geometry.edge_bvh.Build(geometry.positions, geometry.bounds,
+                                    geometry.edges, options.threads);
+        }
+    }
+    // The cache keeps full precision, so only float loads write it.
+    if (!loaded_from_cache_ && !cache_path.empty() && !quantize) {
+        PhaseScope phase(last_phases_, "cache write");
+        WriteModelCache(cache_path, stamp, geometry.positions, geometry.faces,
+                        geometry.edges, geometry.bounds);
+    }
+    if (quantize) {
+        geometry.positions = PositionsSoA();
+    }
 
-            vertex.x = x;
-            vertex.y = y;
-            vertex.z = z;
+    filename_ = filename;
+    // Only the source positions are kept, so the transformed vertices are
+    // computed on first use, in kCpu as well.
+    ReleaseVertices();
+    vertices_dirty_ = geometry.VertexCount() > 0;
+    return true;
+}
+
+// Parses the OBJ, PLY or STL file into the source geometry, including
+// derived data.
+bool Model::ParseFile(const std::string& filename,
+                      const LoadOptions& options) {
+    ObjData data;
+    {
+        PhaseScope phase(last_phases_, "parse");
+        try {
+            bool opened;
+            switch (DetectMeshFormat(filename)) {
+                case MeshFormat::kPly:
+                    opened = ParsePly(filename, data, options.control);
+                    break;
+                case MeshFormat::kStl:
+                    opened = ParseStl(filename, data, options.control);
+                    break;
+                default:
+                    opened = options.backend == ObjBackend::kStream
+                                 ? ParseObjStream(filename, data,
+                                                  options.control)
+                                 : ParseObjMapped(filename, data,
+                                                  options.threads,
+                                                  kDefaultMinChunkBytes,
+                                                  options.control);
+                    break;
+            }
+            if (!opened) {
+                return false;
+            }
+        } catch (const std::exception& e) {
+            std::cerr << "Error reading the file: " << e.what() << std::endl;
+            return false;
         }
     }
 
-    if (current_translate_x_ != 0.0f || current_translate_y_ != 0.0f ||
-        current_translate_z_ != 0.0f) {
-        for (auto& vertex : vertices_) {
-            vertex.x += current_translate_x_;
-            vertex.y += current_translate_y_;
-            vertex.z += current_translate_z_;
+    if (data.vertices.empty()) {
+        std::cerr << "Warning: the file does not contain vertices" << std::endl;
+        return false;
+    }
+
+    // The parsed array is released as soon as it is converted, so the edge
+    // and hierarchy builds and a kCpu model never hold two full copies of
+    // the source positions.
+    ModelGeometry& geometry = *geometry_;
+    geometry.positions.Assign(data.vertices);
+    data.vertices = std::vector<Vertex>();
+    geometry.faces = std::move(data.faces);
+    if (options.control.Cancelled()) {
+        return false;
+    }
+    {
+        PhaseScope phase(last_phases_, "edges");
+        geometry.edges.Build(geometry.faces, options.threads);
+    }
+    {
+        PhaseScope phase(last_phases_, "bounds");
+        geometry.bounds = ComputeBounds(geometry.positions);
+    }
+    return !options.control.Cancelled();
+}
+
+// kGpu releases the transformed vertices, which are only rebuilt if asked
+// for; kCpu keeps the array and rewrites it in place.
+void Model::SyncVerticesWithMode() {
+    if (transform_mode_ == TransformMode::kGpu) {
+        ReleaseVertices();
+        vertices_dirty_ = geometry_->VertexCount() > 0;
+    }
+}
+
+void Model::ReleaseVertices() {
+    vertices_ = std::make_shared<std::vector<Vertex>>();
+    spare_vertices_.reset();
+}
+
+// Setters only record parameters; the vertices are computed once, on the
+// next GetVertices(), however many changes came before it.
+void Model::OnTransformChanged() {
+    transform_revision_++;
+    last_phases_.clear();
+    vertices_dirty_ = geometry_->VertexCount() > 0;
+}
+
+VertexTransform Model::CurrentTransform() const {
+    return VertexTransform::Make(current_translate_x_, current_translate_y_,
+                                 current_translate_z_, current_rotate_x_,
+                                 current_rotate_y_, current_rotate_z_,
+                                 current_scale_);
+}
+
+void Model::ApplyAllTransformations() const {
+    VIEWER3D_TRACE_ZONE("Model::ApplyAllTransformations");
+    PhaseScope phase(last_phases_, "transform");
+    materialization_count_++;
+    // Only this model holds a buffer whose use count is one, and the
+    // release by the last snapshot is ordered before the writes below.
+    if (vertices_.use_count() > 1) {
+        if (!spare_vertices_ || spare_vertices_.use_count() > 1) {
+            spare_vertices_ = std::make_shared<std::vector<Vertex>>();
         }
+        std::swap(vertices_, spare_vertices_);
     }
+    std::atomic_thread_fence(std::memory_order_acquire);
+
+    const ModelGeometry& geometry = *geometry_;
+    std::vector<Vertex>& vertices = *vertices_;
+    vertices.resize(geometry.VertexCount());
+    const VertexTransform transform = CurrentTransform();
+    ParallelFor(vertices.size(), kVerticesPerTransformTask, 0,
+                [&](std::size_t begin, std::size_t end) {
+                    if (geometry.IsQuantized()) {
+                        TransformVertices(geometry.quantized, begin, end,
+                                          transform, vertices.data());
+                    } else {
+                        TransformVertices(geometry.positions, begin, end,
+                                          transform, vertices.data());
+                    }
+                });
+    vertices_dirty_ = false;
+}
+
+std::size_t Model::GetPositionBytes() const {
+    const PositionsSoA& positions = geometry_->positions;
+    return (positions.x.capacity() + positions.y.capacity() +
+            positions.z.capacity()) *
+               sizeof(float) +
+           geometry_->quantized.MemoryBytes();
 }
 
-void Model::CalculateEdgeCount() {
-    if (!vertices_.empty() && !faces_.empty()) {
-        edge_count_ = vertices_.size() + faces_.size() - 2;
-    } else {
-        edge_count_ = 0;
+SnapshotHandoff& SnapshotHandoff::operator=(const SnapshotHandoff&) {
+    for (auto& slot : slots_) {
+        slot.reset();
     }
+    middle_ = 0;
+    publish_slot_ = 1;
+    render_slot_ = 2;
+    published_.reset();
+    return *this;
+}
+
+void SnapshotHandoff::Publish(std::shared_ptr<const ModelSnapshot> snapshot) {
+    published_ = std::move(snapshot);
+    // The release publishes the slot's contents to the renderer; the slot
+    // handed back is the one it last let go of.
+    slots_[publish_slot_] = published_;
+    publish_slot_ =
+        middle_.exchange(publish_slot_ | kFresh, std::memory_order_acq_rel) &
+        ~kFresh;
+    // Releases what the renderer no longer draws, so the next transform can
+    // reuse its vertex array.
+    slots_[publish_slot_].reset();
+}
+
+std::shared_ptr<const ModelSnapshot> SnapshotHandoff::Latest() {
+    if (middle_.load(std::memory_order_relaxed) & kFresh) {
+        render_slot_ =
+            middle_.exchange(render_slot_, std::memory_order_acq_rel) &
+            ~kFresh;
+    }
+    return slots_[render_slot_];
+}
+
+std::shared_ptr<const ModelSnapshot> Model::Publish() const {
+    const std::shared_ptr<const ModelSnapshot>& latest =
+        snapshots_.Published();
+    if (latest && latest->geometry == geometry_ &&
+        latest->geometry_revision == geometry_revision_ &&
+        latest->transform_revision == transform_revision_ &&
+        latest->mode == transform_mode_) {
+        return latest;
+    }
+
+    auto snapshot = std::make_shared<ModelSnapshot>();
+    snapshot->geometry = geometry_;
+    if (transform_mode_ == TransformMode::kCpu) {
+        if (vertices_dirty_) {
+            ApplyAllTransformations();
+        }
+        snapshot->vertices = vertices_;
+    }
+    snapshot->model_matrix = GetModelMatrix();
+    snapshot->mode = transform_mode_;
+    snapshot->geometry_revision = geometry_revision_;
+    snapshot->transform_revision = transform_revision_;
+    snapshots_.Publish(std::move(snapshot));
+    return snapshots_.Published();
+}
+
+std::shared_ptr<const ModelSnapshot> Model::LatestSnapshot() const {
+    return snapshots_.Latest();
 }
 
 }  // namespace viewer3d
\ No newline at end of file
@@ -1,19 +1,146 @@
 #ifndef MODEL_H
 #define MODEL_H
 
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
+#include "model/bounds.hpp"
+#include "model/edge_bvh.hpp"
+#include "model/edge_list.hpp"
+#include "model/face_bvh.hpp"
+#include "model/face_list.hpp"
+#include "model/model_cache.hpp"
+#include "model/parse_control.hpp"
+#include "model/trace.hpp"
+#include "model/transform_kernel.hpp"
+#include "model/vertex.hpp"
+
 namespace viewer3d {
 
-struct Vertex {
-    float x{0.0f};
-    float y{0.0f};
-    float z{0.0f};
+enum class ObjBackend {
+    kStream,  // std::getline + std::istringstream, kept as a reference
+    kMapped,  // memory-mapped file tokenized in place
+};
+
+enum class PositionStorage {
+    kFloat,        // PositionsSoA, 12 bytes per vertex
+    kQuantized16,  // QuantizedPositions, 6 bytes per vertex
+};
+
+struct LoadOptions {
+    ObjBackend backend{ObjBackend::kMapped};
+    // kQuantized16 snaps positions to a grid over the bounding box; see
+    // Model::GetQuantizationError() for what that costs.
+    PositionStorage storage{PositionStorage::kFloat};
+    // Worker threads for the mapped backend and the edge index, 0 means one
+    // per hardware thread. Files smaller than a chunk are always parsed on
+    // one thread.
+    unsigned threads{0};
+    // Binary cache of the parsed model, see model_cache.hpp. Empty
+    // cache_dir writes the cache beside the source file.
+    CacheMode cache{CacheMode::kBypass};
+    std::string cache_dir;
+    // Progress and cancellation of the text parse.
+    ParseControl control;
+};
+
+// The face hit by a ray and its vertex nearest to the hit, in transformed
+// coordinates.
+struct PickResult {
+    std::size_t face{0};
+    std::size_t vertex{0};
+    Vertex point;
+    Vertex vertex_position;
+    // Ray parameter of the hit, in units of the ray direction.
+    float t{0.0f};
+};
+
+enum class TransformMode {
+    kCpu,  // the vertex array is rewritten before the next draw
+    kGpu,  // transforms only update the model matrix
+};
+
+// Source geometry of a model and the data derived from it. A load builds
+// it and nothing but PickIndex() changes it afterwards, so models and
+// snapshots share it.
+struct ModelGeometry {
+    // Exactly one of positions and quantized holds the vertices.
+    PositionsSoA positions;
+    QuantizedPositions quantized;
+    FaceList faces;
+    // In cluster order, see edge_bvh.hpp.
+    EdgeList edges;
+    EdgeBvh edge_bvh;
+    Bounds bounds;
+    // Of the quantized positions against the parsed ones.
+    QuantizationError quantization_error;
+    // Workers for the pick index, as in LoadOptions::threads.
+    unsigned threads{0};
+
+    bool IsQuantized() const { return !quantized.empty(); }
+    std::size_t VertexCount() const {
+        return IsQuantized() ? quantized.size() : positions.size();
+    }
+    Vertex SourcePosition(std::size_t i) const {
+        return IsQuantized() ? quantized.Decode(i)
+                             : Vertex{positions.x[i], positions.y[i],
+                                      positions.z[i]};
+    }
+    // Hierarchy over the faces for picking. Most loads are never picked, so
+    // the first call builds it; later calls, from any thread, share it.
+    const FaceBvh& PickIndex() const;
+
+   private:
+    mutable FaceBvh face_bvh_;
+    mutable std::once_flag face_bvh_built_;
 };
 
-struct Face {
-    std::vector<int> vertexIndices;
+// What a renderer needs to draw the model as it was at one point in time.
+// Snapshots are immutable, so another thread can keep drawing one while
+// the model is transformed or replaced.
+struct ModelSnapshot {
+    std::shared_ptr<const ModelGeometry> geometry;
+    // Transformed vertices in TransformMode::kCpu, nullptr in kGpu.
+    std::shared_ptr<const std::vector<Vertex>> vertices;
+    // Row-major, see Model::GetModelMatrix().
+    std::array<float, 16> model_matrix{};
+    TransformMode mode{TransformMode::kCpu};
+    std::uint64_t geometry_revision{0};
+    std::uint64_t transform_revision{0};
+};
+
+// Hands snapshots from the thread that publishes them to the one that draws
+// them without locks, through three slots: one each side owns and one in
+// between. Publish() fills its slot and exchanges it for the middle one,
+// flagged fresh; Latest() exchanges its slot for the middle one only when
+// it is fresh. One thread may publish and one may take snapshots at a time.
+// Copies start empty, so a copied model does not share the slots.
+class SnapshotHandoff {
+   public:
+    SnapshotHandoff() = default;
+    SnapshotHandoff(const SnapshotHandoff&) {}
+    SnapshotHandoff& operator=(const SnapshotHandoff& other);
+
+    void Publish(std::shared_ptr<const ModelSnapshot> snapshot);
+    std::shared_ptr<const ModelSnapshot> Latest();
+    // The last snapshot published, for the publishing thread only.
+    const std::shared_ptr<const ModelSnapshot>& Published() const {
+        return published_;
+    }
+
+   private:
+    static constexpr unsigned kFresh = 4;
+
+    std::array<std::shared_ptr<const ModelSnapshot>, 3> slots_;
+    std::atomic<unsigned> middle_{0};
+    unsigned publish_slot_{1};
+    unsigned render_slot_{2};
+    std::shared_ptr<const ModelSnapshot> published_;
 };
 
 class Model {
@@ -21,26 +148,119 @@ class Model {
     Model() = default;
     ~Model() = default;
 
-    bool LoadFromFile(const std::string& filename);
+    // Loads an OBJ, PLY or STL file, recognized by its content (see
+    // mesh_format.hpp), into a staging model and adopts it only on success,
+    // so a failed or cancelled load keeps the current model. The backend
+    // option applies to OBJ files.
+    bool LoadFromFile(const std::string& filename,
+                      const LoadOptions& options = LoadOptions());
+    // Takes the geometry and transform parameters of `staging` in O(1),
+    // e.g. after it was loaded on another thread. The transform mode stays.
+    void Adopt(Model& staging);
     void Clear();
 
+    // Transform setters only record their parameters. The vertices are
+    // transformed on the next GetVertices(), so several changes in a row
+    // cost one pass over them.
     void Translate(float dx, float dy, float dz);
     void Rotate(float angleX, float angleY, float angleZ);
     void Scale(float factor);
+    // Sets all parameters at once; rotation angles are in degrees. Returns
+    // false and changes nothing when the scale is too small.
+    bool SetTransform(const std::array<float, 3>& translate,
+                      const std::array<float, 3>& rotate, float scale);
 
-    const std::vector<Vertex>& GetVertices() const { return vertices_; }
-    const std::vector<Face>& GetFaces() const { return faces_; }
+    void SetTransformMode(TransformMode mode);
+    TransformMode GetTransformMode() const { return transform_mode_; }
+
+    // Transformed vertices, computed on first access after a transform
+    // change. kCpu renders from them; kGpu only computes them when asked.
+    const std::vector<Vertex>& GetVertices() const;
+    // How many times the transformed vertices have been computed.
+    std::uint64_t GetMaterializationCount() const {
+        return materialization_count_;
+    }
+    // Source positions of a kFloat model; empty for kQuantized16.
+    const PositionsSoA& GetSourcePositions() const {
+        return geometry_->positions;
+    }
+    // Source positions of a kQuantized16 model; empty for kFloat.
+    const QuantizedPositions& GetQuantizedPositions() const {
+        return geometry_->quantized;
+    }
+    PositionStorage GetPositionStorage() const {
+        return geometry_->IsQuantized() ? PositionStorage::kQuantized16
+                                        : PositionStorage::kFloat;
+    }
+    // Zero for kFloat.
+    const QuantizationError& GetQuantizationError() const {
+        return geometry_->quantization_error;
+    }
+    // Memory held by the source positions.
+    std::size_t GetPositionBytes() const;
+    const FaceList& GetFaces() const { return geometry_->faces; }
+    // Edges are in cluster order, see edge_bvh.hpp.
+    const EdgeList& GetEdges() const { return geometry_->edges; }
+    const EdgeBvh& GetEdgeBvh() const { return geometry_->edge_bvh; }
+    // Bounds of the source positions, before any transform.
+    const Bounds& GetBounds() const { return geometry_->bounds; }
+    // Row-major 4x4 matrix taking source positions to transformed ones.
+    std::array<float, 16> GetModelMatrix() const;
+
+    // Finds the nearest face hit by `ray`, given in transformed coordinates.
+    // The ray is mapped back to source space, so the face hierarchy built
+    // at load time stays valid through every transform.
+    bool Pick(const Ray& ray, PickResult& result) const;
+
+    // Publishes the current state as the latest snapshot, transforming the
+    // vertices first in kCpu, and returns it. The latest snapshot is reused
+    // while it is current. Only one thread may publish at a time, and not
+    // while another one changes the model.
+    std::shared_ptr<const ModelSnapshot> Publish() const;
+    // The snapshot of the last Publish(), nullptr before the first. Lock
+    // free, so a render thread can take one while another thread publishes,
+    // but only one thread may take snapshots at a time.
+    std::shared_ptr<const ModelSnapshot> LatestSnapshot() const;
+
+    // Bumped whenever the source geometry (positions or faces) is replaced.
+    std::uint64_t GetGeometryRevision() const { return geometry_revision_; }
+    // Bumped whenever the transform parameters change.
+    std::uint64_t GetTransformRevision() const { return transform_revision_; }
+
+    // Phases of the last load, or of the last computation of the
+    // transformed vertices.
+    const PhaseTimings& GetLastPhases() const { return last_phases_; }
 
     std::string GetFilename() const { return filename_; }
-    int GetVertexCount() const { return vertices_.size(); }
-    int GetEdgeCount() const { return edge_count_; }
+    bool WasLoadedFromCache() const { return loaded_from_cache_; }
+    int GetVertexCount() const { return geometry_->VertexCount(); }
+    int GetEdgeCount() const { return geometry_->edges.size(); }
+    int GetBoundaryEdgeCount() const {
+        return geometry_->edges.BoundaryCount();
+    }
+    int GetNonManifoldEdgeCount() const {
+        return geometry_->edges.NonManifoldCount();
+    }
 
    private:
-    std::vector<Vertex> vertices_;
-    std::vector<Vertex> original_vertices_;
-    std::vector<Face> faces_;
+    using VertexBuffer = std::shared_ptr<std::vector<Vertex>>;
+
+    // Published snapshots share vertices_, which is then left alone: the
+    // next transform writes to spare_vertices_ once no snapshot holds it,
+    // or to a new array, and the two swap.
+    mutable VertexBuffer vertices_{std::make_shared<std::vector<Vertex>>()};
+    mutable VertexBuffer spare_vertices_;
+    mutable bool vertices_dirty_{false};
+    std::shared_ptr<ModelGeometry> geometry_{
+        std::make_shared<ModelGeometry>()};
+    TransformMode transform_mode_{TransformMode::kCpu};
+    mutable SnapshotHandoff snapshots_;
     std::string filename_;
-    int edge_count_{0};
+    bool loaded_from_cache_{false};
+    std::uint64_t geometry_revision_{0};
+    std::uint64_t transform_revision_{0};
+    mutable PhaseTimings last_phases_;
+    mutable std::uint64_t materialization_count_{0};
 
     float current_translate_x_{0.0f};
     float current_translate_y_{0.0f};
@@ -50,8 +270,13 @@ class Model {
     float current_rotate_z_{0.0f};
     float current_scale_{1.0f};
 
-    void CalculateEdgeCount();
-    void ApplyAllTransformations();
+    bool LoadInPlace(const std::string& filename, const LoadOptions& options);
+    bool ParseFile(const std::string& filename, const LoadOptions& options);
+    void SyncVerticesWithMode();
+    void OnTransformChanged();
+    VertexTransform CurrentTransform() const;
+    void ApplyAllTransformations() const;
+    void ReleaseVertices();
 };
 
 }  // namespace viewer3d
@@ -0,0 +1,48 @@
+#ifndef MODEL_CACHE_H
+#define MODEL_CACHE_H
+
+#include <cstdint>
+#include <string>
+
+#include "model/bounds.hpp"
+#include "model/edge_list.hpp"
+#include "model/face_list.hpp"
+#include "model/transform_kernel.hpp"
+
+namespace viewer3d {
+
+enum class CacheMode {
+    kBypass,   // never read or write the cache
+    kUse,      // read a valid cache, otherwise parse and write one
+    kRebuild,  // always parse and overwrite the cache
+};
+
+// Identifies the version of a source file a cache was built from. The hash
+// covers every byte of the file, so an edit that keeps the size and the
+// mtime still invalidates the cache.
+struct SourceStamp {
+    std::uint64_t size{0};
+    std::int64_t mtime{0};
+    std::uint64_t hash{0};
+};
+
+bool StampSourceFile(const std::string& filename, SourceStamp& stamp);
+
+// Cache file for `source`: "<source>.v3dcache" beside it when `cache_dir`
+// is empty, otherwise a name derived from the absolute source path inside
+// `cache_dir`.
+std::string ModelCachePath(const std::string& source,
+                           const std::string& cache_dir);
+
+// Fails, leaving the outputs untouched, when the cache is missing, was
+// written by another format version or does not match `stamp`.
+bool ReadModelCache(const std::string& path, const SourceStamp& stamp,
+                    PositionsSoA& positions, FaceList& faces, EdgeList& edges,
+                    Bounds& bounds);
+bool WriteModelCache(const std::string& path, const SourceStamp& stamp,
+                     const PositionsSoA& positions, const FaceList& faces,
+                     const EdgeList& edges, const Bounds& bounds);
+
+}  // namespace viewer3d
+
+#endif
@@ -0,0 +1,67 @@
+#include "model/morton.hpp"
+
+#include <algorithm>
+#include <cstddef>
+
+namespace viewer3d {
+
+namespace {
+
+constexpr std::uint32_t kCells = 1u << MortonEncoder::kBitsPerAxis;
+
+// Spreads the low 10 bits of `v` to every third bit.
+std::uint32_t SpreadBits(std::uint32_t v) {
+    v &= kCells - 1;
+    v = (v | (v << 16)) & 0x030000FF;
+    v = (v | (v << 8)) & 0x0300F00F;
+    v = (v | (v << 4)) & 0x030C30C3;
+    v = (v | (v << 2)) & 0x09249249;
+    return v;
+}
+
+std::uint32_t Quantize(float value, float min, float scale) {
+    const float cell = (value - min) * scale;
+    return cell <= 0.0f
+               ? 0
+               : std::min(static_cast<std::uint32_t>(cell), kCells - 1);
+}
+
+}  // namespace
+
+MortonEncoder::MortonEncoder(const Bounds& bounds) : min_(bounds.min) {
+    const float extent[3] = {bounds.max.x - bounds.min.x,
+                             bounds.max.y - bounds.min.y,
+                             bounds.max.z - bounds.min.z};
+    for (int axis = 0; axis < 3; ++axis) {
+        scale_[axis] = extent[axis] > 0.0f ? kCells / extent[axis] : 0.0f;
+    }
+}
+
+std::uint32_t MortonEncoder::operator()(float x, float y, float z) const {
+    return SpreadBits(Quantize(x, min_.x, scale_[0])) |
+           (SpreadBits(Quantize(y, min_.y, scale_[1])) << 1) |
+           (SpreadBits(Quantize(z, min_.z, scale_[2])) << 2);
+}
+
+// Least significant digit radix sort over the 30 code bits, 10 per pass.
+void SortByMortonCode(std::vector<std::uint64_t>& keys) {
+    constexpr int kCodeShift = 32;
+    std::vector<std::uint64_t> buffer(keys.size());
+    std::vector<std::size_t> offsets(kCells + 1);
+    for (int pass = 0; pass < 3; ++pass) {
+        const int shift = kCodeShift + pass * MortonEncoder::kBitsPerAxis;
+        std::fill(offsets.begin(), offsets.end(), 0);
+        for (std::uint64_t key : keys) {
+            offsets[((key >> shift) & (kCells - 1)) + 1]++;
+        }
+        for (std::uint32_t i = 0; i < kCells; ++i) {
+            offsets[i + 1] += offsets[i];
+        }
+        for (std::uint64_t key : keys) {
+            buffer[offsets[(key >> shift) & (kCells - 1)]++] = key;
+        }
+        keys.swap(buffer);
+    }
+}
+
+}  // namespace viewer3d
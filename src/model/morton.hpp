@@ -0,0 +1,32 @@
+#ifndef MORTON_H
+#define MORTON_H
+
+#include <cstdint>
+#include <vector>
+
+#include "model/bounds.hpp"
+
+namespace viewer3d {
+
+// 30-bit Morton codes of points quantized to a 1024^3 grid over `bounds`.
+// Points outside the bounds are clamped to the nearest cell.
+class MortonEncoder {
+   public:
+    static constexpr int kBitsPerAxis = 10;
+
+    explicit MortonEncoder(const Bounds& bounds);
+
+    std::uint32_t operator()(float x, float y, float z) const;
+
+   private:
+    Vertex min_;
+    float scale_[3];
+};
+
+// Sorts keys holding a Morton code in their upper 32 bits, e.g. with an
+// index below it. Keys with equal codes keep their order.
+void SortByMortonCode(std::vector<std::uint64_t>& keys);
+
+}  // namespace viewer3d
+
+#endif
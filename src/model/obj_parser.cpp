@@ -0,0 +1,600 @@
+#include "model/obj_parser.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <charconv>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <sstream>
+
+#include "model/arena_list.hpp"
+#include "model/mapped_file.hpp"
+#include "model/parallel.hpp"
+#include "model/trace.hpp"
+
+namespace viewer3d {
+
+namespace {
+void Warn(const ParseControl& control, int line_number, const char* message) {
+    if (control.on_warning) {
+        control.on_warning(line_number, message);
+        return;
+    }
+    std::cerr << "Warning: " << message << " in the row " << line_number
+              << std::endl;
+}
+
+void WarnVertexData(const ParseControl& control, int line_number) {
+    Warn(control, line_number, "incorrect vertex data");
+}
+
+void WarnVertexIndex(const ParseControl& control, int line_number) {
+    Warn(control, line_number, "incorrect vertex index");
+}
+
+void WarnIndexRange(const ParseControl& control, int line_number) {
+    Warn(control, line_number, "the index of the vertex is out of range");
+}
+
+bool IsSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+const char* SkipSpaces(const char* p, const char* end) {
+    while (p < end && IsSpace(*p)) {
+        ++p;
+    }
+    return p;
+}
+
+const char* SkipToken(const char* p, const char* end) {
+    while (p < end && !IsSpace(*p)) {
+        ++p;
+    }
+    return p;
+}
+
+// std::from_chars does not accept a leading '+', while the stream extractors
+// used by ParseObjStream do.
+const char* SkipPlus(const char* p, const char* end) {
+    if (p + 1 < end && *p == '+' && p[1] != '-' && p[1] != '+') {
+        return p + 1;
+    }
+    return p;
+}
+
+bool IsDigit(char c) { return c >= '0' && c <= '9'; }
+
+// Rejects "inf" and "nan", which std::from_chars accepts but the stream
+// extractors do not.
+bool StartsNumber(const char* p, const char* end) {
+    if (p < end && *p == '-') {
+        ++p;
+    }
+    return p < end && (IsDigit(*p) || *p == '.');
+}
+
+bool ParseFloat(const char*& p, const char* end, float& value) {
+    p = SkipPlus(SkipSpaces(p, end), end);
+    if (!StartsNumber(p, end)) {
+        return false;
+    }
+#if defined(__cpp_lib_to_chars)
+    auto result = std::from_chars(p, end, value);
+    if (result.ec != std::errc()) {
+        return false;
+    }
+    p = result.ptr;
+#else
+    constexpr std::size_t kMaxNumberLength = 64;
+    char buffer[kMaxNumberLength + 1];
+    std::size_t length = std::min<std::size_t>(end - p, kMaxNumberLength);
+    std::memcpy(buffer, p, length);
+    buffer[length] = '\0';
+    char* parsed_end = nullptr;
+    errno = 0;
+    value = std::strtof(buffer, &parsed_end);
+    if (parsed_end == buffer || errno == ERANGE) {
+        return false;
+    }
+    p += parsed_end - buffer;
+#endif
+    return true;
+}
+
+bool ParseInt(const char* p, const char* end, int& value) {
+    p = SkipPlus(p, end);
+    auto result = std::from_chars(p, end, value);
+    return result.ec == std::errc();
+}
+
+// Sentinels stored in ObjChunk::raw_indices. A parsed 0 is always out of
+// range, and so is INT_MIN once resolved, so both collapse to kRangeError.
+constexpr int kSyntaxError = std::numeric_limits<int>::min();
+constexpr int kRangeError = 0;
+
+constexpr unsigned kChunksPerThread = 4;
+// Upper bound on chunk size, so that huge files still report progress and
+// notice cancellation on a single thread.
+constexpr std::size_t kMaxChunkBytes = 64 << 20;
+// Smaller chunks when streaming, so the first batch is published early.
+constexpr std::size_t kMaxStreamingChunkBytes = 4 << 20;
+constexpr std::size_t kProgressStepBytes = 4 << 20;
+constexpr int kStreamProgressLines = 1 << 16;
+constexpr int kStreamBatchLines = 1 << 18;
+// The first buffer of a chunk arena is as large as the chunk text, which
+// holds the raw faces of most files. Pages are only touched as they are
+// filled, and later buffers grow geometrically.
+constexpr std::size_t kMinArenaBytes = 1 << 16;
+
+// Sums parsed bytes over all chunk workers and forwards them to the
+// ParseControl.
+class ProgressMeter {
+   public:
+    ProgressMeter(const ParseControl& control, std::uint64_t total)
+        : control_(control), total_(total) {}
+
+    // Returns false once the parse has been cancelled.
+    bool Advance(std::uint64_t bytes) {
+        const std::uint64_t done = done_.fetch_add(bytes) + bytes;
+        if (control_.progress) {
+            control_.progress(done, total_);
+        }
+        return !control_.Cancelled();
+    }
+
+    bool Cancelled() const { return control_.Cancelled(); }
+
+   private:
+    const ParseControl& control_;
+    const std::uint64_t total_;
+    std::atomic<std::uint64_t> done_{0};
+};
+
+enum class WarningKind { kVertexData, kVertexIndex, kIndexRange };
+
+struct ParseWarning {
+    int line;
+    WarningKind kind;
+};
+
+struct RawFace {
+    std::size_t indices_end;
+    int vertex_count;  // vertices seen in the chunk before this face
+    int line;          // line number inside the chunk, 1-based
+};
+
+// Result of tokenizing one line-aligned slice of the file. Face indices are
+// kept as written because relative indices and range checks depend on the
+// number of vertices before the chunk, which is only known after all chunks
+// before it are parsed. The raw faces live in a per-chunk arena that is
+// dropped as a whole once they are resolved.
+struct ObjChunk {
+    const char* begin{nullptr};
+    const char* end{nullptr};
+
+    int line_count{0};
+    std::vector<Vertex> vertices;
+    std::unique_ptr<std::pmr::monotonic_buffer_resource> arena;
+    ArenaList<int> raw_indices;
+    ArenaList<RawFace> raw_faces;
+    std::vector<ParseWarning> warnings;
+
+    FaceList faces;
+};
+
+void ParseVertexLine(const char* p, const char* end, int line_number,
+                     ObjChunk& chunk) {
+    Vertex vertex;
+    if (!ParseFloat(p, end, vertex.x) || !ParseFloat(p, end, vertex.y) ||
+        !ParseFloat(p, end, vertex.z)) {
+        chunk.warnings.push_back({line_number, WarningKind::kVertexData});
+        return;
+    }
+    chunk.vertices.push_back(vertex);
+}
+
+void ParseFaceLine(const char* p, const char* end, int line_number,
+                   ObjChunk& chunk) {
+    for (p = SkipSpaces(p, end); p < end; p = SkipSpaces(p, end)) {
+        const char* token_end = SkipToken(p, end);
+        int v_index;
+        if (!ParseInt(p, token_end, v_index)) {
+            v_index = kSyntaxError;
+        } else if (v_index == kSyntaxError) {
+            v_index = kRangeError;
+        }
+        chunk.raw_indices.push_back(v_index);
+        p = token_end;
+    }
+
+    chunk.raw_faces.push_back({chunk.raw_indices.size(),
+                               static_cast<int>(chunk.vertices.size()),
+                               line_number});
+}
+
+void ParseChunk(ObjChunk& chunk, ProgressMeter& meter) {
+    VIEWER3D_TRACE_ZONE("ParseChunk");
+    const char* p = chunk.begin;
+    const char* const end = chunk.end;
+    const char* reported = p;
+    int line_number = 0;
+
+    chunk.arena = std::make_unique<std::pmr::monotonic_buffer_resource>(
+        std::max<std::size_t>(end - p, kMinArenaBytes));
+    chunk.raw_indices = ArenaList<int>(*chunk.arena);
+    chunk.raw_faces = ArenaList<RawFace>(*chunk.arena);
+
+    while (p < end) {
+        if (static_cast<std::size_t>(p - reported) >= kProgressStepBytes) {
+            if (!meter.Advance(p - reported)) {
+                return;
+            }
+            reported = p;
+        }
+
+        const char* line_end =
+            static_cast<const char*>(std::memchr(p, '\n', end - p));
+        if (line_end == nullptr) {
+            line_end = end;
+        }
+        line_number++;
+
+        const char* token = SkipSpaces(p, line_end);
+        const char* token_end = SkipToken(token, line_end);
+        const std::size_t token_length = token_end - token;
+
+        if (token_length == 1 && *token == 'v') {
+            ParseVertexLine(token_end, line_end, line_number, chunk);
+        } else if (token_length == 1 && *token == 'f') {
+            ParseFaceLine(token_end, line_end, line_number, chunk);
+        }
+
+        p = line_end + 1;
+    }
+
+    chunk.line_count = line_number;
+    meter.Advance(end - reported);
+}
+
+// Turns raw indices into 0-based ones exactly as a sequential pass would,
+// given the number of vertices in all previous chunks.
+void ResolveChunk(long long vertex_base, ObjChunk& chunk) {
+    VIEWER3D_TRACE_ZONE("ResolveChunk");
+    std::vector<ParseWarning> face_warnings;
+    std::vector<int> scratch;
+    std::size_t index_begin = 0;
+    chunk.faces.reserve(chunk.raw_faces.size(), chunk.raw_indices.size());
+
+    for (std::size_t f = 0; f < chunk.raw_faces.size(); ++f) {
+        const RawFace& raw_face = chunk.raw_faces[f];
+        const long long vertex_count = vertex_base + raw_face.vertex_count;
+        scratch.clear();
+
+        for (std::size_t i = index_begin; i < raw_face.indices_end; ++i) {
+            const int v_index = chunk.raw_indices[i];
+            if (v_index == kSyntaxError) {
+                face_warnings.push_back(
+                    {raw_face.line, WarningKind::kVertexIndex});
+                continue;
+            }
+
+            long long resolved = v_index;
+            if (resolved < 0) {
+                resolved = vertex_count + resolved + 1;
+            }
+
+            if (resolved <= 0 || resolved > vertex_count) {
+                face_warnings.push_back(
+                    {raw_face.line, WarningKind::kIndexRange});
+                continue;
+            }
+
+            scratch.push_back(static_cast<int>(resolved - 1));
+        }
+        index_begin = raw_face.indices_end;
+
+        if (scratch.size() >= 2) {
+            chunk.faces.AddFace(scratch.begin(), scratch.end());
+        }
+    }
+
+    std::vector<ParseWarning> warnings(chunk.warnings.size() +
+                                       face_warnings.size());
+    std::merge(chunk.warnings.begin(), chunk.warnings.end(),
+               face_warnings.begin(), face_warnings.end(), warnings.begin(),
+               [](const ParseWarning& lhs, const ParseWarning& rhs) {
+                   return lhs.line < rhs.line;
+               });
+    chunk.warnings = std::move(warnings);
+
+    chunk.raw_indices = ArenaList<int>();
+    chunk.raw_faces = ArenaList<RawFace>();
+    chunk.arena.reset();
+}
+
+void ReportWarnings(const ObjChunk& chunk, int line_base,
+                    const ParseControl& control) {
+    for (const ParseWarning& warning : chunk.warnings) {
+        const int line_number = line_base + warning.line;
+        switch (warning.kind) {
+            case WarningKind::kVertexData:
+                WarnVertexData(control, line_number);
+                break;
+            case WarningKind::kVertexIndex:
+                WarnVertexIndex(control, line_number);
+                break;
+            case WarningKind::kIndexRange:
+                WarnIndexRange(control, line_number);
+                break;
+        }
+    }
+}
+
+std::vector<ObjChunk> SplitIntoChunks(const char* data, std::size_t size,
+                                      unsigned threads,
+                                      std::size_t min_chunk_bytes,
+                                      std::size_t max_chunk_bytes) {
+    std::size_t chunk_count = 1;
+    if (threads > 1) {
+        chunk_count = std::max<std::size_t>(
+            1, std::min<std::size_t>(size / std::max<std::size_t>(
+                                                min_chunk_bytes, 1),
+                                     threads * kChunksPerThread));
+    }
+    chunk_count = std::max(chunk_count, (size + max_chunk_bytes - 1) /
+                                            max_chunk_bytes);
+
+    std::vector<ObjChunk> chunks;
+    chunks.reserve(chunk_count);
+    const char* const end = data + size;
+    const char* begin = data;
+
+    for (std::size_t i = 1; i <= chunk_count && begin < end; ++i) {
+        const char* chunk_end = end;
+        if (i < chunk_count) {
+            chunk_end = data + size / chunk_count * i;
+            if (chunk_end < begin) {
+                chunk_end = begin;
+            }
+            const void* newline = std::memchr(chunk_end, '\n', end - chunk_end);
+            chunk_end =
+                newline ? static_cast<const char*>(newline) + 1 : end;
+        }
+
+        chunks.emplace_back();
+        chunks.back().begin = begin;
+        chunks.back().end = chunk_end;
+        begin = chunk_end;
+    }
+
+    return chunks;
+}
+
+// Publishes what the stream parser added to `data` since the previous batch.
+void PublishBatch(const ObjData& data, const BatchCallback& on_batch,
+                  std::size_t& vertex_begin, std::size_t& face_begin) {
+    if (vertex_begin == data.vertices.size() &&
+        face_begin == data.faces.size()) {
+        return;
+    }
+
+    const std::vector<Vertex> vertices(data.vertices.begin() + vertex_begin,
+                                       data.vertices.end());
+    FaceList faces;
+    for (std::size_t i = face_begin; i < data.faces.size(); ++i) {
+        const FaceView face = data.faces[i];
+        faces.AddFace(face.begin(), face.end());
+    }
+    on_batch(vertices, faces);
+
+    vertex_begin = data.vertices.size();
+    face_begin = data.faces.size();
+}
+
+void ResolveChunks(std::vector<ObjChunk>& chunks, unsigned threads) {
+    std::vector<long long> vertex_bases(chunks.size());
+    long long vertex_total = 0;
+    for (std::size_t i = 0; i < chunks.size(); ++i) {
+        vertex_bases[i] = vertex_total;
+        vertex_total += chunks[i].vertices.size();
+    }
+
+    RunOnWorkers(chunks.size(), threads, [&](std::size_t i) {
+        ResolveChunk(vertex_bases[i], chunks[i]);
+    });
+}
+
+// Parses the chunks like RunOnWorkers + ResolveChunks, but resolves and
+// publishes every chunk as soon as all chunks before it are parsed.
+void ParseAndPublishChunks(std::vector<ObjChunk>& chunks, unsigned threads,
+                           ProgressMeter& meter,
+                           const BatchCallback& on_batch) {
+    std::mutex mutex;
+    std::vector<char> parsed(chunks.size(), 0);
+    std::size_t next = 0;
+    long long vertex_base = 0;
+
+    RunOnWorkers(chunks.size(), threads, [&](std::size_t i) {
+        if (!meter.Cancelled()) {
+            ParseChunk(chunks[i], meter);
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        parsed[i] = 1;
+        while (next < chunks.size() && parsed[next] && !meter.Cancelled()) {
+            ObjChunk& chunk = chunks[next];
+            ResolveChunk(vertex_base, chunk);
+            vertex_base += chunk.vertices.size();
+            on_batch(chunk.vertices, chunk.faces);
+            next++;
+        }
+    });
+}
+
+}  // namespace
+
+bool ParseObjStream(const std::string& filename, ObjData& data,
+                    const ParseControl& control) {
+    VIEWER3D_TRACE_ZONE("ParseObjStream");
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        std::cerr << "Error: couldn't open the file " << filename << std::endl;
+        return false;
+    }
+
+    file.seekg(0, std::ios::end);
+    const std::uint64_t total = static_cast<std::uint64_t>(file.tellg());
+    file.seekg(0, std::ios::beg);
+
+    // Reused for every line instead of being built per line.
+    std::string line;
+    std::istringstream iss;
+    std::string token;
+    std::vector<int> face;
+    std::string vertex_index;
+    std::istringstream vertex_stream;
+    int line_number = 0;
+    std::size_t batch_vertices = 0;
+    std::size_t batch_faces = 0;
+
+    while (std::getline(file, line)) {
+        line_number++;
+        if (control.on_batch && line_number % kStreamBatchLines == 0) {
+            PublishBatch(data, control.on_batch, batch_vertices, batch_faces);
+        }
+        if (line_number % kStreamProgressLines == 0) {
+            if (control.progress) {
+                control.progress(static_cast<std::uint64_t>(file.tellg()),
+                                 total);
+            }
+            if (control.Cancelled()) {
+                return false;
+            }
+        }
+        iss.clear();
+        iss.str(line);
+        token.clear();
+        iss >> token;
+
+        if (token == "v") {
+            Vertex vertex;
+            if (!(iss >> vertex.x >> vertex.y >> vertex.z)) {
+                WarnVertexData(control, line_number);
+                continue;
+            }
+            data.vertices.push_back(vertex);
+        } else if (token == "f") {
+            face.clear();
+            while (iss >> vertex_index) {
+                vertex_stream.clear();
+                vertex_stream.str(vertex_index);
+                int v_index;
+                if (!(vertex_stream >> v_index)) {
+                    WarnVertexIndex(control, line_number);
+                    continue;
+                }
+
+                if (v_index < 0) {
+                    v_index = data.vertices.size() + v_index + 1;
+                }
+
+                if (v_index <= 0 ||
+                    v_index > static_cast<int>(data.vertices.size())) {
+                    WarnIndexRange(control, line_number);
+                    continue;
+                }
+
+                face.push_back(v_index - 1);
+            }
+            if (face.size() >= 2) {
+                data.faces.AddFace(face.begin(), face.end());
+            }
+        }
+    }
+
+    if (control.on_batch) {
+        PublishBatch(data, control.on_batch, batch_vertices, batch_faces);
+    }
+    if (control.progress) {
+        control.progress(total, total);
+    }
+    return true;
+}
+
+bool ParseObjMapped(const std::string& filename, ObjData& data,
+                    unsigned threads, std::size_t min_chunk_bytes,
+                    const ParseControl& control) {
+    VIEWER3D_TRACE_ZONE("ParseObjMapped");
+    MappedFile file;
+    if (!file.Open(filename)) {
+        std::cerr << "Error: couldn't open the file " << filename << std::endl;
+        return false;
+    }
+
+    threads = ResolveThreadCount(threads);
+
+    std::vector<ObjChunk> chunks = SplitIntoChunks(
+        file.Data(), file.Size(), threads, min_chunk_bytes,
+        control.on_batch ? kMaxStreamingChunkBytes : kMaxChunkBytes);
+    ProgressMeter meter(control, file.Size());
+    if (control.on_batch) {
+        ParseAndPublishChunks(chunks, threads, meter, control.on_batch);
+    } else {
+        RunOnWorkers(chunks.size(), threads, [&](std::size_t i) {
+            if (!meter.Cancelled()) {
+                ParseChunk(chunks[i], meter);
+            }
+        });
+        if (!meter.Cancelled()) {
+            ResolveChunks(chunks, threads);
+        }
+    }
+    if (meter.Cancelled()) {
+        return false;
+    }
+
+    std::size_t vertex_total = 0;
+    std::size_t face_total = 0;
+    std::size_t index_total = 0;
+    for (const ObjChunk& chunk : chunks) {
+        vertex_total += chunk.vertices.size();
+        face_total += chunk.faces.size();
+        index_total += chunk.faces.IndexCount();
+    }
+    const bool move_single_chunk =
+        chunks.size() == 1 && data.vertices.empty() && data.faces.empty();
+    if (!move_single_chunk) {
+        data.vertices.reserve(data.vertices.size() + vertex_total);
+        data.faces.reserve(data.faces.size() + face_total,
+                           data.faces.IndexCount() + index_total);
+    }
+
+    int line_base = 0;
+    for (ObjChunk& chunk : chunks) {
+        ReportWarnings(chunk, line_base, control);
+        line_base += chunk.line_count;
+
+        if (move_single_chunk) {
+            data.vertices = std::move(chunk.vertices);
+            data.faces = std::move(chunk.faces);
+        } else {
+            data.vertices.insert(data.vertices.end(), chunk.vertices.begin(),
+                                 chunk.vertices.end());
+            data.faces.Append(chunk.faces);
+        }
+        chunk = ObjChunk();
+    }
+
+    return true;
+}
+
+}  // namespace viewer3d
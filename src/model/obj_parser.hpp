@@ -0,0 +1,39 @@
+#ifndef OBJ_PARSER_H
+#define OBJ_PARSER_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "model/model.hpp"
+#include "model/parse_control.hpp"
+
+namespace viewer3d {
+
+constexpr std::size_t kDefaultMinChunkBytes = 1 << 20;
+
+struct ObjData {
+    std::vector<Vertex> vertices;
+    FaceList faces;
+};
+
+// Both parsers accept the same subset of OBJ: "v x y z" and "f i j k ..."
+// records, 1-based or negative (relative) indices, "v/vt/vn" style tokens of
+// which only the vertex index is used. Malformed records are skipped with a
+// warning on stderr. Both report progress and stop early, returning false,
+// through `control`.
+bool ParseObjStream(const std::string& filename, ObjData& data,
+                    const ParseControl& control = ParseControl());
+
+// Splits the mapped file into line-aligned chunks of at least
+// `min_chunk_bytes` and parses them on up to `threads` threads (0 picks the
+// hardware concurrency). The result and the warnings do not depend on the
+// thread count.
+bool ParseObjMapped(const std::string& filename, ObjData& data,
+                    unsigned threads = 1,
+                    std::size_t min_chunk_bytes = kDefaultMinChunkBytes,
+                    const ParseControl& control = ParseControl());
+
+}  // namespace viewer3d
+
+#endif
@@ -0,0 +1,80 @@
+#include "model/obj_writer.hpp"
+
+#include <charconv>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+#include "model/temp_path.hpp"
+
+namespace viewer3d {
+
+namespace {
+
+constexpr std::size_t kFlushBytes = 1 << 20;
+
+void AppendFloat(std::string& out, float value) {
+    char buffer[32];
+    const auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    out.append(buffer, result.ptr);
+}
+
+void AppendIndex(std::string& out, int value) {
+    char buffer[16];
+    const auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    out.append(buffer, result.ptr);
+}
+
+void Flush(std::ofstream& file, std::string& buffer) {
+    file.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    buffer.clear();
+}
+
+}  // namespace
+
+bool WriteObjFile(const std::string& filename,
+                  const std::vector<Vertex>& vertices, const FaceList& faces) {
+    const std::string temp_path = UniqueTempPath(filename);
+    std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        std::cerr << "Error: cannot write the file " << filename << std::endl;
+        return false;
+    }
+
+    std::string buffer;
+    buffer.reserve(kFlushBytes + 256);
+    for (const Vertex& vertex : vertices) {
+        buffer += "v ";
+        AppendFloat(buffer, vertex.x);
+        buffer += ' ';
+        AppendFloat(buffer, vertex.y);
+        buffer += ' ';
+        AppendFloat(buffer, vertex.z);
+        buffer += '\n';
+        if (buffer.size() >= kFlushBytes) {
+            Flush(file, buffer);
+        }
+    }
+    for (const FaceView face : faces) {
+        buffer += 'f';
+        for (const int index : face) {
+            buffer += ' ';
+            AppendIndex(buffer, index + 1);
+        }
+        buffer += '\n';
+        if (buffer.size() >= kFlushBytes) {
+            Flush(file, buffer);
+        }
+    }
+    Flush(file, buffer);
+    file.close();
+
+    if (!file || std::rename(temp_path.c_str(), filename.c_str()) != 0) {
+        std::cerr << "Error: cannot write the file " << filename << std::endl;
+        std::remove(temp_path.c_str());
+        return false;
+    }
+    return true;
+}
+
+}  // namespace viewer3d
@@ -0,0 +1,20 @@
+#ifndef OBJ_WRITER_H
+#define OBJ_WRITER_H
+
+#include <string>
+#include <vector>
+
+#include "model/face_list.hpp"
+#include "model/vertex.hpp"
+
+namespace viewer3d {
+
+// Writes "v x y z" records, with the shortest text that reads back to the
+// same floats, followed by 1-based "f" records. The file is written under a
+// temporary name and renamed, so a failed write leaves no partial file.
+bool WriteObjFile(const std::string& filename,
+                  const std::vector<Vertex>& vertices, const FaceList& faces);
+
+}  // namespace viewer3d
+
+#endif
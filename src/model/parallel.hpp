@@ -0,0 +1,72 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <algorithm>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+#include "model/job_system.hpp"
+
+namespace viewer3d {
+
+// 0 means one thread per hardware thread.
+inline unsigned ResolveThreadCount(unsigned threads) {
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    return threads;
+}
+
+// Runs task(i) for every i in [0, count) on up to `threads` threads of the
+// current job system, the calling thread included. An exception thrown by a
+// task reaches the caller, as it would from a plain loop.
+template <typename Task>
+void RunOnWorkers(std::size_t count, unsigned threads, Task task) {
+    const unsigned worker_count = static_cast<unsigned>(
+        std::min<std::size_t>(ResolveThreadCount(threads), count));
+    if (worker_count <= 1) {
+        for (std::size_t i = 0; i < count; ++i) {
+            task(i);
+        }
+        return;
+    }
+    JobSystem::Current().Run(count, worker_count - 1, task);
+}
+
+// Runs task(begin, end) over consecutive ranges of at most `grain` items
+// covering [0, count). Counts up to `grain` run on the calling thread.
+template <typename Task>
+void ParallelFor(std::size_t count, std::size_t grain, unsigned threads,
+                 Task task) {
+    const std::size_t chunks = (count + grain - 1) / grain;
+    RunOnWorkers(chunks, threads, [&](std::size_t chunk) {
+        task(chunk * grain, std::min(count, (chunk + 1) * grain));
+    });
+}
+
+// Folds map(begin, end) over the ranges of ParallelFor with combine(),
+// starting from `init`. Ranges are combined in order, so the result does
+// not depend on the thread count.
+template <typename T, typename Map, typename Combine>
+T ParallelReduce(std::size_t count, std::size_t grain, unsigned threads,
+                 T init, Map map, Combine combine) {
+    const std::size_t chunks = (count + grain - 1) / grain;
+    if (chunks <= 1) {
+        return count == 0 ? init : combine(init, map(0, count));
+    }
+    std::vector<T> partials(chunks, init);
+    RunOnWorkers(chunks, threads, [&](std::size_t chunk) {
+        partials[chunk] =
+            map(chunk * grain, std::min(count, (chunk + 1) * grain));
+    });
+    T result = init;
+    for (const T& partial : partials) {
+        result = combine(result, partial);
+    }
+    return result;
+}
+
+}  // namespace viewer3d
+
+#endif
@@ -0,0 +1,48 @@
+#ifndef PARSE_CONTROL_H
+#define PARSE_CONTROL_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "model/face_list.hpp"
+#include "model/vertex.hpp"
+
+namespace viewer3d {
+
+using ProgressCallback =
+    std::function<void(std::uint64_t bytes_done, std::uint64_t bytes_total)>;
+// Receives the vertices and faces parsed since the previous call, in file
+// order. Face indices refer to all vertices published so far.
+using BatchCallback = std::function<void(const std::vector<Vertex>& vertices,
+                                         const FaceList& faces)>;
+// Receives a malformed record, e.g. "incorrect vertex data", and its 1-based
+// line number.
+using WarningCallback =
+    std::function<void(int line_number, const std::string& message)>;
+
+// Hooks for long-running loads.
+struct ParseControl {
+    // Called with the number of source bytes parsed so far. Parallel parses
+    // call it from worker threads, so consecutive values may arrive out of
+    // order.
+    ProgressCallback progress;
+    // Polled while parsing; once set the parse stops and fails.
+    const std::atomic<bool>* cancel{nullptr};
+    // Enables streaming: the parse publishes its result in batches while it
+    // runs. Called from worker threads, but never concurrently.
+    BatchCallback on_batch;
+    // Replaces the warnings printed to stderr. Called in file order and
+    // never concurrently, after the parse for the mapped backend.
+    WarningCallback on_warning;
+
+    bool Cancelled() const {
+        return cancel != nullptr && cancel->load(std::memory_order_relaxed);
+    }
+};
+
+}  // namespace viewer3d
+
+#endif
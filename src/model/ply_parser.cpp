@@ -0,0 +1,683 @@
+#include "model/ply_parser.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <utility>
+#include <vector>
+
+#include "model/mapped_file.hpp"
+#include "model/trace.hpp"
+
+namespace viewer3d {
+
+namespace {
+enum class PlyFormat { kAscii, kBinaryLittleEndian, kBinaryBigEndian };
+
+enum class PlyType {
+    kInt8,
+    kUint8,
+    kInt16,
+    kUint16,
+    kInt32,
+    kUint32,
+    kFloat32,
+    kFloat64
+};
+
+struct PlyProperty {
+    std::string name;
+    PlyType type{PlyType::kFloat32};
+    // A list is a count of count_type followed by that many `type` values.
+    bool is_list{false};
+    PlyType count_type{PlyType::kUint8};
+};
+
+struct PlyElement {
+    std::string name;
+    std::size_t count{0};
+    std::vector<PlyProperty> properties;
+};
+
+struct PlyHeader {
+    PlyFormat format{PlyFormat::kAscii};
+    std::vector<PlyElement> elements;
+    std::size_t data_offset{0};
+    int line_count{0};
+};
+
+// Where the parts of the model are found in their elements.
+struct PlyLayout {
+    const PlyElement* vertex{nullptr};
+    int x{-1};
+    int y{-1};
+    int z{-1};
+    const PlyElement* face{nullptr};
+    int indices{-1};
+};
+
+constexpr std::size_t kItemsPerProgressStep = 1 << 16;
+
+void Warn(const ParseControl& control, int number, const char* message) {
+    if (control.on_warning) {
+        control.on_warning(number, message);
+        return;
+    }
+    std::cerr << "Warning: " << message << " in the row " << number
+              << std::endl;
+}
+
+bool ParseType(const std::string& name, PlyType& type) {
+    static const std::pair<const char*, PlyType> kTypes[] = {
+        {"char", PlyType::kInt8},      {"int8", PlyType::kInt8},
+        {"uchar", PlyType::kUint8},    {"uint8", PlyType::kUint8},
+        {"short", PlyType::kInt16},    {"int16", PlyType::kInt16},
+        {"ushort", PlyType::kUint16},  {"uint16", PlyType::kUint16},
+        {"int", PlyType::kInt32},      {"int32", PlyType::kInt32},
+        {"uint", PlyType::kUint32},    {"uint32", PlyType::kUint32},
+        {"float", PlyType::kFloat32},  {"float32", PlyType::kFloat32},
+        {"double", PlyType::kFloat64}, {"float64", PlyType::kFloat64},
+    };
+    for (const auto& [type_name, value] : kTypes) {
+        if (name == type_name) {
+            type = value;
+            return true;
+        }
+    }
+    return false;
+}
+
+std::size_t TypeSize(PlyType type) {
+    switch (type) {
+        case PlyType::kInt8:
+        case PlyType::kUint8:
+            return 1;
+        case PlyType::kInt16:
+        case PlyType::kUint16:
+            return 2;
+        case PlyType::kInt32:
+        case PlyType::kUint32:
+        case PlyType::kFloat32:
+            return 4;
+        case PlyType::kFloat64:
+            return 8;
+    }
+    return 0;
+}
+
+bool ReadHeader(const char* data, std::size_t size, PlyHeader& header) {
+    const char* p = data;
+    const char* const end = data + size;
+    bool magic = false;
+    bool format = false;
+
+    while (p < end) {
+        const char* line_end =
+            static_cast<const char*>(std::memchr(p, '\n', end - p));
+        if (line_end == nullptr) {
+            return false;
+        }
+        std::istringstream line(std::string(p, line_end));
+        p = line_end + 1;
+        header.line_count++;
+
+        std::string keyword;
+        line >> keyword;
+        if (!magic) {
+            if (keyword != "ply") {
+                return false;
+            }
+            magic = true;
+        } else if (keyword == "format") {
+            std::string name;
+            line >> name;
+            if (name == "ascii") {
+                header.format = PlyFormat::kAscii;
+            } else if (name == "binary_little_endian") {
+                header.format = PlyFormat::kBinaryLittleEndian;
+            } else if (name == "binary_big_endian") {
+                header.format = PlyFormat::kBinaryBigEndian;
+            } else {
+                return false;
+            }
+            format = true;
+        } else if (keyword == "element") {
+            PlyElement element;
+            if (!(line >> element.name >> element.count)) {
+                return false;
+            }
+            header.elements.push_back(std::move(element));
+        } else if (keyword == "property") {
+            if (header.elements.empty()) {
+                return false;
+            }
+            PlyProperty property;
+            std::string type;
+            line >> type;
+            if (type == "list") {
+                std::string count_type;
+                property.is_list = true;
+                line >> count_type >> type;
+                if (!ParseType(count_type, property.count_type)) {
+                    return false;
+                }
+            }
+            if (!ParseType(type, property.type) || !(line >> property.name)) {
+                return false;
+            }
+            header.elements.back().properties.push_back(std::move(property));
+        } else if (keyword == "end_header") {
+            header.data_offset = p - data;
+            return format;
+        }
+        // "comment", "obj_info" and unknown keywords carry no data.
+    }
+    return false;
+}
+
+int FindProperty(const PlyElement& element, const char* name) {
+    for (std::size_t i = 0; i < element.properties.size(); ++i) {
+        if (element.properties[i].name == name) {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+bool FindLayout(const PlyHeader& header, PlyLayout& layout) {
+    for (const PlyElement& element : header.elements) {
+        if (element.name == "vertex" && layout.vertex == nullptr) {
+            layout.vertex = &element;
+            layout.x = FindProperty(element, "x");
+            layout.y = FindProperty(element, "y");
+            layout.z = FindProperty(element, "z");
+        } else if (element.name == "face" && layout.face == nullptr) {
+            layout.face = &element;
+            layout.indices = FindProperty(element, "vertex_indices");
+            if (layout.indices < 0) {
+                layout.indices = FindProperty(element, "vertex_index");
+            }
+        }
+    }
+    if (layout.vertex == nullptr || layout.x < 0 || layout.y < 0 ||
+        layout.z < 0) {
+        return false;
+    }
+    for (int axis : {layout.x, layout.y, layout.z}) {
+        if (layout.vertex->properties[axis].is_list) {
+            return false;
+        }
+    }
+    return layout.indices < 0 ||
+           layout.face->properties[layout.indices].is_list;
+}
+
+// Keeps the indices of `face` that name one of `vertex_count` vertices and
+// appends the result when at least two remain, like the OBJ parsers.
+void AddFace(const std::vector<long long>& face, long long vertex_base,
+             std::size_t vertex_count, int number, FaceList& faces,
+             std::vector<int>& scratch, const ParseControl& control) {
+    scratch.clear();
+    for (long long index : face) {
+        if (index < 0 || static_cast<std::size_t>(index) >= vertex_count) {
+            Warn(control, number, "the index of the vertex is out of range");
+            continue;
+        }
+        scratch.push_back(static_cast<int>(vertex_base + index));
+    }
+    if (scratch.size() >= 2) {
+        faces.AddFace(scratch.begin(), scratch.end());
+    }
+}
+
+bool ReportProgress(const ParseControl& control, std::size_t done,
+                    std::size_t total) {
+    if (control.progress) {
+        control.progress(done, total);
+    }
+    return !control.Cancelled();
+}
+
+template <typename T>
+T LoadRaw(const char* p, bool swap) {
+    char bytes[sizeof(T)];
+    std::memcpy(bytes, p, sizeof(T));
+    if (swap) {
+        std::reverse(bytes, bytes + sizeof(T));
+    }
+    T value;
+    std::memcpy(&value, bytes, sizeof(T));
+    return value;
+}
+
+double LoadValue(const char* p, PlyType type, bool swap) {
+    switch (type) {
+        case PlyType::kInt8:
+            return LoadRaw<std::int8_t>(p, swap);
+        case PlyType::kUint8:
+            return LoadRaw<std::uint8_t>(p, swap);
+        case PlyType::kInt16:
+            return LoadRaw<std::int16_t>(p, swap);
+        case PlyType::kUint16:
+            return LoadRaw<std::uint16_t>(p, swap);
+        case PlyType::kInt32:
+            return LoadRaw<std::int32_t>(p, swap);
+        case PlyType::kUint32:
+            return LoadRaw<std::uint32_t>(p, swap);
+        case PlyType::kFloat32:
+            return LoadRaw<float>(p, swap);
+        case PlyType::kFloat64:
+            return LoadRaw<double>(p, swap);
+    }
+    return 0.0;
+}
+
+bool HostIsLittleEndian() {
+    const std::uint16_t one = 1;
+    char first;
+    std::memcpy(&first, &one, 1);
+    return first == 1;
+}
+
+// Reads binary elements in order from a bounds-checked cursor.
+class BinaryReader {
+   public:
+    BinaryReader(const char* begin, const char* end, bool swap)
+        : begin_(begin), p_(begin), end_(end), swap_(swap) {}
+
+    std::size_t Offset() const { return p_ - begin_; }
+
+    // Advances past one item of `element`, storing nothing.
+    bool SkipItem(const PlyElement& element) {
+        for (const PlyProperty& property : element.properties) {
+            if (!SkipProperty(property)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool SkipProperty(const PlyProperty& property) {
+        std::size_t bytes = TypeSize(property.type);
+        if (property.is_list) {
+            std::size_t count;
+            if (!ReadCount(property, count)) {
+                return false;
+            }
+            bytes *= count;
+        }
+        return Advance(bytes);
+    }
+
+    bool ReadCount(const PlyProperty& property, std::size_t& count) {
+        const std::size_t size = TypeSize(property.count_type);
+        if (!Has(size)) {
+            return false;
+        }
+        const double value = LoadValue(p_, property.count_type, swap_);
+        p_ += size;
+        if (value < 0.0) {
+            return false;
+        }
+        count = static_cast<std::size_t>(value);
+        return true;
+    }
+
+    bool ReadList(const PlyProperty& property, std::vector<long long>& values) {
+        std::size_t count;
+        if (!ReadCount(property, count)) {
+            return false;
+        }
+        const std::size_t size = TypeSize(property.type);
+        if (!Has(count * size)) {
+            return false;
+        }
+        values.resize(count);
+        for (std::size_t i = 0; i < count; ++i) {
+            values[i] =
+                static_cast<long long>(LoadValue(p_ + i * size, property.type,
+                                                 swap_));
+        }
+        p_ += count * size;
+        return true;
+    }
+
+    bool Has(std::size_t bytes) const {
+        return static_cast<std::size_t>(end_ - p_) >= bytes;
+    }
+    bool Advance(std::size_t bytes) {
+        if (!Has(bytes)) {
+            return false;
+        }
+        p_ += bytes;
+        return true;
+    }
+    const char* Position() const { return p_; }
+    bool Swap() const { return swap_; }
+
+   private:
+    const char* begin_;
+    const char* p_;
+    const char* end_;
+    bool swap_;
+};
+
+// Vertices with list properties differ in size and are read one by one.
+bool ReadVariableVertices(const PlyLayout& layout, BinaryReader& reader,
+                          std::vector<Vertex>& vertices) {
+    const PlyElement& element = *layout.vertex;
+    for (std::size_t i = 0; i < element.count; ++i) {
+        float xyz[3] = {0.0f, 0.0f, 0.0f};
+        for (std::size_t p = 0; p < element.properties.size(); ++p) {
+            const PlyProperty& property = element.properties[p];
+            const int index = static_cast<int>(p);
+            const int axis = index == layout.x   ? 0
+                             : index == layout.y ? 1
+                             : index == layout.z ? 2
+                                                 : -1;
+            if (axis >= 0 && reader.Has(TypeSize(property.type))) {
+                xyz[axis] = static_cast<float>(LoadValue(
+                    reader.Position(), property.type, reader.Swap()));
+            }
+            if (!reader.SkipProperty(property)) {
+                return false;
+            }
+        }
+        vertices.push_back({xyz[0], xyz[1], xyz[2]});
+    }
+    return true;
+}
+
+bool ReadBinaryVertices(const PlyLayout& layout, BinaryReader& reader,
+                        std::vector<Vertex>& vertices) {
+    const PlyElement& element = *layout.vertex;
+    std::size_t stride = 0;
+    std::vector<std::size_t> offsets;
+    for (const PlyProperty& property : element.properties) {
+        if (property.is_list) {
+            return ReadVariableVertices(layout, reader, vertices);
+        }
+        offsets.push_back(stride);
+        stride += TypeSize(property.type);
+    }
+    if (!reader.Has(stride * element.count)) {
+        return false;
+    }
+
+    const std::size_t base = vertices.size();
+    vertices.resize(base + element.count);
+    const PlyProperty& x = element.properties[layout.x];
+    const PlyProperty& y = element.properties[layout.y];
+    const PlyProperty& z = element.properties[layout.z];
+    const char* data = reader.Position();
+
+    static_assert(sizeof(Vertex) == 3 * sizeof(float),
+                  "packed float xyz vertices are copied as they are");
+    const bool packed = !reader.Swap() && stride == sizeof(Vertex) &&
+                        x.type == PlyType::kFloat32 && offsets[layout.x] == 0 &&
+                        y.type == PlyType::kFloat32 &&
+                        offsets[layout.y] == sizeof(float) &&
+                        z.type == PlyType::kFloat32 &&
+                        offsets[layout.z] == 2 * sizeof(float);
+    if (packed) {
+        std::memcpy(vertices.data() + base, data, stride * element.count);
+    } else {
+        const bool swap = reader.Swap();
+        for (std::size_t i = 0; i < element.count; ++i) {
+            const char* item = data + i * stride;
+            vertices[base + i] = {
+                static_cast<float>(
+                    LoadValue(item + offsets[layout.x], x.type, swap)),
+                static_cast<float>(
+                    LoadValue(item + offsets[layout.y], y.type, swap)),
+                static_cast<float>(
+                    LoadValue(item + offsets[layout.z], z.type, swap))};
+        }
+    }
+    return reader.Advance(stride * element.count);
+}
+
+bool ReadBinaryFaces(const PlyLayout& layout, BinaryReader& reader,
+                     std::size_t vertex_base, std::size_t vertex_count,
+                     std::size_t total_bytes, ObjData& data,
+                     const ParseControl& control) {
+    const PlyElement& element = *layout.face;
+    std::vector<long long> face;
+    std::vector<int> scratch;
+    data.faces.reserve(data.faces.size() + element.count,
+                       data.faces.IndexCount() + 3 * element.count);
+
+    for (std::size_t i = 0; i < element.count; ++i) {
+        if (i % kItemsPerProgressStep == 0 &&
+            !ReportProgress(control, reader.Offset(), total_bytes)) {
+            return false;
+        }
+        for (std::size_t p = 0; p < element.properties.size(); ++p) {
+            const PlyProperty& property = element.properties[p];
+            if (static_cast<int>(p) != layout.indices) {
+                if (!reader.SkipProperty(property)) {
+                    return false;
+                }
+            } else if (!reader.ReadList(property, face)) {
+                return false;
+            }
+        }
+        if (layout.indices >= 0) {
+            AddFace(face, vertex_base, vertex_count, static_cast<int>(i + 1),
+                    data.faces, scratch, control);
+        }
+    }
+    return true;
+}
+
+bool ParseBinary(const PlyHeader& header, const PlyLayout& layout,
+                 const char* begin, const char* end, ObjData& data,
+                 const ParseControl& control) {
+    const bool little_endian = header.format == PlyFormat::kBinaryLittleEndian;
+    BinaryReader reader(begin, end, little_endian != HostIsLittleEndian());
+    const std::size_t total = end - begin;
+    const std::size_t vertex_base = data.vertices.size();
+
+    for (const PlyElement& element : header.elements) {
+        bool read = true;
+        if (&element == layout.vertex) {
+            read = ReadBinaryVertices(layout, reader, data.vertices);
+        } else if (&element == layout.face) {
+            read = ReadBinaryFaces(layout, reader, vertex_base,
+                                   layout.vertex->count, total, data, control);
+        } else {
+            for (std::size_t i = 0; i < element.count && read; ++i) {
+                read = reader.SkipItem(element);
+            }
+        }
+        if (control.Cancelled()) {
+            return false;
+        }
+        if (!read) {
+            std::cerr << "Error: the PLY data of the element " << element.name
+                      << " is truncated" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool IsSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+bool ParseNumber(const char*& p, const char* end, double& value) {
+    while (p < end && IsSpace(*p)) {
+        ++p;
+    }
+    if (p == end) {
+        return false;
+    }
+#if defined(__cpp_lib_to_chars)
+    const auto result = std::from_chars(p, end, value);
+    if (result.ec != std::errc()) {
+        return false;
+    }
+    p = result.ptr;
+#else
+    constexpr std::size_t kMaxNumberLength = 64;
+    char buffer[kMaxNumberLength + 1];
+    const std::size_t length =
+        std::min<std::size_t>(end - p, kMaxNumberLength);
+    std::memcpy(buffer, p, length);
+    buffer[length] = '\0';
+    char* parsed_end = nullptr;
+    errno = 0;
+    value = std::strtod(buffer, &parsed_end);
+    if (parsed_end == buffer || errno == ERANGE) {
+        return false;
+    }
+    p += parsed_end - buffer;
+#endif
+    return p == end || IsSpace(*p);
+}
+
+// ASCII items are one line each. Malformed vertices become the origin, so
+// the faces after them still refer to the right vertices.
+bool ParseAscii(const PlyHeader& header, const PlyLayout& layout,
+                const char* begin, const char* end, ObjData& data,
+                const ParseControl& control) {
+    const char* p = begin;
+    int line_number = header.line_count;
+    const std::size_t vertex_base = data.vertices.size();
+    std::vector<long long> face;
+    std::vector<int> scratch;
+
+    for (const PlyElement& element : header.elements) {
+        for (std::size_t i = 0; i < element.count; ++i) {
+            if (i % kItemsPerProgressStep == 0 &&
+                !ReportProgress(control, p - begin, end - begin)) {
+                return false;
+            }
+            // Blank lines between items are skipped.
+            const char* line_end = nullptr;
+            while (line_end == nullptr) {
+                if (p >= end) {
+                    std::cerr << "Error: the PLY data of the element "
+                              << element.name << " is truncated" << std::endl;
+                    return false;
+                }
+                const char* next =
+                    static_cast<const char*>(std::memchr(p, '\n', end - p));
+                if (next == nullptr) {
+                    next = end;
+                }
+                line_number++;
+                if (std::any_of(p, next, [](char c) { return !IsSpace(c); })) {
+                    line_end = next;
+                } else {
+                    p = next + 1;
+                }
+            }
+
+            const bool is_vertex = &element == layout.vertex;
+            const bool is_face = &element == layout.face;
+            double values[3] = {0.0, 0.0, 0.0};
+            bool valid = true;
+            face.clear();
+            const char* q = p;
+            for (std::size_t k = 0; k < element.properties.size() && valid;
+                 ++k) {
+                const PlyProperty& property = element.properties[k];
+                double value;
+                if (!ParseNumber(q, line_end, value)) {
+                    valid = false;
+                    break;
+                }
+                if (!property.is_list) {
+                    const int index = static_cast<int>(k);
+                    if (is_vertex && index == layout.x) {
+                        values[0] = value;
+                    } else if (is_vertex && index == layout.y) {
+                        values[1] = value;
+                    } else if (is_vertex && index == layout.z) {
+                        values[2] = value;
+                    }
+                    continue;
+                }
+                const bool indices = is_face && static_cast<int>(k) ==
+                                                    layout.indices;
+                for (long long n = static_cast<long long>(value); n > 0; --n) {
+                    if (!ParseNumber(q, line_end, value)) {
+                        valid = false;
+                        break;
+                    }
+                    if (indices) {
+                        face.push_back(static_cast<long long>(value));
+                    }
+                }
+            }
+
+            if (is_vertex) {
+                if (!valid) {
+                    Warn(control, line_number, "incorrect vertex data");
+                    values[0] = values[1] = values[2] = 0.0;
+                }
+                data.vertices.push_back({static_cast<float>(values[0]),
+                                         static_cast<float>(values[1]),
+                                         static_cast<float>(values[2])});
+            } else if (is_face) {
+                if (!valid) {
+                    Warn(control, line_number, "incorrect vertex index");
+                }
+                AddFace(face, vertex_base, layout.vertex->count, line_number,
+                        data.faces, scratch, control);
+            }
+            p = line_end + 1;
+        }
+    }
+    return true;
+}
+}  // namespace
+
+bool ParsePly(const std::string& filename, ObjData& data,
+              const ParseControl& control) {
+    VIEWER3D_TRACE_ZONE("ParsePly");
+    MappedFile file;
+    if (!file.Open(filename)) {
+        std::cerr << "Error: couldn't open the file " << filename << std::endl;
+        return false;
+    }
+
+    PlyHeader header;
+    PlyLayout layout;
+    if (!ReadHeader(file.Data(), file.Size(), header)) {
+        std::cerr << "Error: invalid PLY header in " << filename << std::endl;
+        return false;
+    }
+    if (!FindLayout(header, layout)) {
+        std::cerr << "Error: " << filename
+                  << " has no vertex element with x, y and z" << std::endl;
+        return false;
+    }
+
+    const char* begin = file.Data() + header.data_offset;
+    const char* end = file.Data() + file.Size();
+    const bool parsed =
+        header.format == PlyFormat::kAscii
+            ? ParseAscii(header, layout, begin, end, data, control)
+            : ParseBinary(header, layout, begin, end, data, control);
+    if (!parsed || control.Cancelled()) {
+        return false;
+    }
+
+    if (control.on_batch) {
+        control.on_batch(data.vertices, data.faces);
+    }
+    if (control.progress) {
+        control.progress(file.Size(), file.Size());
+    }
+    return true;
+}
+
+}  // namespace viewer3d
@@ -0,0 +1,24 @@
+#ifndef PLY_PARSER_H
+#define PLY_PARSER_H
+
+#include <string>
+
+#include "model/obj_parser.hpp"
+#include "model/parse_control.hpp"
+
+namespace viewer3d {
+
+// Reads the x, y and z properties of the "vertex" element and the
+// "vertex_indices" (or "vertex_index") lists of the "face" element of an
+// ASCII or binary PLY file; other elements and properties are skipped.
+// Binary vertices are copied in one block when they hold just three floats,
+// and with one strided pass otherwise. Out-of-range indices are dropped with
+// a warning that carries the line number in ASCII files and the 1-based
+// face number in binary ones. Errors in the header or truncated binary data
+// fail the parse.
+bool ParsePly(const std::string& filename, ObjData& data,
+              const ParseControl& control = ParseControl());
+
+}  // namespace viewer3d
+
+#endif
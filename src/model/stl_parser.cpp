@@ -0,0 +1,345 @@
+#include "model/stl_parser.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include "model/mapped_file.hpp"
+#include "model/mesh_format.hpp"
+#include "model/trace.hpp"
+
+namespace viewer3d {
+
+namespace {
+
+constexpr std::size_t kHeaderBytes = 80;
+constexpr std::size_t kTriangleBytes = 50;
+constexpr std::size_t kCornersOffset = 12;
+constexpr std::size_t kTrianglesPerProgressStep = 1 << 16;
+
+// Open-addressing map from a position to its vertex index. Positions match
+// when their bits do, with -0 stored as 0. Slots keep the bits next to the
+// index, so a probe touches one cache line instead of also reading the
+// vertex array.
+class VertexWelder {
+   public:
+    VertexWelder(std::vector<Vertex>& vertices, std::size_t expected)
+        : vertices_(vertices) {
+        std::size_t capacity = 16;
+        while (capacity < 2 * expected) {
+            capacity *= 2;
+        }
+        slots_.resize(capacity);
+    }
+
+    static constexpr std::size_t kMaxBatch = 96;
+
+    // Welds up to kMaxBatch corners into `indices`. All their slots are
+    // prefetched before the first probe, so the cache misses of a batch
+    // overlap instead of following one another.
+    void AddBatch(const Vertex* corners, std::size_t count, int* indices) {
+        while (2 * (count_ + count) > slots_.size()) {
+            Grow();
+        }
+        const std::size_t mask = slots_.size() - 1;
+        Slot keys[kMaxBatch];
+        std::size_t slots[kMaxBatch];
+        for (std::size_t i = 0; i < count; ++i) {
+            keys[i] = MakeKey(corners[i]);
+            slots[i] = Hash(keys[i]) & mask;
+#if defined(__GNUC__)
+            __builtin_prefetch(&slots_[slots[i]]);
+#endif
+        }
+        for (std::size_t i = 0; i < count; ++i) {
+            indices[i] = Insert(keys[i], slots[i]);
+        }
+    }
+
+    int Add(const Vertex& vertex) {
+        int index;
+        AddBatch(&vertex, 1, &index);
+        return index;
+    }
+
+   private:
+    static constexpr int kEmpty = -1;
+    static constexpr std::uint32_t kNegativeZero = 0x80000000u;
+
+    struct Slot {
+        std::uint32_t bits[3];
+        int index{kEmpty};
+    };
+
+    static Slot MakeKey(const Vertex& vertex) {
+        Slot key;
+        std::memcpy(&key.bits[0], &vertex.x, sizeof(float));
+        std::memcpy(&key.bits[1], &vertex.y, sizeof(float));
+        std::memcpy(&key.bits[2], &vertex.z, sizeof(float));
+        for (std::uint32_t& bits : key.bits) {
+            if (bits == kNegativeZero) {
+                bits = 0;
+            }
+        }
+        return key;
+    }
+
+    static std::size_t Hash(const Slot& slot) {
+        std::uint64_t h = slot.bits[0] * 0x9E3779B97F4A7C15ull;
+        h ^= slot.bits[1] * 0xC2B2AE3D27D4EB4Full;
+        h ^= slot.bits[2] * 0x165667B19E3779F9ull;
+        return static_cast<std::size_t>(h ^ (h >> 32));
+    }
+
+    int Insert(Slot key, std::size_t slot) {
+        const std::size_t mask = slots_.size() - 1;
+        while (slots_[slot].index != kEmpty) {
+            if (std::equal(key.bits, key.bits + 3, slots_[slot].bits)) {
+                return slots_[slot].index;
+            }
+            slot = (slot + 1) & mask;
+        }
+        key.index = static_cast<int>(vertices_.size());
+        slots_[slot] = key;
+        count_++;
+        Vertex welded;
+        std::memcpy(&welded.x, &key.bits[0], sizeof(float));
+        std::memcpy(&welded.y, &key.bits[1], sizeof(float));
+        std::memcpy(&welded.z, &key.bits[2], sizeof(float));
+        vertices_.push_back(welded);
+        return key.index;
+    }
+
+    void Grow() {
+        std::vector<Slot> old(slots_.size() * 2);
+        old.swap(slots_);
+        for (const Slot& entry : old) {
+            if (entry.index == kEmpty) {
+                continue;
+            }
+            std::size_t slot = Hash(entry) & (slots_.size() - 1);
+            while (slots_[slot].index != kEmpty) {
+                slot = (slot + 1) & (slots_.size() - 1);
+            }
+            slots_[slot] = entry;
+        }
+    }
+
+    std::vector<Vertex>& vertices_;
+    std::vector<Slot> slots_;
+    std::size_t count_{0};
+};
+
+bool HostIsLittleEndian() {
+    const std::uint16_t one = 1;
+    char first;
+    std::memcpy(&first, &one, 1);
+    return first == 1;
+}
+
+std::uint32_t SwapBytes(std::uint32_t word) {
+    return (word >> 24) | ((word >> 8) & 0xFF00u) | ((word << 8) & 0xFF0000u) |
+           (word << 24);
+}
+
+bool ReportProgress(const ParseControl& control, std::size_t done,
+                    std::size_t total) {
+    if (control.progress) {
+        control.progress(done, total);
+    }
+    return !control.Cancelled();
+}
+
+bool ParseBinary(const char* data, std::size_t size, ObjData& out,
+                 const ParseControl& control) {
+    if (size < kMeshFormatHeadBytes) {
+        std::cerr << "Error: the STL data is truncated" << std::endl;
+        return false;
+    }
+    std::uint32_t count;
+    std::memcpy(&count, data + kHeaderBytes, sizeof(count));
+    const bool swap = !HostIsLittleEndian();
+    if (swap) {
+        count = SwapBytes(count);
+    }
+    if ((size - kMeshFormatHeadBytes) / kTriangleBytes < count) {
+        std::cerr << "Error: the STL data is truncated" << std::endl;
+        return false;
+    }
+
+    // Closed meshes have about half as many vertices as triangles.
+    VertexWelder welder(out.vertices, count / 2);
+    out.faces.reserve(out.faces.size() + count,
+                      out.faces.IndexCount() + 3 * std::size_t{count});
+    constexpr std::uint32_t kBatch = VertexWelder::kMaxBatch / 3;
+    static_assert(kTrianglesPerProgressStep % kBatch == 0,
+                  "progress is reported between batches");
+    const char* record = data + kMeshFormatHeadBytes;
+    for (std::uint32_t first = 0; first < count; first += kBatch) {
+        if (first % kTrianglesPerProgressStep == 0 &&
+            !ReportProgress(control, record - data, size)) {
+            return false;
+        }
+        const std::uint32_t batch = std::min(kBatch, count - first);
+        Vertex corners[3 * kBatch];
+        static_assert(sizeof(Vertex) == 3 * sizeof(float),
+                      "corners are packed floats");
+        for (std::uint32_t t = 0; t < batch; ++t, record += kTriangleBytes) {
+            std::memcpy(&corners[3 * t], record + kCornersOffset,
+                        3 * sizeof(Vertex));
+        }
+        if (swap) {
+            std::uint32_t words[9 * kBatch];
+            std::memcpy(words, corners, sizeof(corners));
+            for (std::uint32_t& word : words) {
+                word = SwapBytes(word);
+            }
+            std::memcpy(corners, words, sizeof(corners));
+        }
+        int indices[3 * kBatch];
+        welder.AddBatch(corners, 3 * batch, indices);
+        for (std::uint32_t t = 0; t < batch; ++t) {
+            out.faces.AddFace(&indices[3 * t], &indices[3 * t + 3]);
+        }
+    }
+    return true;
+}
+
+bool IsSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+const char* SkipSpaces(const char* p, const char* end) {
+    while (p < end && IsSpace(*p)) {
+        ++p;
+    }
+    return p;
+}
+
+bool StartsWith(const char* p, const char* end, const char* keyword) {
+    const std::size_t length = std::strlen(keyword);
+    return static_cast<std::size_t>(end - p) >= length &&
+           std::memcmp(p, keyword, length) == 0 &&
+           (static_cast<std::size_t>(end - p) == length ||
+            IsSpace(p[length]) || p[length] == '\n');
+}
+
+bool ParseFloat(const char*& p, const char* end, float& value) {
+    p = SkipSpaces(p, end);
+    if (p == end) {
+        return false;
+    }
+#if defined(__cpp_lib_to_chars)
+    auto result = std::from_chars(p, end, value);
+    if (result.ec != std::errc()) {
+        return false;
+    }
+    p = result.ptr;
+#else
+    constexpr std::size_t kMaxNumberLength = 64;
+    char buffer[kMaxNumberLength + 1];
+    std::size_t length = std::min<std::size_t>(end - p, kMaxNumberLength);
+    std::memcpy(buffer, p, length);
+    buffer[length] = '\0';
+    char* parsed_end = nullptr;
+    errno = 0;
+    value = std::strtof(buffer, &parsed_end);
+    if (parsed_end == buffer || errno == ERANGE) {
+        return false;
+    }
+    p += parsed_end - buffer;
+#endif
+    return true;
+}
+
+// Collects the "vertex" lines of each "outer loop" and emits the loop as a
+// face at "endloop". Loops with a malformed vertex are dropped.
+bool ParseAscii(const char* data, std::size_t size, ObjData& out,
+                const ParseControl& control) {
+    const char* const end = data + size;
+    // ASCII facets take about 250 bytes each.
+    VertexWelder welder(out.vertices, size / 500);
+    std::vector<int> loop;
+    bool loop_valid = true;
+    int line_number = 0;
+
+    for (const char* p = data; p < end;) {
+        const char* line_end =
+            static_cast<const char*>(std::memchr(p, '\n', end - p));
+        if (line_end == nullptr) {
+            line_end = end;
+        }
+        line_number++;
+        if (line_number % kTrianglesPerProgressStep == 0 &&
+            !ReportProgress(control, p - data, size)) {
+            return false;
+        }
+
+        const char* q = SkipSpaces(p, line_end);
+        if (StartsWith(q, line_end, "vertex")) {
+            q += std::strlen("vertex");
+            Vertex vertex;
+            if (ParseFloat(q, line_end, vertex.x) &&
+                ParseFloat(q, line_end, vertex.y) &&
+                ParseFloat(q, line_end, vertex.z)) {
+                loop.push_back(welder.Add(vertex));
+            } else {
+                if (control.on_warning) {
+                    control.on_warning(line_number, "incorrect vertex data");
+                } else {
+                    std::cerr << "Warning: incorrect vertex data in the row "
+                              << line_number << std::endl;
+                }
+                loop_valid = false;
+            }
+        } else if (StartsWith(q, line_end, "endloop")) {
+            if (loop_valid && loop.size() >= 2) {
+                out.faces.AddFace(loop.begin(), loop.end());
+            }
+            loop.clear();
+            loop_valid = true;
+        }
+        p = line_end + 1;
+    }
+    return true;
+}
+
+}  // namespace
+
+bool ParseStl(const std::string& filename, ObjData& data,
+              const ParseControl& control) {
+    VIEWER3D_TRACE_ZONE("ParseStl");
+    MappedFile file;
+    if (!file.Open(filename)) {
+        std::cerr << "Error: couldn't open the file " << filename << std::endl;
+        return false;
+    }
+
+    const char* bytes = file.Data();
+    const std::size_t size = file.Size();
+    // Binary headers often start with "solid" too, so a matching triangle
+    // count wins over the keyword.
+    const bool ascii =
+        !IsBinaryStl(bytes, size, size) &&
+        StartsWith(SkipSpaces(bytes, bytes + size), bytes + size, "solid");
+    const bool parsed = ascii ? ParseAscii(bytes, size, data, control)
+                              : ParseBinary(bytes, size, data, control);
+    if (!parsed || control.Cancelled()) {
+        return false;
+    }
+
+    if (control.on_batch) {
+        control.on_batch(data.vertices, data.faces);
+    }
+    if (control.progress) {
+        control.progress(size, size);
+    }
+    return true;
+}
+
+}  // namespace viewer3d
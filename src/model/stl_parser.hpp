@@ -0,0 +1,20 @@
+#ifndef STL_PARSER_H
+#define STL_PARSER_H
+
+#include <string>
+
+#include "model/obj_parser.hpp"
+#include "model/parse_control.hpp"
+
+namespace viewer3d {
+
+// Reads a binary or ASCII STL file into triangles. STL repeats the corners
+// of every triangle, so corners at bit-identical positions are welded into
+// one vertex while reading and the model keeps its connectivity. Normals and
+// attribute bytes are ignored.
+bool ParseStl(const std::string& filename, ObjData& data,
+              const ParseControl& control = ParseControl());
+
+}  // namespace viewer3d
+
+#endif
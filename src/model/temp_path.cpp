@@ -0,0 +1,30 @@
+#include "model/temp_path.hpp"
+
+#include <atomic>
+
+#if defined(_WIN32)
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace viewer3d {
+
+namespace {
+long ProcessId() {
+#if defined(_WIN32)
+    return static_cast<long>(_getpid());
+#else
+    return static_cast<long>(::getpid());
+#endif
+}
+}  // namespace
+
+std::string UniqueTempPath(const std::string& path) {
+    static std::atomic<unsigned long> counter{0};
+    return path + "." + std::to_string(ProcessId()) + "." +
+           std::to_string(counter.fetch_add(1, std::memory_order_relaxed)) +
+           ".tmp";
+}
+
+}  // namespace viewer3d
@@ -0,0 +1,15 @@
+#ifndef TEMP_PATH_H
+#define TEMP_PATH_H
+
+#include <string>
+
+namespace viewer3d {
+
+// "<path>.<pid>.<n>.tmp": a name beside `path` that no other process, and no
+// other call in this one, uses at the same time. Files are written there and
+// then renamed over `path`, so concurrent writers never mix their output.
+std::string UniqueTempPath(const std::string& path);
+
+}  // namespace viewer3d
+
+#endif
@@ -0,0 +1,171 @@
+#include "model/trace.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+
+namespace viewer3d {
+namespace trace {
+
+namespace {
+
+struct TraceEvent {
+    const char* name;
+    std::uint64_t start_ns;
+    std::uint64_t end_ns;
+    std::uint32_t thread;
+};
+
+// Written by one thread at a time; the lock only contends with an export.
+struct ThreadRing {
+    std::mutex mutex;
+    std::vector<TraceEvent> events;
+    std::uint64_t written{0};
+};
+
+// Rings outlive their threads so that short-lived workers still show up in
+// the trace, and are handed on to new threads instead of piling up.
+class RingRegistry {
+   public:
+    ThreadRing* Acquire() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!free_.empty()) {
+            ThreadRing* ring = free_.back();
+            free_.pop_back();
+            return ring;
+        }
+        rings_.push_back(std::make_unique<ThreadRing>());
+        return rings_.back().get();
+    }
+
+    void Release(ThreadRing* ring) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        free_.push_back(ring);
+    }
+
+    template <typename Visitor>
+    void ForEach(Visitor visitor) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& ring : rings_) {
+            std::lock_guard<std::mutex> ring_lock(ring->mutex);
+            visitor(*ring);
+        }
+    }
+
+   private:
+    std::mutex mutex_;
+    std::vector<std::unique_ptr<ThreadRing>> rings_;
+    std::vector<ThreadRing*> free_;
+};
+
+// Never destroyed, since thread_local leases may be released after static
+// destructors have run.
+RingRegistry& Registry() {
+    static RingRegistry* registry = new RingRegistry();
+    return *registry;
+}
+
+std::atomic<std::uint32_t> next_thread_id{1};
+
+struct RingLease {
+    ThreadRing* ring{nullptr};
+    std::uint32_t thread{0};
+
+    ~RingLease() {
+        if (ring != nullptr) {
+            Registry().Release(ring);
+        }
+    }
+};
+
+thread_local RingLease lease;
+
+}  // namespace
+
+bool Start() {
+#if VIEWER3D_TRACING
+    Registry().ForEach([](ThreadRing& ring) { ring.written = 0; });
+    internal::recording.store(true);
+    return true;
+#else
+    std::cerr << "Warning: tracing was compiled out (VIEWER3D_TRACING=OFF)"
+              << std::endl;
+    return false;
+#endif
+}
+
+void Stop() { internal::recording.store(false); }
+
+bool WriteChromeTrace(const std::string& filename) {
+    std::vector<TraceEvent> events;
+    std::uint64_t dropped = 0;
+    Registry().ForEach([&](ThreadRing& ring) {
+        const std::uint64_t kept =
+            std::min<std::uint64_t>(ring.written, ring.events.size());
+        dropped += ring.written - kept;
+        for (std::uint64_t i = ring.written - kept; i < ring.written; ++i) {
+            events.push_back(ring.events[i % ring.events.size()]);
+        }
+    });
+    std::sort(events.begin(), events.end(),
+              [](const TraceEvent& lhs, const TraceEvent& rhs) {
+                  return lhs.start_ns < rhs.start_ns;
+              });
+
+    std::ofstream out(filename, std::ios::trunc);
+    if (!out) {
+        std::cerr << "Error: cannot write the trace " << filename << std::endl;
+        return false;
+    }
+    const std::uint64_t origin = events.empty() ? 0 : events.front().start_ns;
+    out << "{\"displayTimeUnit\":\"ms\",\"otherData\":{\"dropped_events\":"
+        << dropped << "},\"traceEvents\":[";
+    char timing[64];
+    for (std::size_t i = 0; i < events.size(); ++i) {
+        const TraceEvent& event = events[i];
+        std::snprintf(timing, sizeof(timing), "\"ts\":%.3f,\"dur\":%.3f",
+                      (event.start_ns - origin) / 1000.0,
+                      (event.end_ns - event.start_ns) / 1000.0);
+        out << (i > 0 ? ",\n" : "\n") << "{\"name\":\"" << event.name
+            << "\",\"cat\":\"viewer3d\",\"ph\":\"X\",\"pid\":1,\"tid\":"
+            << event.thread << "," << timing << "}";
+    }
+    out << "\n]}\n";
+    out.close();
+    if (!out) {
+        std::cerr << "Error: cannot write the trace " << filename << std::endl;
+        return false;
+    }
+    return true;
+}
+
+namespace internal {
+
+std::uint64_t NowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+void Record(const char* name, std::uint64_t start_ns, std::uint64_t end_ns) {
+    if (lease.ring == nullptr) {
+        lease.ring = Registry().Acquire();
+        lease.thread = next_thread_id++;
+    }
+    ThreadRing& ring = *lease.ring;
+    std::lock_guard<std::mutex> lock(ring.mutex);
+    if (ring.events.empty()) {
+        ring.events.resize(kRingCapacity);
+    }
+    ring.events[ring.written % kRingCapacity] = {name, start_ns, end_ns,
+                                                 lease.thread};
+    ring.written++;
+}
+
+}  // namespace internal
+
+}  // namespace trace
+}  // namespace viewer3d
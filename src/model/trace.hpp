@@ -0,0 +1,110 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace viewer3d {
+
+// Duration of one named phase of an operation, e.g. "parse" during a load.
+struct PhaseTiming {
+    const char* name;
+    double ms;
+};
+using PhaseTimings = std::vector<PhaseTiming>;
+
+// Scoped trace zones recorded into per-thread ring buffers and exported as
+// a Chrome trace (chrome://tracing or ui.perfetto.dev). Zones are compiled
+// in with VIEWER3D_TRACING; while recording is stopped each one costs a
+// relaxed atomic load.
+namespace trace {
+
+// Events kept per thread; older ones are overwritten.
+constexpr std::size_t kRingCapacity = 1 << 15;
+
+// Clears the recorded events and starts recording. Fails when zones were
+// compiled out.
+bool Start();
+void Stop();
+// Writes the recorded events as Chrome trace JSON; recording continues.
+bool WriteChromeTrace(const std::string& filename);
+
+namespace internal {
+inline std::atomic<bool> recording{false};
+std::uint64_t NowNs();
+void Record(const char* name, std::uint64_t start_ns, std::uint64_t end_ns);
+}  // namespace internal
+
+inline bool IsRecording() {
+    return internal::recording.load(std::memory_order_relaxed);
+}
+
+}  // namespace trace
+
+#if VIEWER3D_TRACING
+// `name` must outlive the trace, a string literal in practice.
+class TraceZone {
+   public:
+    explicit TraceZone(const char* name)
+        : name_(trace::IsRecording() ? name : nullptr),
+          start_ns_(name_ != nullptr ? trace::internal::NowNs() : 0) {}
+    ~TraceZone() {
+        if (name_ != nullptr) {
+            trace::internal::Record(name_, start_ns_,
+                                    trace::internal::NowNs());
+        }
+    }
+
+    TraceZone(const TraceZone&) = delete;
+    TraceZone& operator=(const TraceZone&) = delete;
+
+   private:
+    const char* name_;
+    std::uint64_t start_ns_;
+};
+
+#define VIEWER3D_TRACE_CONCAT_(a, b) a##b
+#define VIEWER3D_TRACE_CONCAT(a, b) VIEWER3D_TRACE_CONCAT_(a, b)
+#define VIEWER3D_TRACE_ZONE(name) \
+    ::viewer3d::TraceZone VIEWER3D_TRACE_CONCAT(trace_zone_, __LINE__)(name)
+#else
+#define VIEWER3D_TRACE_ZONE(name) static_cast<void>(0)
+#endif
+
+// Appends the duration of its scope to `phases` and traces it as a zone.
+class PhaseScope {
+   public:
+    PhaseScope(PhaseTimings& phases, const char* name)
+        : phases_(phases),
+          name_(name),
+#if VIEWER3D_TRACING
+          zone_(name),
+#endif
+          start_(std::chrono::steady_clock::now()) {
+    }
+    ~PhaseScope() {
+        phases_.push_back(
+            {name_, std::chrono::duration<double, std::milli>(
+                        std::chrono::steady_clock::now() - start_)
+                        .count()});
+    }
+
+    PhaseScope(const PhaseScope&) = delete;
+    PhaseScope& operator=(const PhaseScope&) = delete;
+
+   private:
+    PhaseTimings& phases_;
+    const char* name_;
+#if VIEWER3D_TRACING
+    TraceZone zone_;
+#endif
+    std::chrono::steady_clock::time_point start_;
+};
+
+}  // namespace viewer3d
+
+#endif
@@ -0,0 +1,601 @@
+#include "model/transform_kernel.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define VIEWER3D_X86_SIMD 1
+#define VIEWER3D_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+namespace viewer3d {
+
+namespace {
+constexpr float kDegToRad = M_PI / 180.0f;
+
+static_assert(sizeof(Vertex) == 3 * sizeof(float),
+              "the SIMD stores expect tightly packed vertices");
+
+using KernelFn = void (*)(const float*, const float*, const float*,
+                          std::size_t, const VertexTransform&, Vertex*);
+using QuantizedKernelFn = void (*)(const std::uint16_t*, const std::uint16_t*,
+                                   const std::uint16_t*, std::size_t,
+                                   const VertexTransform&, Vertex*);
+
+void Multiply3x3(const float* lhs, const float* rhs, float* out) {
+    for (int row = 0; row < 3; ++row) {
+        for (int col = 0; col < 3; ++col) {
+            out[row * 3 + col] = lhs[row * 3 + 0] * rhs[0 * 3 + col] +
+                                 lhs[row * 3 + 1] * rhs[1 * 3 + col] +
+                                 lhs[row * 3 + 2] * rhs[2 * 3 + col];
+        }
+    }
+}
+
+template <bool kScale, bool kRotate, bool kTranslate>
+void TransformScalar(const float* x, const float* y, const float* z,
+                     std::size_t count, const VertexTransform& transform,
+                     Vertex* out) {
+    const float* m = transform.linear;
+    const float s = transform.scale;
+    const float* t = transform.translate;
+
+    for (std::size_t i = 0; i < count; ++i) {
+        float px = x[i];
+        float py = y[i];
+        float pz = z[i];
+        float ox = px;
+        float oy = py;
+        float oz = pz;
+
+        if constexpr (kRotate) {
+            ox = m[0] * px + m[1] * py + m[2] * pz;
+            oy = m[3] * px + m[4] * py + m[5] * pz;
+            oz = m[6] * px + m[7] * py + m[8] * pz;
+        } else if constexpr (kScale) {
+            ox = px * s;
+            oy = py * s;
+            oz = pz * s;
+        }
+
+        if constexpr (kTranslate) {
+            ox += t[0];
+            oy += t[1];
+            oz += t[2];
+        }
+
+        out[i].x = ox;
+        out[i].y = oy;
+        out[i].z = oz;
+    }
+}
+
+// Quantized positions always go through the full affine map, which has
+// the decoding folded in, see FoldDecoding().
+void TransformQuantizedScalar(const std::uint16_t* x, const std::uint16_t* y,
+                              const std::uint16_t* z, std::size_t count,
+                              const VertexTransform& transform, Vertex* out) {
+    const float* m = transform.linear;
+    const float* t = transform.translate;
+
+    for (std::size_t i = 0; i < count; ++i) {
+        const float px = x[i];
+        const float py = y[i];
+        const float pz = z[i];
+        out[i].x = m[0] * px + m[1] * py + m[2] * pz + t[0];
+        out[i].y = m[3] * px + m[4] * py + m[5] * pz + t[1];
+        out[i].z = m[6] * px + m[7] * py + m[8] * pz + t[2];
+    }
+}
+
+#ifdef VIEWER3D_X86_SIMD
+// Interleaves four vertices into out[0..3]. Each row store writes one float
+// past its vertex, which the next row overwrites; the last row spills into
+// out[4].x, so the caller must own at least one more vertex.
+inline void StoreInterleavedSse(Vertex* out, __m128 x, __m128 y, __m128 z) {
+    __m128 w = _mm_setzero_ps();
+    _MM_TRANSPOSE4_PS(x, y, z, w);
+    float* dst = &out[0].x;
+    _mm_storeu_ps(dst + 0, x);
+    _mm_storeu_ps(dst + 3, y);
+    _mm_storeu_ps(dst + 6, z);
+    _mm_storeu_ps(dst + 9, w);
+}
+
+template <bool kScale, bool kRotate, bool kTranslate>
+void TransformSse2(const float* x, const float* y, const float* z,
+                   std::size_t count, const VertexTransform& transform,
+                   Vertex* out) {
+    constexpr std::size_t kWidth = 4;
+    const float* m = transform.linear;
+    const float* t = transform.translate;
+
+    const __m128 m0 = _mm_set1_ps(m[0]), m1 = _mm_set1_ps(m[1]),
+                 m2 = _mm_set1_ps(m[2]), m3 = _mm_set1_ps(m[3]),
+                 m4 = _mm_set1_ps(m[4]), m5 = _mm_set1_ps(m[5]),
+                 m6 = _mm_set1_ps(m[6]), m7 = _mm_set1_ps(m[7]),
+                 m8 = _mm_set1_ps(m[8]);
+    const __m128 s = _mm_set1_ps(transform.scale);
+    const __m128 tx = _mm_set1_ps(t[0]), ty = _mm_set1_ps(t[1]),
+                 tz = _mm_set1_ps(t[2]);
+
+    std::size_t i = 0;
+    for (; i + kWidth < count; i += kWidth) {
+        __m128 px = _mm_loadu_ps(x + i);
+        __m128 py = _mm_loadu_ps(y + i);
+        __m128 pz = _mm_loadu_ps(z + i);
+        __m128 ox = px;
+        __m128 oy = py;
+        __m128 oz = pz;
+
+        if constexpr (kRotate) {
+            ox = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m0, px), _mm_mul_ps(m1, py)),
+                            _mm_mul_ps(m2, pz));
+            oy = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m3, px), _mm_mul_ps(m4, py)),
+                            _mm_mul_ps(m5, pz));
+            oz = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m6, px), _mm_mul_ps(m7, py)),
+                            _mm_mul_ps(m8, pz));
+        } else if constexpr (kScale) {
+            ox = _mm_mul_ps(px, s);
+            oy = _mm_mul_ps(py, s);
+            oz = _mm_mul_ps(pz, s);
+        }
+
+        if constexpr (kTranslate) {
+            ox = _mm_add_ps(ox, tx);
+            oy = _mm_add_ps(oy, ty);
+            oz = _mm_add_ps(oz, tz);
+        }
+
+        StoreInterleavedSse(out + i, ox, oy, oz);
+    }
+
+    TransformScalar<kScale, kRotate, kTranslate>(x + i, y + i, z + i,
+                                                 count - i, transform, out + i);
+}
+
+// Widens four 16-bit values to floats.
+inline __m128 LoadQuantizedSse(const std::uint16_t* values) {
+    const __m128i packed =
+        _mm_loadl_epi64(reinterpret_cast<const __m128i*>(values));
+    return _mm_cvtepi32_ps(_mm_unpacklo_epi16(packed, _mm_setzero_si128()));
+}
+
+void TransformQuantizedSse2(const std::uint16_t* x, const std::uint16_t* y,
+                            const std::uint16_t* z, std::size_t count,
+                            const VertexTransform& transform, Vertex* out) {
+    constexpr std::size_t kWidth = 4;
+    const float* m = transform.linear;
+    const float* t = transform.translate;
+
+    const __m128 m0 = _mm_set1_ps(m[0]), m1 = _mm_set1_ps(m[1]),
+                 m2 = _mm_set1_ps(m[2]), m3 = _mm_set1_ps(m[3]),
+                 m4 = _mm_set1_ps(m[4]), m5 = _mm_set1_ps(m[5]),
+                 m6 = _mm_set1_ps(m[6]), m7 = _mm_set1_ps(m[7]),
+                 m8 = _mm_set1_ps(m[8]);
+    const __m128 tx = _mm_set1_ps(t[0]), ty = _mm_set1_ps(t[1]),
+                 tz = _mm_set1_ps(t[2]);
+
+    std::size_t i = 0;
+    for (; i + kWidth < count; i += kWidth) {
+        const __m128 px = LoadQuantizedSse(x + i);
+        const __m128 py = LoadQuantizedSse(y + i);
+        const __m128 pz = LoadQuantizedSse(z + i);
+        const __m128 ox = _mm_add_ps(
+            _mm_add_ps(_mm_add_ps(_mm_mul_ps(m0, px), _mm_mul_ps(m1, py)),
+                       _mm_mul_ps(m2, pz)),
+            tx);
+        const __m128 oy = _mm_add_ps(
+            _mm_add_ps(_mm_add_ps(_mm_mul_ps(m3, px), _mm_mul_ps(m4, py)),
+                       _mm_mul_ps(m5, pz)),
+            ty);
+        const __m128 oz = _mm_add_ps(
+            _mm_add_ps(_mm_add_ps(_mm_mul_ps(m6, px), _mm_mul_ps(m7, py)),
+                       _mm_mul_ps(m8, pz)),
+            tz);
+        StoreInterleavedSse(out + i, ox, oy, oz);
+    }
+
+    TransformQuantizedScalar(x + i, y + i, z + i, count - i, transform,
+                             out + i);
+}
+
+VIEWER3D_TARGET_AVX2 inline void StoreInterleavedAvx(Vertex* out, __m128 x,
+                                                     __m128 y, __m128 z) {
+    __m128 w = _mm_setzero_ps();
+    _MM_TRANSPOSE4_PS(x, y, z, w);
+    float* dst = &out[0].x;
+    _mm_storeu_ps(dst + 0, x);
+    _mm_storeu_ps(dst + 3, y);
+    _mm_storeu_ps(dst + 6, z);
+    _mm_storeu_ps(dst + 9, w);
+}
+
+template <bool kScale, bool kRotate, bool kTranslate>
+VIEWER3D_TARGET_AVX2 void TransformAvx2(const float* x, const float* y,
+                                        const float* z, std::size_t count,
+                                        const VertexTransform& transform,
+                                        Vertex* out) {
+    constexpr std::size_t kWidth = 8;
+    const float* m = transform.linear;
+    const float* t = transform.translate;
+
+    const __m256 m0 = _mm256_set1_ps(m[0]), m1 = _mm256_set1_ps(m[1]),
+                 m2 = _mm256_set1_ps(m[2]), m3 = _mm256_set1_ps(m[3]),
+                 m4 = _mm256_set1_ps(m[4]), m5 = _mm256_set1_ps(m[5]),
+                 m6 = _mm256_set1_ps(m[6]), m7 = _mm256_set1_ps(m[7]),
+                 m8 = _mm256_set1_ps(m[8]);
+    const __m256 s = _mm256_set1_ps(transform.scale);
+    const __m256 tx = _mm256_set1_ps(t[0]), ty = _mm256_set1_ps(t[1]),
+                 tz = _mm256_set1_ps(t[2]);
+
+    std::size_t i = 0;
+    for (; i + kWidth < count; i += kWidth) {
+        __m256 px = _mm256_loadu_ps(x + i);
+        __m256 py = _mm256_loadu_ps(y + i);
+        __m256 pz = _mm256_loadu_ps(z + i);
+        __m256 ox = px;
+        __m256 oy = py;
+        __m256 oz = pz;
+
+        if constexpr (kRotate) {
+            ox = _mm256_add_ps(
+                _mm256_add_ps(_mm256_mul_ps(m0, px), _mm256_mul_ps(m1, py)),
+                _mm256_mul_ps(m2, pz));
+            oy = _mm256_add_ps(
+                _mm256_add_ps(_mm256_mul_ps(m3, px), _mm256_mul_ps(m4, py)),
+                _mm256_mul_ps(m5, pz));
+            oz = _mm256_add_ps(
+                _mm256_add_ps(_mm256_mul_ps(m6, px), _mm256_mul_ps(m7, py)),
+                _mm256_mul_ps(m8, pz));
+        } else if constexpr (kScale) {
+            ox = _mm256_mul_ps(px, s);
+            oy = _mm256_mul_ps(py, s);
+            oz = _mm256_mul_ps(pz, s);
+        }
+
+        if constexpr (kTranslate) {
+            ox = _mm256_add_ps(ox, tx);
+            oy = _mm256_add_ps(oy, ty);
+            oz = _mm256_add_ps(oz, tz);
+        }
+
+        StoreInterleavedAvx(out + i, _mm256_castps256_ps128(ox),
+                            _mm256_castps256_ps128(oy),
+                            _mm256_castps256_ps128(oz));
+        StoreInterleavedAvx(out + i + 4, _mm256_extractf128_ps(ox, 1),
+                            _mm256_extractf128_ps(oy, 1),
+                            _mm256_extractf128_ps(oz, 1));
+    }
+
+    TransformScalar<kScale, kRotate, kTranslate>(x + i, y + i, z + i,
+                                                 count - i, transform, out + i);
+}
+
+// Widens eight 16-bit values to floats.
+VIEWER3D_TARGET_AVX2 inline __m256 LoadQuantizedAvx(
+    const std::uint16_t* values) {
+    const __m128i packed =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(values));
+    return _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(packed));
+}
+
+VIEWER3D_TARGET_AVX2 void TransformQuantizedAvx2(
+    const std::uint16_t* x, const std::uint16_t* y, const std::uint16_t* z,
+    std::size_t count, const VertexTransform& transform, Vertex* out) {
+    constexpr std::size_t kWidth = 8;
+    const float* m = transform.linear;
+    const float* t = transform.translate;
+
+    const __m256 m0 = _mm256_set1_ps(m[0]), m1 = _mm256_set1_ps(m[1]),
+                 m2 = _mm256_set1_ps(m[2]), m3 = _mm256_set1_ps(m[3]),
+                 m4 = _mm256_set1_ps(m[4]), m5 = _mm256_set1_ps(m[5]),
+                 m6 = _mm256_set1_ps(m[6]), m7 = _mm256_set1_ps(m[7]),
+                 m8 = _mm256_set1_ps(m[8]);
+    const __m256 tx = _mm256_set1_ps(t[0]), ty = _mm256_set1_ps(t[1]),
+                 tz = _mm256_set1_ps(t[2]);
+
+    std::size_t i = 0;
+    for (; i + kWidth < count; i += kWidth) {
+        const __m256 px = LoadQuantizedAvx(x + i);
+        const __m256 py = LoadQuantizedAvx(y + i);
+        const __m256 pz = LoadQuantizedAvx(z + i);
+        const __m256 ox = _mm256_add_ps(
+            _mm256_add_ps(
+                _mm256_add_ps(_mm256_mul_ps(m0, px), _mm256_mul_ps(m1, py)),
+                _mm256_mul_ps(m2, pz)),
+            tx);
+        const __m256 oy = _mm256_add_ps(
+            _mm256_add_ps(
+                _mm256_add_ps(_mm256_mul_ps(m3, px), _mm256_mul_ps(m4, py)),
+                _mm256_mul_ps(m5, pz)),
+            ty);
+        const __m256 oz = _mm256_add_ps(
+            _mm256_add_ps(
+                _mm256_add_ps(_mm256_mul_ps(m6, px), _mm256_mul_ps(m7, py)),
+                _mm256_mul_ps(m8, pz)),
+            tz);
+
+        StoreInterleavedAvx(out + i, _mm256_castps256_ps128(ox),
+                            _mm256_castps256_ps128(oy),
+                            _mm256_castps256_ps128(oz));
+        StoreInterleavedAvx(out + i + 4, _mm256_extractf128_ps(ox, 1),
+                            _mm256_extractf128_ps(oy, 1),
+                            _mm256_extractf128_ps(oz, 1));
+    }
+
+    TransformQuantizedScalar(x + i, y + i, z + i, count - i, transform,
+                             out + i);
+}
+#endif
+
+// One kernel per combination of transform flags, indexed by
+// scale | rotation << 1 | translation << 2.
+#define VIEWER3D_KERNEL_TABLE(kernel)                                       \
+    {                                                                       \
+        &kernel<false, false, false>, &kernel<true, false, false>,          \
+            &kernel<false, true, false>, &kernel<true, true, false>,        \
+            &kernel<false, false, true>, &kernel<true, false, true>,        \
+            &kernel<false, true, true>, &kernel<true, true, true>,          \
+    }
+
+KernelFn SelectKernel(TransformIsa isa, const VertexTransform& transform) {
+    static constexpr KernelFn kScalarKernels[8] =
+        VIEWER3D_KERNEL_TABLE(TransformScalar);
+#ifdef VIEWER3D_X86_SIMD
+    static constexpr KernelFn kSse2Kernels[8] =
+        VIEWER3D_KERNEL_TABLE(TransformSse2);
+    static constexpr KernelFn kAvx2Kernels[8] =
+        VIEWER3D_KERNEL_TABLE(TransformAvx2);
+#endif
+
+    const int combination = (transform.has_scale ? 1 : 0) |
+                            (transform.has_rotation ? 2 : 0) |
+                            (transform.has_translation ? 4 : 0);
+
+    switch (isa) {
+#ifdef VIEWER3D_X86_SIMD
+        case TransformIsa::kAvx2:
+            return kAvx2Kernels[combination];
+        case TransformIsa::kSse2:
+            return kSse2Kernels[combination];
+#endif
+        default:
+            return kScalarKernels[combination];
+    }
+}
+
+#undef VIEWER3D_KERNEL_TABLE
+
+QuantizedKernelFn SelectQuantizedKernel(TransformIsa isa) {
+    switch (isa) {
+#ifdef VIEWER3D_X86_SIMD
+        case TransformIsa::kAvx2:
+            return &TransformQuantizedAvx2;
+        case TransformIsa::kSse2:
+            return &TransformQuantizedSse2;
+#endif
+        default:
+            return &TransformQuantizedScalar;
+    }
+}
+
+// linear * (origin + step * q) + translate as one affine map of q.
+VertexTransform FoldDecoding(const QuantizedPositions& source,
+                             const VertexTransform& transform) {
+    VertexTransform folded = transform;
+    for (int row = 0; row < 3; ++row) {
+        for (int col = 0; col < 3; ++col) {
+            const float m = transform.linear[row * 3 + col];
+            folded.linear[row * 3 + col] = m * source.step[col];
+            folded.translate[row] += m * source.origin[col];
+        }
+    }
+    folded.has_scale = true;
+    folded.has_rotation = true;
+    folded.has_translation = true;
+    return folded;
+}
+}  // namespace
+
+void PositionsSoA::Assign(const std::vector<Vertex>& vertices) {
+    x.resize(vertices.size());
+    y.resize(vertices.size());
+    z.resize(vertices.size());
+    for (std::size_t i = 0; i < vertices.size(); ++i) {
+        x[i] = vertices[i].x;
+        y[i] = vertices[i].y;
+        z[i] = vertices[i].z;
+    }
+}
+
+void PositionsSoA::clear() {
+    x.clear();
+    y.clear();
+    z.clear();
+}
+
+void QuantizedPositions::Encode(const PositionsSoA& positions,
+                                const Vertex& min, const Vertex& max) {
+    const float lows[3] = {min.x, min.y, min.z};
+    const float highs[3] = {max.x, max.y, max.z};
+    const std::vector<float>* axes[3] = {&positions.x, &positions.y,
+                                         &positions.z};
+    std::vector<std::uint16_t>* codes[3] = {&x, &y, &z};
+    constexpr float kTop = kLevels - 1;
+
+    for (int axis = 0; axis < 3; ++axis) {
+        const float extent = highs[axis] - lows[axis];
+        origin[axis] = lows[axis];
+        step[axis] = extent > 0.0f ? extent / kTop : 0.0f;
+        const float inv_step = extent > 0.0f ? kTop / extent : 0.0f;
+
+        const std::vector<float>& values = *axes[axis];
+        std::vector<std::uint16_t>& out = *codes[axis];
+        out.resize(values.size());
+        for (std::size_t i = 0; i < values.size(); ++i) {
+            const float code = (values[i] - lows[axis]) * inv_step + 0.5f;
+            out[i] = static_cast<std::uint16_t>(
+                std::min(std::max(code, 0.0f), kTop));
+        }
+    }
+}
+
+void QuantizedPositions::Decode(PositionsSoA& positions) const {
+    positions.x.resize(size());
+    positions.y.resize(size());
+    positions.z.resize(size());
+    for (std::size_t i = 0; i < size(); ++i) {
+        const Vertex v = Decode(i);
+        positions.x[i] = v.x;
+        positions.y[i] = v.y;
+        positions.z[i] = v.z;
+    }
+}
+
+std::array<float, 16> QuantizedPositions::DecodeMatrix() const {
+    return {step[0], 0.0f,    0.0f,    origin[0],
+            0.0f,    step[1], 0.0f,    origin[1],
+            0.0f,    0.0f,    step[2], origin[2],
+            0.0f,    0.0f,    0.0f,    1.0f};
+}
+
+QuantizationError QuantizedPositions::MeasureError(
+    const PositionsSoA& positions) const {
+    QuantizationError error;
+    error.bound = 0.5f * std::sqrt(step[0] * step[0] + step[1] * step[1] +
+                                   step[2] * step[2]);
+    if (positions.size() != size() || empty()) {
+        return error;
+    }
+
+    double max_squared = 0.0;
+    double sum_squared = 0.0;
+    for (std::size_t i = 0; i < size(); ++i) {
+        const Vertex v = Decode(i);
+        const double dx = v.x - positions.x[i];
+        const double dy = v.y - positions.y[i];
+        const double dz = v.z - positions.z[i];
+        const double squared = dx * dx + dy * dy + dz * dz;
+        max_squared = std::max(max_squared, squared);
+        sum_squared += squared;
+    }
+    error.max = static_cast<float>(std::sqrt(max_squared));
+    error.rms = static_cast<float>(std::sqrt(sum_squared / size()));
+    return error;
+}
+
+void QuantizedPositions::clear() {
+    x.clear();
+    y.clear();
+    z.clear();
+    origin = {0.0f, 0.0f, 0.0f};
+    step = {0.0f, 0.0f, 0.0f};
+}
+
+VertexTransform VertexTransform::Make(float translate_x, float translate_y,
+                                      float translate_z, float rotate_x,
+                                      float rotate_y, float rotate_z,
+                                      float scale) {
+    VertexTransform transform;
+    transform.scale = scale;
+    transform.translate[0] = translate_x;
+    transform.translate[1] = translate_y;
+    transform.translate[2] = translate_z;
+
+    transform.has_scale = scale != 1.0f;
+    transform.has_rotation =
+        rotate_x != 0.0f || rotate_y != 0.0f || rotate_z != 0.0f;
+    transform.has_translation =
+        translate_x != 0.0f || translate_y != 0.0f || translate_z != 0.0f;
+
+    if (transform.has_rotation) {
+        const float sin_x = std::sin(rotate_x * kDegToRad);
+        const float cos_x = std::cos(rotate_x * kDegToRad);
+        const float sin_y = std::sin(rotate_y * kDegToRad);
+        const float cos_y = std::cos(rotate_y * kDegToRad);
+        const float sin_z = std::sin(rotate_z * kDegToRad);
+        const float cos_z = std::cos(rotate_z * kDegToRad);
+
+        const float rotation_x[9] = {1.0f, 0.0f, 0.0f,   0.0f, cos_x,
+                                     -sin_x, 0.0f, sin_x, cos_x};
+        const float rotation_y[9] = {cos_y,  0.0f, sin_y, 0.0f, 1.0f,
+                                     0.0f, -sin_y, 0.0f, cos_y};
+        const float rotation_z[9] = {cos_z, -sin_z, 0.0f, sin_z, cos_z,
+                                     0.0f,  0.0f,   0.0f, 1.0f};
+
+        float rotation_zy[9];
+        Multiply3x3(rotation_z, rotation_y, rotation_zy);
+        Multiply3x3(rotation_zy, rotation_x, transform.linear);
+
+        for (float& value : transform.linear) {
+            value *= scale;
+        }
+    } else {
+        transform.linear[0] = scale;
+        transform.linear[4] = scale;
+        transform.linear[8] = scale;
+    }
+
+    return transform;
+}
+
+bool IsTransformIsaSupported(TransformIsa isa) {
+    switch (isa) {
+        case TransformIsa::kScalar:
+            return true;
+#ifdef VIEWER3D_X86_SIMD
+        case TransformIsa::kSse2:
+            return __builtin_cpu_supports("sse2");
+        case TransformIsa::kAvx2:
+            return __builtin_cpu_supports("avx2");
+#endif
+        default:
+            return false;
+    }
+}
+
+TransformIsa BestTransformIsa() {
+    static const TransformIsa best = [] {
+        if (IsTransformIsaSupported(TransformIsa::kAvx2)) {
+            return TransformIsa::kAvx2;
+        }
+        if (IsTransformIsaSupported(TransformIsa::kSse2)) {
+            return TransformIsa::kSse2;
+        }
+        return TransformIsa::kScalar;
+    }();
+    return best;
+}
+
+void TransformVertices(const PositionsSoA& source, std::size_t begin,
+                       std::size_t end, const VertexTransform& transform,
+                       Vertex* out, TransformIsa isa) {
+    if (begin >= end) {
+        return;
+    }
+    if (!IsTransformIsaSupported(isa)) {
+        isa = TransformIsa::kScalar;
+    }
+    KernelFn kernel = SelectKernel(isa, transform);
+    kernel(source.x.data() + begin, source.y.data() + begin,
+           source.z.data() + begin, end - begin, transform, out + begin);
+}
+
+void TransformVertices(const QuantizedPositions& source, std::size_t begin,
+                       std::size_t end, const VertexTransform& transform,
+                       Vertex* out, TransformIsa isa) {
+    if (begin >= end) {
+        return;
+    }
+    if (!IsTransformIsaSupported(isa)) {
+        isa = TransformIsa::kScalar;
+    }
+    SelectQuantizedKernel(isa)(source.x.data() + begin,
+                               source.y.data() + begin,
+                               source.z.data() + begin, end - begin,
+                               FoldDecoding(source, transform), out + begin);
+}
+
+}  // namespace viewer3d
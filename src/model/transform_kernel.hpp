@@ -0,0 +1,106 @@
+#ifndef TRANSFORM_KERNEL_H
+#define TRANSFORM_KERNEL_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "model/vertex.hpp"
+
+namespace viewer3d {
+
+// Vertex positions in structure-of-arrays layout, the input of the
+// transform kernel.
+struct PositionsSoA {
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<float> z;
+
+    std::size_t size() const { return x.size(); }
+    bool empty() const { return x.empty(); }
+
+    void Assign(const std::vector<Vertex>& vertices);
+    void clear();
+};
+
+// Deviation of quantized positions from the floats they were made from.
+struct QuantizationError {
+    // Largest and root mean square distance between a source position and
+    // its decoded value.
+    float max{0.0f};
+    float rms{0.0f};
+    // Distance bound implied by the grid, half a step along every axis.
+    float bound{0.0f};
+};
+
+// Positions stored as 16 bits per axis on a grid spanning the bounding box
+// of the model: axis a of vertex i decodes to origin[a] + step[a] * a[i].
+// Takes half the memory of PositionsSoA. Decoding is affine, so it folds
+// into the transform matrix on the CPU and into the model matrix on the
+// GPU at no cost per vertex.
+struct QuantizedPositions {
+    static constexpr int kLevels = 1 << 16;
+
+    std::vector<std::uint16_t> x;
+    std::vector<std::uint16_t> y;
+    std::vector<std::uint16_t> z;
+    std::array<float, 3> origin{0.0f, 0.0f, 0.0f};
+    std::array<float, 3> step{0.0f, 0.0f, 0.0f};
+
+    std::size_t size() const { return x.size(); }
+    bool empty() const { return x.empty(); }
+    std::size_t MemoryBytes() const {
+        return 3 * x.capacity() * sizeof(std::uint16_t);
+    }
+
+    // `min` and `max` bound all positions.
+    void Encode(const PositionsSoA& positions, const Vertex& min,
+                const Vertex& max);
+    void Decode(PositionsSoA& positions) const;
+    Vertex Decode(std::size_t i) const {
+        return {origin[0] + step[0] * x[i], origin[1] + step[1] * y[i],
+                origin[2] + step[2] * z[i]};
+    }
+    // Row-major 4x4 matrix taking stored values to positions.
+    std::array<float, 16> DecodeMatrix() const;
+    QuantizationError MeasureError(const PositionsSoA& positions) const;
+    void clear();
+};
+
+// Scale, then rotate around X, Y and Z, then translate, folded into one
+// 3x3 matrix (row-major, scale included) and a translation.
+struct VertexTransform {
+    float linear[9]{1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f};
+    float translate[3]{0.0f, 0.0f, 0.0f};
+    float scale{1.0f};
+
+    bool has_scale{false};
+    bool has_rotation{false};
+    bool has_translation{false};
+
+    static VertexTransform Make(float translate_x, float translate_y,
+                                float translate_z, float rotate_x,
+                                float rotate_y, float rotate_z, float scale);
+};
+
+enum class TransformIsa { kScalar, kSse2, kAvx2 };
+
+bool IsTransformIsaSupported(TransformIsa isa);
+// The widest instruction set supported by the running CPU.
+TransformIsa BestTransformIsa();
+
+// Writes the transformed positions [begin, end) of `source` to
+// out[begin, end). The kernel is picked once per call from the flags of
+// `transform`, so the per-vertex loop has no branches.
+void TransformVertices(const PositionsSoA& source, std::size_t begin,
+                       std::size_t end, const VertexTransform& transform,
+                       Vertex* out, TransformIsa isa = BestTransformIsa());
+// Same for quantized positions, decoding them on the way.
+void TransformVertices(const QuantizedPositions& source, std::size_t begin,
+                       std::size_t end, const VertexTransform& transform,
+                       Vertex* out, TransformIsa isa = BestTransformIsa());
+
+}  // namespace viewer3d
+
+#endif
@@ -0,0 +1,14 @@
+#ifndef VERTEX_H
+#define VERTEX_H
+
+namespace viewer3d {
+
+struct Vertex {
+    float x{0.0f};
+    float y{0.0f};
+    float z{0.0f};
+};
+
+}  // namespace viewer3d
+
+#endif
@@ -1,13 +1,20 @@
 #include "view/glwidget.hpp"
 
-#ifdef __APPLE__
-#include <OpenGL/glu.h>
-#else
-#include <GL/glu.h>
-#endif
-
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFontDatabase>
+#include <QGuiApplication>
+#include <QLocale>
 #include <QMouseEvent>
+#include <QPainter>
+#include <QScreen>
 #include <QWheelEvent>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <utility>
+#include <vector>
 
 namespace viewer3d {
 
@@ -20,6 +27,7 @@ constexpr float kBackgroundA = 1.0f;
 constexpr float kModelR = 0.9f;
 constexpr float kModelG = 0.9f;
 constexpr float kModelB = 0.9f;
+constexpr float kModelA = 1.0f;
 
 constexpr float kCameraDistance = -5.0f;
 constexpr float kRotationSpeed = 0.5f;
@@ -28,49 +36,146 @@ constexpr float kMinZoom = 0.1f;
 constexpr float kDefaultFOV = 45.0f;
 constexpr float kNearPlane = 0.1f;
 constexpr float kFarPlane = 100.0f;
+
+// A streaming load repaints at most this often.
+constexpr int kStreamRepaintIntervalMs = 100;
+
+// GPU times arrive a few frames late; older frames are waited for once this
+// many are in flight.
+constexpr std::size_t kMaxPendingGpuFrames = 4;
+constexpr int kOverlayMargin = 8;
+constexpr int kOverlayPadding = 6;
+constexpr qreal kPickMarkerRadius = 5.0;
+
+QString formatMs(double ms) { return QString::number(ms, 'f', 2); }
 }  // namespace
 
 GLWidget::GLWidget(Controller& controller, QWidget* parent)
-    : QOpenGLWidget(parent), controller_(controller) {}
+    : QOpenGLWidget(parent),
+      controller_(controller),
+      transformScheduler_(controller),
+      streamTimer_(new QTimer(this)) {
+    streamTimer_->setInterval(kStreamRepaintIntervalMs);
+    connect(streamTimer_, &QTimer::timeout, this, &GLWidget::onStreamTimer);
+}
+
+GLWidget::~GLWidget() {
+    makeCurrent();
+    collectFrameSamples(true);
+    idleGpuTimers_.clear();
+    renderer_.reset();
+    doneCurrent();
+}
 
-GLWidget::~GLWidget() {}
+const PhaseTimings& GLWidget::lastFramePhases() const {
+    static const PhaseTimings kNoPhases;
+    return renderer_ ? renderer_->lastPhases() : kNoPhases;
+}
 
 void GLWidget::initializeGL() {
     initializeOpenGLFunctions();
     glClearColor(kBackgroundR, kBackgroundG, kBackgroundB, kBackgroundA);
+
+    renderer_ = std::make_unique<ModelRenderer>();
+    renderer_->initialize();
+    renderer_->setColor(QVector4D(kModelR, kModelG, kModelB, kModelA));
+
+    // Frames are presented on vertical sync, so a transform that waits
+    // longer than one refresh has missed a frame.
+    const QScreen* screen = QGuiApplication::primaryScreen();
+    if (screen && screen->refreshRate() > 0.0) {
+        transformScheduler_.SetFrameInterval(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::duration<double>(1.0 / screen->refreshRate())));
+    }
 }
 
 void GLWidget::paintGL() {
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-    glLoadIdentity();
+    collectFrameSamples(false);
 
-    glTranslatef(0.0f, 0.0f, kCameraDistance);
-    glScalef(zoom_, zoom_, zoom_);
-    glRotatef(rotationX_, 1.0f, 0.0f, 0.0f);
-    glRotatef(rotationY_, 0.0f, 1.0f, 0.0f);
+    PendingFrame frame;
+    QElapsedTimer cpuTimer;
+    cpuTimer.start();
+    frame.gpuTimer = startGpuTimer();
+    {
+        VIEWER3D_TRACE_ZONE("GLWidget::paintGL");
+        // The model is published on a worker, see publishModel(); the frame
+        // takes the latest snapshot and reads nothing else.
+        frameSnapshot_ = controller_.GetLatestSnapshot();
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        drawModel();
+    }
+    if (frame.gpuTimer) {
+        frame.gpuTimer->end();
+    }
+    frame.sample.cpu_ms = cpuTimer.nsecsElapsed() / 1e6;
+    if (renderer_) {
+        const DrawCounts& counts = renderer_->lastDrawCounts();
+        frame.sample.draw_calls = counts.drawCalls;
+        frame.sample.vertices = counts.vertices;
+        frame.sample.lines = counts.lines;
+        frame.sample.culled_lines = counts.culledLines;
+    }
+    pendingFrames_.push_back(std::move(frame));
+    collectFrameSamples(false);
 
-    drawModel();
+    drawPickMarker();
+    if (frameStatsVisible_) {
+        drawFrameStats();
+    }
+    frameSnapshot_.reset();
+    emit frameDrawn();
 }
 
 void GLWidget::resizeGL(int width, int height) {
     glViewport(0, 0, width, height);
-    glMatrixMode(GL_PROJECTION);
-    glLoadIdentity();
 
     float aspect = static_cast<float>(width) / (height ? height : 1);
-    gluPerspective(kDefaultFOV, aspect, kNearPlane, kFarPlane);
+    projection_.setToIdentity();
+    projection_.perspective(kDefaultFOV, aspect, kNearPlane, kFarPlane);
+}
+
+void GLWidget::mousePressEvent(QMouseEvent* event) {
+    lastPos_ = event->pos();
+    if (event->button() != Qt::LeftButton || stream_) {
+        return;
+    }
 
-    glMatrixMode(GL_MODELVIEW);
-    glLoadIdentity();
+    PickResult result;
+    hasPick_ = pickAt(event->localPos(), result);
+    if (hasPick_) {
+        pick_ = result;
+        pickGeometryRevision_ = controller_.GetGeometryRevision();
+    }
+    emit picked(hasPick_, result);
+    update();
 }
 
-void GLWidget::mousePressEvent(QMouseEvent* event) { lastPos_ = event->pos(); }
+// The ray runs from the near to the far plane through the pixel, in the
+// coordinates the model is drawn in.
+bool GLWidget::pickAt(const QPointF& pos, PickResult& result) const {
+    if (width() <= 0 || height() <= 0) {
+        return false;
+    }
+    const float x = 2.0f * pos.x() / width() - 1.0f;
+    const float y = 1.0f - 2.0f * pos.y() / height();
+    const QMatrix4x4 inverse = (projection_ * viewMatrix()).inverted();
+    const QVector3D nearPoint = inverse.map(QVector3D(x, y, -1.0f));
+    const QVector3D direction =
+        inverse.map(QVector3D(x, y, 1.0f)) - nearPoint;
+    const Ray ray{{nearPoint.x(), nearPoint.y(), nearPoint.z()},
+                  {direction.x(), direction.y(), direction.z()}};
+    return controller_.Pick(ray, result);
+}
 
 void GLWidget::mouseMoveEvent(QMouseEvent* event) {
     int dx = event->x() - lastPos_.x();
     int dy = event->y() - lastPos_.y();
 
-    if (event->buttons() & Qt::LeftButton) {
+    if ((event->buttons() & Qt::LeftButton) &&
+        (event->modifiers() & Qt::ControlModifier)) {
+        emit modelDragged(kRotationSpeed * dy, kRotationSpeed * dx);
+    } else if (event->buttons() & Qt::LeftButton) {
         rotationX_ += kRotationSpeed * dy;
         rotationY_ += kRotationSpeed * dx;
         update();
@@ -86,40 +191,284 @@ void GLWidget::wheelEvent(QWheelEvent* event) {
     update();
 }
 
-void GLWidget::updateModel() { update(); }
+void GLWidget::updateModel() { publishModel(); }
 
-void GLWidget::drawModel() {
-    const auto& vertices = controller_.GetVertices();
-    const auto& faces = controller_.GetFaces();
+void GLWidget::requestTransform(const TransformParams& params) {
+    if (transformScheduler_.Request(params)) {
+        publishModel();
+    }
+}
 
-    if (vertices.empty() || faces.empty()) {
+// Applies the pending transform and publishes the model on a worker thread,
+// then repaints. Changes made meanwhile are published after it, so a kCpu
+// transform never runs on this thread or inside a frame.
+void GLWidget::publishModel() {
+    if (controller_.IsPublishing()) {
+        republish_ = true;
         return;
     }
+    republish_ = false;
+    transformScheduler_.Flush();
+    controller_.PublishSnapshotAsync([this]() {
+        update();
+        if (republish_) {
+            publishModel();
+        }
+    });
+}
 
-    glColor3f(kModelR, kModelG, kModelB);
+void GLWidget::setFrameStatsVisible(bool visible) {
+    frameStatsVisible_ = visible;
+    update();
+}
 
-    for (const auto& face : faces) {
-        const auto& indices = face.vertexIndices;
-        if (indices.size() == 2) {
-            glBegin(GL_LINES);
-            for (int index : indices) {
-                if (index >= 0 && index < static_cast<int>(vertices.size())) {
-                    const auto& vertex = vertices[index];
-                    glVertex3f(vertex.x, vertex.y, vertex.z);
-                }
-            }
-            glEnd();
-        } else if (indices.size() >= 3) {
-            glBegin(GL_LINE_LOOP);
-            for (int index : indices) {
-                if (index >= 0 && index < static_cast<int>(vertices.size())) {
-                    const auto& vertex = vertices[index];
-                    glVertex3f(vertex.x, vertex.y, vertex.z);
-                }
+bool GLWidget::startFrameStatsLog(const QString& filename) {
+    stopFrameStatsLog();
+    return frameStats_.StartCsvLog(filename.toStdString());
+}
+
+void GLWidget::stopFrameStatsLog() {
+    if (!frameStats_.IsLogging()) {
+        return;
+    }
+    // Frames still waiting for their GPU time belong in the log.
+    if (isValid()) {
+        makeCurrent();
+        collectFrameSamples(true);
+        doneCurrent();
+    }
+    frameStats_.StopCsvLog();
+}
+
+void GLWidget::setStream(std::shared_ptr<const GeometryStream> stream) {
+    stream_ = std::move(stream);
+    drawnStreamRevision_ = 0;
+    streamGeometryDrawn_ = false;
+    if (renderer_) {
+        renderer_->resetStream();
+    }
+
+    if (stream_) {
+        streamTimer_->start();
+    } else {
+        streamTimer_->stop();
+    }
+    update();
+}
+
+void GLWidget::onStreamTimer() {
+    if (stream_ && stream_->Revision() != drawnStreamRevision_) {
+        update();
+    }
+}
+
+// Timer queries cost a little, so frames are only timed on the GPU while
+// the statistics are shown or logged. Needs OpenGL 3.3 or
+// GL_ARB_timer_query; otherwise the statistics hold CPU times only.
+std::unique_ptr<QOpenGLTimerQuery> GLWidget::startGpuTimer() {
+    if (!gpuTimersAvailable_ ||
+        !(frameStatsVisible_ || frameStats_.IsLogging())) {
+        return nullptr;
+    }
+    if (pendingFrames_.size() >= kMaxPendingGpuFrames) {
+        collectFrameSamples(true);
+    }
+
+    std::unique_ptr<QOpenGLTimerQuery> timer;
+    if (!idleGpuTimers_.empty()) {
+        timer = std::move(idleGpuTimers_.back());
+        idleGpuTimers_.pop_back();
+    } else {
+        timer = std::make_unique<QOpenGLTimerQuery>();
+        if (!timer->create()) {
+            gpuTimersAvailable_ = false;
+            qInfo() << "GPU timer queries are not available, frame "
+                       "statistics show CPU times only";
+            return nullptr;
+        }
+    }
+    timer->begin();
+    return timer;
+}
+
+// Moves finished frames to frameStats_ in order. Without `wait` it stops at
+// the first frame whose GPU time is not available yet.
+void GLWidget::collectFrameSamples(bool wait) {
+    while (!pendingFrames_.empty()) {
+        PendingFrame& frame = pendingFrames_.front();
+        if (frame.gpuTimer) {
+            if (!wait && !frame.gpuTimer->isResultAvailable()) {
+                return;
             }
-            glEnd();
+            frame.sample.gpu_ms = frame.gpuTimer->waitForResult() / 1e6;
+            idleGpuTimers_.push_back(std::move(frame.gpuTimer));
+        }
+        frameStats_.Add(frame.sample);
+        pendingFrames_.pop_front();
+    }
+}
+
+void GLWidget::drawFrameStats() {
+    QStringList lines;
+    if (frameStats_.empty()) {
+        lines << "Waiting for frames...";
+    } else {
+        const FrameSample& last = frameStats_.Last();
+        const QLocale locale;
+        lines << QString("CPU %1 ms  p50 %2  p99 %3")
+                     .arg(formatMs(last.cpu_ms))
+                     .arg(formatMs(frameStats_.CpuPercentile(50)))
+                     .arg(formatMs(frameStats_.CpuPercentile(99)));
+        if (last.gpu_ms >= 0.0) {
+            lines << QString("GPU %1 ms  p50 %2  p99 %3")
+                         .arg(formatMs(last.gpu_ms))
+                         .arg(formatMs(frameStats_.GpuPercentile(50)))
+                         .arg(formatMs(frameStats_.GpuPercentile(99)));
+        } else {
+            lines << "GPU n/a";
+        }
+        lines << QString("Draw calls %1").arg(last.draw_calls);
+        lines << "Vertices " +
+                     locale.toString(static_cast<qulonglong>(last.vertices));
+        lines << "Lines " +
+                     locale.toString(static_cast<qulonglong>(last.lines));
+        const quint64 total = last.lines + last.culled_lines;
+        if (total > 0) {
+            lines << QString("Culled %1%").arg(
+                100.0 * last.culled_lines / total, 0, 'f', 1);
+        }
+        const std::shared_ptr<const LodChain> lods = controller_.GetLods();
+        if (lodLevel_ > 0 && lods && lodLevel_ <= lods->size()) {
+            lines << QString("Level of detail %1 (%2%)")
+                         .arg(lodLevel_)
+                         .arg((*lods)[lodLevel_ - 1].ratio * 100.0);
+        } else {
+            lines << "Full detail";
         }
+        const TransformSchedulerStats& transforms =
+            transformScheduler_.GetStats();
+        if (transforms.requests > 0) {
+            lines << QString("Transforms %1 of %2, %3 coalesced, %4 dropped")
+                         .arg(transforms.applied)
+                         .arg(transforms.requests)
+                         .arg(transforms.coalesced)
+                         .arg(transforms.dropped_frames);
+        }
+        lines << QString("Last %1 frames").arg(frameStats_.size());
+    }
+    if (frameStats_.IsLogging()) {
+        lines << "Logging to CSV";
+    }
+
+    QPainter painter(this);
+    painter.setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+    const QFontMetrics metrics = painter.fontMetrics();
+    int width = 0;
+    for (const QString& line : lines) {
+        width = std::max(width, metrics.horizontalAdvance(line));
+    }
+    const QRect box(kOverlayMargin, kOverlayMargin,
+                    width + 2 * kOverlayPadding,
+                    lines.size() * metrics.height() + 2 * kOverlayPadding);
+    painter.fillRect(box, QColor(0, 0, 0, 160));
+    painter.setPen(Qt::white);
+    painter.drawText(box.adjusted(kOverlayPadding, kOverlayPadding,
+                                  -kOverlayPadding, -kOverlayPadding),
+                     Qt::AlignLeft | Qt::AlignTop, lines.join('\n'));
+}
+
+// Circles the picked vertex, following later transforms of the model.
+void GLWidget::drawPickMarker() {
+    if (!hasPick_ || stream_ || !frameSnapshot_ ||
+        pickGeometryRevision_ != frameSnapshot_->geometry_revision) {
+        return;
     }
+    const Vertex v = frameSnapshot_->geometry->SourcePosition(pick_.vertex);
+    const QVector3D ndc =
+        (projection_ * viewMatrix() *
+         QMatrix4x4(frameSnapshot_->model_matrix.data()))
+            .map(QVector3D(v.x, v.y, v.z));
+    if (ndc.z() < -1.0f || ndc.z() > 1.0f) {
+        return;
+    }
+
+    QPainter painter(this);
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.setPen(QColor(255, 200, 0));
+    painter.drawEllipse(QPointF((ndc.x() + 1.0f) * 0.5f * width(),
+                                (1.0f - ndc.y()) * 0.5f * height()),
+                        kPickMarkerRadius, kPickMarkerRadius);
+}
+
+QMatrix4x4 GLWidget::viewMatrix() const {
+    QMatrix4x4 view;
+    view.translate(0.0f, 0.0f, kCameraDistance);
+    view.scale(zoom_);
+    view.rotate(rotationX_, 1.0f, 0.0f, 0.0f);
+    view.rotate(rotationY_, 0.0f, 1.0f, 0.0f);
+    return view;
+}
+
+void GLWidget::drawModel() {
+    VIEWER3D_TRACE_ZONE("GLWidget::drawModel");
+    if (!renderer_) {
+        return;
+    }
+
+    if (!stream_) {
+        if (!frameSnapshot_) {
+            return;
+        }
+        const std::shared_ptr<const LodChain> lods = controller_.GetLods();
+        lodLevel_ = chooseLod(lods);
+        renderer_->draw(*frameSnapshot_, lods, projection_ * viewMatrix(),
+                        lodLevel_);
+        return;
+    }
+
+    drawnStreamRevision_ = stream_->Revision();
+    const bool drawn =
+        renderer_->drawStream(*stream_, projection_ * viewMatrix());
+    if (drawn && !streamGeometryDrawn_) {
+        streamGeometryDrawn_ = true;
+        emit firstStreamGeometryDrawn();
+    }
+}
+
+std::size_t GLWidget::chooseLod(const std::shared_ptr<const LodChain>& lods) {
+    if (!lods || lods->empty()) {
+        return 0;
+    }
+    std::vector<std::size_t> edgeCounts;
+    edgeCounts.reserve(lods->size() + 1);
+    edgeCounts.push_back(frameSnapshot_->geometry->edges.size());
+    for (std::size_t i = 0; i < lods->size(); ++i) {
+        edgeCounts.push_back((*lods)[i].edges.size());
+    }
+    return SelectLod(edgeCounts, projectedModelPixels(), lodLevel_);
+}
+
+// Screen area of the model's bounding sphere, in framebuffer pixels. The
+// sphere is treated as if it were centred in front of the camera.
+double GLWidget::projectedModelPixels() const {
+    const Bounds& bounds = frameSnapshot_->geometry->bounds;
+    if (bounds.empty()) {
+        return 0.0;
+    }
+    const double dx = bounds.max.x - bounds.min.x;
+    const double dy = bounds.max.y - bounds.min.y;
+    const double dz = bounds.max.z - bounds.min.z;
+    const std::array<float, 16>& model = frameSnapshot_->model_matrix;
+    const double modelScale = std::sqrt(
+        model[0] * model[0] + model[4] * model[4] + model[8] * model[8]);
+    const double radius =
+        0.5 * std::sqrt(dx * dx + dy * dy + dz * dz) * modelScale * zoom_;
+
+    const double halfFov = kDefaultFOV * 0.5 * M_PI / 180.0;
+    const double pixelsPerUnit = height() * devicePixelRatioF() /
+                                 (2.0 * std::tan(halfFov) * -kCameraDistance);
+    const double radiusPixels = radius * pixelsPerUnit;
+    return M_PI * radiusPixels * radiusPixels;
 }
 
 }  // namespace viewer3d
\ No newline at end of file
@@ -4,9 +4,18 @@
 #include <QMatrix4x4>
 #include <QOpenGLBuffer>
 #include <QOpenGLFunctions>
+#include <QOpenGLTimerQuery>
 #include <QOpenGLWidget>
+#include <QTimer>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <vector>
 
 #include "controller/controller.hpp"
+#include "controller/transform_scheduler.hpp"
+#include "model/frame_stats.hpp"
+#include "view/model_renderer.hpp"
 
 namespace viewer3d {
 
@@ -17,6 +26,24 @@ class GLWidget : public QOpenGLWidget, protected QOpenGLFunctions {
     explicit GLWidget(Controller& controller, QWidget* parent = nullptr);
     ~GLWidget();
 
+    // Upload and draw times of the last frame.
+    const PhaseTimings& lastFramePhases() const;
+
+    const FrameStats& frameStats() const { return frameStats_; }
+    bool isFrameStatsVisible() const { return frameStatsVisible_; }
+    // Appends every frame to a CSV file until stopFrameStatsLog().
+    bool startFrameStatsLog(const QString& filename);
+    void stopFrameStatsLog();
+
+    // Casts a ray through `pos`, in widget coordinates, and finds the face
+    // and vertex under it. Fast enough to run on every mouse move.
+    bool pickAt(const QPointF& pos, PickResult& result) const;
+
+    const TransformSchedulerStats& transformStats() const {
+        return transformScheduler_.GetStats();
+    }
+    void resetTransformStats() { transformScheduler_.ResetStats(); }
+
    protected:
     void initializeGL() override;
     void paintGL() override;
@@ -27,17 +54,78 @@ class GLWidget : public QOpenGLWidget, protected QOpenGLFunctions {
     void wheelEvent(QWheelEvent* event) override;
 
    public slots:
+    // Publishes the model after a change and repaints once it is drawable.
     void updateModel();
+    // Shows the geometry of a streaming load instead of the model, repainted
+    // at a throttled rate while it grows. nullptr goes back to the model.
+    void setStream(std::shared_ptr<const GeometryStream> stream);
+    // Draws CPU and GPU frame times, percentiles over the last frames and
+    // what the frame submitted over the viewport.
+    void setFrameStatsVisible(bool visible);
+    // Transforms the model on a worker thread and repaints once it is done.
+    // Requests that arrive in the meantime replace each other, so the model
+    // is transformed at most once per published snapshot.
+    void requestTransform(const TransformParams& params);
+
+   signals:
+    // Emitted once per stream, after the first frame that shows some of it.
+    void firstStreamGeometryDrawn();
+    void frameDrawn();
+    // Emitted for every left click on the model view; `hit` is false when
+    // nothing is under the cursor.
+    void picked(bool hit, const PickResult& result);
+    // Ctrl + left drag, in degrees about the x and y axes of the view.
+    void modelDragged(float angleX, float angleY);
 
    private:
     Controller& controller_;
+    TransformScheduler transformScheduler_;
+    std::unique_ptr<ModelRenderer> renderer_;
+    // What the current frame draws, taken when it starts.
+    std::shared_ptr<const ModelSnapshot> frameSnapshot_;
+    // The model changed while a publish was running.
+    bool republish_ = false;
+    QMatrix4x4 projection_;
     QPoint lastPos_;
 
+    std::shared_ptr<const GeometryStream> stream_;
+    QTimer* streamTimer_;
+    std::uint64_t drawnStreamRevision_ = 0;
+    bool streamGeometryDrawn_ = false;
+
+    // A frame waiting for its GPU time; frames reach frameStats_ in order.
+    struct PendingFrame {
+        FrameSample sample;
+        std::unique_ptr<QOpenGLTimerQuery> gpuTimer;
+    };
+    FrameStats frameStats_;
+    bool frameStatsVisible_ = false;
+    bool gpuTimersAvailable_ = true;
+    std::deque<PendingFrame> pendingFrames_;
+    std::vector<std::unique_ptr<QOpenGLTimerQuery>> idleGpuTimers_;
+
+    // The last pick, marked in the view until the geometry changes.
+    bool hasPick_ = false;
+    PickResult pick_;
+    std::uint64_t pickGeometryRevision_ = 0;
+
+    // Level of detail of the last frame, 0 for the full model.
+    std::size_t lodLevel_ = 0;
+
     float rotationX_ = 0.0f;
     float rotationY_ = 0.0f;
     float zoom_ = 1.0f;
 
+    QMatrix4x4 viewMatrix() const;
+    void publishModel();
     void drawModel();
+    std::size_t chooseLod(const std::shared_ptr<const LodChain>& lods);
+    double projectedModelPixels() const;
+    void onStreamTimer();
+    std::unique_ptr<QOpenGLTimerQuery> startGpuTimer();
+    void collectFrameSamples(bool wait);
+    void drawFrameStats();
+    void drawPickMarker();
 };
 
 }  // namespace viewer3d
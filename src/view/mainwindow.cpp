@@ -1,10 +1,17 @@
 #include "view/mainwindow.hpp"
 
 #include <QApplication>
+#include <QDebug>
 #include <QFileInfo>
+#include <QKeySequence>
+#include <QMenu>
 #include <QMessageBox>
 #include <QPalette>
+#include <QSignalBlocker>
+#include <QStringList>
 #include <QStyleFactory>
+#include <cmath>
+#include <utility>
 
 namespace viewer3d {
 
@@ -12,6 +19,25 @@ namespace {
 const QString kAppTitle = "3DViewer";
 const int kMinWindowWidth = 800;
 const int kMinWindowHeight = 600;
+const int kTimedMessageMs = 5000;
+
+QString formatMegabytes(std::size_t bytes) {
+    return QString::number(bytes / (1024.0 * 1024.0), 'f', 1) + " MB";
+}
+
+// " (parse 650 ms, edges 120 ms)"
+QString formatPhases(const PhaseTimings& phases) {
+    if (phases.empty()) {
+        return QString();
+    }
+    QStringList parts;
+    for (const PhaseTiming& phase : phases) {
+        parts << QString("%1 %2 ms")
+                     .arg(phase.name)
+                     .arg(phase.ms, 0, 'f', phase.ms < 10.0 ? 1 : 0);
+    }
+    return " (" + parts.join(", ") + ")";
+}
 
 QPalette createDarkPalette() {
     QPalette darkPalette;
@@ -40,15 +66,33 @@ MainWindow::MainWindow(Controller& controller, QWidget* parent)
     setupUI();
     setupConnections();
     updateStatusBar();
+
+    controller_.SetDispatcher([this](std::function<void()> task) {
+        QMetaObject::invokeMethod(this, std::move(task), Qt::QueuedConnection);
+    });
+    controller_.SetLodCallback(
+        [this](const LodChain& lods) { onLodsBuilt(lods); });
+}
+
+// Completions posted by the worker threads must not outlive the window.
+MainWindow::~MainWindow() {
+    controller_.WaitForPublish();
+    controller_.CancelLoad();
+    controller_.CancelLodBuild();
+    controller_.SetLodCallback(nullptr);
 }
 
 void MainWindow::setupUI() {
     createWidgets();
     createLayouts();
+    createMenus();
 
     setWindowTitle(kAppTitle);
     setMinimumSize(kMinWindowWidth, kMinWindowHeight);
 
+    statusBar()->addPermanentWidget(loadProgress_);
+    statusBar()->addPermanentWidget(cancelLoadButton_);
+    setLoadingVisible(false);
     statusBar()->showMessage("Ready for work.");
 }
 
@@ -56,6 +100,9 @@ void MainWindow::createWidgets() {
     glWidget_ = new GLWidget(controller_, this);
 
     openButton_ = new QPushButton("Open file", this);
+    loadProgress_ = new QProgressBar(this);
+    loadProgress_->setRange(0, 100);
+    cancelLoadButton_ = new QPushButton("Cancel", this);
 
     translateXSpin_ = new QDoubleSpinBox(this);
     translateYSpin_ = new QDoubleSpinBox(this);
@@ -93,6 +140,8 @@ void MainWindow::createWidgets() {
     fileNameLabel_ = new QLabel(this);
     vertexCountLabel_ = new QLabel(this);
     edgeCountLabel_ = new QLabel(this);
+    boundaryEdgeCountLabel_ = new QLabel(this);
+    nonManifoldEdgeCountLabel_ = new QLabel(this);
 
     QString buttonStyle =
         "QPushButton { background-color: #3a3a3a; border-radius: 4px; padding: "
@@ -125,6 +174,8 @@ void MainWindow::createLayouts() {
     infoLayout->addWidget(fileNameLabel_);
     infoLayout->addWidget(vertexCountLabel_);
     infoLayout->addWidget(edgeCountLabel_);
+    infoLayout->addWidget(boundaryEdgeCountLabel_);
+    infoLayout->addWidget(nonManifoldEdgeCountLabel_);
     fileLayout->addWidget(infoGroup);
 
     controlsLayout->addLayout(fileLayout);
@@ -173,28 +224,335 @@ void MainWindow::createLayouts() {
 
 void MainWindow::setupConnections() {
     connect(openButton_, &QPushButton::clicked, this, &MainWindow::openFile);
+    connect(cancelLoadButton_, &QPushButton::clicked, this,
+            &MainWindow::cancelLoading);
+    connect(glWidget_, &GLWidget::firstStreamGeometryDrawn, this,
+            &MainWindow::onFirstGeometryDrawn);
+    connect(glWidget_, &GLWidget::frameDrawn, this, &MainWindow::onFrameDrawn);
+    connect(glWidget_, &GLWidget::picked, this, &MainWindow::onPicked);
+    connect(recordTraceAction_, &QAction::toggled, this,
+            &MainWindow::recordTrace);
+    connect(saveTraceAction_, &QAction::triggered, this,
+            &MainWindow::saveTrace);
+    connect(frameStatsAction_, &QAction::toggled, glWidget_,
+            &GLWidget::setFrameStatsVisible);
+    connect(frameStatsLogAction_, &QAction::toggled, this,
+            &MainWindow::toggleFrameStatsLog);
     connect(translateButton_, &QPushButton::clicked, this,
             &MainWindow::translate);
     connect(rotateButton_, &QPushButton::clicked, this, &MainWindow::rotate);
     connect(scaleButton_, &QPushButton::clicked, this, &MainWindow::scale);
+
+    connect(liveTransformsAction_, &QAction::toggled, this,
+            &MainWindow::toggleLiveTransforms);
+    for (QDoubleSpinBox* spin :
+         {translateXSpin_, translateYSpin_, translateZSpin_, rotateXSpin_,
+          rotateYSpin_, rotateZSpin_, scaleSpin_}) {
+        connect(spin, QOverload<double>::of(&QDoubleSpinBox::valueChanged),
+                this, &MainWindow::onTransformValueChanged);
+    }
+    connect(glWidget_, &GLWidget::modelDragged, this,
+            &MainWindow::onModelDragged);
+}
+
+void MainWindow::createMenus() {
+    QMenu* toolsMenu = menuBar()->addMenu("Tools");
+    recordTraceAction_ = new QAction("Record trace", this);
+    recordTraceAction_->setCheckable(true);
+    recordTraceAction_->setShortcut(QKeySequence("Ctrl+Shift+R"));
+    saveTraceAction_ = new QAction("Save trace...", this);
+    saveTraceAction_->setShortcut(QKeySequence("Ctrl+Shift+T"));
+    toolsMenu->addAction(recordTraceAction_);
+    toolsMenu->addAction(saveTraceAction_);
+    toolsMenu->addSeparator();
+
+    frameStatsAction_ = new QAction("Frame statistics", this);
+    frameStatsAction_->setCheckable(true);
+    frameStatsAction_->setShortcut(QKeySequence("F3"));
+    frameStatsLogAction_ = new QAction("Log frame statistics...", this);
+    frameStatsLogAction_->setCheckable(true);
+    toolsMenu->addAction(frameStatsAction_);
+    toolsMenu->addAction(frameStatsLogAction_);
+    toolsMenu->addSeparator();
+
+    liveTransformsAction_ = new QAction("Live transforms", this);
+    liveTransformsAction_->setCheckable(true);
+    liveTransformsAction_->setShortcut(QKeySequence("F4"));
+    toolsMenu->addAction(liveTransformsAction_);
 }
 
 void MainWindow::openFile() {
     QString filename = QFileDialog::getOpenFileName(
-        this, "Open 3D model", QDir::currentPath(), "OBJ Files (*.obj)");
+        this, "Open 3D model", QDir::currentPath(),
+        "3D models (*.obj *.ply *.stl);;OBJ Files (*.obj);;"
+        "PLY Files (*.ply);;STL Files (*.stl)");
 
     if (filename.isEmpty()) {
         return;
     }
 
+    loadFile(filename);
+}
+
+void MainWindow::loadFile(const QString& filename) {
+    loadPercent_ = 0;
+    loadProgress_->setValue(0);
+    setLoadingVisible(true);
     statusBar()->showMessage("Loading model...");
-    bool success = controller_.LoadModel(filename.toStdString());
-    if (success) {
-        onModelLoaded();
-        statusBar()->showMessage("Model loaded successfully", 3000);
+    loadTimer_.start();
+    firstGeometryMs_ = -1;
+
+    std::shared_ptr<GeometryStream> stream;
+    if (progressiveLoading_) {
+        stream = std::make_shared<GeometryStream>();
+    }
+    glWidget_->setStream(stream);
+
+    controller_.LoadModelAsync(
+        filename.toStdString(),
+        [this](std::uint64_t bytesDone, std::uint64_t bytesTotal) {
+            reportLoadProgress(bytesDone, bytesTotal);
+        },
+        [this, filename](LoadStatus status) {
+            onLoadFinished(filename, status);
+        },
+        stream);
+}
+
+void MainWindow::cancelLoading() { controller_.CancelLoad(); }
+
+void MainWindow::onFirstGeometryDrawn() {
+    firstGeometryMs_ = loadTimer_.elapsed();
+    qInfo() << "First geometry visible after" << firstGeometryMs_ << "ms";
+}
+
+// Runs on the loading thread, so only changes of the percentage are posted
+// to the GUI thread.
+void MainWindow::reportLoadProgress(std::uint64_t bytesDone,
+                                    std::uint64_t bytesTotal) {
+    if (bytesTotal == 0) {
+        return;
+    }
+    const int percent = static_cast<int>(bytesDone * 100 / bytesTotal);
+    int shown = loadPercent_.load();
+    while (percent > shown &&
+           !loadPercent_.compare_exchange_weak(shown, percent)) {
+    }
+    if (percent > shown) {
+        QMetaObject::invokeMethod(
+            this, [this, percent]() { loadProgress_->setValue(percent); },
+            Qt::QueuedConnection);
+    }
+}
+
+void MainWindow::onLoadFinished(const QString& filename, LoadStatus status) {
+    if (controller_.IsLoading()) {
+        // A newer load replaced this one and owns the progress widgets.
+        return;
+    }
+    setLoadingVisible(false);
+    glWidget_->setStream(nullptr);
+
+    switch (status) {
+        case LoadStatus::kLoaded: {
+            onModelLoaded();
+            QString message = controller_.WasLoadedFromCache()
+                                  ? "Model loaded from cache"
+                                  : "Model loaded successfully";
+            message += QString(" in %1 ms").arg(loadTimer_.elapsed());
+            if (firstGeometryMs_ >= 0) {
+                message += QString(", first geometry after %1 ms")
+                               .arg(firstGeometryMs_);
+            }
+            showTimedMessage(message);
+            break;
+        }
+        case LoadStatus::kCancelled:
+            statusBar()->showMessage("Loading cancelled", 3000);
+            break;
+        case LoadStatus::kFailed:
+            qWarning() << "Failed to upload file:" << filename;
+            statusBar()->showMessage("Failed to load model", 3000);
+            break;
+    }
+}
+
+// Shows the model phases now and adds the frame phases after the next
+// repaint.
+void MainWindow::showTimedMessage(const QString& message) {
+    timedMessage_ = message;
+    awaitingFrameTimings_ = true;
+    statusBar()->showMessage(
+        message + formatPhases(controller_.GetLastPhases()), kTimedMessageMs);
+}
+
+void MainWindow::onFrameDrawn() {
+    if (!awaitingFrameTimings_) {
+        return;
+    }
+    awaitingFrameTimings_ = false;
+    PhaseTimings phases = controller_.GetLastPhases();
+    const PhaseTimings& frame = glWidget_->lastFramePhases();
+    phases.insert(phases.end(), frame.begin(), frame.end());
+    statusBar()->showMessage(timedMessage_ + formatPhases(phases),
+                             kTimedMessageMs);
+}
+
+void MainWindow::setTraceRecording(bool enabled) {
+    recordTraceAction_->setChecked(enabled);
+}
+
+void MainWindow::recordTrace(bool enabled) {
+    if (!enabled) {
+        trace::Stop();
+        statusBar()->showMessage("Trace recording stopped", 3000);
+        return;
+    }
+    // A recording started before the window, e.g. by --trace, keeps its
+    // events.
+    if (!trace::IsRecording() && !trace::Start()) {
+        recordTraceAction_->setChecked(false);
+        statusBar()->showMessage("Tracing is not available in this build",
+                                 3000);
+        return;
+    }
+    statusBar()->showMessage("Recording a trace", 3000);
+}
+
+void MainWindow::saveTrace() {
+    const QString filename = QFileDialog::getSaveFileName(
+        this, "Save trace", QDir::currentPath() + "/trace.json",
+        "Chrome trace (*.json)");
+    if (filename.isEmpty()) {
+        return;
+    }
+    if (trace::WriteChromeTrace(filename.toStdString())) {
+        statusBar()->showMessage("Trace saved to " + filename, 3000);
     } else {
-        statusBar()->showMessage("Failed to load model", 3000);
+        statusBar()->showMessage("Failed to save the trace", 3000);
+    }
+}
+
+void MainWindow::onLodsBuilt(const LodChain& lods) {
+    glWidget_->updateModel();
+    if (lods.empty()) {
+        return;
+    }
+    const QString message =
+        QString("Built %1 levels of detail in %2 ms (%3, peak %4)")
+            .arg(lods.size())
+            .arg(lods.BuildMs(), 0, 'f', 0)
+            .arg(formatMegabytes(lods.MemoryBytes()))
+            .arg(formatMegabytes(lods.PeakBuildBytes()));
+    qInfo().noquote() << message;
+    statusBar()->showMessage(message, kTimedMessageMs);
+}
+
+void MainWindow::onPicked(bool hit, const PickResult& result) {
+    if (!hit) {
+        statusBar()->showMessage("Nothing under the cursor", 3000);
+        return;
     }
+    const Vertex& p = result.vertex_position;
+    statusBar()->showMessage(QString("Face %1, vertex %2 at (%3, %4, %5)")
+                                 .arg(result.face)
+                                 .arg(result.vertex)
+                                 .arg(p.x, 0, 'g', 6)
+                                 .arg(p.y, 0, 'g', 6)
+                                 .arg(p.z, 0, 'g', 6));
+}
+
+void MainWindow::setFrameStatsVisible(bool visible) {
+    frameStatsAction_->setChecked(visible);
+}
+
+bool MainWindow::logFrameStats(const QString& filename) {
+    if (!glWidget_->startFrameStatsLog(filename)) {
+        statusBar()->showMessage("Failed to open the frame log", 3000);
+        return false;
+    }
+    const QSignalBlocker blocker(frameStatsLogAction_);
+    frameStatsLogAction_->setChecked(true);
+    statusBar()->showMessage("Logging frame statistics to " + filename, 3000);
+    return true;
+}
+
+void MainWindow::toggleFrameStatsLog(bool enabled) {
+    if (!enabled) {
+        glWidget_->stopFrameStatsLog();
+        statusBar()->showMessage("Frame statistics log closed", 3000);
+        return;
+    }
+    const QString filename = QFileDialog::getSaveFileName(
+        this, "Log frame statistics", QDir::currentPath() + "/frames.csv",
+        "CSV files (*.csv)");
+    if (filename.isEmpty() || !logFrameStats(filename)) {
+        const QSignalBlocker blocker(frameStatsLogAction_);
+        frameStatsLogAction_->setChecked(false);
+    }
+}
+
+void MainWindow::setLiveTransforms(bool enabled) {
+    liveTransformsAction_->setChecked(enabled);
+}
+
+// While live, every change of the spin boxes is applied by the next frame
+// and the buttons have nothing left to do.
+void MainWindow::toggleLiveTransforms(bool enabled) {
+    translateButton_->setEnabled(!enabled);
+    rotateButton_->setEnabled(!enabled);
+    scaleButton_->setEnabled(!enabled);
+    if (enabled) {
+        glWidget_->resetTransformStats();
+        glWidget_->requestTransform(transformFromSpinBoxes());
+        statusBar()->showMessage("Live transforms on", 3000);
+        return;
+    }
+    const TransformSchedulerStats& stats = glWidget_->transformStats();
+    const QString message =
+        QString("Live transforms off: %1 of %2 requests applied, %3 "
+                "coalesced, %4 dropped frames")
+            .arg(stats.applied)
+            .arg(stats.requests)
+            .arg(stats.coalesced)
+            .arg(stats.dropped_frames);
+    qInfo().noquote() << message;
+    statusBar()->showMessage(message, kTimedMessageMs);
+}
+
+TransformParams MainWindow::transformFromSpinBoxes() const {
+    TransformParams params;
+    params.translate = {static_cast<float>(translateXSpin_->value()),
+                        static_cast<float>(translateYSpin_->value()),
+                        static_cast<float>(translateZSpin_->value())};
+    params.rotate = {static_cast<float>(rotateXSpin_->value()),
+                     static_cast<float>(rotateYSpin_->value()),
+                     static_cast<float>(rotateZSpin_->value())};
+    params.scale = static_cast<float>(scaleSpin_->value());
+    return params;
+}
+
+void MainWindow::onTransformValueChanged() {
+    if (liveTransformsAction_->isChecked()) {
+        glWidget_->requestTransform(transformFromSpinBoxes());
+    }
+}
+
+// Dragging turns the rotation spin boxes, which request the transform.
+// Angles wrap into [-180, 180] to stay inside their range.
+void MainWindow::onModelDragged(float angleX, float angleY) {
+    if (!liveTransformsAction_->isChecked()) {
+        return;
+    }
+    rotateXSpin_->setValue(
+        std::remainder(rotateXSpin_->value() + angleX, 360.0));
+    rotateYSpin_->setValue(
+        std::remainder(rotateYSpin_->value() + angleY, 360.0));
+}
+
+void MainWindow::setLoadingVisible(bool visible) {
+    loadProgress_->setVisible(visible);
+    cancelLoadButton_->setVisible(visible);
 }
 
 void MainWindow::onModelLoaded() {
@@ -218,7 +576,7 @@ void MainWindow::translate() {
     statusBar()->showMessage("Moving the model...");
     controller_.TranslateModel(dx, dy, dz);
     glWidget_->updateModel();
-    statusBar()->showMessage("The model has been moved", 3000);
+    showTimedMessage("The model has been moved");
 }
 
 void MainWindow::rotate() {
@@ -229,7 +587,7 @@ void MainWindow::rotate() {
     statusBar()->showMessage("Rotating the model...");
     controller_.RotateModel(angleX, angleY, angleZ);
     glWidget_->updateModel();
-    statusBar()->showMessage("The model has been rotated", 3000);
+    showTimedMessage("The model has been rotated");
 }
 
 void MainWindow::scale() {
@@ -238,7 +596,7 @@ void MainWindow::scale() {
     statusBar()->showMessage("Scaling the model...");
     controller_.ScaleModel(factor);
     glWidget_->updateModel();
-    statusBar()->showMessage("The model has been scaled", 3000);
+    showTimedMessage("The model has been scaled");
 }
 
 void MainWindow::updateStatusBar() {
@@ -248,6 +606,12 @@ void MainWindow::updateStatusBar() {
                                QString::number(controller_.GetVertexCount()));
     edgeCountLabel_->setText("Edges: " +
                              QString::number(controller_.GetEdgeCount()));
+    boundaryEdgeCountLabel_->setText(
+        "Boundary edges: " +
+        QString::number(controller_.GetBoundaryEdgeCount()));
+    nonManifoldEdgeCountLabel_->setText(
+        "Non-manifold edges: " +
+        QString::number(controller_.GetNonManifoldEdgeCount()));
 }
 
 }  // namespace viewer3d
\ No newline at end of file
@@ -1,16 +1,21 @@
 #ifndef MAINWINDOW_H
 #define MAINWINDOW_H
 
+#include <QAction>
 #include <QDoubleSpinBox>
+#include <QElapsedTimer>
 #include <QFileDialog>
 #include <QGroupBox>
 #include <QHBoxLayout>
 #include <QLabel>
 #include <QLineEdit>
 #include <QMainWindow>
+#include <QMenuBar>
+#include <QProgressBar>
 #include <QPushButton>
 #include <QStatusBar>
 #include <QVBoxLayout>
+#include <atomic>
 
 #include "controller/controller.hpp"
 #include "view/glwidget.hpp"
@@ -22,12 +27,37 @@ class MainWindow : public QMainWindow {
 
    public:
     explicit MainWindow(Controller& controller, QWidget* parent = nullptr);
-    ~MainWindow() = default;
-
+    ~MainWindow();
+
+    // Loads in the background; the current model stays on screen until the
+    // new one is ready.
+    void loadFile(const QString& filename);
+    // Streams the geometry of loading files into the viewport as it is
+    // parsed.
+    void setProgressiveLoading(bool enabled) { progressiveLoading_ = enabled; }
+    // Same as toggling Tools > Record trace.
+    void setTraceRecording(bool enabled);
+    // Same as toggling Tools > Frame statistics.
+    void setFrameStatsVisible(bool visible);
+    // Logs frame statistics to a CSV file, like Tools > Log frame
+    // statistics.
+    bool logFrameStats(const QString& filename);
+    // Same as toggling Tools > Live transforms.
+    void setLiveTransforms(bool enabled);
     void onModelLoaded();
 
    private slots:
     void openFile();
+    void cancelLoading();
+    void onFirstGeometryDrawn();
+    void onFrameDrawn();
+    void onPicked(bool hit, const PickResult& result);
+    void recordTrace(bool enabled);
+    void saveTrace();
+    void toggleFrameStatsLog(bool enabled);
+    void toggleLiveTransforms(bool enabled);
+    void onTransformValueChanged();
+    void onModelDragged(float angleX, float angleY);
     void translate();
     void rotate();
     void scale();
@@ -38,6 +68,24 @@ class MainWindow : public QMainWindow {
     GLWidget* glWidget_;
 
     QPushButton* openButton_;
+    QProgressBar* loadProgress_;
+    QPushButton* cancelLoadButton_;
+    // Highest percentage shown for the current load, updated from the
+    // loading thread.
+    std::atomic<int> loadPercent_{0};
+    bool progressiveLoading_ = false;
+    QElapsedTimer loadTimer_;
+    qint64 firstGeometryMs_ = -1;
+    // Message of the last load or transform, shown again with the upload
+    // and draw times once the next frame is drawn.
+    QString timedMessage_;
+    bool awaitingFrameTimings_ = false;
+
+    QAction* recordTraceAction_;
+    QAction* saveTraceAction_;
+    QAction* frameStatsAction_;
+    QAction* frameStatsLogAction_;
+    QAction* liveTransformsAction_;
 
     QDoubleSpinBox* translateXSpin_;
     QDoubleSpinBox* translateYSpin_;
@@ -55,11 +103,20 @@ class MainWindow : public QMainWindow {
     QLabel* fileNameLabel_;
     QLabel* vertexCountLabel_;
     QLabel* edgeCountLabel_;
+    QLabel* boundaryEdgeCountLabel_;
+    QLabel* nonManifoldEdgeCountLabel_;
 
     void setupUI();
     void createWidgets();
     void createLayouts();
     void setupConnections();
+    void createMenus();
+    void showTimedMessage(const QString& message);
+    TransformParams transformFromSpinBoxes() const;
+    void reportLoadProgress(std::uint64_t bytesDone, std::uint64_t bytesTotal);
+    void onLoadFinished(const QString& filename, LoadStatus status);
+    void onLodsBuilt(const LodChain& lods);
+    void setLoadingVisible(bool visible);
 };
 
 }  // namespace viewer3d
@@ -0,0 +1,419 @@
+#include "view/model_renderer.hpp"
+
+#include <QDebug>
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+namespace viewer3d {
+
+namespace {
+constexpr GLuint kXLocation = 0;
+constexpr GLuint kYLocation = 1;
+constexpr GLuint kZLocation = 2;
+
+// glDrawElements takes a GLsizei count, so huge index buffers are drawn in
+// several calls.
+constexpr std::size_t kMaxIndicesPerDraw =
+    (static_cast<std::size_t>(std::numeric_limits<GLsizei>::max()) / 2) * 2;
+
+const char* const kVertexShader = R"(
+#version 120
+attribute float a_x;
+attribute float a_y;
+attribute float a_z;
+uniform mat4 u_mvp;
+void main() {
+    gl_Position = u_mvp * vec4(a_x, a_y, a_z, 1.0);
+}
+)";
+
+const char* const kFragmentShader = R"(
+#version 120
+uniform vec4 u_color;
+void main() {
+    gl_FragColor = u_color;
+}
+)";
+
+static_assert(sizeof(Edge) == 2 * sizeof(GLuint),
+              "edges are uploaded as GL_LINES index pairs");
+}  // namespace
+
+ModelRenderer::ModelRenderer()
+    : vertexBuffer_(QOpenGLBuffer::VertexBuffer),
+      indexBuffer_(QOpenGLBuffer::IndexBuffer),
+      streamVertexBuffer_(QOpenGLBuffer::VertexBuffer),
+      streamIndexBuffer_(QOpenGLBuffer::IndexBuffer) {}
+
+ModelRenderer::~ModelRenderer() {
+    vertexBuffer_.destroy();
+    indexBuffer_.destroy();
+    streamVertexBuffer_.destroy();
+    streamIndexBuffer_.destroy();
+    releaseLods();
+}
+
+bool ModelRenderer::initialize() {
+    initializeOpenGLFunctions();
+
+    initialized_ =
+        program_.addShaderFromSourceCode(QOpenGLShader::Vertex,
+                                         kVertexShader) &&
+        program_.addShaderFromSourceCode(QOpenGLShader::Fragment,
+                                         kFragmentShader);
+    if (initialized_) {
+        program_.bindAttributeLocation("a_x", kXLocation);
+        program_.bindAttributeLocation("a_y", kYLocation);
+        program_.bindAttributeLocation("a_z", kZLocation);
+        initialized_ = program_.link();
+    }
+    if (initialized_) {
+        initialized_ = vertexBuffer_.create() && indexBuffer_.create() &&
+                       streamVertexBuffer_.create() &&
+                       streamIndexBuffer_.create();
+    }
+
+    if (!initialized_) {
+        qWarning() << "Failed to set up the model renderer:" << program_.log();
+    }
+    return initialized_;
+}
+
+void ModelRenderer::draw(const Controller& controller,
+                         const QMatrix4x4& projectionView, std::size_t lod) {
+    draw(*controller.PublishSnapshot(), controller.GetLods(), projectionView,
+         lod);
+}
+
+void ModelRenderer::draw(const ModelSnapshot& snapshot,
+                         const std::shared_ptr<const LodChain>& lods,
+                         const QMatrix4x4& projectionView, std::size_t lod) {
+    if (!initialized_) {
+        return;
+    }
+
+    phases_.clear();
+    counts_ = DrawCounts();
+    if (lods != uploadedLods_) {
+        releaseLods();
+        uploadedLods_ = lods;
+        if (lods) {
+            lodBuffers_.resize(lods->size());
+        }
+    }
+    if (lod > 0 && lods && lod <= lods->size()) {
+        drawLod(snapshot, *lods, lod - 1, projectionView);
+        return;
+    }
+    {
+        PhaseScope phase(phases_, "upload");
+        syncBuffers(snapshot);
+    }
+    if (vertexCount_ == 0 || indexCount_ == 0) {
+        return;
+    }
+
+    // The hierarchy bounds source positions, so it is culled with the model
+    // matrix in both modes, while kCpu vertices are already transformed.
+    const QMatrix4x4 sourceToClip =
+        projectionView * QMatrix4x4(snapshot.model_matrix.data());
+    const QMatrix4x4 mvp = uploadedMode_ == TransformMode::kGpu
+                               ? sourceToClip * decodeMatrix_
+                               : projectionView;
+    const EdgeBvh& bvh = snapshot.geometry->edge_bvh;
+    const std::vector<EdgeRange>* ranges = nullptr;
+    if (!bvh.empty() && bvh.EdgeCount() * 2 == indexCount_) {
+        PhaseScope phase(phases_, "cull");
+        std::array<float, 16> clip;
+        sourceToClip.copyDataTo(clip.data());
+        bvh.Cull(clip, visibleRanges_);
+        ranges = &visibleRanges_;
+    }
+    PhaseScope phase(phases_, "draw");
+    drawLines(vertexBuffer_, indexBuffer_, layout_, vertexCount_, indexCount_,
+              mvp, ranges);
+}
+
+bool ModelRenderer::drawStream(const GeometryStream& stream,
+                               const QMatrix4x4& projectionView) {
+    if (!initialized_) {
+        return false;
+    }
+
+    phases_.clear();
+    counts_ = DrawCounts();
+    {
+        PhaseScope phase(phases_, "upload");
+        stream.ReadNewBatches(streamBatches_);
+        std::vector<BufferPiece> vertexPieces;
+        std::vector<BufferPiece> edgePieces;
+        for (const auto& batch : streamBatches_) {
+            vertexPieces.push_back(
+                {batch->vertices.data(), batch->vertices.size()});
+            edgePieces.push_back({batch->edges.data(), batch->edges.size()});
+        }
+        appendToBuffer(streamVertexBuffer_, GL_ARRAY_BUFFER, sizeof(Vertex),
+                       vertexPieces, streamVertexCount_,
+                       streamVertexCapacity_);
+        appendToBuffer(streamIndexBuffer_, GL_ELEMENT_ARRAY_BUFFER,
+                       sizeof(Edge), edgePieces, streamEdgeCount_,
+                       streamEdgeCapacity_);
+    }
+    if (streamVertexCount_ == 0) {
+        return false;
+    }
+
+    // Streamed positions are untransformed, like a freshly loaded model.
+    // OBJ files usually list all vertices before the faces, so until the
+    // first faces arrive the vertices are shown as points.
+    PhaseScope phase(phases_, "draw");
+    drawLines(streamVertexBuffer_, streamIndexBuffer_,
+              VertexLayout::kInterleaved, streamVertexCount_,
+              streamEdgeCount_ * 2, projectionView);
+    return true;
+}
+
+// Levels keep their source positions, so they are drawn with the model
+// matrix in both transform modes.
+void ModelRenderer::drawLod(const ModelSnapshot& snapshot,
+                            const LodChain& lods, std::size_t level,
+                            const QMatrix4x4& projectionView) {
+    std::unique_ptr<LodBuffers>& buffers = lodBuffers_[level];
+    {
+        PhaseScope phase(phases_, "upload");
+        if (!buffers) {
+            const LodLevel& source = lods[level];
+            buffers = std::make_unique<LodBuffers>();
+            buffers->vertices.create();
+            buffers->vertices.bind();
+            glBufferData(GL_ARRAY_BUFFER,
+                         source.vertices.size() * sizeof(Vertex),
+                         source.vertices.data(), GL_STATIC_DRAW);
+            buffers->vertices.release();
+            buffers->indices.create();
+            buffers->indices.bind();
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER,
+                         source.edges.size() * sizeof(Edge),
+                         source.edges.Edges().data(), GL_STATIC_DRAW);
+            buffers->indices.release();
+            buffers->vertexCount = source.vertices.size();
+            buffers->indexCount = source.edges.size() * 2;
+        }
+    }
+
+    const QMatrix4x4 mvp =
+        projectionView * QMatrix4x4(snapshot.model_matrix.data());
+    PhaseScope phase(phases_, "draw");
+    drawLines(buffers->vertices, buffers->indices, VertexLayout::kInterleaved,
+              buffers->vertexCount, buffers->indexCount, mvp);
+}
+
+void ModelRenderer::releaseLods() {
+    for (std::unique_ptr<LodBuffers>& buffers : lodBuffers_) {
+        if (buffers) {
+            buffers->vertices.destroy();
+            buffers->indices.destroy();
+        }
+    }
+    lodBuffers_.clear();
+    uploadedLods_.reset();
+}
+
+void ModelRenderer::resetStream() {
+    streamBatches_.clear();
+    streamVertexCount_ = 0;
+    streamEdgeCount_ = 0;
+    streamVertexCapacity_ = 0;
+    streamEdgeCapacity_ = 0;
+}
+
+void ModelRenderer::drawLines(QOpenGLBuffer& vertices, QOpenGLBuffer& indices,
+                              VertexLayout layout, std::size_t vertexCount,
+                              std::size_t indexCount, const QMatrix4x4& mvp,
+                              const std::vector<EdgeRange>* ranges) {
+    program_.bind();
+    program_.setUniformValue("u_color", color_);
+    program_.setUniformValue("u_mvp", mvp);
+
+    vertices.bind();
+    bindPositionAttributes(layout, vertexCount);
+    indices.bind();
+
+    counts_.vertices += vertexCount;
+    if (indexCount == 0) {
+        glDrawArrays(GL_POINTS, 0, static_cast<GLsizei>(vertexCount));
+        counts_.drawCalls++;
+    }
+    const std::vector<EdgeRange> all{{0, indexCount / 2}};
+    std::size_t drawn = 0;
+    for (const EdgeRange& range : ranges != nullptr ? *ranges : all) {
+        const std::size_t last = 2 * range.last;
+        for (std::size_t first = 2 * range.first; first < last;
+             first += kMaxIndicesPerDraw) {
+            const std::size_t count =
+                std::min(kMaxIndicesPerDraw, last - first);
+            glDrawElements(
+                GL_LINES, static_cast<GLsizei>(count), GL_UNSIGNED_INT,
+                reinterpret_cast<const void*>(first * sizeof(GLuint)));
+            counts_.drawCalls++;
+        }
+        drawn += range.last - range.first;
+    }
+    counts_.lines += drawn;
+    counts_.culledLines += indexCount / 2 - drawn;
+
+    indices.release();
+    program_.disableAttributeArray(kXLocation);
+    program_.disableAttributeArray(kYLocation);
+    program_.disableAttributeArray(kZLocation);
+    vertices.release();
+    program_.release();
+}
+
+// Uploads the elements of `pieces` past the first `uploaded` after those
+// already in `buffer`. A larger allocation is filled from the pieces again;
+// it grows geometrically, so appending stays linear overall.
+void ModelRenderer::appendToBuffer(QOpenGLBuffer& buffer, GLenum target,
+                                   std::size_t elementSize,
+                                   const std::vector<BufferPiece>& pieces,
+                                   std::size_t& uploaded,
+                                   std::size_t& capacity) {
+    std::size_t count = 0;
+    for (const BufferPiece& piece : pieces) {
+        count += piece.count;
+    }
+    if (count <= uploaded) {
+        return;
+    }
+
+    buffer.bind();
+    std::size_t first = uploaded;
+    if (count > capacity) {
+        capacity = std::max(count, capacity * 2);
+        glBufferData(target, capacity * elementSize, nullptr, GL_DYNAMIC_DRAW);
+        first = 0;
+    }
+    std::size_t offset = 0;
+    for (const BufferPiece& piece : pieces) {
+        if (offset + piece.count > first) {
+            const std::size_t skipped = first > offset ? first - offset : 0;
+            glBufferSubData(
+                target, (offset + skipped) * elementSize,
+                (piece.count - skipped) * elementSize,
+                static_cast<const char*>(piece.data) + skipped * elementSize);
+        }
+        offset += piece.count;
+    }
+    buffer.release();
+    uploaded = count;
+}
+
+void ModelRenderer::syncBuffers(const ModelSnapshot& snapshot) {
+    const TransformMode mode = snapshot.mode;
+    const std::uint64_t geometryRevision = snapshot.geometry_revision;
+    const std::uint64_t transformRevision = snapshot.transform_revision;
+
+    const bool geometryChanged =
+        !uploaded_ || geometryRevision != uploadedGeometryRevision_;
+    const bool verticesChanged =
+        geometryChanged || mode != uploadedMode_ ||
+        (mode == TransformMode::kCpu &&
+         transformRevision != uploadedTransformRevision_);
+
+    if (verticesChanged) {
+        uploadVertices(snapshot);
+    }
+    if (geometryChanged) {
+        uploadIndices(snapshot.geometry->edges);
+    }
+
+    uploaded_ = true;
+    uploadedMode_ = mode;
+    uploadedGeometryRevision_ = geometryRevision;
+    uploadedTransformRevision_ = transformRevision;
+}
+
+void ModelRenderer::uploadVertices(const ModelSnapshot& snapshot) {
+    vertexBuffer_.bind();
+
+    decodeMatrix_.setToIdentity();
+    if (snapshot.mode == TransformMode::kGpu &&
+        snapshot.geometry->IsQuantized()) {
+        const QuantizedPositions& positions = snapshot.geometry->quantized;
+        const std::size_t axisBytes =
+            positions.size() * sizeof(std::uint16_t);
+        glBufferData(GL_ARRAY_BUFFER, 3 * axisBytes, nullptr, GL_STATIC_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, axisBytes, positions.x.data());
+        glBufferSubData(GL_ARRAY_BUFFER, axisBytes, axisBytes,
+                        positions.y.data());
+        glBufferSubData(GL_ARRAY_BUFFER, 2 * axisBytes, axisBytes,
+                        positions.z.data());
+        vertexCount_ = positions.size();
+        layout_ = VertexLayout::kQuantized;
+        decodeMatrix_ = QMatrix4x4(positions.DecodeMatrix().data());
+    } else if (snapshot.mode == TransformMode::kGpu) {
+        const PositionsSoA& positions = snapshot.geometry->positions;
+        const std::size_t axisBytes = positions.size() * sizeof(float);
+        glBufferData(GL_ARRAY_BUFFER, 3 * axisBytes, nullptr, GL_STATIC_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, axisBytes, positions.x.data());
+        glBufferSubData(GL_ARRAY_BUFFER, axisBytes, axisBytes,
+                        positions.y.data());
+        glBufferSubData(GL_ARRAY_BUFFER, 2 * axisBytes, axisBytes,
+                        positions.z.data());
+        vertexCount_ = positions.size();
+        layout_ = VertexLayout::kPlanar;
+    } else {
+        const std::vector<Vertex>& vertices = *snapshot.vertices;
+        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex),
+                     vertices.data(), GL_DYNAMIC_DRAW);
+        vertexCount_ = vertices.size();
+        layout_ = VertexLayout::kInterleaved;
+    }
+
+    vertexBuffer_.release();
+    vertexUploads_++;
+}
+
+void ModelRenderer::uploadIndices(const EdgeList& edges) {
+    indexBuffer_.bind();
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, edges.size() * sizeof(Edge),
+                 edges.Edges().data(), GL_STATIC_DRAW);
+    indexBuffer_.release();
+
+    indexCount_ = edges.size() * 2;
+    indexUploads_++;
+}
+
+void ModelRenderer::bindPositionAttributes(VertexLayout layout,
+                                           std::size_t vertexCount) {
+    program_.enableAttributeArray(kXLocation);
+    program_.enableAttributeArray(kYLocation);
+    program_.enableAttributeArray(kZLocation);
+
+    if (layout != VertexLayout::kInterleaved) {
+        // Quantized values reach the shader as unnormalized floats in
+        // [0, 65535], which decodeMatrix_ maps back to positions.
+        const bool quantized = layout == VertexLayout::kQuantized;
+        const GLenum type = quantized ? GL_UNSIGNED_SHORT : GL_FLOAT;
+        const int tightlyPacked = 0;
+        const std::size_t axisBytes =
+            vertexCount * (quantized ? sizeof(std::uint16_t) : sizeof(float));
+        glVertexAttribPointer(kXLocation, 1, type, GL_FALSE, tightlyPacked,
+                              nullptr);
+        glVertexAttribPointer(kYLocation, 1, type, GL_FALSE, tightlyPacked,
+                              reinterpret_cast<const void*>(axisBytes));
+        glVertexAttribPointer(kZLocation, 1, type, GL_FALSE, tightlyPacked,
+                              reinterpret_cast<const void*>(2 * axisBytes));
+    } else {
+        const int stride = sizeof(Vertex);
+        glVertexAttribPointer(kXLocation, 1, GL_FLOAT, GL_FALSE, stride,
+                              reinterpret_cast<const void*>(0));
+        glVertexAttribPointer(kYLocation, 1, GL_FLOAT, GL_FALSE, stride,
+                              reinterpret_cast<const void*>(sizeof(float)));
+        glVertexAttribPointer(kZLocation, 1, GL_FLOAT, GL_FALSE, stride,
+                              reinterpret_cast<const void*>(2 * sizeof(float)));
+    }
+}
+
+}  // namespace viewer3d
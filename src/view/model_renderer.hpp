@@ -0,0 +1,143 @@
+#ifndef MODEL_RENDERER_H
+#define MODEL_RENDERER_H
+
+#include <QMatrix4x4>
+#include <QOpenGLBuffer>
+#include <QOpenGLFunctions>
+#include <QOpenGLShaderProgram>
+#include <QVector4D>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "controller/controller.hpp"
+
+namespace viewer3d {
+
+// What one draw() or drawStream() call submitted to OpenGL.
+struct DrawCounts {
+    quint64 drawCalls = 0;
+    quint64 vertices = 0;
+    quint64 lines = 0;
+    // Lines skipped because their cluster was outside the view frustum.
+    quint64 culledLines = 0;
+};
+
+// Draws model snapshots as wireframes from GPU buffers. Positions and line
+// indices are uploaded only when the model geometry changes (or, in
+// TransformMode::kCpu, when the transformed vertices change); every frame
+// is then a glDrawElements call per visible range of edge clusters (see
+// EdgeBvh) with the model matrix applied in the vertex shader. Levels of
+// detail are uploaded the first time they are drawn. Every call needs the
+// OpenGL context used by initialize() to be current, including destruction.
+class ModelRenderer : protected QOpenGLFunctions {
+   public:
+    ModelRenderer();
+    ~ModelRenderer();
+
+    bool initialize();
+    // Level `lod` > 0 draws (*lods)[lod - 1] instead of the model when it
+    // exists. Only the snapshot is read, never the model itself.
+    void draw(const ModelSnapshot& snapshot,
+              const std::shared_ptr<const LodChain>& lods,
+              const QMatrix4x4& projectionView, std::size_t lod = 0);
+    // Publishes the model of `controller` and draws its snapshot and levels.
+    void draw(const Controller& controller, const QMatrix4x4& projectionView,
+              std::size_t lod = 0);
+    // Draws the geometry of a streaming load, uploading only what was
+    // appended since the previous call. Call resetStream() before drawing a
+    // different stream. Returns whether anything was drawn.
+    bool drawStream(const GeometryStream& stream,
+                    const QMatrix4x4& projectionView);
+    void resetStream();
+
+    void setColor(const QVector4D& color) { color_ = color; }
+
+    // Upload and draw times of the last draw() or drawStream() call.
+    const PhaseTimings& lastPhases() const { return phases_; }
+    const DrawCounts& lastDrawCounts() const { return counts_; }
+
+    quint64 vertexUploadCount() const { return vertexUploads_; }
+    quint64 indexUploadCount() const { return indexUploads_; }
+
+   private:
+    enum class VertexLayout {
+        kInterleaved,  // xyz floats per vertex
+        kPlanar,       // [x...][y...][z...] floats
+        kQuantized,    // [x...][y...][z...] 16-bit grid values
+    };
+
+    struct LodBuffers {
+        QOpenGLBuffer vertices{QOpenGLBuffer::VertexBuffer};
+        QOpenGLBuffer indices{QOpenGLBuffer::IndexBuffer};
+        std::size_t vertexCount = 0;
+        std::size_t indexCount = 0;
+    };
+
+    void drawLod(const ModelSnapshot& snapshot, const LodChain& lods,
+                 std::size_t level, const QMatrix4x4& projectionView);
+    void releaseLods();
+    void syncBuffers(const ModelSnapshot& snapshot);
+    void uploadVertices(const ModelSnapshot& snapshot);
+    void uploadIndices(const EdgeList& edges);
+    // Without indices the vertices are drawn as points. With `ranges` only
+    // those edges are drawn.
+    void drawLines(QOpenGLBuffer& vertices, QOpenGLBuffer& indices,
+                   VertexLayout layout, std::size_t vertexCount,
+                   std::size_t indexCount, const QMatrix4x4& mvp,
+                   const std::vector<EdgeRange>* ranges = nullptr);
+    // Consecutive parts of a buffer's contents, e.g. the vertices of every
+    // stream batch.
+    struct BufferPiece {
+        const void* data;
+        std::size_t count;
+    };
+    void appendToBuffer(QOpenGLBuffer& buffer, GLenum target,
+                        std::size_t elementSize,
+                        const std::vector<BufferPiece>& pieces,
+                        std::size_t& uploaded, std::size_t& capacity);
+    void bindPositionAttributes(VertexLayout layout, std::size_t vertexCount);
+
+    QOpenGLShaderProgram program_;
+    QOpenGLBuffer vertexBuffer_;
+    QOpenGLBuffer indexBuffer_;
+    QOpenGLBuffer streamVertexBuffer_;
+    QOpenGLBuffer streamIndexBuffer_;
+    QVector4D color_{0.9f, 0.9f, 0.9f, 1.0f};
+    bool initialized_ = false;
+
+    // Source positions are stored planar or quantized (kGpu), transformed
+    // vertices interleaved (kCpu). Quantized values are decoded by the
+    // matrix in front of the model matrix.
+    VertexLayout layout_ = VertexLayout::kInterleaved;
+    QMatrix4x4 decodeMatrix_;
+    std::size_t vertexCount_ = 0;
+    std::size_t indexCount_ = 0;
+
+    bool uploaded_ = false;
+    TransformMode uploadedMode_ = TransformMode::kCpu;
+    std::uint64_t uploadedGeometryRevision_ = 0;
+    std::uint64_t uploadedTransformRevision_ = 0;
+    // Batches of the stream read so far; they are uploaded without its lock.
+    GeometryStream::BatchList streamBatches_;
+    std::size_t streamVertexCount_ = 0;
+    std::size_t streamEdgeCount_ = 0;
+    std::size_t streamVertexCapacity_ = 0;
+    std::size_t streamEdgeCapacity_ = 0;
+
+    // Buffers of the levels of uploadedLods_, created on first use.
+    std::shared_ptr<const LodChain> uploadedLods_;
+    std::vector<std::unique_ptr<LodBuffers>> lodBuffers_;
+
+    // Clusters of the model inside the frustum, reused between frames.
+    std::vector<EdgeRange> visibleRanges_;
+
+    PhaseTimings phases_;
+    DrawCounts counts_;
+    quint64 vertexUploads_ = 0;
+    quint64 indexUploads_ = 0;
+};
+
+}  // namespace viewer3d
+
+#endif
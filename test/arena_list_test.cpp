@@ -0,0 +1,67 @@
+#include "model/arena_list.hpp"
+
+#include <gtest/gtest.h>
+
+#include <memory_resource>
+
+namespace viewer3d {
+namespace {
+
+struct Pair {
+    int first;
+    int second;
+};
+
+TEST(ArenaListTest, StartsEmpty) {
+    std::pmr::monotonic_buffer_resource arena;
+    ArenaList<int> list(arena);
+    EXPECT_TRUE(list.empty());
+    EXPECT_EQ(list.size(), 0);
+}
+
+TEST(ArenaListTest, KeepsElementsAcrossBlocks) {
+    std::pmr::monotonic_buffer_resource arena;
+    ArenaList<Pair> list(arena);
+    const int count = 3 * ArenaList<Pair>::kBlockSize + 5;
+    for (int i = 0; i < count; ++i) {
+        list.push_back({i, -i});
+    }
+
+    ASSERT_EQ(list.size(), count);
+    for (int i = 0; i < count; ++i) {
+        EXPECT_EQ(list[i].first, i);
+        EXPECT_EQ(list[i].second, -i);
+    }
+}
+
+TEST(ArenaListTest, ElementsDoNotMoveWhileGrowing) {
+    std::pmr::monotonic_buffer_resource arena;
+    ArenaList<int> list(arena);
+    list.push_back(7);
+    const int* first = &list[0];
+    for (std::size_t i = 0; i < 2 * ArenaList<int>::kBlockSize; ++i) {
+        list.push_back(0);
+    }
+    EXPECT_EQ(&list[0], first);
+    EXPECT_EQ(*first, 7);
+}
+
+TEST(ArenaListTest, ListsShareOneArena) {
+    std::pmr::monotonic_buffer_resource arena;
+    ArenaList<int> ints(arena);
+    ArenaList<Pair> pairs(arena);
+    for (int i = 0; i < 1000; ++i) {
+        ints.push_back(i);
+        pairs.push_back({i, i + 1});
+    }
+    EXPECT_EQ(ints[999], 999);
+    EXPECT_EQ(pairs[999].second, 1000);
+
+    ints = ArenaList<int>();
+    pairs = ArenaList<Pair>();
+    arena.release();
+    EXPECT_TRUE(ints.empty());
+}
+
+}  // namespace
+}  // namespace viewer3d
\ No newline at end of file
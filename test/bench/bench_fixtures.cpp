@@ -0,0 +1,71 @@
+#include "bench_fixtures.hpp"
+
+#include <cstdlib>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <stdexcept>
+
+#include "objgen/obj_generator.hpp"
+
+namespace viewer3d {
+namespace bench {
+
+namespace {
+
+constexpr std::size_t kDefaultMeshSizes[] = {1000000};
+constexpr std::size_t kLargeMeshSizes[] = {10000000, 50000000};
+
+std::string MeshDirectory() {
+    const char* dir = std::getenv("VIEWER3D_BENCH_DIR");
+    return dir != nullptr && *dir != '\0' ? dir : "bench_meshes";
+}
+
+}  // namespace
+
+std::string ResourcePath(const std::string& name) {
+    return std::string(VIEWER3D_RESOURCE_DIR) + "/" + name;
+}
+
+const std::vector<std::size_t>& GeneratedMeshSizes() {
+    static const std::vector<std::size_t> sizes = [] {
+        std::vector<std::size_t> result(std::begin(kDefaultMeshSizes),
+                                        std::end(kDefaultMeshSizes));
+        if (std::getenv("VIEWER3D_BENCH_LARGE") != nullptr) {
+            result.insert(result.end(), std::begin(kLargeMeshSizes),
+                          std::end(kLargeMeshSizes));
+        }
+        return result;
+    }();
+    return sizes;
+}
+
+std::string GeneratedMeshPath(std::size_t vertex_count) {
+    const std::string dir = MeshDirectory();
+    const std::string path =
+        dir + "/objgen_" + std::to_string(vertex_count) + ".obj";
+    if (!std::filesystem::exists(path)) {
+        std::filesystem::create_directories(dir);
+        ObjGenOptions options;
+        options.vertex_count = vertex_count;
+        if (!WriteGeneratedObj(path, options)) {
+            throw std::runtime_error("cannot write " + path);
+        }
+    }
+    return path;
+}
+
+const Model& GeneratedModel(std::size_t vertex_count) {
+    static std::map<std::size_t, std::unique_ptr<Model>> models;
+    std::unique_ptr<Model>& model = models[vertex_count];
+    if (!model) {
+        model = std::make_unique<Model>();
+        if (!model->LoadFromFile(GeneratedMeshPath(vertex_count))) {
+            throw std::runtime_error("cannot load the generated mesh");
+        }
+    }
+    return *model;
+}
+
+}  // namespace bench
+}  // namespace viewer3d
@@ -0,0 +1,31 @@
+#ifndef BENCH_FIXTURES_H
+#define BENCH_FIXTURES_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "model/model.hpp"
+
+namespace viewer3d {
+namespace bench {
+
+// Path of a model shipped in resources/.
+std::string ResourcePath(const std::string& name);
+
+// Vertex counts of the generated meshes. 10M and 50M are only included when
+// VIEWER3D_BENCH_LARGE is set, since their files take several gigabytes.
+const std::vector<std::size_t>& GeneratedMeshSizes();
+
+// Writes a triangle mesh with `vertex_count` vertices, see objgen, on first
+// use and returns its path. Files go to VIEWER3D_BENCH_DIR, or
+// ./bench_meshes, and are reused by later runs.
+std::string GeneratedMeshPath(std::size_t vertex_count);
+
+// The generated mesh, loaded once per process.
+const Model& GeneratedModel(std::size_t vertex_count);
+
+}  // namespace bench
+}  // namespace viewer3d
+
+#endif
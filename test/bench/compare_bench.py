@@ -0,0 +1,81 @@
+#!/usr/bin/env python3
+"""Compares a Google Benchmark JSON report against a baseline report.
+
+Exits with status 1 when a benchmark present in both reports got slower than
+the baseline by more than the tolerance. With repetitions the median
+aggregate is compared, otherwise the single run.
+"""
+
+import argparse
+import json
+import sys
+
+UNIT_TO_NS = {"ns": 1.0, "us": 1e3, "ms": 1e6, "s": 1e9}
+
+
+def load_times(path):
+    with open(path) as report:
+        benchmarks = json.load(report)["benchmarks"]
+
+    times = {}
+    medians = {}
+    for entry in benchmarks:
+        if entry.get("error_occurred"):
+            continue
+        time = entry["real_time"] * UNIT_TO_NS[entry.get("time_unit", "ns")]
+        if entry.get("run_type") == "aggregate":
+            if entry.get("aggregate_name") == "median":
+                medians[entry["run_name"]] = time
+        else:
+            times.setdefault(entry.get("run_name", entry["name"]), time)
+    times.update(medians)
+    return times
+
+
+def format_time(ns):
+    for unit, scale in (("s", 1e9), ("ms", 1e6), ("us", 1e3)):
+        if ns >= scale:
+            return "%.3f %s" % (ns / scale, unit)
+    return "%.1f ns" % ns
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("baseline")
+    parser.add_argument("current")
+    parser.add_argument("--tolerance", type=float, default=0.2,
+                        help="allowed slowdown, 0.2 means 20%% (default)")
+    args = parser.parse_args()
+
+    baseline = load_times(args.baseline)
+    current = load_times(args.current)
+
+    regressions = []
+    width = max((len(name) for name in current), default=10)
+    for name in sorted(current):
+        if name not in baseline:
+            print("%-*s  %12s  (no baseline)" % (width, name,
+                                                 format_time(current[name])))
+            continue
+        change = current[name] / baseline[name] - 1.0
+        status = ""
+        if change > args.tolerance:
+            status = "REGRESSION"
+            regressions.append(name)
+        print("%-*s  %12s  %12s  %+7.1f%%  %s" % (
+            width, name, format_time(baseline[name]),
+            format_time(current[name]), change * 100.0, status))
+
+    missing = sorted(set(baseline) - set(current))
+    for name in missing:
+        print("%-*s  missing from the current run" % (width, name))
+
+    if regressions:
+        print("\n%d benchmark(s) regressed by more than %.0f%%" %
+              (len(regressions), args.tolerance * 100.0))
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
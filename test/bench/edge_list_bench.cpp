@@ -0,0 +1,35 @@
+#include <benchmark/benchmark.h>
+
+#include "bench_fixtures.hpp"
+#include "model/edge_list.hpp"
+
+namespace viewer3d {
+namespace bench {
+namespace {
+
+// The deduplicated edge index that replaced CalculateEdgeCount. range(1) is
+// the thread count, 0 meaning all hardware threads.
+void BM_BuildEdgeList(benchmark::State& state) {
+    const FaceList& faces = GeneratedModel(state.range(0)).GetFaces();
+    EdgeList edges;
+    for (auto _ : state) {
+        edges.Build(faces, static_cast<unsigned>(state.range(1)));
+        benchmark::DoNotOptimize(edges.size());
+    }
+    state.SetItemsProcessed(state.iterations() * faces.IndexCount());
+}
+
+const bool kRegistered = [] {
+    for (std::size_t size : GeneratedMeshSizes()) {
+        benchmark::RegisterBenchmark("BM_BuildEdgeList", BM_BuildEdgeList)
+            ->Args({static_cast<long>(size), 1})
+            ->Args({static_cast<long>(size), 0})
+            ->Unit(benchmark::kMillisecond)
+            ->UseRealTime();
+    }
+    return true;
+}();
+
+}  // namespace
+}  // namespace bench
+}  // namespace viewer3d
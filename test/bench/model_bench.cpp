@@ -0,0 +1,82 @@
+#include <benchmark/benchmark.h>
+
+#include <filesystem>
+#include <string>
+
+#include "bench_fixtures.hpp"
+#include "model/model.hpp"
+
+namespace viewer3d {
+namespace bench {
+namespace {
+
+void LoadFromFile(benchmark::State& state, const std::string& path,
+                  const LoadOptions& options) {
+    Model model;
+    for (auto _ : state) {
+        if (!model.LoadFromFile(path, options)) {
+            state.SkipWithError("the model failed to load");
+            break;
+        }
+        benchmark::DoNotOptimize(model.GetVertexCount());
+    }
+    state.SetBytesProcessed(state.iterations() *
+                            std::filesystem::file_size(path));
+    state.counters["vertices"] = model.GetVertexCount();
+}
+
+void BM_LoadResource(benchmark::State& state, const std::string& name) {
+    LoadFromFile(state, ResourcePath(name), LoadOptions());
+}
+BENCHMARK_CAPTURE(BM_LoadResource, cube, std::string("cube.obj"))
+    ->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(BM_LoadResource, madara, std::string("madara.obj"))
+    ->Unit(benchmark::kMillisecond);
+
+void BM_LoadGenerated(benchmark::State& state) {
+    LoadFromFile(state, GeneratedMeshPath(state.range(0)), LoadOptions());
+}
+
+// Reopening a model whose binary cache is up to date.
+void BM_LoadGeneratedCached(benchmark::State& state) {
+    LoadOptions options;
+    options.cache = CacheMode::kUse;
+    options.cache_dir = std::filesystem::temp_directory_path().string() +
+                        "/viewer3d_bench_cache";
+    const std::string path = GeneratedMeshPath(state.range(0));
+    Model warm_up;
+    warm_up.LoadFromFile(path, options);
+    LoadFromFile(state, path, options);
+}
+
+void BM_Clear(benchmark::State& state) {
+    const Model& source = GeneratedModel(state.range(0));
+    for (auto _ : state) {
+        state.PauseTiming();
+        Model model = source;
+        state.ResumeTiming();
+        model.Clear();
+    }
+}
+
+const bool kRegistered = [] {
+    for (std::size_t size : GeneratedMeshSizes()) {
+        benchmark::RegisterBenchmark("BM_LoadGenerated", BM_LoadGenerated)
+            ->Arg(size)
+            ->Unit(benchmark::kMillisecond)
+            ->UseRealTime();
+        benchmark::RegisterBenchmark("BM_LoadGeneratedCached",
+                                     BM_LoadGeneratedCached)
+            ->Arg(size)
+            ->Unit(benchmark::kMillisecond)
+            ->UseRealTime();
+        benchmark::RegisterBenchmark("BM_Clear", BM_Clear)
+            ->Arg(size)
+            ->Unit(benchmark::kMillisecond);
+    }
+    return true;
+}();
+
+}  // namespace
+}  // namespace bench
+}  // namespace viewer3d
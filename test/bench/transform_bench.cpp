@@ -0,0 +1,58 @@
+#include <benchmark/benchmark.h>
+
+#include <string>
+
+#include "bench_fixtures.hpp"
+#include "model/model.hpp"
+
+namespace viewer3d {
+namespace bench {
+namespace {
+
+enum TransformParts { kScale = 1, kRotate = 2, kTranslate = 4 };
+
+std::string PartsName(int parts) {
+    std::string name;
+    name += parts & kScale ? "S" : "";
+    name += parts & kRotate ? "R" : "";
+    name += parts & kTranslate ? "T" : "";
+    return name.empty() ? "identity" : name;
+}
+
+// Times Model::ApplyAllTransformations through Translate() and
+// GetVertices() in kCpu mode; scale and rotation are set up front so every
+// call runs the kernel for the chosen combination.
+void BM_ApplyAllTransformations(benchmark::State& state, int parts) {
+    Model model = GeneratedModel(state.range(0));
+    model.SetTransformMode(TransformMode::kCpu);
+    if (parts & kScale) {
+        model.Scale(1.5f);
+    }
+    if (parts & kRotate) {
+        model.Rotate(10.0f, 20.0f, 30.0f);
+    }
+    const float offset = parts & kTranslate ? 0.5f : 0.0f;
+
+    for (auto _ : state) {
+        model.Translate(offset, offset, offset);
+        benchmark::DoNotOptimize(model.GetVertices().data());
+    }
+    state.SetItemsProcessed(state.iterations() * model.GetVertexCount());
+}
+
+const bool kRegistered = [] {
+    for (std::size_t size : GeneratedMeshSizes()) {
+        for (int parts = 0; parts < 8; ++parts) {
+            benchmark::RegisterBenchmark(
+                ("BM_ApplyAllTransformations/" + PartsName(parts)).c_str(),
+                BM_ApplyAllTransformations, parts)
+                ->Arg(size)
+                ->Unit(benchmark::kMillisecond);
+        }
+    }
+    return true;
+}();
+
+}  // namespace
+}  // namespace bench
+}  // namespace viewer3d
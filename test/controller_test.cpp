@@ -3,14 +3,47 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
 #include <fstream>
+#include <functional>
+#include <mutex>
 #include <string>
+#include <thread>
 
 #include "model/model.hpp"
+#include "objgen/obj_generator.hpp"
 
 namespace viewer3d {
 namespace {
 
+// Stands in for the GUI event loop in the asynchronous loading tests.
+class TaskQueue {
+   public:
+    void Post(std::function<void()> task) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        tasks_.push_back(std::move(task));
+        ready_.notify_one();
+    }
+
+    void RunOne() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        ready_.wait(lock, [this]() { return !tasks_.empty(); });
+        std::function<void()> task = std::move(tasks_.front());
+        tasks_.pop_front();
+        lock.unlock();
+        task();
+    }
+
+   private:
+    std::mutex mutex_;
+    std::condition_variable ready_;
+    std::deque<std::function<void()>> tasks_;
+};
+
 class TestController : public ::testing::Test {
    protected:
     void SetUp() override { CreateTestObjFile("test_cube.obj"); }
@@ -126,5 +159,253 @@ TEST_F(TestController, CombinedTransformations) {
     EXPECT_NEAR(transformedVertices[0].z, 3.0f, 0.001f);
 }
 
+TEST_F(TestController, SetTransformMaterializesOnce) {
+    EXPECT_TRUE(controller_.LoadModel("test_cube.obj"));
+
+    EXPECT_TRUE(controller_.SetTransform({1.0f, 1.0f, 1.0f},
+                                         {90.0f, 0.0f, 0.0f}, 2.0f));
+    controller_.SetTransform({1.0f, 1.0f, 1.0f}, {90.0f, 0.0f, 0.0f},
+                             2.0f);
+    EXPECT_EQ(model_.GetMaterializationCount(), 0);
+
+    const auto& vertices = controller_.GetVertices();
+    EXPECT_NEAR(vertices[0].x, 3.0f, 0.001f);
+    EXPECT_NEAR(vertices[0].y, -1.0f, 0.001f);
+    EXPECT_NEAR(vertices[0].z, 3.0f, 0.001f);
+    controller_.GetVertices();
+    EXPECT_EQ(model_.GetMaterializationCount(), 1);
+}
+
+TEST_F(TestController, PicksNearestFaceAndVertex) {
+    EXPECT_TRUE(controller_.LoadModel("test_cube.obj"));
+
+    PickResult pick;
+    ASSERT_TRUE(
+        controller_.Pick({{0.2f, 0.3f, 5.0f}, {0.0f, 0.0f, -1.0f}}, pick));
+    EXPECT_EQ(pick.face, 2);
+    EXPECT_EQ(pick.vertex, 0);
+    EXPECT_NEAR(pick.t, 4.0f, 1e-5f);
+    EXPECT_NEAR(pick.point.z, 1.0f, 1e-5f);
+
+    EXPECT_FALSE(
+        controller_.Pick({{0.2f, 0.3f, 5.0f}, {0.0f, 0.0f, 1.0f}}, pick));
+    EXPECT_FALSE(
+        controller_.Pick({{3.0f, 0.0f, 5.0f}, {0.0f, 0.0f, -1.0f}}, pick));
+}
+
+TEST_F(TestController, PickFollowsTransforms) {
+    EXPECT_TRUE(controller_.LoadModel("test_cube.obj"));
+
+    for (TransformMode mode : {TransformMode::kCpu, TransformMode::kGpu}) {
+        controller_.SetTransformMode(mode);
+        controller_.ScaleModel(2.0f);
+        controller_.TranslateModel(3.0f, 0.0f, 0.0f);
+
+        PickResult pick;
+        ASSERT_TRUE(
+            controller_.Pick({{3.2f, 0.3f, 10.0f}, {0.0f, 0.0f, -2.0f}}, pick));
+        EXPECT_EQ(pick.face, 2);
+        EXPECT_EQ(pick.vertex, 0);
+        EXPECT_NEAR(pick.t, 4.0f, 1e-5f);
+        EXPECT_NEAR(pick.point.x, 3.2f, 1e-5f);
+        EXPECT_NEAR(pick.point.z, 2.0f, 1e-5f);
+        EXPECT_NEAR(pick.vertex_position.x, 5.0f, 1e-5f);
+        EXPECT_NEAR(pick.vertex_position.y, 2.0f, 1e-5f);
+        EXPECT_NEAR(pick.vertex_position.z, 2.0f, 1e-5f);
+
+        controller_.ScaleModel(1.0f);
+        controller_.TranslateModel(0.0f, 0.0f, 0.0f);
+    }
+}
+
+TEST_F(TestController, CompletionsWithoutDispatcherRunOnOwnerThread) {
+    std::thread::id completed_on;
+    controller_.LoadModelAsync("test_cube.obj", nullptr,
+                               [&completed_on](LoadStatus status) {
+                                   EXPECT_EQ(status, LoadStatus::kLoaded);
+                                   completed_on = std::this_thread::get_id();
+                               });
+    for (int i = 0; i < 5000 && controller_.RunPendingCompletions() == 0;
+         ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_EQ(completed_on, std::this_thread::get_id());
+    EXPECT_FALSE(controller_.IsLoading());
+    EXPECT_EQ(controller_.GetVertexCount(), 8);
+}
+
+// The owner keeps transforming and publishing on the worker while another
+// thread takes snapshots the way a renderer does; none of them is torn.
+TEST_F(TestController, PublishesOnAWorkerWhileAnotherThreadRenders) {
+    ASSERT_TRUE(controller_.LoadModel("test_cube.obj"));
+    controller_.SetTransformMode(TransformMode::kCpu);
+    controller_.PublishSnapshot();
+
+    std::atomic<bool> done{false};
+    int frames = 0;
+    std::thread renderer([this, &done, &frames]() {
+        do {
+            const auto snapshot = controller_.GetLatestSnapshot();
+            const PositionsSoA& source = snapshot->geometry->positions;
+            const std::vector<Vertex>& vertices = *snapshot->vertices;
+            ASSERT_EQ(vertices.size(), source.size());
+            const auto& m = snapshot->model_matrix;
+            for (std::size_t i = 0; i < vertices.size(); ++i) {
+                const float x = source.x[i];
+                const float y = source.y[i];
+                const float z = source.z[i];
+                EXPECT_NEAR(vertices[i].x,
+                            m[0] * x + m[1] * y + m[2] * z + m[3], 1e-4f);
+                EXPECT_NEAR(vertices[i].y,
+                            m[4] * x + m[5] * y + m[6] * z + m[7], 1e-4f);
+            }
+            ++frames;
+        } while (!done);
+    });
+
+    int completions = 0;
+    for (int i = 1; i <= 300; ++i) {
+        EXPECT_TRUE(controller_.SetTransform(
+            {0.01f * i, 0.0f, 0.0f}, {0.0f, 0.0f, static_cast<float>(i)},
+            1.0f + (i % 3)));
+        controller_.PublishSnapshotAsync([&completions]() { ++completions; });
+        EXPECT_TRUE(controller_.IsPublishing());
+        controller_.RunPendingCompletions();
+    }
+    controller_.WaitForPublish();
+    controller_.RunPendingCompletions();
+    done = true;
+    renderer.join();
+
+    EXPECT_EQ(completions, 300);
+    EXPECT_FALSE(controller_.IsPublishing());
+    EXPECT_GT(frames, 0);
+    EXPECT_EQ(controller_.GetLatestSnapshot()->transform_revision,
+              controller_.GetTransformRevision());
+}
+
+class AsyncController : public TestController {
+   protected:
+    void SetUp() override {
+        TestController::SetUp();
+        controller_.SetDispatcher([this](std::function<void()> task) {
+            queue_.Post(std::move(task));
+        });
+    }
+
+    TaskQueue queue_;
+    LoadStatus status_{LoadStatus::kFailed};
+};
+
+TEST_F(AsyncController, LoadsInBackground) {
+    std::uint64_t bytes_done = 0;
+    std::uint64_t bytes_total = 0;
+    controller_.LoadModelAsync(
+        "test_cube.obj",
+        [&](std::uint64_t done, std::uint64_t total) {
+            bytes_done = done;
+            bytes_total = total;
+        },
+        [this](LoadStatus status) { status_ = status; });
+    EXPECT_TRUE(controller_.IsLoading());
+
+    queue_.RunOne();
+    EXPECT_FALSE(controller_.IsLoading());
+    EXPECT_EQ(status_, LoadStatus::kLoaded);
+    EXPECT_EQ(controller_.GetVertexCount(), 8);
+    EXPECT_EQ(controller_.GetEdgeCount(), 12);
+    EXPECT_GT(bytes_total, 0u);
+    EXPECT_EQ(bytes_done, bytes_total);
+}
+
+TEST_F(AsyncController, FailedLoadKeepsModel) {
+    ASSERT_TRUE(controller_.LoadModel("test_cube.obj"));
+
+    controller_.LoadModelAsync("nonexistent_file.obj", nullptr,
+                               [this](LoadStatus status) { status_ = status; });
+    queue_.RunOne();
+    EXPECT_EQ(status_, LoadStatus::kFailed);
+    EXPECT_EQ(controller_.GetVertexCount(), 8);
+    EXPECT_EQ(controller_.GetFilename(), "test_cube.obj");
+}
+
+TEST_F(AsyncController, CancelledLoadKeepsModel) {
+    controller_.LoadModelAsync("test_cube.obj", nullptr,
+                               [this](LoadStatus status) { status_ = status; });
+    controller_.CancelLoad();
+    queue_.RunOne();
+    EXPECT_EQ(status_, LoadStatus::kCancelled);
+    EXPECT_EQ(controller_.GetVertexCount(), 0);
+}
+
+TEST_F(AsyncController, SynchronousLoadCancelsPendingLoad) {
+    {
+        std::ofstream file("test_triangle.obj");
+        file << "v 0 0 0\nv 1 0 0\nv 0 1 0\nf 1 2 3\n";
+    }
+    controller_.LoadModelAsync("test_cube.obj", nullptr,
+                               [this](LoadStatus status) { status_ = status; });
+    ASSERT_TRUE(controller_.LoadModel("test_triangle.obj"));
+    queue_.RunOne();
+    EXPECT_EQ(status_, LoadStatus::kCancelled);
+    EXPECT_EQ(controller_.GetVertexCount(), 3);
+    EXPECT_EQ(controller_.GetFilename(), "test_triangle.obj");
+    std::remove("test_triangle.obj");
+}
+
+TEST_F(AsyncController, NewLoadCancelsPrevious) {
+    std::vector<LoadStatus> statuses;
+    auto record = [&](LoadStatus status) { statuses.push_back(status); };
+    controller_.LoadModelAsync("test_cube.obj", nullptr, record);
+    controller_.LoadModelAsync("test_cube.obj", nullptr, record);
+
+    queue_.RunOne();
+    queue_.RunOne();
+    ASSERT_EQ(statuses.size(), 2u);
+    EXPECT_EQ(statuses[0], LoadStatus::kCancelled);
+    EXPECT_EQ(statuses[1], LoadStatus::kLoaded);
+    EXPECT_FALSE(controller_.IsLoading());
+    EXPECT_EQ(controller_.GetVertexCount(), 8);
+}
+
+TEST_F(AsyncController, BuildsLodsAfterLoad) {
+    ObjGenOptions mesh;
+    mesh.vertex_count = 2000;
+    ASSERT_TRUE(WriteGeneratedObj("test_lods.obj", mesh));
+    LodOptions options;
+    options.enabled = true;
+    options.min_triangles = 100;
+    controller_.SetLodOptions(options);
+    std::size_t levels = 0;
+    controller_.SetLodCallback(
+        [&levels](const LodChain& lods) { levels = lods.size(); });
+
+    controller_.LoadModelAsync("test_lods.obj", nullptr,
+                               [this](LoadStatus status) { status_ = status; });
+    queue_.RunOne();
+    EXPECT_EQ(status_, LoadStatus::kLoaded);
+    EXPECT_TRUE(controller_.IsBuildingLods());
+    EXPECT_EQ(controller_.GetLods(), nullptr);
+
+    queue_.RunOne();
+    EXPECT_FALSE(controller_.IsBuildingLods());
+    ASSERT_NE(controller_.GetLods(), nullptr);
+    EXPECT_GT(levels, 0u);
+    EXPECT_EQ(controller_.GetLods()->size(), levels);
+    EXPECT_LT((*controller_.GetLods())[0].edges.size(),
+              static_cast<std::size_t>(controller_.GetEdgeCount()));
+
+    // Levels belong to the geometry they were built from.
+    controller_.ClearModel();
+    EXPECT_EQ(controller_.GetLods(), nullptr);
+
+    ASSERT_TRUE(controller_.LoadModel("test_lods.obj"));
+    controller_.ClearModel();
+    queue_.RunOne();
+    EXPECT_FALSE(controller_.IsBuildingLods());
+    EXPECT_EQ(controller_.GetLods(), nullptr);
+    std::remove("test_lods.obj");
+}
+
 }  // namespace
 }  // namespace viewer3d
\ No newline at end of file
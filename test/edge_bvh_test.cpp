@@ -0,0 +1,199 @@
+#include "model/edge_bvh.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <array>
+#include <vector>
+
+namespace viewer3d {
+namespace {
+
+constexpr int kGridSize = 200;
+
+// Quads of a kGridSize x kGridSize grid in the z = 0 plane, spanning
+// [0, kGridSize] on x and y.
+struct Grid {
+    PositionsSoA positions;
+    EdgeList edges;
+    Bounds bounds;
+};
+
+Grid MakeGrid() {
+    Grid grid;
+    std::vector<Vertex> vertices;
+    const int row = kGridSize + 1;
+    for (int y = 0; y < row; ++y) {
+        for (int x = 0; x < row; ++x) {
+            vertices.push_back({static_cast<float>(x), static_cast<float>(y),
+                                0.0f});
+        }
+    }
+    grid.positions.Assign(vertices);
+    FaceList faces;
+    for (int y = 0; y < kGridSize; ++y) {
+        for (int x = 0; x < kGridSize; ++x) {
+            const int v = y * row + x;
+            const int quad[] = {v, v + 1, v + row + 1, v + row};
+            faces.AddFace(quad, quad + 4);
+        }
+    }
+    grid.edges.Build(faces);
+    grid.bounds = ComputeBounds(grid.positions);
+    return grid;
+}
+
+// Row-major orthographic projection of the box [min, max] onto clip space.
+std::array<float, 16> Ortho(const Vertex& min, const Vertex& max) {
+    const float sx = max.x - min.x;
+    const float sy = max.y - min.y;
+    const float sz = max.z - min.z;
+    return {2.0f / sx, 0.0f,      0.0f,      -(max.x + min.x) / sx,
+            0.0f,      2.0f / sy, 0.0f,      -(max.y + min.y) / sy,
+            0.0f,      0.0f,      2.0f / sz, -(max.z + min.z) / sz,
+            0.0f,      0.0f,      0.0f,      1.0f};
+}
+
+bool EdgeLess(const Edge& lhs, const Edge& rhs) {
+    return lhs.a != rhs.a ? lhs.a < rhs.a : lhs.b < rhs.b;
+}
+
+TEST(EdgeBvhTest, EmptyListHasNoClusters) {
+    EdgeBvh bvh;
+    PositionsSoA positions;
+    EdgeList edges;
+    bvh.Build(positions, Bounds(), edges);
+    EXPECT_TRUE(bvh.empty());
+
+    std::vector<EdgeRange> visible{{0, 1}};
+    const CullStats stats = bvh.Cull(Ortho({-1, -1, -1}, {1, 1, 1}), visible);
+    EXPECT_TRUE(visible.empty());
+    EXPECT_EQ(stats.visible_edges, 0);
+}
+
+TEST(EdgeBvhTest, BuildReordersEdgesIntoClusters) {
+    Grid grid = MakeGrid();
+    std::vector<Edge> before = grid.edges.Edges();
+    const std::size_t boundary = grid.edges.BoundaryCount();
+
+    EdgeBvh bvh;
+    bvh.Build(grid.positions, grid.bounds, grid.edges, 2);
+    EXPECT_EQ(bvh.EdgeCount(), before.size());
+    EXPECT_EQ(bvh.ClusterCount(),
+              (before.size() + EdgeBvh::kEdgesPerCluster - 1) /
+                  EdgeBvh::kEdgesPerCluster);
+    EXPECT_EQ(grid.edges.BoundaryCount(), boundary);
+
+    std::vector<Edge> after = grid.edges.Edges();
+    std::sort(before.begin(), before.end(), EdgeLess);
+    std::sort(after.begin(), after.end(), EdgeLess);
+    ASSERT_EQ(after.size(), before.size());
+    for (std::size_t i = 0; i < after.size(); ++i) {
+        EXPECT_EQ(after[i].a, before[i].a);
+        EXPECT_EQ(after[i].b, before[i].b);
+    }
+}
+
+TEST(EdgeBvhTest, VisibleModelIsOneRange) {
+    Grid grid = MakeGrid();
+    EdgeBvh bvh;
+    bvh.Build(grid.positions, grid.bounds, grid.edges);
+
+    std::vector<EdgeRange> visible;
+    const CullStats stats =
+        bvh.Cull(Ortho({-1.0f, -1.0f, -1.0f},
+                       {kGridSize + 1.0f, kGridSize + 1.0f, 1.0f}),
+                 visible);
+    ASSERT_EQ(visible.size(), 1);
+    EXPECT_EQ(visible[0].first, 0);
+    EXPECT_EQ(visible[0].last, grid.edges.size());
+    EXPECT_EQ(stats.visible_clusters, bvh.ClusterCount());
+    EXPECT_EQ(stats.visible_edges, grid.edges.size());
+}
+
+TEST(EdgeBvhTest, ModelOutsideTheFrustumIsCulled) {
+    Grid grid = MakeGrid();
+    EdgeBvh bvh;
+    bvh.Build(grid.positions, grid.bounds, grid.edges);
+
+    std::vector<EdgeRange> visible;
+    const CullStats stats = bvh.Cull(
+        Ortho({-50.0f, -50.0f, -1.0f}, {-10.0f, -10.0f, 1.0f}), visible);
+    EXPECT_TRUE(visible.empty());
+    EXPECT_EQ(stats.visible_clusters, 0);
+}
+
+// Edges read back in cluster order keep that order and get the same tree.
+TEST(EdgeBvhTest, BuildClusteredKeepsTheEdgeOrder) {
+    Grid grid = MakeGrid();
+    EdgeBvh sorted;
+    sorted.Build(grid.positions, grid.bounds, grid.edges);
+    const std::vector<Edge> order = grid.edges.Edges();
+
+    EdgeBvh clustered;
+    clustered.BuildClustered(grid.positions, grid.bounds, grid.edges, 2);
+    EXPECT_EQ(clustered.ClusterCount(), sorted.ClusterCount());
+    EXPECT_EQ(clustered.EdgeCount(), sorted.EdgeCount());
+    ASSERT_EQ(grid.edges.size(), order.size());
+    for (std::size_t i = 0; i < order.size(); ++i) {
+        EXPECT_EQ(grid.edges[i].a, order[i].a);
+        EXPECT_EQ(grid.edges[i].b, order[i].b);
+    }
+
+    const auto clip = Ortho({20.0f, 30.0f, -1.0f}, {60.0f, 70.0f, 1.0f});
+    std::vector<EdgeRange> expected;
+    std::vector<EdgeRange> visible;
+    sorted.Cull(clip, expected);
+    clustered.Cull(clip, visible);
+    ASSERT_EQ(visible.size(), expected.size());
+    for (std::size_t r = 0; r < visible.size(); ++r) {
+        EXPECT_EQ(visible[r].first, expected[r].first);
+        EXPECT_EQ(visible[r].last, expected[r].last);
+    }
+}
+
+// Culling is conservative: every edge inside the frustum is drawn, while
+// most of the model is skipped.
+TEST(EdgeBvhTest, KeepsEveryEdgeInsideAPartialView) {
+    Grid grid = MakeGrid();
+    EdgeBvh bvh;
+    bvh.Build(grid.positions, grid.bounds, grid.edges);
+
+    const Vertex min{20.0f, 30.0f, -1.0f};
+    const Vertex max{60.0f, 70.0f, 1.0f};
+    std::vector<EdgeRange> visible;
+    const CullStats stats = bvh.Cull(Ortho(min, max), visible);
+    ASSERT_FALSE(visible.empty());
+    EXPECT_LT(stats.visible_edges, grid.edges.size() / 4);
+
+    std::size_t covered = 0;
+    for (std::size_t r = 0; r < visible.size(); ++r) {
+        EXPECT_LT(visible[r].first, visible[r].last);
+        if (r > 0) {
+            // Adjacent ranges are merged.
+            EXPECT_LT(visible[r - 1].last, visible[r].first);
+        }
+        covered += visible[r].last - visible[r].first;
+    }
+    EXPECT_EQ(covered, stats.visible_edges);
+
+    auto inside = [&](int index) {
+        const float x = grid.positions.x[index];
+        const float y = grid.positions.y[index];
+        return x >= min.x && x <= max.x && y >= min.y && y <= max.y;
+    };
+    auto drawn = [&](std::size_t edge) {
+        return std::any_of(visible.begin(), visible.end(),
+                           [edge](const EdgeRange& range) {
+                               return edge >= range.first && edge < range.last;
+                           });
+    };
+    for (std::size_t i = 0; i < grid.edges.size(); ++i) {
+        if (inside(grid.edges[i].a) || inside(grid.edges[i].b)) {
+            EXPECT_TRUE(drawn(i)) << "edge " << i;
+        }
+    }
+}
+
+}  // namespace
+}  // namespace viewer3d
\ No newline at end of file
@@ -0,0 +1,122 @@
+#include "model/edge_list.hpp"
+
+#include <gtest/gtest.h>
+
+#include <initializer_list>
+#include <vector>
+
+namespace viewer3d {
+namespace {
+
+void AddFace(FaceList& faces, std::initializer_list<int> indices) {
+    faces.AddFace(indices.begin(), indices.end());
+}
+
+// Triangulated n x n grid of quads: every interior edge is shared by two
+// triangles and the outline is the boundary.
+FaceList MakeGrid(int n) {
+    FaceList faces;
+    const int row = n + 1;
+    for (int y = 0; y < n; ++y) {
+        for (int x = 0; x < n; ++x) {
+            const int v = y * row + x;
+            AddFace(faces, {v, v + 1, v + row + 1});
+            AddFace(faces, {v, v + row + 1, v + row});
+        }
+    }
+    return faces;
+}
+
+TEST(EdgeListTest, Empty) {
+    EdgeList edges;
+    edges.Build(FaceList());
+    EXPECT_TRUE(edges.empty());
+    EXPECT_EQ(edges.BoundaryCount(), 0);
+    EXPECT_EQ(edges.NonManifoldCount(), 0);
+}
+
+TEST(EdgeListTest, ClosedCube) {
+    FaceList faces;
+    AddFace(faces, {0, 1, 3, 2});
+    AddFace(faces, {4, 5, 7, 6});
+    AddFace(faces, {0, 4, 6, 2});
+    AddFace(faces, {1, 5, 7, 3});
+    AddFace(faces, {0, 1, 5, 4});
+    AddFace(faces, {2, 3, 7, 6});
+
+    EdgeList edges;
+    edges.Build(faces);
+    EXPECT_EQ(edges.size(), 12);
+    EXPECT_EQ(edges.BoundaryCount(), 0);
+    EXPECT_EQ(edges.NonManifoldCount(), 0);
+    EXPECT_EQ(edges.WireCount(), 0);
+}
+
+TEST(EdgeListTest, EdgesAreSortedAndOrdered) {
+    FaceList faces;
+    AddFace(faces, {2, 1, 0});
+    AddFace(faces, {0, 2, 3});
+
+    EdgeList edges;
+    edges.Build(faces);
+    ASSERT_EQ(edges.size(), 5);
+    for (std::size_t i = 0; i < edges.size(); ++i) {
+        EXPECT_LT(edges[i].a, edges[i].b);
+    }
+    EXPECT_EQ(edges[0].a, 0);
+    EXPECT_EQ(edges[0].b, 1);
+    EXPECT_EQ(edges[4].a, 2);
+    EXPECT_EQ(edges[4].b, 3);
+    EXPECT_EQ(edges.BoundaryCount(), 4);
+}
+
+TEST(EdgeListTest, NonManifoldEdge) {
+    FaceList faces;
+    AddFace(faces, {0, 1, 2});
+    AddFace(faces, {1, 0, 3});
+    AddFace(faces, {0, 1, 4});
+
+    EdgeList edges;
+    edges.Build(faces);
+    EXPECT_EQ(edges.size(), 7);
+    EXPECT_EQ(edges.NonManifoldCount(), 1);
+    EXPECT_EQ(edges.BoundaryCount(), 6);
+}
+
+TEST(EdgeListTest, WireAndDegenerateFaces) {
+    FaceList faces;
+    AddFace(faces, {0, 1});
+    AddFace(faces, {1, 0});
+    AddFace(faces, {2, 2});
+    AddFace(faces, {3});
+    AddFace(faces, {1, 2, 3});
+
+    EdgeList edges;
+    edges.Build(faces);
+    EXPECT_EQ(edges.size(), 4);
+    EXPECT_EQ(edges.WireCount(), 1);
+    EXPECT_EQ(edges.BoundaryCount(), 3);
+}
+
+TEST(EdgeListTest, ParallelMatchesSerial) {
+    const int n = 300;
+    const FaceList faces = MakeGrid(n);
+
+    EdgeList serial;
+    serial.Build(faces, 1);
+    EdgeList parallel;
+    parallel.Build(faces, 8);
+
+    EXPECT_EQ(serial.size(), static_cast<std::size_t>(3 * n * n + 2 * n));
+    EXPECT_EQ(serial.BoundaryCount(), static_cast<std::size_t>(4 * n));
+    EXPECT_EQ(serial.NonManifoldCount(), 0);
+    ASSERT_EQ(parallel.size(), serial.size());
+    EXPECT_EQ(parallel.BoundaryCount(), serial.BoundaryCount());
+    for (std::size_t i = 0; i < serial.size(); ++i) {
+        ASSERT_EQ(parallel[i].a, serial[i].a);
+        ASSERT_EQ(parallel[i].b, serial[i].b);
+    }
+}
+
+}  // namespace
+}  // namespace viewer3d
\ No newline at end of file
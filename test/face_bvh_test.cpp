@@ -0,0 +1,122 @@
+#include "model/face_bvh.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace viewer3d {
+namespace {
+
+constexpr int kGridSize = 300;
+
+// Quads of a kGridSize x kGridSize height field over [0, kGridSize]^2, so
+// the face above (x, y) is floor(y) * kGridSize + floor(x).
+struct HeightField {
+    PositionsSoA positions;
+    FaceList faces;
+    Bounds bounds;
+};
+
+float Height(int x, int y) { return std::sin(0.1f * x) * std::cos(0.07f * y); }
+
+HeightField MakeHeightField() {
+    HeightField field;
+    std::vector<Vertex> vertices;
+    const int row = kGridSize + 1;
+    for (int y = 0; y < row; ++y) {
+        for (int x = 0; x < row; ++x) {
+            vertices.push_back(
+                {static_cast<float>(x), static_cast<float>(y), Height(x, y)});
+        }
+    }
+    field.positions.Assign(vertices);
+    for (int y = 0; y < kGridSize; ++y) {
+        for (int x = 0; x < kGridSize; ++x) {
+            const int v = y * row + x;
+            const int quad[] = {v, v + 1, v + row + 1, v + row};
+            field.faces.AddFace(quad, quad + 4);
+        }
+    }
+    field.bounds = ComputeBounds(field.positions);
+    return field;
+}
+
+TEST(FaceBvhTest, EmptyModelHasNoHits) {
+    FaceBvh bvh;
+    PositionsSoA positions;
+    FaceList faces;
+    bvh.Build(positions, faces, Bounds());
+    EXPECT_TRUE(bvh.empty());
+
+    FaceHit hit;
+    EXPECT_FALSE(
+        bvh.Intersect(positions, faces, {{0, 0, 1}, {0, 0, -1}}, hit));
+}
+
+TEST(FaceBvhTest, SkipsFacesThatCannotBeHit) {
+    PositionsSoA positions;
+    positions.Assign({{0, 0, 0}, {1, 0, 0}, {0, 1, 0}});
+    FaceList faces;
+    const int wire[] = {0, 1};
+    faces.AddFace(wire, wire + 2);
+    const int invalid[] = {0, 1, 7};
+    faces.AddFace(invalid, invalid + 3);
+    const int triangle[] = {0, 1, 2};
+    faces.AddFace(triangle, triangle + 3);
+
+    FaceBvh bvh;
+    bvh.Build(positions, faces, ComputeBounds(positions));
+    FaceHit hit;
+    ASSERT_TRUE(bvh.Intersect(positions, faces,
+                              {{0.2f, 0.2f, 1.0f}, {0.0f, 0.0f, -1.0f}}, hit));
+    EXPECT_EQ(hit.face, 2);
+    EXPECT_FLOAT_EQ(hit.t, 1.0f);
+    EXPECT_FALSE(bvh.Intersect(positions, faces,
+                               {{0.8f, 0.8f, 1.0f}, {0.0f, 0.0f, -1.0f}}, hit));
+}
+
+TEST(FaceBvhTest, FindsTheFaceUnderEveryRay) {
+    const HeightField field = MakeHeightField();
+    FaceBvh bvh;
+    bvh.Build(field.positions, field.faces, field.bounds, 2);
+    ASSERT_FALSE(bvh.empty());
+
+    std::mt19937 random(17);
+    std::uniform_int_distribution<int> cell(0, kGridSize - 1);
+    std::uniform_real_distribution<float> offset(0.05f, 0.95f);
+    for (int i = 0; i < 2000; ++i) {
+        const int x = cell(random);
+        const int y = cell(random);
+        const Ray ray{{x + offset(random), y + offset(random), 5.0f},
+                      {0.0f, 0.0f, -1.0f}};
+        FaceHit hit;
+        ASSERT_TRUE(bvh.Intersect(field.positions, field.faces, ray, hit));
+        EXPECT_EQ(hit.face, static_cast<std::size_t>(y * kGridSize + x));
+        EXPECT_NEAR(hit.point.x, ray.origin.x, 1e-4f);
+        EXPECT_NEAR(hit.point.z, 5.0f - hit.t, 1e-4f);
+    }
+}
+
+// A ray along the field crosses it wherever cos(0.07 y) changes sign,
+// first at y = pi / 0.14 and last at y = 13 pi / 0.14.
+TEST(FaceBvhTest, ReportsTheNearestOfSeveralHits) {
+    const HeightField field = MakeHeightField();
+    FaceBvh bvh;
+    bvh.Build(field.positions, field.faces, field.bounds);
+
+    FaceHit hit;
+    ASSERT_TRUE(bvh.Intersect(field.positions, field.faces,
+                              {{10.5f, -20.0f, 0.0f}, {0.0f, 1.0f, 0.0f}},
+                              hit));
+    EXPECT_NEAR(hit.point.y, M_PI / 0.14, 0.5);
+
+    ASSERT_TRUE(bvh.Intersect(
+        field.positions, field.faces,
+        {{10.5f, kGridSize + 20.0f, 0.0f}, {0.0f, -1.0f, 0.0f}}, hit));
+    EXPECT_NEAR(hit.point.y, 13 * M_PI / 0.14, 0.5);
+}
+
+}  // namespace
+}  // namespace viewer3d
\ No newline at end of file
@@ -0,0 +1,79 @@
+#include "model/face_list.hpp"
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+namespace viewer3d {
+namespace {
+
+std::vector<int> Indices(FaceView face) {
+    return std::vector<int>(face.begin(), face.end());
+}
+
+TEST(FaceListTest, Empty) {
+    FaceList faces;
+    EXPECT_TRUE(faces.empty());
+    EXPECT_EQ(faces.size(), 0);
+    EXPECT_EQ(faces.IndexCount(), 0);
+    EXPECT_TRUE(faces.begin() == faces.end());
+}
+
+TEST(FaceListTest, AddFace) {
+    FaceList faces;
+    std::vector<int> quad{0, 1, 2, 3};
+    std::vector<int> line{4, 5};
+    faces.AddFace(quad.begin(), quad.end());
+    faces.AddFace(line.begin(), line.end());
+
+    ASSERT_EQ(faces.size(), 2);
+    EXPECT_EQ(faces.IndexCount(), 6);
+    EXPECT_EQ(faces[0].size(), 4);
+    EXPECT_EQ(faces[1][1], 5);
+    EXPECT_EQ(Indices(faces[0]), quad);
+    EXPECT_EQ(Indices(faces[1]), line);
+}
+
+TEST(FaceListTest, Iterate) {
+    FaceList faces;
+    std::vector<int> triangle{0, 1, 2};
+    for (int i = 0; i < 3; ++i) {
+        faces.AddFace(triangle.begin(), triangle.end());
+    }
+
+    int count = 0;
+    for (FaceView face : faces) {
+        EXPECT_EQ(Indices(face), triangle);
+        ++count;
+    }
+    EXPECT_EQ(count, 3);
+}
+
+TEST(FaceListTest, Append) {
+    FaceList first;
+    FaceList second;
+    std::vector<int> a{0, 1, 2};
+    std::vector<int> b{3, 4};
+    first.AddFace(a.begin(), a.end());
+    second.AddFace(b.begin(), b.end());
+    second.AddFace(a.begin(), a.end());
+
+    first.Append(second);
+    ASSERT_EQ(first.size(), 3);
+    EXPECT_EQ(Indices(first[0]), a);
+    EXPECT_EQ(Indices(first[1]), b);
+    EXPECT_EQ(Indices(first[2]), a);
+}
+
+TEST(FaceListTest, Clear) {
+    FaceList faces;
+    std::vector<int> triangle{0, 1, 2};
+    faces.AddFace(triangle.begin(), triangle.end());
+
+    faces.clear();
+    EXPECT_TRUE(faces.empty());
+    EXPECT_EQ(faces.IndexCount(), 0);
+}
+
+}  // namespace
+}  // namespace viewer3d
@@ -0,0 +1,97 @@
+#include "model/frame_stats.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+namespace viewer3d {
+namespace {
+
+constexpr const char* kLogFile = "test_frames.csv";
+
+FrameSample Sample(double cpu_ms, double gpu_ms = -1.0) {
+    FrameSample sample;
+    sample.cpu_ms = cpu_ms;
+    sample.gpu_ms = gpu_ms;
+    sample.draw_calls = 1;
+    sample.vertices = 4;
+    sample.lines = 6;
+    sample.culled_lines = 2;
+    return sample;
+}
+
+TEST(FrameStatsTest, PercentilesUseNearestRank) {
+    FrameStats stats;
+    EXPECT_TRUE(stats.empty());
+    EXPECT_DOUBLE_EQ(stats.CpuPercentile(50), 0.0);
+    EXPECT_LT(stats.GpuPercentile(50), 0.0);
+
+    for (int ms = 100; ms >= 1; --ms) {
+        stats.Add(Sample(ms));
+    }
+    EXPECT_EQ(stats.size(), 100);
+    EXPECT_DOUBLE_EQ(stats.Last().cpu_ms, 1.0);
+    EXPECT_DOUBLE_EQ(stats.CpuPercentile(50), 50.0);
+    EXPECT_DOUBLE_EQ(stats.CpuPercentile(99), 99.0);
+    EXPECT_DOUBLE_EQ(stats.CpuPercentile(100), 100.0);
+    EXPECT_DOUBLE_EQ(stats.CpuPercentile(0), 1.0);
+}
+
+TEST(FrameStatsTest, WindowKeepsTheNewestFrames) {
+    FrameStats stats(4);
+    for (int ms = 1; ms <= 10; ++ms) {
+        stats.Add(Sample(ms));
+    }
+    EXPECT_EQ(stats.size(), 4);
+    EXPECT_EQ(stats.FrameCount(), 10u);
+    EXPECT_DOUBLE_EQ(stats.Last().cpu_ms, 10.0);
+    EXPECT_DOUBLE_EQ(stats.CpuPercentile(0), 7.0);
+    EXPECT_DOUBLE_EQ(stats.CpuPercentile(100), 10.0);
+
+    stats.Clear();
+    EXPECT_TRUE(stats.empty());
+    stats.Add(Sample(3));
+    EXPECT_DOUBLE_EQ(stats.Last().cpu_ms, 3.0);
+    EXPECT_EQ(stats.FrameCount(), 11u);
+}
+
+TEST(FrameStatsTest, GpuPercentilesSkipUntimedFrames) {
+    FrameStats stats;
+    stats.Add(Sample(1.0, 4.0));
+    stats.Add(Sample(1.0));
+    stats.Add(Sample(1.0, 2.0));
+    EXPECT_DOUBLE_EQ(stats.GpuPercentile(50), 2.0);
+    EXPECT_DOUBLE_EQ(stats.GpuPercentile(99), 4.0);
+}
+
+TEST(FrameStatsTest, LogsEveryFrameAsCsv) {
+    FrameStats stats(2);
+    stats.Add(Sample(9.0));
+    ASSERT_TRUE(stats.StartCsvLog(kLogFile));
+    EXPECT_TRUE(stats.IsLogging());
+    stats.Add(Sample(1.5, 0.25));
+    stats.Add(Sample(2.0));
+    stats.Add(Sample(2.5));
+    stats.StopCsvLog();
+    EXPECT_FALSE(stats.IsLogging());
+    stats.Add(Sample(3.0));
+
+    std::ifstream file(kLogFile);
+    std::ostringstream contents;
+    contents << file.rdbuf();
+    EXPECT_EQ(contents.str(),
+              "frame,cpu_ms,gpu_ms,draw_calls,vertices,lines,culled_lines\n"
+              "2,1.5000,0.2500,1,4,6,2\n"
+              "3,2.0000,,1,4,6,2\n"
+              "4,2.5000,,1,4,6,2\n");
+    std::remove(kLogFile);
+
+    EXPECT_FALSE(stats.StartCsvLog("missing_dir/frames.csv"));
+    EXPECT_FALSE(stats.IsLogging());
+}
+
+}  // namespace
+}  // namespace viewer3d
\ No newline at end of file
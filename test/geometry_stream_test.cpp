@@ -0,0 +1,70 @@
+#include "model/geometry_stream.hpp"
+
+#include <gtest/gtest.h>
+
+#include <thread>
+#include <vector>
+
+namespace viewer3d {
+namespace {
+
+TEST(GeometryStreamTest, ReadsOnlyNewBatches) {
+    GeometryStream stream;
+    GeometryStream::BatchList batches;
+    stream.ReadNewBatches(batches);
+    EXPECT_TRUE(batches.empty());
+
+    FaceList quad;
+    const std::vector<int> corners{0, 1, 2, 3};
+    quad.AddFace(corners.begin(), corners.end());
+    stream.Append({{0, 0, 0}, {1, 0, 0}, {1, 1, 0}, {0, 1, 0}}, quad);
+    stream.ReadNewBatches(batches);
+    ASSERT_EQ(batches.size(), 1);
+    EXPECT_EQ(batches[0]->vertices.size(), 4);
+    ASSERT_EQ(batches[0]->edges.size(), 4);
+    EXPECT_EQ(batches[0]->edges[3].a, 0);
+    EXPECT_EQ(batches[0]->edges[3].b, 3);
+
+    // Edges of later batches keep indexing the whole stream.
+    FaceList line;
+    const std::vector<int> ends{3, 4};
+    line.AddFace(ends.begin(), ends.end());
+    stream.Append({{2, 2, 0}}, line);
+    const auto first = batches[0];
+    stream.ReadNewBatches(batches);
+    ASSERT_EQ(batches.size(), 2);
+    EXPECT_EQ(batches[0], first);
+    EXPECT_EQ(batches[1]->vertices.size(), 1);
+    ASSERT_EQ(batches[1]->edges.size(), 1);
+    EXPECT_EQ(batches[1]->edges[0].b, 4);
+    EXPECT_EQ(stream.Revision(), 2);
+}
+
+// A reader works on its batches without the lock while the parse goes on
+// appending.
+TEST(GeometryStreamTest, AppendsWhileAReaderUsesItsBatches) {
+    GeometryStream stream;
+    std::thread parser([&stream]() {
+        for (int i = 0; i < 2000; ++i) {
+            stream.Append(std::vector<Vertex>(10, Vertex{1, 2, 3}),
+                          FaceList());
+        }
+    });
+    GeometryStream::BatchList batches;
+    std::size_t vertices = 0;
+    do {
+        const std::size_t first = batches.size();
+        stream.ReadNewBatches(batches);
+        for (std::size_t i = first; i < batches.size(); ++i) {
+            for (const Vertex& vertex : batches[i]->vertices) {
+                EXPECT_EQ(vertex.z, 3.0f);
+            }
+            vertices += batches[i]->vertices.size();
+        }
+    } while (batches.size() < 2000);
+    parser.join();
+    EXPECT_EQ(vertices, 20000);
+}
+
+}  // namespace
+}  // namespace viewer3d
\ No newline at end of file
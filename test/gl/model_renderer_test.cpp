@@ -0,0 +1,260 @@
+#include "view/model_renderer.hpp"
+
+#include <gtest/gtest.h>
+
+#include <QImage>
+#include <QOffscreenSurface>
+#include <QOpenGLContext>
+#include <QOpenGLFramebufferObject>
+#include <atomic>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include "controller/controller.hpp"
+#include "model/geometry_stream.hpp"
+#include "model/model.hpp"
+#include "model/obj_parser.hpp"
+
+namespace viewer3d {
+namespace {
+
+constexpr int kSize = 64;
+
+class ModelRendererTest : public ::testing::Test {
+   protected:
+    void SetUp() override {
+        CreateTestObjFile("test_square.obj");
+
+        surface_.create();
+        if (!context_.create() || !context_.makeCurrent(&surface_)) {
+            // CI sets VIEWER3D_REQUIRE_GL, so the tests cannot pass there
+            // without having run.
+            if (!qEnvironmentVariableIsEmpty("VIEWER3D_REQUIRE_GL")) {
+                FAIL() << "no OpenGL context available";
+            }
+            GTEST_SKIP() << "no OpenGL context available";
+        }
+        framebuffer_ = std::make_unique<QOpenGLFramebufferObject>(kSize, kSize);
+        ASSERT_TRUE(framebuffer_->bind());
+
+        renderer_ = std::make_unique<ModelRenderer>();
+        ASSERT_TRUE(renderer_->initialize());
+        renderer_->setColor(QVector4D(1.0f, 1.0f, 1.0f, 1.0f));
+
+        ASSERT_TRUE(controller_.LoadModel("test_square.obj"));
+    }
+
+    void TearDown() override {
+        renderer_.reset();
+        framebuffer_.reset();
+        context_.doneCurrent();
+        std::remove("test_square.obj");
+    }
+
+    void CreateTestObjFile(const std::string& filename) {
+        std::ofstream file(filename);
+        file << "v -0.5 -0.5 0.0\n";
+        file << "v 0.5 -0.5 0.0\n";
+        file << "v 0.5 0.5 0.0\n";
+        file << "v -0.5 0.5 0.0\n";
+        file << "f 1 2 3 4\n";
+        file.close();
+    }
+
+    void Clear() {
+        QOpenGLFunctions* gl = context_.functions();
+        gl->glViewport(0, 0, kSize, kSize);
+        gl->glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+        gl->glClear(GL_COLOR_BUFFER_BIT);
+    }
+
+    QImage Finish() {
+        context_.functions()->glFinish();
+        return framebuffer_->toImage();
+    }
+
+    QImage Render() {
+        Clear();
+        renderer_->draw(controller_, QMatrix4x4());
+        return Finish();
+    }
+
+    static QRect LitBounds(const QImage& image) {
+        QRect bounds;
+        for (int y = 0; y < image.height(); ++y) {
+            for (int x = 0; x < image.width(); ++x) {
+                if (qRed(image.pixel(x, y)) > 128) {
+                    bounds |= QRect(x, y, 1, 1);
+                }
+            }
+        }
+        return bounds;
+    }
+
+    QOffscreenSurface surface_;
+    QOpenGLContext context_;
+    std::unique_ptr<QOpenGLFramebufferObject> framebuffer_;
+    std::unique_ptr<ModelRenderer> renderer_;
+    Model model_;
+    Controller controller_{model_};
+};
+
+TEST_F(ModelRendererTest, GpuModeMatchesCpuMode) {
+    controller_.ScaleModel(0.5f);
+    controller_.TranslateModel(0.3f, 0.3f, 0.0f);
+
+    controller_.SetTransformMode(TransformMode::kCpu);
+    QImage cpu_image = Render();
+    controller_.SetTransformMode(TransformMode::kGpu);
+    QImage gpu_image = Render();
+
+    EXPECT_FALSE(LitBounds(gpu_image).isEmpty());
+    EXPECT_EQ(cpu_image, gpu_image);
+}
+
+TEST_F(ModelRendererTest, GpuModeAppliesModelMatrix) {
+    controller_.SetTransformMode(TransformMode::kGpu);
+    controller_.ScaleModel(0.5f);
+    controller_.TranslateModel(0.3f, 0.3f, 0.0f);
+
+    // The square spans [0.05, 0.55] in clip space on both axes, which is
+    // pixels 33.6 .. 49.6 horizontally and 14.4 .. 30.4 from the top.
+    QRect bounds = LitBounds(Render());
+    EXPECT_NEAR(bounds.left(), 33, 1);
+    EXPECT_NEAR(bounds.right(), 49, 1);
+    EXPECT_NEAR(bounds.top(), 14, 1);
+    EXPECT_NEAR(bounds.bottom(), 30, 1);
+}
+
+TEST_F(ModelRendererTest, QuantizedModelsAreDecodedByTheShader) {
+    controller_.SetTransformMode(TransformMode::kGpu);
+    controller_.ScaleModel(0.5f);
+    controller_.TranslateModel(0.3f, 0.3f, 0.0f);
+    const QRect expected = LitBounds(Render());
+
+    LoadOptions options;
+    options.storage = PositionStorage::kQuantized16;
+    controller_.SetLoadOptions(options);
+    ASSERT_TRUE(controller_.LoadModel("test_square.obj"));
+    controller_.ScaleModel(0.5f);
+    controller_.TranslateModel(0.3f, 0.3f, 0.0f);
+    EXPECT_EQ(LitBounds(Render()), expected);
+
+    controller_.SetTransformMode(TransformMode::kCpu);
+    EXPECT_EQ(LitBounds(Render()), expected);
+}
+
+TEST_F(ModelRendererTest, UploadsOnlyWhenGeometryChanges) {
+    controller_.SetTransformMode(TransformMode::kGpu);
+    Render();
+    EXPECT_EQ(renderer_->vertexUploadCount(), 1u);
+    EXPECT_EQ(renderer_->indexUploadCount(), 1u);
+
+    controller_.TranslateModel(0.1f, 0.0f, 0.0f);
+    controller_.RotateModel(0.0f, 0.0f, 15.0f);
+    Render();
+    Render();
+    EXPECT_EQ(renderer_->vertexUploadCount(), 1u);
+    EXPECT_EQ(renderer_->indexUploadCount(), 1u);
+
+    controller_.SetTransformMode(TransformMode::kCpu);
+    Render();
+    controller_.ScaleModel(0.5f);
+    Render();
+    EXPECT_EQ(renderer_->vertexUploadCount(), 3u);
+    EXPECT_EQ(renderer_->indexUploadCount(), 1u);
+
+    ASSERT_TRUE(controller_.LoadModel("test_square.obj"));
+    Render();
+    EXPECT_EQ(renderer_->vertexUploadCount(), 4u);
+    EXPECT_EQ(renderer_->indexUploadCount(), 2u);
+}
+
+TEST_F(ModelRendererTest, CountsWhatEachDrawSubmits) {
+    Render();
+    EXPECT_EQ(renderer_->lastDrawCounts().drawCalls, 1u);
+    EXPECT_EQ(renderer_->lastDrawCounts().vertices, 4u);
+    EXPECT_EQ(renderer_->lastDrawCounts().lines, 4u);
+
+    GeometryStream stream;
+    Clear();
+    renderer_->drawStream(stream, QMatrix4x4());
+    EXPECT_EQ(renderer_->lastDrawCounts().drawCalls, 0u);
+    EXPECT_EQ(renderer_->lastDrawCounts().vertices, 0u);
+}
+
+TEST_F(ModelRendererTest, SkipsClustersOutsideTheView) {
+    Render();
+    EXPECT_EQ(renderer_->lastDrawCounts().culledLines, 0u);
+
+    for (TransformMode mode : {TransformMode::kCpu, TransformMode::kGpu}) {
+        controller_.SetTransformMode(mode);
+        controller_.TranslateModel(5.0f, 0.0f, 0.0f);
+        const QImage image = Render();
+        EXPECT_TRUE(LitBounds(image).isEmpty());
+        EXPECT_EQ(renderer_->lastDrawCounts().drawCalls, 0u);
+        EXPECT_EQ(renderer_->lastDrawCounts().lines, 0u);
+        EXPECT_EQ(renderer_->lastDrawCounts().culledLines, 4u);
+        controller_.TranslateModel(0.0f, 0.0f, 0.0f);
+    }
+}
+
+TEST_F(ModelRendererTest, DrawsSnapshotsWhileTransformedOnAnotherThread) {
+    controller_.SetTransformMode(TransformMode::kCpu);
+    controller_.PublishSnapshot();
+
+    std::atomic<bool> done{false};
+    std::thread writer([this, &done]() {
+        for (int i = 0; i < 500; ++i) {
+            model_.SetTransform({0.001f * i, 0.0f, 0.0f},
+                                {0.0f, 0.0f, static_cast<float>(i)}, 0.5f);
+            model_.Publish();
+        }
+        done = true;
+    });
+    int frames = 0;
+    do {
+        Clear();
+        renderer_->draw(*controller_.GetLatestSnapshot(), nullptr,
+                        QMatrix4x4());
+        const DrawCounts& counts = renderer_->lastDrawCounts();
+        EXPECT_EQ(counts.lines + counts.culledLines, 4u);
+        ++frames;
+    } while (!done);
+    writer.join();
+    EXPECT_GT(frames, 0);
+
+    // The last snapshot draws what a render on the model's thread does.
+    Clear();
+    renderer_->draw(*controller_.GetLatestSnapshot(), nullptr, QMatrix4x4());
+    const QImage last = Finish();
+    EXPECT_FALSE(LitBounds(last).isEmpty());
+    EXPECT_EQ(last, Render());
+}
+
+TEST_F(ModelRendererTest, StreamMatchesLoadedModel) {
+    GeometryStream stream;
+    Clear();
+    EXPECT_FALSE(renderer_->drawStream(stream, QMatrix4x4()));
+
+    ParseControl control;
+    control.on_batch = [&stream](const std::vector<Vertex>& vertices,
+                                 const FaceList& faces) {
+        stream.Append(vertices, faces);
+    };
+    ObjData data;
+    ASSERT_TRUE(ParseObjMapped("test_square.obj", data, 1,
+                               kDefaultMinChunkBytes, control));
+
+    Clear();
+    EXPECT_TRUE(renderer_->drawStream(stream, QMatrix4x4()));
+    QImage stream_image = Finish();
+
+    EXPECT_FALSE(LitBounds(stream_image).isEmpty());
+    EXPECT_EQ(stream_image, Render());
+}
+
+}  // namespace
+}  // namespace viewer3d
\ No newline at end of file
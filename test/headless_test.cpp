@@ -0,0 +1,177 @@
+#include "cli/headless.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "model/model.hpp"
+
+namespace viewer3d {
+namespace {
+
+class HeadlessTest : public ::testing::Test {
+   protected:
+    void SetUp() override {
+        std::ofstream cube(kCube);
+        cube << "v 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 1 0\n"
+             << "v 0 0 1\nv 1 0 1\nv 1 1 1\nv 0 1 1\n"
+             << "f 1 2 3 4\nf 5 8 7 6\nf 1 5 6 2\n"
+             << "f 2 6 7 3\nf 3 7 8 4\nf 4 8 5 1\n";
+        std::ofstream broken(kBroken);
+        broken << "v 0 0 0\nv 1 0 0\nv 1 x 0\nv 0 1 0\n"
+               << "f 1 2 3\nf 1 1 2\n";
+    }
+
+    void TearDown() override {
+        std::remove(kCube);
+        std::remove(kBroken);
+        std::remove(kOutput);
+    }
+
+    int Run(const std::vector<std::string>& args) {
+        out_.str("");
+        err_.str("");
+        return RunHeadless(args, out_, err_);
+    }
+
+    std::vector<std::string> Lines() const {
+        std::vector<std::string> lines;
+        std::istringstream in(out_.str());
+        for (std::string line; std::getline(in, line);) {
+            lines.push_back(line);
+        }
+        return lines;
+    }
+
+    static bool Contains(const std::string& text, const std::string& part) {
+        return text.find(part) != std::string::npos;
+    }
+
+    static constexpr const char* kCube = "test_headless_cube.obj";
+    static constexpr const char* kBroken = "test_headless_broken.obj";
+    static constexpr const char* kOutput = "test_headless_out.obj";
+    std::ostringstream out_;
+    std::ostringstream err_;
+};
+
+TEST_F(HeadlessTest, StatsPrintsOneLinePerFileInOrder) {
+    EXPECT_EQ(Run({"stats", "-j", "3", kCube, "missing.obj", kCube}), 1);
+    const std::vector<std::string> lines = Lines();
+    ASSERT_EQ(lines.size(), 3);
+    EXPECT_EQ(lines[0], lines[2].substr(0, lines[0].find("\"load_ms\"")) +
+                            lines[0].substr(lines[0].find("\"load_ms\"")));
+    EXPECT_TRUE(Contains(lines[0], "\"file\":\"test_headless_cube.obj\""));
+    EXPECT_TRUE(Contains(lines[0], "\"vertices\":8,\"faces\":6,\"edges\":12"));
+    EXPECT_TRUE(
+        Contains(lines[0], "\"bounds\":{\"min\":[0,0,0],\"max\":[1,1,1]}"));
+    EXPECT_TRUE(Contains(lines[1], "\"ok\":false"));
+    EXPECT_TRUE(Contains(lines[1], "\"error\":\"file not found\""));
+
+    EXPECT_EQ(Run({"stats", kCube}), 0);
+}
+
+TEST_F(HeadlessTest, StatsReportsQuantizationError) {
+    EXPECT_EQ(Run({"stats", kCube}), 0);
+    EXPECT_TRUE(Contains(out_.str(), "\"position_bytes\":96"));
+    EXPECT_FALSE(Contains(out_.str(), "quantization_error"));
+
+    EXPECT_EQ(Run({"stats", "--quantize", kCube}), 0);
+    EXPECT_TRUE(Contains(out_.str(), "\"position_bytes\":48"));
+    EXPECT_TRUE(Contains(out_.str(), "\"quantization_error\":{\"max\":"));
+    EXPECT_TRUE(Contains(out_.str(), "\"vertices\":8,\"faces\":6"));
+}
+
+TEST_F(HeadlessTest, TransformWritesTransformedModel) {
+    EXPECT_EQ(Run({"transform", "--translate", "1,0,-1", "--scale", "2", "-o",
+                   kOutput, kCube}),
+              0);
+    EXPECT_TRUE(Contains(out_.str(), "\"output\":\"test_headless_out.obj\""));
+
+    Model model;
+    ASSERT_TRUE(model.LoadFromFile(kOutput));
+    EXPECT_EQ(model.GetVertexCount(), 8);
+    EXPECT_EQ(model.GetFaces().size(), 6);
+    EXPECT_FLOAT_EQ(model.GetBounds().min.x, 1.0f);
+    EXPECT_FLOAT_EQ(model.GetBounds().max.x, 3.0f);
+    EXPECT_FLOAT_EQ(model.GetBounds().min.z, -1.0f);
+}
+
+// Outputs are OBJ whatever the input format, and named that way.
+TEST_F(HeadlessTest, TransformNamesOutputsAfterTheirFormat) {
+    const char* const kScan = "test_headless_scan.stl";
+    const std::filesystem::path output_dir = "test_headless_output";
+    {
+        std::ofstream scan(kScan);
+        scan << "solid scan\n"
+             << "facet normal 0 0 1\nouter loop\n"
+             << "vertex 0 0 0\nvertex 1 0 0\nvertex 0 1 0\n"
+             << "endloop\nendfacet\nendsolid scan\n";
+    }
+
+    EXPECT_EQ(Run({"transform", "--translate", "0,0,2", "--output-dir",
+                   output_dir.string(), kScan}),
+              0);
+    EXPECT_FALSE(
+        std::filesystem::exists(output_dir / "test_headless_scan.stl"));
+    Model model;
+    ASSERT_TRUE(
+        model.LoadFromFile((output_dir / "test_headless_scan.obj").string()));
+    EXPECT_EQ(model.GetVertexCount(), 3);
+    EXPECT_EQ(model.GetFaces().size(), 1);
+    EXPECT_FLOAT_EQ(model.GetBounds().min.z, 2.0f);
+
+    // Both inputs would be written to test_headless_cube.obj.
+    const std::string cube_stl =
+        (output_dir / "test_headless_cube.stl").string();
+    std::filesystem::copy_file(kScan, cube_stl);
+    EXPECT_EQ(Run({"transform", "--output-dir", output_dir.string(), kCube,
+                   cube_stl}),
+              2);
+    EXPECT_EQ(Run({"transform", "-o", "test_headless_out.stl", kScan}), 2);
+
+    std::remove(kScan);
+    std::filesystem::remove_all(output_dir);
+}
+
+TEST_F(HeadlessTest, ValidateReportsProblems) {
+    EXPECT_EQ(Run({"validate", kCube}), 0);
+    EXPECT_TRUE(Contains(out_.str(), "\"valid\":true"));
+
+    EXPECT_EQ(Run({"validate", kBroken}), 1);
+    const std::string result = out_.str();
+    EXPECT_TRUE(Contains(result, "\"valid\":false"));
+    EXPECT_TRUE(Contains(result, "\"warnings\":1"));
+    EXPECT_TRUE(Contains(result, "\"line 3: incorrect vertex data\""));
+    EXPECT_TRUE(Contains(result, "\"degenerate_faces\":1"));
+}
+
+TEST_F(HeadlessTest, WarningsNameTheirFileAndKeepItsOrder) {
+    EXPECT_EQ(Run({"stats", "-j", "3", kBroken, kCube, kBroken}), 0);
+    EXPECT_EQ(Lines().size(), 3);
+    const std::string warning =
+        "Warning: test_headless_broken.obj: line 3: incorrect vertex data\n";
+    EXPECT_EQ(err_.str(), warning + warning);
+
+    // Validate lists them in the result instead.
+    EXPECT_EQ(Run({"validate", kBroken}), 1);
+    EXPECT_FALSE(Contains(err_.str(), "Warning"));
+}
+
+TEST_F(HeadlessTest, UsageErrors) {
+    EXPECT_EQ(Run({}), 2);
+    EXPECT_EQ(Run({"render", kCube}), 2);
+    EXPECT_EQ(Run({"stats"}), 2);
+    EXPECT_EQ(Run({"stats", "-j", "many", kCube}), 2);
+    EXPECT_EQ(Run({"transform", kCube}), 2);
+    EXPECT_EQ(Run({"transform", "-o", kOutput, kCube, kBroken}), 2);
+    EXPECT_EQ(Run({"--help"}), 0);
+    EXPECT_TRUE(Contains(out_.str(), "Usage:"));
+}
+
+}  // namespace
+}  // namespace viewer3d
\ No newline at end of file
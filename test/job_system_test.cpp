@@ -0,0 +1,175 @@
+#include "model/job_system.hpp"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstdint>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "model/bounds.hpp"
+#include "model/parallel.hpp"
+
+namespace viewer3d {
+namespace {
+
+TEST(JobSystemTest, RunsEveryTaskOnce) {
+    JobSystem jobs(3);
+    EXPECT_EQ(jobs.WorkerCount(), 3);
+
+    std::vector<std::atomic<int>> runs(10000);
+    auto task = [&runs](std::size_t i) { ++runs[i]; };
+    jobs.Run(runs.size(), 3, task);
+    for (const auto& count : runs) {
+        EXPECT_EQ(count.load(), 1);
+    }
+
+    // Nothing to do is fine as well.
+    jobs.Run(0, 3, task);
+}
+
+TEST(JobSystemTest, NestedAndConcurrentBatchesFinish) {
+    JobSystem jobs(2);
+    std::atomic<int> total{0};
+    auto inner = [&total](std::size_t) { ++total; };
+    auto outer = [&](std::size_t) { jobs.Run(100, 2, inner); };
+
+    std::vector<std::thread> submitters;
+    for (int i = 0; i < 4; ++i) {
+        submitters.emplace_back([&]() { jobs.Run(8, 2, outer); });
+    }
+    for (auto& thread : submitters) {
+        thread.join();
+    }
+    EXPECT_EQ(total.load(), 4 * 8 * 100);
+}
+
+TEST(JobSystemTest, SmallCountsStayOnTheCallingThread) {
+    const std::thread::id caller = std::this_thread::get_id();
+    bool same_thread = false;
+    ParallelFor(1000, 1000, 0, [&](std::size_t begin, std::size_t end) {
+        EXPECT_EQ(begin, 0);
+        EXPECT_EQ(end, 1000);
+        same_thread = std::this_thread::get_id() == caller;
+    });
+    EXPECT_TRUE(same_thread);
+}
+
+TEST(JobSystemTest, ParallelForCoversTheRange) {
+    std::vector<int> values(100001, 0);
+    ParallelFor(values.size(), 1000, 4,
+                [&values](std::size_t begin, std::size_t end) {
+                    for (std::size_t i = begin; i < end; ++i) {
+                        values[i] += 1;
+                    }
+                });
+    for (int value : values) {
+        ASSERT_EQ(value, 1);
+    }
+}
+
+TEST(JobSystemTest, ParallelReduceCombinesInOrder) {
+    const std::size_t count = 12345;
+    auto sum = [](std::size_t begin, std::size_t end) {
+        std::uint64_t total = 0;
+        for (std::size_t i = begin; i < end; ++i) {
+            total += i;
+        }
+        return total;
+    };
+    auto add = [](std::uint64_t a, std::uint64_t b) { return a + b; };
+    EXPECT_EQ(ParallelReduce<std::uint64_t>(count, 100, 4, 7, sum, add),
+              7 + count * (count - 1) / 2);
+    EXPECT_EQ(ParallelReduce<std::uint64_t>(0, 100, 4, 7, sum, add), 7);
+
+    // Concatenation is not commutative.
+    auto digits = [](std::size_t begin, std::size_t) {
+        return std::to_string(begin / 10);
+    };
+    auto concat = [](const std::string& a, const std::string& b) {
+        return a + b;
+    };
+    EXPECT_EQ(ParallelReduce<std::string>(50, 10, 4, "", digits, concat),
+              "01234");
+}
+
+TEST(JobSystemTest, ExceptionsReachTheCallingThread) {
+    JobSystem jobs(3);
+    std::atomic<int> runs{0};
+    auto failing = [&runs](std::size_t i) {
+        ++runs;
+        if (i == 5) {
+            throw std::length_error("task 5");
+        }
+    };
+    EXPECT_THROW(jobs.Run(1000, 3, failing), std::length_error);
+    EXPECT_LE(runs.load(), 1000);
+
+    // The workers survive and take the next batch.
+    std::atomic<int> total{0};
+    auto count = [&total](std::size_t) { ++total; };
+    jobs.Run(1000, 3, count);
+    EXPECT_EQ(total.load(), 1000);
+
+    auto failing_chunk = [](std::size_t begin, std::size_t) {
+        if (begin == 500) {
+            throw std::bad_alloc();
+        }
+    };
+    EXPECT_THROW(ParallelFor(1000, 100, 4, failing_chunk), std::bad_alloc);
+    auto failing_sum = [](std::size_t begin, std::size_t) -> int {
+        if (begin == 0) {
+            throw std::runtime_error("chunk 0");
+        }
+        return 1;
+    };
+    auto add = [](int a, int b) { return a + b; };
+    EXPECT_THROW(ParallelReduce<int>(1000, 100, 4, 0, failing_sum, add),
+                 std::runtime_error);
+}
+
+TEST(JobSystemTest, ParallelPassesRunOnTheInstalledJobSystem) {
+    JobSystem jobs(0);
+    EXPECT_EQ(jobs.WorkerCount(), 0);
+    {
+        JobSystem::Scope scope(jobs);
+        EXPECT_EQ(&JobSystem::Current(), &jobs);
+
+        // Without workers the caller runs every task.
+        const std::thread::id caller = std::this_thread::get_id();
+        std::atomic<int> elsewhere{0};
+        RunOnWorkers(1000, 4, [&](std::size_t) {
+            if (std::this_thread::get_id() != caller) {
+                ++elsewhere;
+            }
+        });
+        EXPECT_EQ(elsewhere.load(), 0);
+    }
+    EXPECT_NE(&JobSystem::Current(), &jobs);
+}
+
+TEST(JobSystemTest, BoundsOfALargeModelMatchASerialScan) {
+    std::vector<Vertex> vertices;
+    for (int i = 0; i < 400000; ++i) {
+        vertices.push_back({static_cast<float>(i % 977) - 300.0f,
+                            static_cast<float>(i % 1009) * 0.5f,
+                            -static_cast<float>(i % 331)});
+    }
+    vertices[123456] = {-1000.0f, 2000.0f, 3000.0f};
+    PositionsSoA positions;
+    positions.Assign(vertices);
+
+    const Bounds bounds = ComputeBounds(positions);
+    EXPECT_FLOAT_EQ(bounds.min.x, -1000.0f);
+    EXPECT_FLOAT_EQ(bounds.max.x, 676.0f);
+    EXPECT_FLOAT_EQ(bounds.min.y, 0.0f);
+    EXPECT_FLOAT_EQ(bounds.max.y, 2000.0f);
+    EXPECT_FLOAT_EQ(bounds.min.z, -330.0f);
+    EXPECT_FLOAT_EQ(bounds.max.z, 3000.0f);
+}
+
+}  // namespace
+}  // namespace viewer3d
\ No newline at end of file
@@ -0,0 +1,167 @@
+#include "model/lod_chain.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+#include "model/mesh_simplifier.hpp"
+
+namespace viewer3d {
+namespace {
+
+// A closed UV sphere with `rings` x `segments` quads around the poles.
+TriangleMesh Sphere(int rings, int segments) {
+    PositionsSoA positions;
+    std::vector<Vertex> vertices;
+    vertices.push_back({0.0f, 0.0f, 1.0f});
+    for (int r = 1; r < rings; ++r) {
+        const double theta = M_PI * r / rings;
+        for (int s = 0; s < segments; ++s) {
+            const double phi = 2.0 * M_PI * s / segments;
+            vertices.push_back(
+                {static_cast<float>(std::sin(theta) * std::cos(phi)),
+                 static_cast<float>(std::sin(theta) * std::sin(phi)),
+                 static_cast<float>(std::cos(theta))});
+        }
+    }
+    vertices.push_back({0.0f, 0.0f, -1.0f});
+    positions.Assign(vertices);
+
+    const int south = static_cast<int>(vertices.size()) - 1;
+    auto ring_vertex = [segments](int r, int s) {
+        return 1 + (r - 1) * segments + (s % segments);
+    };
+    FaceList faces;
+    for (int s = 0; s < segments; ++s) {
+        const int top[] = {0, ring_vertex(1, s), ring_vertex(1, s + 1)};
+        faces.AddFace(top, top + 3);
+        const int bottom[] = {south, ring_vertex(rings - 1, s + 1),
+                              ring_vertex(rings - 1, s)};
+        faces.AddFace(bottom, bottom + 3);
+    }
+    for (int r = 1; r + 1 < rings; ++r) {
+        for (int s = 0; s < segments; ++s) {
+            const int quad[] = {ring_vertex(r, s), ring_vertex(r + 1, s),
+                                ring_vertex(r + 1, s + 1),
+                                ring_vertex(r, s + 1)};
+            faces.AddFace(quad, quad + 4);
+        }
+    }
+    return Triangulate(positions, faces);
+}
+
+float MaxRadiusError(const TriangleMesh& mesh) {
+    float error = 0.0f;
+    for (const Vertex& v : mesh.vertices) {
+        const float radius = std::sqrt(v.x * v.x + v.y * v.y + v.z * v.z);
+        error = std::max(error, std::fabs(radius - 1.0f));
+    }
+    return error;
+}
+
+TEST(MeshSimplifierTest, TriangulatesPolygonsAndSkipsBrokenFaces) {
+    PositionsSoA positions;
+    positions.Assign({{0, 0, 0}, {1, 0, 0}, {1, 1, 0}, {0, 1, 0}});
+    FaceList faces;
+    const int quad[] = {0, 1, 2, 3};
+    const int line[] = {0, 1};
+    const int out_of_range[] = {0, 1, 7};
+    const int degenerate[] = {0, 0, 1};
+    faces.AddFace(quad, quad + 4);
+    faces.AddFace(line, line + 2);
+    faces.AddFace(out_of_range, out_of_range + 3);
+    faces.AddFace(degenerate, degenerate + 3);
+
+    const TriangleMesh mesh = Triangulate(positions, faces);
+    EXPECT_EQ(mesh.vertices.size(), 4u);
+    ASSERT_EQ(mesh.triangles.size(), 2u);
+    EXPECT_EQ(mesh.triangles[0], (std::array<int, 3>{0, 1, 2}));
+    EXPECT_EQ(mesh.triangles[1], (std::array<int, 3>{0, 2, 3}));
+}
+
+TEST(MeshSimplifierTest, ReachesTargetAndKeepsShape) {
+    TriangleMesh mesh = Sphere(64, 128);
+    const std::size_t source = mesh.triangles.size();
+
+    SimplifyStats stats;
+    ASSERT_TRUE(SimplifyMesh(mesh, source / 10, SimplifyOptions(), &stats));
+    EXPECT_LE(mesh.triangles.size(), source / 10);
+    EXPECT_GT(mesh.triangles.size(), source / 20);
+    EXPECT_GT(stats.peak_bytes, 0u);
+    EXPECT_LT(MaxRadiusError(mesh), 0.05f);
+
+    // Every vertex is still used and every index is valid.
+    std::vector<bool> used(mesh.vertices.size(), false);
+    for (const std::array<int, 3>& triangle : mesh.triangles) {
+        for (int index : triangle) {
+            ASSERT_GE(index, 0);
+            ASSERT_LT(static_cast<std::size_t>(index), mesh.vertices.size());
+            used[index] = true;
+        }
+    }
+    EXPECT_TRUE(std::all_of(used.begin(), used.end(),
+                            [](bool flag) { return flag; }));
+}
+
+TEST(MeshSimplifierTest, StopsWhenCancelled) {
+    TriangleMesh mesh = Sphere(16, 32);
+    std::atomic<bool> cancel{true};
+    SimplifyOptions options;
+    options.cancel = &cancel;
+    EXPECT_FALSE(SimplifyMesh(mesh, 10, options));
+}
+
+TEST(LodChainTest, BuildsCoarserLevels) {
+    TriangleMesh mesh = Sphere(64, 128);
+    const std::size_t source = mesh.triangles.size();
+    LodOptions options;
+    options.min_triangles = 100;
+
+    LodChain lods;
+    ASSERT_TRUE(lods.Build(std::move(mesh), options));
+    ASSERT_EQ(lods.size(), 4u);
+    EXPECT_LE(lods[0].triangle_count, source / 2);
+    for (std::size_t i = 1; i < lods.size(); ++i) {
+        EXPECT_LT(lods[i].triangle_count, lods[i - 1].triangle_count);
+        EXPECT_LT(lods[i].edges.size(), lods[i - 1].edges.size());
+    }
+    EXPECT_DOUBLE_EQ(lods[3].ratio, 0.02);
+    EXPECT_GT(lods.MemoryBytes(), 0u);
+    EXPECT_GE(lods.PeakBuildBytes(), lods.MemoryBytes());
+    EXPECT_GT(lods.BuildMs(), 0.0);
+}
+
+TEST(LodChainTest, SkipsLevelsBelowMinimum) {
+    LodOptions options;
+    options.min_triangles = 900;
+    LodChain lods;
+    ASSERT_TRUE(lods.Build(Sphere(32, 64), options));
+    // 3968 triangles: only the 50% and 25% levels reach the minimum.
+    EXPECT_EQ(lods.size(), 2u);
+
+    LodChain none;
+    ASSERT_TRUE(none.Build(Sphere(4, 8), LodOptions()));
+    EXPECT_TRUE(none.empty());
+}
+
+TEST(LodChainTest, SelectLodAppliesHysteresis) {
+    const std::vector<std::size_t> edges = {1000, 500, 100};
+    EXPECT_EQ(SelectLod({}, 10.0, 0), 0u);
+    // Zoomed in far enough, the full model is always drawn.
+    EXPECT_EQ(SelectLod(edges, 1e9, 2), 0u);
+    EXPECT_EQ(SelectLod(edges, 1.0, 0), 2u);
+
+    // Budget 600: the full model is drawn until it exceeds 1.5x the budget.
+    EXPECT_EQ(SelectLod(edges, 700.0, 0, 1.0, 1.5), 0u);
+    EXPECT_EQ(SelectLod(edges, 600.0, 0, 1.0, 1.5), 1u);
+    // ...and only comes back once the budget is 1.5x its edge count.
+    EXPECT_EQ(SelectLod(edges, 1000.0, 1, 1.0, 1.5), 1u);
+    EXPECT_EQ(SelectLod(edges, 1500.0, 1, 1.0, 1.5), 0u);
+    EXPECT_EQ(SelectLod(edges, 149.0, 2, 1.0, 1.5), 2u);
+    EXPECT_EQ(SelectLod(edges, 750.0, 2, 1.0, 1.5), 1u);
+}
+
+}  // namespace
+}  // namespace viewer3d
\ No newline at end of file
@@ -0,0 +1,69 @@
+#include "model/mesh_format.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+
+namespace viewer3d {
+namespace {
+
+std::string BinaryStlHead(const std::string& header, std::uint32_t count) {
+    std::string head = header;
+    head.resize(80, ' ');
+    for (int shift = 0; shift < 32; shift += 8) {
+        head.push_back(static_cast<char>((count >> shift) & 0xFF));
+    }
+    return head;
+}
+
+MeshFormat Detect(const std::string& head, std::uint64_t file_size) {
+    return DetectMeshFormat(head.data(), head.size(), file_size);
+}
+
+TEST(MeshFormatTest, RecognizesPlyByItsMagicLine) {
+    const std::string head = "ply\nformat ascii 1.0\n";
+    EXPECT_EQ(Detect(head, head.size()), MeshFormat::kPly);
+    EXPECT_EQ(Detect("ply\r\nformat binary_little_endian 1.0\r\n", 100),
+              MeshFormat::kPly);
+    EXPECT_EQ(Detect("plyx 1 2 3\n", 11), MeshFormat::kObj);
+}
+
+TEST(MeshFormatTest, RecognizesBinaryStlByItsTriangleCount) {
+    const std::string head = BinaryStlHead("binary header", 3);
+    EXPECT_EQ(Detect(head, 84 + 3 * 50), MeshFormat::kStl);
+    EXPECT_EQ(Detect(BinaryStlHead("", 0), 84), MeshFormat::kStl);
+    EXPECT_EQ(Detect(head, 84 + 3 * 50 + 1), MeshFormat::kObj);
+}
+
+TEST(MeshFormatTest, BinaryStlMayStartWithSolid) {
+    const std::string head = BinaryStlHead("solid exported by a scanner", 2);
+    EXPECT_TRUE(IsBinaryStl(head.data(), head.size(), 84 + 2 * 50));
+    EXPECT_EQ(Detect(head, 84 + 2 * 50), MeshFormat::kStl);
+}
+
+TEST(MeshFormatTest, RecognizesAsciiStlBySolidKeyword) {
+    const std::string head = "  solid cube\n  facet normal 0 0 1\n";
+    EXPECT_EQ(Detect(head, 4096), MeshFormat::kStl);
+    EXPECT_EQ(Detect("solid\n", 6), MeshFormat::kStl);
+    EXPECT_EQ(Detect("solidity 1\n", 11), MeshFormat::kObj);
+}
+
+TEST(MeshFormatTest, EverythingElseIsObj) {
+    EXPECT_EQ(Detect("# comment\nv 1 2 3\n", 18), MeshFormat::kObj);
+    EXPECT_EQ(Detect("", 0), MeshFormat::kObj);
+    EXPECT_EQ(DetectMeshFormat("nonexistent_file.ply"), MeshFormat::kObj);
+}
+
+TEST(MeshFormatTest, ReadsTheHeadOfAFile) {
+    {
+        std::ofstream file("test_format.stl", std::ios::binary);
+        file << BinaryStlHead("solid", 1) << std::string(50, '\0');
+    }
+    EXPECT_EQ(DetectMeshFormat("test_format.stl"), MeshFormat::kStl);
+    std::remove("test_format.stl");
+}
+
+}  // namespace
+}  // namespace viewer3d
\ No newline at end of file
@@ -0,0 +1,213 @@
+#include "model/model_cache.hpp"
+
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "model/model.hpp"
+
+namespace viewer3d {
+namespace {
+
+class ModelCacheTest : public ::testing::Test {
+   protected:
+    void SetUp() override {
+        std::filesystem::remove_all(kCacheDir);
+        WriteCube(kSource, "1.0");
+        options_.cache = CacheMode::kUse;
+        options_.cache_dir = kCacheDir;
+    }
+
+    void TearDown() override {
+        std::remove(kSource);
+        std::filesystem::remove_all(kCacheDir);
+    }
+
+    // `corner` is the x coordinate of the first vertex, so two files of the
+    // same size can still differ.
+    void WriteCube(const std::string& filename, const std::string& corner) {
+        std::ofstream file(filename);
+        file << "v " << corner << " 1.0 1.0\n";
+        file << "v 1.0 1.0 -1.0\n";
+        file << "v 1.0 -1.0 1.0\n";
+        file << "v 1.0 -1.0 -1.0\n";
+        file << "v -1.0 1.0 1.0\n";
+        file << "v -1.0 1.0 -1.0\n";
+        file << "v -1.0 -1.0 1.0\n";
+        file << "v -1.0 -1.0 -1.0\n";
+        file << "f 1 2 4 3\n";
+        file << "f 5 6 8 7\n";
+        file << "f 1 5 7 3\n";
+        file << "f 2 6 8 4\n";
+        file << "f 1 2 6 5\n";
+        file << "f 3 4 8 7\n";
+    }
+
+    std::string CachePath() const { return ModelCachePath(kSource, kCacheDir); }
+
+    static constexpr const char* kSource = "test_cache_cube.obj";
+    static constexpr const char* kCacheDir = "test_model_cache";
+    LoadOptions options_;
+};
+
+TEST_F(ModelCacheTest, SecondLoadUsesCache) {
+    Model parsed;
+    ASSERT_TRUE(parsed.LoadFromFile(kSource, options_));
+    EXPECT_FALSE(parsed.WasLoadedFromCache());
+    EXPECT_TRUE(std::filesystem::exists(CachePath()));
+
+    Model cached;
+    ASSERT_TRUE(cached.LoadFromFile(kSource, options_));
+    EXPECT_TRUE(cached.WasLoadedFromCache());
+    EXPECT_EQ(cached.GetFilename(), kSource);
+
+    EXPECT_EQ(cached.GetSourcePositions().x, parsed.GetSourcePositions().x);
+    EXPECT_EQ(cached.GetSourcePositions().y, parsed.GetSourcePositions().y);
+    EXPECT_EQ(cached.GetSourcePositions().z, parsed.GetSourcePositions().z);
+    EXPECT_EQ(cached.GetFaces().Indices(), parsed.GetFaces().Indices());
+    EXPECT_EQ(cached.GetFaces().Offsets(), parsed.GetFaces().Offsets());
+    EXPECT_EQ(cached.GetEdgeCount(), 12);
+    EXPECT_EQ(cached.GetBoundaryEdgeCount(), 0);
+    EXPECT_FLOAT_EQ(cached.GetBounds().min.x, -1.0f);
+    EXPECT_FLOAT_EQ(cached.GetBounds().max.z, 1.0f);
+    EXPECT_EQ(cached.GetVertices().size(), 8);
+}
+
+TEST_F(ModelCacheTest, ChangedContentIsStale) {
+    Model model;
+    ASSERT_TRUE(model.LoadFromFile(kSource, options_));
+
+    // Same size and possibly the same mtime, only the hash differs.
+    WriteCube(kSource, "2.0");
+    ASSERT_TRUE(model.LoadFromFile(kSource, options_));
+    EXPECT_FALSE(model.WasLoadedFromCache());
+    EXPECT_FLOAT_EQ(model.GetBounds().max.x, 2.0f);
+
+    ASSERT_TRUE(model.LoadFromFile(kSource, options_));
+    EXPECT_TRUE(model.WasLoadedFromCache());
+    EXPECT_FLOAT_EQ(model.GetBounds().max.x, 2.0f);
+}
+
+TEST_F(ModelCacheTest, ChangedStampIsStale) {
+    Model model;
+    ASSERT_TRUE(model.LoadFromFile(kSource, options_));
+
+    SourceStamp stamp;
+    ASSERT_TRUE(StampSourceFile(kSource, stamp));
+    PositionsSoA positions;
+    FaceList faces;
+    EdgeList edges;
+    Bounds bounds;
+    EXPECT_TRUE(ReadModelCache(CachePath(), stamp, positions, faces, edges,
+                               bounds));
+
+    SourceStamp size_changed = stamp;
+    size_changed.size++;
+    EXPECT_FALSE(ReadModelCache(CachePath(), size_changed, positions, faces,
+                                edges, bounds));
+
+    SourceStamp mtime_changed = stamp;
+    mtime_changed.mtime++;
+    EXPECT_FALSE(ReadModelCache(CachePath(), mtime_changed, positions, faces,
+                                edges, bounds));
+}
+
+TEST_F(ModelCacheTest, EditKeepingSizeAndMtimeIsStale) {
+    // Large enough that a sampled hash would skip most of the file.
+    {
+        std::ofstream file(kSource);
+        for (int i = 0; i < 200000; ++i) {
+            file << "v 1.0 1.0 1.0\n";
+        }
+        file << "f 1 2 3\n";
+    }
+    Model model;
+    ASSERT_TRUE(model.LoadFromFile(kSource, options_));
+    const auto mtime = std::filesystem::last_write_time(kSource);
+
+    {
+        std::fstream file(kSource, std::ios::in | std::ios::out);
+        file.seekp(100000 * 14 + 2);
+        file << '5';
+    }
+    std::filesystem::last_write_time(kSource, mtime);
+    ASSERT_TRUE(model.LoadFromFile(kSource, options_));
+    EXPECT_FALSE(model.WasLoadedFromCache());
+    EXPECT_FLOAT_EQ(model.GetBounds().max.x, 5.0f);
+}
+
+TEST_F(ModelCacheTest, ConcurrentWritersLeaveAValidCache) {
+    Model model;
+    ASSERT_TRUE(model.LoadFromFile(kSource, options_));
+    SourceStamp stamp;
+    ASSERT_TRUE(StampSourceFile(kSource, stamp));
+
+    std::vector<std::thread> writers;
+    for (int i = 0; i < 4; ++i) {
+        writers.emplace_back([&] {
+            for (int k = 0; k < 20; ++k) {
+                EXPECT_TRUE(WriteModelCache(
+                    CachePath(), stamp, model.GetSourcePositions(),
+                    model.GetFaces(), model.GetEdges(), model.GetBounds()));
+            }
+        });
+    }
+    for (std::thread& writer : writers) {
+        writer.join();
+    }
+
+    PositionsSoA positions;
+    FaceList faces;
+    EdgeList edges;
+    Bounds bounds;
+    EXPECT_TRUE(ReadModelCache(CachePath(), stamp, positions, faces, edges,
+                               bounds));
+    EXPECT_EQ(positions.x, model.GetSourcePositions().x);
+    EXPECT_EQ(std::distance(
+                  std::filesystem::directory_iterator(kCacheDir),
+                  std::filesystem::directory_iterator()),
+              1);
+}
+
+TEST_F(ModelCacheTest, TruncatedCacheIsRejected) {
+    Model model;
+    ASSERT_TRUE(model.LoadFromFile(kSource, options_));
+    const auto size = std::filesystem::file_size(CachePath());
+    std::filesystem::resize_file(CachePath(), size - 4);
+
+    ASSERT_TRUE(model.LoadFromFile(kSource, options_));
+    EXPECT_FALSE(model.WasLoadedFromCache());
+    EXPECT_EQ(std::filesystem::file_size(CachePath()), size);
+}
+
+TEST_F(ModelCacheTest, BypassAndRebuild) {
+    Model model;
+    options_.cache = CacheMode::kBypass;
+    ASSERT_TRUE(model.LoadFromFile(kSource, options_));
+    EXPECT_FALSE(std::filesystem::exists(CachePath()));
+
+    options_.cache = CacheMode::kRebuild;
+    ASSERT_TRUE(model.LoadFromFile(kSource, options_));
+    EXPECT_FALSE(model.WasLoadedFromCache());
+    ASSERT_TRUE(model.LoadFromFile(kSource, options_));
+    EXPECT_FALSE(model.WasLoadedFromCache());
+    EXPECT_TRUE(std::filesystem::exists(CachePath()));
+
+    options_.cache = CacheMode::kUse;
+    ASSERT_TRUE(model.LoadFromFile(kSource, options_));
+    EXPECT_TRUE(model.WasLoadedFromCache());
+}
+
+TEST_F(ModelCacheTest, CachePathBesideSource) {
+    EXPECT_EQ(ModelCachePath("models/cube.obj", ""),
+              "models/cube.obj.v3dcache");
+    EXPECT_NE(ModelCachePath("a/cube.obj", kCacheDir),
+              ModelCachePath("b/cube.obj", kCacheDir));
+}
+
+}  // namespace
+}  // namespace viewer3d
\ No newline at end of file
@@ -2,8 +2,10 @@
 
 #include <gtest/gtest.h>
 
+#include <atomic>
 #include <fstream>
 #include <string>
+#include <thread>
 
 namespace viewer3d {
 namespace {
@@ -42,6 +44,59 @@ TEST_F(ModelTest, LoadFromFile) {
     EXPECT_EQ(model_.GetVertexCount(), 8);
     EXPECT_EQ(model_.GetFaces().size(), 6);
     EXPECT_EQ(model_.GetEdgeCount(), 12);
+    EXPECT_EQ(model_.GetBoundaryEdgeCount(), 0);
+    EXPECT_EQ(model_.GetNonManifoldEdgeCount(), 0);
+}
+
+TEST_F(ModelTest, LoadsPlyAndStlByContent) {
+    const float corners[8][3] = {{1, 1, 1},   {1, 1, -1},  {1, -1, 1},
+                                 {1, -1, -1}, {-1, 1, 1},  {-1, 1, -1},
+                                 {-1, -1, 1}, {-1, -1, -1}};
+    const int quads[6][4] = {{0, 1, 3, 2}, {4, 5, 7, 6}, {0, 4, 6, 2},
+                             {1, 5, 7, 3}, {0, 1, 5, 4}, {2, 3, 7, 6}};
+    {
+        std::ofstream ply("test_cube.model", std::ios::binary);
+        ply << "ply\nformat ascii 1.0\nelement vertex 8\n"
+               "property float x\nproperty float y\nproperty float z\n"
+               "element face 6\nproperty list uchar int vertex_indices\n"
+               "end_header\n";
+        for (const auto& corner : corners) {
+            ply << corner[0] << " " << corner[1] << " " << corner[2] << "\n";
+        }
+        for (const auto& quad : quads) {
+            ply << "4 " << quad[0] << " " << quad[1] << " " << quad[2] << " "
+                << quad[3] << "\n";
+        }
+    }
+    ASSERT_TRUE(model_.LoadFromFile("test_cube.model"));
+    EXPECT_EQ(model_.GetVertexCount(), 8);
+    EXPECT_EQ(model_.GetFaces().size(), 6);
+    EXPECT_EQ(model_.GetEdgeCount(), 12);
+
+    {
+        std::ofstream stl("test_cube.model", std::ios::binary);
+        stl << "solid cube\n";
+        for (const auto& quad : quads) {
+            // Fans 0-1-2 and 0-2-3.
+            for (int t = 0; t < 2; ++t) {
+                stl << "facet normal 0 0 0\nouter loop\n";
+                for (int k : {0, t + 1, t + 2}) {
+                    const float* corner = corners[quad[k]];
+                    stl << "vertex " << corner[0] << " " << corner[1] << " "
+                        << corner[2] << "\n";
+                }
+                stl << "endloop\nendfacet\n";
+            }
+        }
+        stl << "endsolid cube\n";
+    }
+    ASSERT_TRUE(model_.LoadFromFile("test_cube.model"));
+    EXPECT_EQ(model_.GetVertexCount(), 8);
+    EXPECT_EQ(model_.GetFaces().size(), 12);
+    // The cube edges and one diagonal per side.
+    EXPECT_EQ(model_.GetEdgeCount(), 18);
+    EXPECT_EQ(model_.GetBoundaryEdgeCount(), 0);
+    std::remove("test_cube.model");
 }
 
 TEST_F(ModelTest, LoadFromNonExistentFile) {
@@ -49,6 +104,38 @@ TEST_F(ModelTest, LoadFromNonExistentFile) {
     EXPECT_EQ(model_.GetVertexCount(), 0);
 }
 
+TEST_F(ModelTest, FailedLoadKeepsModel) {
+    EXPECT_TRUE(model_.LoadFromFile("test_cube.obj"));
+    const auto revision = model_.GetGeometryRevision();
+
+    EXPECT_FALSE(model_.LoadFromFile("non_existent_file.obj"));
+    EXPECT_EQ(model_.GetVertexCount(), 8);
+    EXPECT_EQ(model_.GetFilename(), "test_cube.obj");
+    EXPECT_EQ(model_.GetGeometryRevision(), revision);
+
+    std::atomic<bool> cancel{true};
+    LoadOptions options;
+    options.control.cancel = &cancel;
+    EXPECT_FALSE(model_.LoadFromFile("test_cube.obj", options));
+    EXPECT_EQ(model_.GetVertexCount(), 8);
+}
+
+TEST_F(ModelTest, AdoptSwapsGeometry) {
+    Model staging;
+    ASSERT_TRUE(staging.LoadFromFile("test_cube.obj"));
+    staging.Scale(2.0f);
+    const auto revision = model_.GetGeometryRevision();
+
+    model_.SetTransformMode(TransformMode::kGpu);
+    model_.Adopt(staging);
+    EXPECT_EQ(model_.GetVertexCount(), 8);
+    EXPECT_EQ(model_.GetEdgeCount(), 12);
+    EXPECT_GT(model_.GetGeometryRevision(), revision);
+    EXPECT_EQ(model_.GetTransformMode(), TransformMode::kGpu);
+    EXPECT_FLOAT_EQ(model_.GetVertices()[0].x, 2.0f);
+    EXPECT_EQ(staging.GetVertexCount(), 0);
+}
+
 TEST_F(ModelTest, Clear) {
     EXPECT_TRUE(model_.LoadFromFile("test_cube.obj"));
     EXPECT_EQ(model_.GetVertexCount(), 8);
@@ -125,5 +212,313 @@ TEST_F(ModelTest, CombinedTransformations) {
     EXPECT_NEAR(transformedVertices[0].z, 3.0f, 0.001f);
 }
 
+TEST_F(ModelTest, GpuModeDefersVertexTransform) {
+    Model cpu_model;
+    EXPECT_TRUE(cpu_model.LoadFromFile("test_cube.obj"));
+    cpu_model.Scale(2.0f);
+    cpu_model.Rotate(30.0f, 45.0f, 60.0f);
+    cpu_model.Translate(1.0f, 2.0f, 3.0f);
+
+    model_.SetTransformMode(TransformMode::kGpu);
+    EXPECT_TRUE(model_.LoadFromFile("test_cube.obj"));
+    model_.Scale(2.0f);
+    model_.Rotate(30.0f, 45.0f, 60.0f);
+    model_.Translate(1.0f, 2.0f, 3.0f);
+
+    const auto& source = model_.GetSourcePositions();
+    EXPECT_FLOAT_EQ(source.x[0], 1.0f);
+    EXPECT_FLOAT_EQ(source.y[0], 1.0f);
+    EXPECT_FLOAT_EQ(source.z[0], 1.0f);
+    EXPECT_EQ(model_.GetVertexCount(), 8);
+
+    const auto& expected = cpu_model.GetVertices();
+    const auto& vertices = model_.GetVertices();
+    ASSERT_EQ(vertices.size(), expected.size());
+    for (size_t i = 0; i < vertices.size(); ++i) {
+        EXPECT_FLOAT_EQ(vertices[i].x, expected[i].x);
+        EXPECT_FLOAT_EQ(vertices[i].y, expected[i].y);
+        EXPECT_FLOAT_EQ(vertices[i].z, expected[i].z);
+    }
+}
+
+TEST_F(ModelTest, ModelMatrixMatchesVertices) {
+    EXPECT_TRUE(model_.LoadFromFile("test_cube.obj"));
+    model_.Scale(1.5f);
+    model_.Rotate(10.0f, 20.0f, 30.0f);
+    model_.Translate(-1.0f, 0.5f, 2.0f);
+
+    const auto m = model_.GetModelMatrix();
+    const auto& source = model_.GetSourcePositions();
+    const auto& vertices = model_.GetVertices();
+    EXPECT_FLOAT_EQ(m[12], 0.0f);
+    EXPECT_FLOAT_EQ(m[15], 1.0f);
+    for (size_t i = 0; i < vertices.size(); ++i) {
+        float x = source.x[i];
+        float y = source.y[i];
+        float z = source.z[i];
+        EXPECT_NEAR(vertices[i].x, m[0] * x + m[1] * y + m[2] * z + m[3],
+                    1e-5f);
+        EXPECT_NEAR(vertices[i].y, m[4] * x + m[5] * y + m[6] * z + m[7],
+                    1e-5f);
+        EXPECT_NEAR(vertices[i].z, m[8] * x + m[9] * y + m[10] * z + m[11],
+                    1e-5f);
+    }
+}
+
+TEST_F(ModelTest, SwitchTransformMode) {
+    EXPECT_TRUE(model_.LoadFromFile("test_cube.obj"));
+    model_.SetTransformMode(TransformMode::kGpu);
+    model_.Translate(1.0f, 0.0f, 0.0f);
+
+    model_.SetTransformMode(TransformMode::kCpu);
+    EXPECT_FLOAT_EQ(model_.GetVertices()[0].x, 2.0f);
+
+    model_.Translate(2.0f, 0.0f, 0.0f);
+    EXPECT_FLOAT_EQ(model_.GetVertices()[0].x, 3.0f);
+}
+
+TEST_F(ModelTest, TransformsAreMaterializedOnce) {
+    // Loading keeps only the source positions.
+    EXPECT_TRUE(model_.LoadFromFile("test_cube.obj"));
+    EXPECT_EQ(model_.GetMaterializationCount(), 0);
+    EXPECT_EQ(model_.GetVertices()[0].x, 1.0f);
+    EXPECT_EQ(model_.GetMaterializationCount(), 1);
+
+    model_.Translate(1.0f, 0.0f, 0.0f);
+    model_.Rotate(0.0f, 0.0f, 90.0f);
+    model_.Scale(2.0f);
+    EXPECT_EQ(model_.GetMaterializationCount(), 1);
+
+    EXPECT_NEAR(model_.GetVertices()[0].x, -1.0f, 1e-5f);
+    EXPECT_NEAR(model_.GetVertices()[0].y, 2.0f, 1e-5f);
+    EXPECT_EQ(model_.GetMaterializationCount(), 2);
+}
+
+TEST_F(ModelTest, SetTransformMatchesSeparateSetters) {
+    Model separate;
+    EXPECT_TRUE(separate.LoadFromFile("test_cube.obj"));
+    separate.Translate(1.0f, 2.0f, 3.0f);
+    separate.Rotate(30.0f, 45.0f, 60.0f);
+    separate.Scale(1.5f);
+
+    EXPECT_TRUE(model_.LoadFromFile("test_cube.obj"));
+    const auto revision = model_.GetTransformRevision();
+    EXPECT_TRUE(model_.SetTransform({1.0f, 2.0f, 3.0f}, {30.0f, 45.0f, 60.0f},
+                                    1.5f));
+    EXPECT_EQ(model_.GetTransformRevision(), revision + 1);
+    EXPECT_EQ(model_.GetModelMatrix(), separate.GetModelMatrix());
+
+    EXPECT_FALSE(model_.SetTransform({5.0f, 0.0f, 0.0f}, {0.0f, 0.0f, 0.0f},
+                                     0.05f));
+    EXPECT_EQ(model_.GetTransformRevision(), revision + 1);
+    EXPECT_EQ(model_.GetModelMatrix(), separate.GetModelMatrix());
+}
+
+TEST_F(ModelTest, Revisions) {
+    const auto geometry = model_.GetGeometryRevision();
+    EXPECT_TRUE(model_.LoadFromFile("test_cube.obj"));
+    EXPECT_GT(model_.GetGeometryRevision(), geometry);
+
+    const auto loaded = model_.GetGeometryRevision();
+    const auto transform = model_.GetTransformRevision();
+    model_.Translate(1.0f, 0.0f, 0.0f);
+    EXPECT_EQ(model_.GetGeometryRevision(), loaded);
+    EXPECT_GT(model_.GetTransformRevision(), transform);
+
+    model_.Clear();
+    EXPECT_GT(model_.GetGeometryRevision(), loaded);
+}
+
+TEST_F(ModelTest, QuantizedStorageKeepsOnlyCompactPositions) {
+    Model reference;
+    ASSERT_TRUE(reference.LoadFromFile("test_cube.obj"));
+    EXPECT_EQ(reference.GetPositionStorage(), PositionStorage::kFloat);
+    EXPECT_EQ(reference.GetPositionBytes(), 8 * 3 * sizeof(float));
+
+    LoadOptions options;
+    options.storage = PositionStorage::kQuantized16;
+    ASSERT_TRUE(model_.LoadFromFile("test_cube.obj", options));
+    EXPECT_EQ(model_.GetPositionStorage(), PositionStorage::kQuantized16);
+    EXPECT_TRUE(model_.GetSourcePositions().empty());
+    EXPECT_EQ(model_.GetVertexCount(), 8);
+    EXPECT_EQ(model_.GetPositionBytes(), 8 * 3 * sizeof(std::uint16_t));
+    const QuantizationError& error = model_.GetQuantizationError();
+    EXPECT_GT(error.bound, 0.0f);
+    EXPECT_LE(error.max, error.bound);
+
+    model_.SetTransform({1.0f, 2.0f, 3.0f}, {10.0f, 20.0f, 30.0f}, 2.0f);
+    reference.SetTransform({1.0f, 2.0f, 3.0f}, {10.0f, 20.0f, 30.0f}, 2.0f);
+    const std::vector<Vertex>& vertices = model_.GetVertices();
+    const std::vector<Vertex>& expected = reference.GetVertices();
+    ASSERT_EQ(vertices.size(), expected.size());
+    for (std::size_t i = 0; i < vertices.size(); ++i) {
+        EXPECT_NEAR(vertices[i].x, expected[i].x, 1e-4f);
+        EXPECT_NEAR(vertices[i].y, expected[i].y, 1e-4f);
+        EXPECT_NEAR(vertices[i].z, expected[i].z, 1e-4f);
+    }
+}
+
+TEST_F(ModelTest, QuantizedModelsArePickable) {
+    LoadOptions options;
+    options.storage = PositionStorage::kQuantized16;
+    ASSERT_TRUE(model_.LoadFromFile("test_cube.obj", options));
+    model_.Translate(0.0f, 0.0f, 1.0f);
+
+    PickResult pick;
+    ASSERT_TRUE(model_.Pick({{0.5f, 0.5f, 5.0f}, {0.0f, 0.0f, -1.0f}}, pick));
+    EXPECT_NEAR(pick.point.z, 2.0f, 1e-4f);
+    EXPECT_EQ(pick.vertex, 0);
+    EXPECT_NEAR(pick.vertex_position.x, 1.0f, 1e-4f);
+    EXPECT_NEAR(pick.vertex_position.z, 2.0f, 1e-4f);
+}
+
+// The pick index is built by the first pick, once, even when copies that
+// share the geometry pick at the same time.
+TEST_F(ModelTest, CopiesPickConcurrently) {
+    ASSERT_TRUE(model_.LoadFromFile("test_cube.obj"));
+    const Model copy = model_;
+    const Ray ray{{0.5f, 0.5f, 5.0f}, {0.0f, 0.0f, -1.0f}};
+
+    PickResult copy_pick;
+    bool copy_hit = false;
+    std::thread picker([&] { copy_hit = copy.Pick(ray, copy_pick); });
+    PickResult pick;
+    const bool hit = model_.Pick(ray, pick);
+    picker.join();
+
+    ASSERT_TRUE(hit);
+    ASSERT_TRUE(copy_hit);
+    EXPECT_EQ(copy_pick.face, pick.face);
+    EXPECT_EQ(copy_pick.vertex, pick.vertex);
+    EXPECT_NEAR(pick.point.z, 1.0f, 1e-4f);
+}
+
+TEST_F(ModelTest, SnapshotsKeepTheStateTheyWerePublishedWith) {
+    EXPECT_EQ(model_.LatestSnapshot(), nullptr);
+    EXPECT_TRUE(model_.LoadFromFile("test_cube.obj"));
+    const auto loaded = model_.Publish();
+    ASSERT_NE(loaded, nullptr);
+    EXPECT_EQ(model_.LatestSnapshot(), loaded);
+    EXPECT_EQ(model_.Publish(), loaded);
+    EXPECT_EQ(loaded->geometry->positions.size(), 8);
+    EXPECT_EQ(loaded->geometry->edges.size(), 12);
+    ASSERT_NE(loaded->vertices, nullptr);
+    EXPECT_FLOAT_EQ((*loaded->vertices)[0].x, 1.0f);
+
+    model_.Translate(1.0f, 0.0f, 0.0f);
+    EXPECT_EQ(model_.LatestSnapshot(), loaded);
+    const auto moved = model_.Publish();
+    EXPECT_EQ(moved->geometry, loaded->geometry);
+    EXPECT_FLOAT_EQ((*moved->vertices)[0].x, 2.0f);
+    EXPECT_FLOAT_EQ(moved->model_matrix[3], 1.0f);
+    EXPECT_FLOAT_EQ((*loaded->vertices)[0].x, 1.0f);
+    EXPECT_FLOAT_EQ(loaded->model_matrix[3], 0.0f);
+
+    model_.SetTransformMode(TransformMode::kGpu);
+    const auto gpu = model_.Publish();
+    EXPECT_EQ(gpu->mode, TransformMode::kGpu);
+    EXPECT_EQ(gpu->vertices, nullptr);
+    EXPECT_EQ(model_.GetMaterializationCount(), 2);
+
+    model_.Clear();
+    EXPECT_EQ(model_.Publish()->geometry->positions.size(), 0);
+    EXPECT_EQ(moved->geometry->positions.size(), 8);
+}
+
+// Copies share the geometry but not the snapshots of the original.
+TEST_F(ModelTest, CopiesStartWithoutSnapshots) {
+    EXPECT_TRUE(model_.LoadFromFile("test_cube.obj"));
+    const auto published = model_.Publish();
+    EXPECT_EQ(model_.LatestSnapshot(), published);
+
+    Model copy = model_;
+    EXPECT_EQ(copy.LatestSnapshot(), nullptr);
+    const auto copied = copy.Publish();
+    EXPECT_NE(copied, published);
+    EXPECT_EQ(copied->geometry, published->geometry);
+    EXPECT_EQ(copy.LatestSnapshot(), copied);
+    EXPECT_EQ(model_.LatestSnapshot(), published);
+
+    copy = model_;
+    EXPECT_EQ(copy.LatestSnapshot(), nullptr);
+}
+
+// A transform writes to the array no snapshot holds, so two arrays take
+// turns while a renderer keeps one frame.
+TEST_F(ModelTest, SnapshotVerticesAreDoubleBuffered) {
+    EXPECT_TRUE(model_.LoadFromFile("test_cube.obj"));
+    auto previous = model_.Publish();
+    model_.Translate(1.0f, 0.0f, 0.0f);
+    auto current = model_.Publish();
+    EXPECT_NE(current->vertices, previous->vertices);
+    const Vertex* first = previous->vertices->data();
+    const Vertex* second = current->vertices->data();
+
+    for (int i = 2; i < 6; ++i) {
+        previous = std::move(current);
+        model_.Translate(static_cast<float>(i), 0.0f, 0.0f);
+        current = model_.Publish();
+        EXPECT_EQ(current->vertices->data(), i % 2 == 0 ? first : second);
+        EXPECT_FLOAT_EQ((*current->vertices)[0].x, 1.0f + i);
+        EXPECT_FLOAT_EQ((*previous->vertices)[0].x, static_cast<float>(i));
+    }
+}
+
+// Every snapshot seen by the reader has vertices that match its own model
+// matrix, however the writer's transforms interleave with the reads.
+TEST_F(ModelTest, SnapshotsDoNotTearWhileTransformedOnAnotherThread) {
+    constexpr int kRow = 400;
+    {
+        std::ofstream file("test_cube.obj");
+        for (int y = 0; y < kRow; ++y) {
+            for (int x = 0; x < kRow; ++x) {
+                file << "v " << x << ' ' << y << " 0\n";
+            }
+        }
+        for (int y = 0; y + 1 < kRow; ++y) {
+            const int v = y * kRow + 1;
+            file << "f " << v << ' ' << v + 1 << ' ' << v + kRow + 1 << ' '
+                 << v + kRow << "\n";
+        }
+    }
+    ASSERT_TRUE(model_.LoadFromFile("test_cube.obj"));
+    model_.Publish();
+
+    std::atomic<bool> done{false};
+    std::thread writer([this, &done]() {
+        for (int i = 1; i <= 200; ++i) {
+            model_.SetTransform({static_cast<float>(i), 0.0f, 0.0f},
+                                {0.0f, 0.0f, static_cast<float>(i)},
+                                1.0f + (i % 3));
+            model_.Publish();
+        }
+        done = true;
+    });
+
+    std::uint64_t revisions_seen = 0;
+    std::uint64_t last_revision = 0;
+    do {
+        const auto snapshot = model_.LatestSnapshot();
+        if (snapshot->transform_revision != last_revision) {
+            last_revision = snapshot->transform_revision;
+            ++revisions_seen;
+        }
+        const PositionsSoA& source = snapshot->geometry->positions;
+        const std::vector<Vertex>& vertices = *snapshot->vertices;
+        ASSERT_EQ(vertices.size(), source.size());
+        const auto& m = snapshot->model_matrix;
+        for (std::size_t i = 0; i < vertices.size(); i += 997) {
+            const float x = source.x[i];
+            const float y = source.y[i];
+            ASSERT_NEAR(vertices[i].x, m[0] * x + m[1] * y + m[3], 1e-2f);
+            ASSERT_NEAR(vertices[i].y, m[4] * x + m[5] * y + m[7], 1e-2f);
+        }
+    } while (!done);
+    writer.join();
+
+    EXPECT_GE(revisions_seen, 1);
+    EXPECT_FLOAT_EQ(model_.LatestSnapshot()->model_matrix[3], 200.0f);
+}
+
 }  // namespace
 }  // namespace viewer3d
\ No newline at end of file
@@ -0,0 +1,117 @@
+#include "objgen/obj_generator.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include "model/obj_parser.hpp"
+
+namespace viewer3d {
+namespace {
+
+class ObjGeneratorTest : public ::testing::Test {
+   protected:
+    void SetUp() override {
+        options_.vertex_count = 2000;
+        options_.face_count = 3000;
+        options_.seed = 7;
+        options_.polygons = {{3, 1.0}, {4, 1.0}, {6, 0.5}};
+    }
+
+    void TearDown() override {
+        std::remove(kFirst);
+        std::remove(kSecond);
+    }
+
+    static std::string ReadFile(const std::string& filename) {
+        std::ifstream file(filename, std::ios::binary);
+        std::ostringstream contents;
+        contents << file.rdbuf();
+        return contents.str();
+    }
+
+    static constexpr const char* kFirst = "test_objgen_first.obj";
+    static constexpr const char* kSecond = "test_objgen_second.obj";
+    ObjGenOptions options_;
+};
+
+TEST_F(ObjGeneratorTest, SameSeedGivesSameFile) {
+    ASSERT_TRUE(WriteGeneratedObj(kFirst, options_));
+    ASSERT_TRUE(WriteGeneratedObj(kSecond, options_));
+    EXPECT_EQ(ReadFile(kFirst), ReadFile(kSecond));
+
+    options_.seed = 8;
+    ASSERT_TRUE(WriteGeneratedObj(kSecond, options_));
+    EXPECT_NE(ReadFile(kFirst), ReadFile(kSecond));
+}
+
+TEST_F(ObjGeneratorTest, ParsesToRequestedCounts) {
+    options_.negative_index_ratio = 0.3;
+    options_.full_token_ratio = 0.3;
+    ASSERT_TRUE(WriteGeneratedObj(kFirst, options_));
+
+    ObjData mapped;
+    ASSERT_TRUE(ParseObjMapped(kFirst, mapped));
+    EXPECT_EQ(mapped.vertices.size(), 2000);
+    ASSERT_EQ(mapped.faces.size(), 3000);
+    bool sizes[7] = {};
+    for (std::size_t i = 0; i < mapped.faces.size(); ++i) {
+        const std::size_t sides = mapped.faces[i].size();
+        ASSERT_TRUE(sides == 3 || sides == 4 || sides == 6);
+        sizes[sides] = true;
+    }
+    EXPECT_TRUE(sizes[3] && sizes[4] && sizes[6]);
+
+    ObjData stream;
+    ASSERT_TRUE(ParseObjStream(kFirst, stream));
+    EXPECT_EQ(stream.faces.Indices(), mapped.faces.Indices());
+}
+
+TEST_F(ObjGeneratorTest, TokenStyleDoesNotChangeMesh) {
+    ASSERT_TRUE(WriteGeneratedObj(kFirst, options_));
+    options_.negative_index_ratio = 1.0;
+    options_.full_token_ratio = 0.5;
+    ASSERT_TRUE(WriteGeneratedObj(kSecond, options_));
+    EXPECT_NE(ReadFile(kFirst), ReadFile(kSecond));
+
+    ObjData plain;
+    ObjData styled;
+    ASSERT_TRUE(ParseObjMapped(kFirst, plain));
+    ASSERT_TRUE(ParseObjMapped(kSecond, styled));
+    EXPECT_EQ(plain.vertices.size(), styled.vertices.size());
+    EXPECT_EQ(plain.faces.Offsets(), styled.faces.Offsets());
+    EXPECT_EQ(plain.faces.Indices(), styled.faces.Indices());
+}
+
+TEST_F(ObjGeneratorTest, RejectsInvalidOptions) {
+    std::string error;
+    EXPECT_TRUE(ValidateObjGenOptions(options_, error));
+
+    ObjGenOptions options = options_;
+    options.vertex_count = 0;
+    EXPECT_FALSE(ValidateObjGenOptions(options, error));
+
+    options = options_;
+    options.polygons = {{2, 1.0}};
+    EXPECT_FALSE(ValidateObjGenOptions(options, error));
+
+    options = options_;
+    options.polygons = {{3, 0.0}};
+    EXPECT_FALSE(ValidateObjGenOptions(options, error));
+
+    options = options_;
+    options.negative_index_ratio = 1.5;
+    EXPECT_FALSE(ValidateObjGenOptions(options, error));
+
+    options = options_;
+    options.vertex_count = 10;
+    options.polygons = {{20, 1.0}};
+    EXPECT_FALSE(ValidateObjGenOptions(options, error));
+    EXPECT_FALSE(WriteGeneratedObj(kFirst, options));
+}
+
+}  // namespace
+}  // namespace viewer3d
\ No newline at end of file
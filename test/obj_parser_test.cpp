@@ -0,0 +1,232 @@
+#include "model/obj_parser.hpp"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "model/model.hpp"
+
+namespace viewer3d {
+namespace {
+
+class ObjParserTest : public ::testing::Test {
+   protected:
+    void SetUp() override { CreateTestObjFile("test_parser.obj"); }
+
+    void TearDown() override { std::remove("test_parser.obj"); }
+
+    void CreateTestObjFile(const std::string& filename) {
+        std::ofstream file(filename, std::ios::binary);
+        file << "# comment line\n";
+        file << "o object\n";
+        file << "v 1.0 2.0 3.0\n";
+        file << "v -1.5 +2.5 .5\r\n";
+        file << "vn 0.0 0.0 1.0\n";
+        file << "vt 0.5 0.5\n";
+        file << "v 1e-2 -2E1 0\n";
+        file << "v 1.0 not_a_number 1.0\n";
+        file << "v inf 1.0 1.0\n";
+        file << "  v   4 5 6   \n";
+        file << "f 1 2 3\n";
+        file << "f 1//1 2//1 3//1 4//1\n";
+        file << "f 1/1/1 2/1/1 -1/1/1\r\n";
+        file << "f -1 -2 -3 -4\n";
+        file << "f 1 2 nonexistent 9\n";
+        file << "f 7\n";
+        file << "f\n";
+        file << "v 7 8 9\n";
+        file << "f 5 -1 +1";
+    }
+
+    static void ExpectSameData(const ObjData& expected, const ObjData& actual) {
+        ASSERT_EQ(expected.vertices.size(), actual.vertices.size());
+        for (size_t i = 0; i < expected.vertices.size(); ++i) {
+            EXPECT_EQ(expected.vertices[i].x, actual.vertices[i].x);
+            EXPECT_EQ(expected.vertices[i].y, actual.vertices[i].y);
+            EXPECT_EQ(expected.vertices[i].z, actual.vertices[i].z);
+        }
+        EXPECT_EQ(expected.faces.Offsets(), actual.faces.Offsets());
+        EXPECT_EQ(expected.faces.Indices(), actual.faces.Indices());
+    }
+
+    static std::vector<int> Indices(FaceView face) {
+        return std::vector<int>(face.begin(), face.end());
+    }
+};
+
+TEST_F(ObjParserTest, MappedMatchesStream) {
+    ObjData stream_data;
+    ObjData mapped_data;
+    ASSERT_TRUE(ParseObjStream("test_parser.obj", stream_data));
+    ASSERT_TRUE(ParseObjMapped("test_parser.obj", mapped_data));
+    ExpectSameData(stream_data, mapped_data);
+}
+
+TEST_F(ObjParserTest, MappedParsesRecords) {
+    ObjData data;
+    ASSERT_TRUE(ParseObjMapped("test_parser.obj", data));
+
+    ASSERT_EQ(data.vertices.size(), 5);
+    EXPECT_FLOAT_EQ(data.vertices[1].x, -1.5f);
+    EXPECT_FLOAT_EQ(data.vertices[1].y, 2.5f);
+    EXPECT_FLOAT_EQ(data.vertices[1].z, 0.5f);
+    EXPECT_FLOAT_EQ(data.vertices[2].y, -20.0f);
+    EXPECT_FLOAT_EQ(data.vertices[3].z, 6.0f);
+
+    ASSERT_EQ(data.faces.size(), 6);
+    EXPECT_EQ(Indices(data.faces[1]), (std::vector<int>{0, 1, 2, 3}));
+    EXPECT_EQ(Indices(data.faces[2]), (std::vector<int>{0, 1, 3}));
+    EXPECT_EQ(Indices(data.faces[3]), (std::vector<int>{3, 2, 1, 0}));
+    EXPECT_EQ(Indices(data.faces[4]), (std::vector<int>{0, 1}));
+    EXPECT_EQ(Indices(data.faces[5]), (std::vector<int>{4, 4, 0}));
+}
+
+TEST_F(ObjParserTest, EmptyFile) {
+    std::ofstream("test_empty.obj").close();
+
+    ObjData data;
+    EXPECT_TRUE(ParseObjMapped("test_empty.obj", data));
+    EXPECT_TRUE(data.vertices.empty());
+    EXPECT_TRUE(data.faces.empty());
+
+    std::remove("test_empty.obj");
+}
+
+TEST_F(ObjParserTest, NonExistentFile) {
+    ObjData data;
+    EXPECT_FALSE(ParseObjMapped("non_existent_file.obj", data));
+}
+
+TEST_F(ObjParserTest, ParallelMatchesSerial) {
+    ObjData serial_data;
+    ASSERT_TRUE(ParseObjMapped("test_parser.obj", serial_data, 1));
+
+    for (unsigned threads : {2u, 3u, 8u}) {
+        for (std::size_t min_chunk_bytes : {1u, 7u, 32u}) {
+            ObjData parallel_data;
+            ASSERT_TRUE(ParseObjMapped("test_parser.obj", parallel_data,
+                                       threads, min_chunk_bytes));
+            ExpectSameData(serial_data, parallel_data);
+        }
+    }
+}
+
+TEST_F(ObjParserTest, ReportsProgressAndStopsWhenCancelled) {
+    std::uint64_t last_done = 0;
+    std::uint64_t last_total = 0;
+    ParseControl control;
+    control.progress = [&](std::uint64_t done, std::uint64_t total) {
+        last_done = done;
+        last_total = total;
+    };
+
+    ObjData mapped_data;
+    ASSERT_TRUE(ParseObjMapped("test_parser.obj", mapped_data, 1,
+                               kDefaultMinChunkBytes, control));
+    EXPECT_GT(last_total, 0u);
+    EXPECT_EQ(last_done, last_total);
+
+    last_done = 0;
+    ObjData stream_data;
+    ASSERT_TRUE(ParseObjStream("test_parser.obj", stream_data, control));
+    EXPECT_EQ(last_done, last_total);
+
+    std::atomic<bool> cancel{true};
+    control.cancel = &cancel;
+    ObjData cancelled_data;
+    EXPECT_FALSE(ParseObjMapped("test_parser.obj", cancelled_data, 2, 1,
+                                control));
+}
+
+TEST_F(ObjParserTest, StreamingBatchesAddUpToResult) {
+    ObjData expected;
+    ASSERT_TRUE(ParseObjMapped("test_parser.obj", expected, 1));
+
+    ObjData published;
+    ParseControl control;
+    control.on_batch = [&published](const std::vector<Vertex>& vertices,
+                                    const FaceList& faces) {
+        published.vertices.insert(published.vertices.end(), vertices.begin(),
+                                  vertices.end());
+        published.faces.Append(faces);
+    };
+
+    for (unsigned threads : {1u, 3u}) {
+        published = ObjData();
+        ObjData mapped_data;
+        ASSERT_TRUE(ParseObjMapped("test_parser.obj", mapped_data, threads, 7,
+                                   control));
+        ExpectSameData(expected, mapped_data);
+        ExpectSameData(expected, published);
+    }
+
+    published = ObjData();
+    ObjData stream_data;
+    ASSERT_TRUE(ParseObjStream("test_parser.obj", stream_data, control));
+    ExpectSameData(stream_data, published);
+}
+
+TEST_F(ObjParserTest, ParallelResolvesRelativeIndicesPerLine) {
+    std::ofstream file("test_relative.obj");
+    for (int i = 0; i < 200; ++i) {
+        file << "v " << i << " 0 0\n";
+        file << "f -1 -2 -3\n";
+    }
+    file.close();
+
+    ObjData serial_data;
+    ObjData parallel_data;
+    ASSERT_TRUE(ParseObjMapped("test_relative.obj", serial_data, 1));
+    ASSERT_TRUE(ParseObjMapped("test_relative.obj", parallel_data, 4, 64));
+    ExpectSameData(serial_data, parallel_data);
+
+    ASSERT_EQ(parallel_data.faces.size(), 199);
+    EXPECT_EQ(Indices(parallel_data.faces[0]), (std::vector<int>{1, 0}));
+    EXPECT_EQ(Indices(parallel_data.faces[150]),
+              (std::vector<int>{151, 150, 149}));
+
+    std::remove("test_relative.obj");
+}
+
+TEST_F(ObjParserTest, WarningCallbackReplacesStderr) {
+    std::vector<std::string> mapped_warnings;
+    std::vector<std::string> stream_warnings;
+    ParseControl control;
+    control.on_warning = [&](int line_number, const std::string& message) {
+        mapped_warnings.push_back(std::to_string(line_number) + " " + message);
+    };
+    ObjData mapped_data;
+    testing::internal::CaptureStderr();
+    ASSERT_TRUE(ParseObjMapped("test_parser.obj", mapped_data, 4, 16,
+                               control));
+    EXPECT_EQ(testing::internal::GetCapturedStderr(), "");
+
+    control.on_warning = [&](int line_number, const std::string& message) {
+        stream_warnings.push_back(std::to_string(line_number) + " " + message);
+    };
+    ObjData stream_data;
+    ASSERT_TRUE(ParseObjStream("test_parser.obj", stream_data, control));
+
+    ASSERT_FALSE(mapped_warnings.empty());
+    EXPECT_EQ(mapped_warnings.front(), "8 incorrect vertex data");
+    EXPECT_EQ(mapped_warnings, stream_warnings);
+}
+
+TEST_F(ObjParserTest, ModelBackendsAgree) {
+    Model stream_model;
+    Model mapped_model;
+    LoadOptions options;
+    options.backend = ObjBackend::kStream;
+    ASSERT_TRUE(stream_model.LoadFromFile("test_parser.obj", options));
+    ASSERT_TRUE(mapped_model.LoadFromFile("test_parser.obj"));
+    EXPECT_EQ(stream_model.GetVertexCount(), mapped_model.GetVertexCount());
+    EXPECT_EQ(stream_model.GetFaces().size(), mapped_model.GetFaces().size());
+    EXPECT_EQ(stream_model.GetEdgeCount(), mapped_model.GetEdgeCount());
+}
+
+}  // namespace
+}  // namespace viewer3d
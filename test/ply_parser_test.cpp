@@ -0,0 +1,265 @@
+#include "model/ply_parser.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace viewer3d {
+namespace {
+
+class PlyParserTest : public ::testing::Test {
+   protected:
+    void TearDown() override { std::remove("test_parser.ply"); }
+
+    static void Write(const std::string& contents) {
+        std::ofstream file("test_parser.ply", std::ios::binary);
+        file << contents;
+    }
+
+    template <typename T>
+    static void Append(std::string& out, T value, bool big_endian = false) {
+        char bytes[sizeof(T)];
+        std::memcpy(bytes, &value, sizeof(T));
+        if (big_endian) {
+            std::reverse(bytes, bytes + sizeof(T));
+        }
+        out.append(bytes, sizeof(T));
+    }
+
+    static std::vector<int> Indices(FaceView face) {
+        return std::vector<int>(face.begin(), face.end());
+    }
+
+    static void ExpectSquare(const ObjData& data) {
+        ASSERT_EQ(data.vertices.size(), 4u);
+        EXPECT_FLOAT_EQ(data.vertices[1].x, 1.0f);
+        EXPECT_FLOAT_EQ(data.vertices[2].y, 1.0f);
+        EXPECT_FLOAT_EQ(data.vertices[3].z, -0.5f);
+        ASSERT_EQ(data.faces.size(), 2u);
+        EXPECT_EQ(Indices(data.faces[0]), (std::vector<int>{0, 1, 2}));
+        EXPECT_EQ(Indices(data.faces[1]), (std::vector<int>{0, 2, 3}));
+    }
+
+    static const float kSquare[4][3];
+};
+
+const float PlyParserTest::kSquare[4][3] = {
+    {0.0f, 0.0f, 0.0f}, {1.0f, 0.0f, 0.0f}, {1.0f, 1.0f, 0.0f},
+    {0.0f, 1.0f, -0.5f}};
+
+TEST_F(PlyParserTest, ParsesAscii) {
+    Write(
+        "ply\n"
+        "format ascii 1.0\n"
+        "comment made by hand\n"
+        "element vertex 4\n"
+        "property float x\n"
+        "property float y\n"
+        "property float z\n"
+        "element face 2\n"
+        "property list uchar int vertex_indices\n"
+        "end_header\n"
+        "0 0 0\n"
+        "1 0 0\n"
+        "1 1 0\r\n"
+        "0 1 -0.5\n"
+        "3 0 1 2\n"
+        "\n"
+        "3 0 2 3\n");
+    ObjData data;
+    ASSERT_TRUE(ParsePly("test_parser.ply", data));
+    ExpectSquare(data);
+}
+
+TEST_F(PlyParserTest, ParsesBinaryLittleEndian) {
+    std::string file =
+        "ply\r\n"
+        "format binary_little_endian 1.0\r\n"
+        "element vertex 4\r\n"
+        "property float x\r\n"
+        "property float y\r\n"
+        "property float z\r\n"
+        "element face 2\r\n"
+        "property list uchar int vertex_indices\r\n"
+        "end_header\r\n";
+    for (const auto& vertex : kSquare) {
+        for (float value : vertex) {
+            Append(file, value);
+        }
+    }
+    for (const std::vector<int>& face : {std::vector<int>{0, 1, 2},
+                                         std::vector<int>{0, 2, 3}}) {
+        Append(file, static_cast<std::uint8_t>(face.size()));
+        for (int index : face) {
+            Append(file, index);
+        }
+    }
+    Write(file);
+    ObjData data;
+    ASSERT_TRUE(ParsePly("test_parser.ply", data));
+    ExpectSquare(data);
+}
+
+TEST_F(PlyParserTest, ParsesBigEndianWithExtraProperties) {
+    std::string file =
+        "ply\n"
+        "format binary_big_endian 1.0\n"
+        "obj_info scanner output\n"
+        "element vertex 4\n"
+        "property double z\n"
+        "property uchar red\n"
+        "property double x\n"
+        "property list uchar short texcoords\n"
+        "property double y\n"
+        "element face 2\n"
+        "property uchar flags\n"
+        "property list ushort uint vertex_index\n"
+        "property float quality\n"
+        "element camera 1\n"
+        "property float focal\n"
+        "end_header\n";
+    for (const auto& vertex : kSquare) {
+        Append(file, static_cast<double>(vertex[2]), true);
+        Append(file, std::uint8_t{200}, true);
+        Append(file, static_cast<double>(vertex[0]), true);
+        Append(file, std::uint8_t{2}, true);
+        Append(file, std::int16_t{7}, true);
+        Append(file, std::int16_t{8}, true);
+        Append(file, static_cast<double>(vertex[1]), true);
+    }
+    for (const std::vector<std::uint32_t>& face :
+         {std::vector<std::uint32_t>{0, 1, 2},
+          std::vector<std::uint32_t>{0, 2, 3}}) {
+        Append(file, std::uint8_t{1}, true);
+        Append(file, static_cast<std::uint16_t>(face.size()), true);
+        for (std::uint32_t index : face) {
+            Append(file, index, true);
+        }
+        Append(file, 0.5f, true);
+    }
+    Append(file, 35.0f, true);
+    Write(file);
+    ObjData data;
+    ASSERT_TRUE(ParsePly("test_parser.ply", data));
+    ExpectSquare(data);
+}
+
+TEST_F(PlyParserTest, DropsOutOfRangeIndices) {
+    Write(
+        "ply\n"
+        "format ascii 1.0\n"
+        "element vertex 3\n"
+        "property float x\n"
+        "property float y\n"
+        "property float z\n"
+        "element face 3\n"
+        "property list uchar int vertex_indices\n"
+        "end_header\n"
+        "0 0 0\n"
+        "1 0 0\n"
+        "a 1 0\n"
+        "4 0 1 3 2\n"
+        "3 0 -1 7\n"
+        "3 0 1\n");
+    std::vector<std::pair<int, std::string>> warnings;
+    ParseControl control;
+    control.on_warning = [&](int line, const std::string& message) {
+        warnings.emplace_back(line, message);
+    };
+    ObjData data;
+    ASSERT_TRUE(ParsePly("test_parser.ply", data, control));
+
+    ASSERT_EQ(data.vertices.size(), 3u);
+    EXPECT_EQ(data.vertices[2].x, 0.0f);
+    ASSERT_EQ(data.faces.size(), 2u);
+    EXPECT_EQ(Indices(data.faces[0]), (std::vector<int>{0, 1, 2}));
+    EXPECT_EQ(Indices(data.faces[1]), (std::vector<int>{0, 1}));
+    const std::vector<std::pair<int, std::string>> expected = {
+        {12, "incorrect vertex data"},
+        {13, "the index of the vertex is out of range"},
+        {14, "the index of the vertex is out of range"},
+        {14, "the index of the vertex is out of range"},
+        {15, "incorrect vertex index"}};
+    EXPECT_EQ(warnings, expected);
+}
+
+TEST_F(PlyParserTest, NumbersBinaryWarningsByFace) {
+    std::string file =
+        "ply\n"
+        "format binary_little_endian 1.0\n"
+        "element vertex 3\n"
+        "property float x\n"
+        "property float y\n"
+        "property float z\n"
+        "element face 2\n"
+        "property list uchar int vertex_indices\n"
+        "end_header\n";
+    for (int i = 0; i < 9; ++i) {
+        Append(file, static_cast<float>(i));
+    }
+    for (int index : {3, 0, 1, 2, 3, 0, 1, 9}) {
+        if (index == 3) {
+            Append(file, std::uint8_t{3});
+        } else {
+            Append(file, index);
+        }
+    }
+    Write(file);
+    std::vector<int> rows;
+    ParseControl control;
+    control.on_warning = [&](int row, const std::string&) {
+        rows.push_back(row);
+    };
+    ObjData data;
+    ASSERT_TRUE(ParsePly("test_parser.ply", data, control));
+    EXPECT_EQ(data.faces.size(), 2u);
+    EXPECT_EQ(Indices(data.faces[1]), (std::vector<int>{0, 1}));
+    EXPECT_EQ(rows, std::vector<int>{2});
+}
+
+TEST_F(PlyParserTest, RejectsMalformedFiles) {
+    ObjData data;
+    EXPECT_FALSE(ParsePly("nonexistent_file.ply", data));
+
+    Write("ply\nformat ascii 1.0\nelement vertex 1\nproperty float x\n");
+    EXPECT_FALSE(ParsePly("test_parser.ply", data));
+
+    Write("ply\nformat ascii 1.0\nelement vertex 1\nproperty float x\n"
+          "end_header\n1\n");
+    EXPECT_FALSE(ParsePly("test_parser.ply", data));
+
+    Write("ply\nformat binary_little_endian 1.0\nelement vertex 2\n"
+          "property float x\nproperty float y\nproperty float z\n"
+          "end_header\n" + std::string(12, '\0'));
+    EXPECT_FALSE(ParsePly("test_parser.ply", data));
+}
+
+TEST_F(PlyParserTest, PublishesOneBatchAndStopsWhenCancelled) {
+    Write("ply\nformat ascii 1.0\nelement vertex 1\nproperty float x\n"
+          "property float y\nproperty float z\nend_header\n1 2 3\n");
+    int batches = 0;
+    ParseControl control;
+    control.on_batch = [&](const std::vector<Vertex>& vertices,
+                           const FaceList&) {
+        batches++;
+        EXPECT_EQ(vertices.size(), 1u);
+    };
+    ObjData data;
+    ASSERT_TRUE(ParsePly("test_parser.ply", data, control));
+    EXPECT_EQ(batches, 1);
+
+    std::atomic<bool> cancel{true};
+    control.cancel = &cancel;
+    ObjData cancelled;
+    EXPECT_FALSE(ParsePly("test_parser.ply", cancelled, control));
+}
+
+}  // namespace
+}  // namespace viewer3d
\ No newline at end of file
@@ -0,0 +1,178 @@
+#include "model/stl_parser.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace viewer3d {
+namespace {
+
+class StlParserTest : public ::testing::Test {
+   protected:
+    void TearDown() override { std::remove("test_parser.stl"); }
+
+    static void Write(const std::string& contents) {
+        std::ofstream file("test_parser.stl", std::ios::binary);
+        file << contents;
+    }
+
+    // Two triangles of a unit square sharing the diagonal 0-2.
+    static std::string BinarySquare(const std::string& header) {
+        const float triangles[2][3][3] = {
+            {{0, 0, 0}, {1, 0, 0}, {1, 1, 0}},
+            {{-0.0f, 0, 0}, {1, 1, 0}, {0, 1, 0}}};
+        std::string file = header;
+        file.resize(80, ' ');
+        const std::uint32_t count = 2;
+        file.append(reinterpret_cast<const char*>(&count), sizeof(count));
+        for (const auto& triangle : triangles) {
+            const float normal[3] = {0, 0, 1};
+            file.append(reinterpret_cast<const char*>(normal), sizeof(normal));
+            file.append(reinterpret_cast<const char*>(triangle),
+                        sizeof(triangle));
+            file.append(2, '\0');
+        }
+        return file;
+    }
+
+    static std::vector<int> Indices(FaceView face) {
+        return std::vector<int>(face.begin(), face.end());
+    }
+
+    static void ExpectWeldedSquare(const ObjData& data) {
+        ASSERT_EQ(data.vertices.size(), 4u);
+        EXPECT_EQ(data.vertices[2].x, 1.0f);
+        EXPECT_EQ(data.vertices[2].y, 1.0f);
+        EXPECT_EQ(data.vertices[3].y, 1.0f);
+        ASSERT_EQ(data.faces.size(), 2u);
+        EXPECT_EQ(Indices(data.faces[0]), (std::vector<int>{0, 1, 2}));
+        EXPECT_EQ(Indices(data.faces[1]), (std::vector<int>{0, 2, 3}));
+    }
+};
+
+TEST_F(StlParserTest, WeldsBinaryTriangles) {
+    Write(BinarySquare("binary"));
+    ObjData data;
+    ASSERT_TRUE(ParseStl("test_parser.stl", data));
+    ExpectWeldedSquare(data);
+}
+
+TEST_F(StlParserTest, BinaryHeaderMayStartWithSolid) {
+    Write(BinarySquare("solid square"));
+    ObjData data;
+    ASSERT_TRUE(ParseStl("test_parser.stl", data));
+    ExpectWeldedSquare(data);
+}
+
+TEST_F(StlParserTest, WeldsAsciiTriangles) {
+    Write(
+        "solid square\n"
+        "  facet normal 0 0 1\n"
+        "    outer loop\n"
+        "      vertex 0 0 0\n"
+        "      vertex 1 0 0\n"
+        "      vertex 1 1 0\n"
+        "    endloop\n"
+        "  endfacet\n"
+        "  facet normal 0 0 1\r\n"
+        "    outer loop\r\n"
+        "      vertex -0 0 0\r\n"
+        "      vertex 1.0 1e0 0\r\n"
+        "      vertex 0 1 0\r\n"
+        "    endloop\r\n"
+        "  endfacet\r\n"
+        "endsolid square\n");
+    ObjData data;
+    ASSERT_TRUE(ParseStl("test_parser.stl", data));
+    ExpectWeldedSquare(data);
+}
+
+TEST_F(StlParserTest, DropsAsciiFacetsWithBadVertices) {
+    Write(
+        "solid\n"
+        "facet normal 0 0 1\n"
+        "outer loop\n"
+        "vertex 0 0 0\n"
+        "vertex 1 zero 0\n"
+        "vertex 1 1 0\n"
+        "endloop\n"
+        "endfacet\n"
+        "facet normal 0 0 1\n"
+        "outer loop\n"
+        "vertex 0 0 0\n"
+        "vertex 1 1 0\n"
+        "vertex 0 1 0\n"
+        "endloop\n"
+        "endfacet\n"
+        "endsolid\n");
+    std::vector<std::pair<int, std::string>> warnings;
+    ParseControl control;
+    control.on_warning = [&](int line, const std::string& message) {
+        warnings.emplace_back(line, message);
+    };
+    ObjData data;
+    ASSERT_TRUE(ParseStl("test_parser.stl", data, control));
+    EXPECT_EQ(data.vertices.size(), 3u);
+    ASSERT_EQ(data.faces.size(), 1u);
+    EXPECT_EQ(Indices(data.faces[0]), (std::vector<int>{0, 1, 2}));
+    const std::vector<std::pair<int, std::string>> expected = {
+        {5, "incorrect vertex data"}};
+    EXPECT_EQ(warnings, expected);
+}
+
+TEST_F(StlParserTest, WeldsManyVertices) {
+    // A grid of quads forces the welder to grow past its initial estimate.
+    constexpr int kSide = 100;
+    std::string file(80, ' ');
+    const std::uint32_t count = 2 * kSide * kSide;
+    file.append(reinterpret_cast<const char*>(&count), sizeof(count));
+    auto corner = [](int x, int y) {
+        return std::vector<float>{static_cast<float>(x),
+                                  static_cast<float>(y), 0.0f};
+    };
+    for (int y = 0; y < kSide; ++y) {
+        for (int x = 0; x < kSide; ++x) {
+            for (const auto& triangle :
+                 {std::vector<std::vector<float>>{corner(x, y),
+                                                  corner(x + 1, y),
+                                                  corner(x + 1, y + 1)},
+                  std::vector<std::vector<float>>{
+                      corner(x, y), corner(x + 1, y + 1), corner(x, y + 1)}}) {
+                file.append(12, '\0');
+                for (const auto& position : triangle) {
+                    file.append(reinterpret_cast<const char*>(position.data()),
+                                3 * sizeof(float));
+                }
+                file.append(2, '\0');
+            }
+        }
+    }
+    Write(file);
+    ObjData data;
+    ASSERT_TRUE(ParseStl("test_parser.stl", data));
+    EXPECT_EQ(data.vertices.size(),
+              static_cast<size_t>((kSide + 1) * (kSide + 1)));
+    EXPECT_EQ(data.faces.size(), count);
+    EXPECT_EQ(data.faces.IndexCount(), 3u * count);
+}
+
+TEST_F(StlParserTest, RejectsTruncatedBinaryFiles) {
+    ObjData data;
+    EXPECT_FALSE(ParseStl("nonexistent_file.stl", data));
+
+    std::string file = BinarySquare("binary");
+    file.resize(file.size() - 10);
+    Write(file);
+    EXPECT_FALSE(ParseStl("test_parser.stl", data));
+
+    Write("tiny");
+    EXPECT_FALSE(ParseStl("test_parser.stl", data));
+}
+
+}  // namespace
+}  // namespace viewer3d
\ No newline at end of file
@@ -0,0 +1,135 @@
+#include "model/trace.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include "model/model.hpp"
+
+namespace viewer3d {
+namespace {
+
+class TraceTest : public ::testing::Test {
+   protected:
+    void SetUp() override {
+        std::ofstream model(kModelFile);
+        model << "v 0 0 0\nv 1 0 0\nv 0 1 0\nf 1 2 3\n";
+    }
+
+    void TearDown() override {
+        trace::Stop();
+        std::remove(kTraceFile);
+        std::remove(kModelFile);
+    }
+
+    static std::string WriteAndRead() {
+        EXPECT_TRUE(trace::WriteChromeTrace(kTraceFile));
+        std::ifstream file(kTraceFile);
+        std::ostringstream contents;
+        contents << file.rdbuf();
+        return contents.str();
+    }
+
+    static std::size_t Count(const std::string& text,
+                             const std::string& part) {
+        std::size_t count = 0;
+        for (std::size_t pos = text.find(part); pos != std::string::npos;
+             pos = text.find(part, pos + 1)) {
+            ++count;
+        }
+        return count;
+    }
+
+    static constexpr const char* kTraceFile = "test_trace.json";
+    static constexpr const char* kModelFile = "test_trace_model.obj";
+};
+
+TEST_F(TraceTest, PhaseScopeRecordsDurations) {
+    PhaseTimings phases;
+    {
+        PhaseScope first(phases, "first");
+    }
+    {
+        PhaseScope second(phases, "second");
+    }
+    ASSERT_EQ(phases.size(), 2);
+    EXPECT_STREQ(phases[0].name, "first");
+    EXPECT_STREQ(phases[1].name, "second");
+    EXPECT_GE(phases[0].ms, 0.0);
+}
+
+TEST_F(TraceTest, ModelReportsLoadAndTransformPhases) {
+    Model model;
+    ASSERT_TRUE(model.LoadFromFile(kModelFile));
+    std::string names;
+    for (const PhaseTiming& phase : model.GetLastPhases()) {
+        names += std::string(phase.name) + ";";
+    }
+    EXPECT_EQ(names, "parse;edges;bounds;clusters;");
+
+    model.Translate(1.0f, 0.0f, 0.0f);
+    EXPECT_TRUE(model.GetLastPhases().empty());
+    model.GetVertices();
+    ASSERT_EQ(model.GetLastPhases().size(), 1);
+    EXPECT_STREQ(model.GetLastPhases()[0].name, "transform");
+}
+
+#if VIEWER3D_TRACING
+
+TEST_F(TraceTest, ZonesAreRecordedOnlyWhileRecording) {
+    {
+        VIEWER3D_TRACE_ZONE("before");
+    }
+    ASSERT_TRUE(trace::Start());
+    {
+        VIEWER3D_TRACE_ZONE("outer");
+        VIEWER3D_TRACE_ZONE("inner");
+    }
+    std::thread worker([] { VIEWER3D_TRACE_ZONE("worker"); });
+    worker.join();
+    trace::Stop();
+    {
+        VIEWER3D_TRACE_ZONE("after");
+    }
+
+    const std::string json = WriteAndRead();
+    EXPECT_EQ(json.find("\"before\""), std::string::npos);
+    EXPECT_EQ(json.find("\"after\""), std::string::npos);
+    EXPECT_EQ(Count(json, "\"ph\":\"X\""), 3);
+    EXPECT_NE(json.find("\"name\":\"outer\""), std::string::npos);
+    EXPECT_NE(json.find("\"name\":\"worker\""), std::string::npos);
+    EXPECT_NE(json.find("\"dropped_events\":0"), std::string::npos);
+}
+
+TEST_F(TraceTest, RingKeepsTheNewestEvents) {
+    ASSERT_TRUE(trace::Start());
+    for (std::size_t i = 0; i < trace::kRingCapacity + 10; ++i) {
+        VIEWER3D_TRACE_ZONE("zone");
+    }
+    const std::string json = WriteAndRead();
+    EXPECT_EQ(Count(json, "\"name\":\"zone\""), trace::kRingCapacity);
+    EXPECT_NE(json.find("\"dropped_events\":10"), std::string::npos);
+
+    // Start() clears the previous recording.
+    ASSERT_TRUE(trace::Start());
+    EXPECT_EQ(Count(WriteAndRead(), "\"name\":\"zone\""), 0);
+}
+
+TEST_F(TraceTest, LoadIsTraced) {
+    ASSERT_TRUE(trace::Start());
+    Model model;
+    ASSERT_TRUE(model.LoadFromFile(kModelFile));
+    const std::string json = WriteAndRead();
+    EXPECT_NE(json.find("\"Model::LoadFromFile\""), std::string::npos);
+    EXPECT_NE(json.find("\"parse\""), std::string::npos);
+    EXPECT_NE(json.find("\"EdgeList::Build\""), std::string::npos);
+}
+
+#endif
+
+}  // namespace
+}  // namespace viewer3d
\ No newline at end of file
@@ -0,0 +1,229 @@
+#include "model/transform_kernel.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <vector>
+
+namespace viewer3d {
+namespace {
+
+constexpr float kTolerance = 1e-4f;
+
+// The sequential scale / rotate / translate passes the kernel replaces.
+Vertex ReferenceTransform(Vertex v, float tx, float ty, float tz, float rx,
+                          float ry, float rz, float scale) {
+    const float deg_to_rad = M_PI / 180.0f;
+    v.x *= scale;
+    v.y *= scale;
+    v.z *= scale;
+
+    float y1 =
+        v.y * std::cos(rx * deg_to_rad) - v.z * std::sin(rx * deg_to_rad);
+    float z1 =
+        v.y * std::sin(rx * deg_to_rad) + v.z * std::cos(rx * deg_to_rad);
+    v.y = y1;
+    v.z = z1;
+
+    float x2 =
+        v.x * std::cos(ry * deg_to_rad) + v.z * std::sin(ry * deg_to_rad);
+    float z2 =
+        -v.x * std::sin(ry * deg_to_rad) + v.z * std::cos(ry * deg_to_rad);
+    v.x = x2;
+    v.z = z2;
+
+    float x3 =
+        v.x * std::cos(rz * deg_to_rad) - v.y * std::sin(rz * deg_to_rad);
+    float y3 =
+        v.x * std::sin(rz * deg_to_rad) + v.y * std::cos(rz * deg_to_rad);
+    v.x = x3;
+    v.y = y3;
+
+    v.x += tx;
+    v.y += ty;
+    v.z += tz;
+    return v;
+}
+
+std::vector<Vertex> MakeVertices(std::size_t count) {
+    std::vector<Vertex> vertices(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        vertices[i].x = std::sin(i * 0.37f) * 3.0f;
+        vertices[i].y = std::cos(i * 0.11f) * 2.0f - 1.0f;
+        vertices[i].z = static_cast<float>(i % 7) - 3.0f;
+    }
+    return vertices;
+}
+
+class TransformKernelTest : public ::testing::TestWithParam<TransformIsa> {};
+
+TEST_P(TransformKernelTest, MatchesReferenceForEveryCombination) {
+    const TransformIsa isa = GetParam();
+    if (!IsTransformIsaSupported(isa)) {
+        GTEST_SKIP() << "instruction set not supported by this CPU";
+    }
+
+    for (int combination = 0; combination < 8; ++combination) {
+        const float scale = (combination & 1) ? 2.5f : 1.0f;
+        const float rx = (combination & 2) ? 30.0f : 0.0f;
+        const float ry = (combination & 2) ? -45.0f : 0.0f;
+        const float rz = (combination & 2) ? 90.0f : 0.0f;
+        const float t = (combination & 4) ? 1.5f : 0.0f;
+        const VertexTransform transform =
+            VertexTransform::Make(t, -t, 2.0f * t, rx, ry, rz, scale);
+
+        for (std::size_t count : {0u, 1u, 3u, 4u, 5u, 8u, 9u, 17u, 100u}) {
+            std::vector<Vertex> vertices = MakeVertices(count);
+            PositionsSoA source;
+            source.Assign(vertices);
+
+            std::vector<Vertex> out(count + 1);
+            out[count] = Vertex{-7.0f, -7.0f, -7.0f};
+            TransformVertices(source, 0, count, transform, out.data(), isa);
+
+            for (std::size_t i = 0; i < count; ++i) {
+                Vertex expected = ReferenceTransform(vertices[i], t, -t,
+                                                     2.0f * t, rx, ry, rz,
+                                                     scale);
+                EXPECT_NEAR(out[i].x, expected.x, kTolerance);
+                EXPECT_NEAR(out[i].y, expected.y, kTolerance);
+                EXPECT_NEAR(out[i].z, expected.z, kTolerance);
+            }
+            EXPECT_EQ(out[count].x, -7.0f);
+        }
+    }
+}
+
+TEST_P(TransformKernelTest, WritesOnlyTheRequestedRange) {
+    const TransformIsa isa = GetParam();
+    if (!IsTransformIsaSupported(isa)) {
+        GTEST_SKIP() << "instruction set not supported by this CPU";
+    }
+
+    std::vector<Vertex> vertices = MakeVertices(64);
+    PositionsSoA source;
+    source.Assign(vertices);
+    const VertexTransform transform =
+        VertexTransform::Make(1.0f, 2.0f, 3.0f, 10.0f, 20.0f, 30.0f, 2.0f);
+
+    std::vector<Vertex> out(64, Vertex{-7.0f, -7.0f, -7.0f});
+    TransformVertices(source, 5, 29, transform, out.data(), isa);
+
+    for (std::size_t i = 0; i < out.size(); ++i) {
+        if (i >= 5 && i < 29) {
+            Vertex expected = ReferenceTransform(vertices[i], 1.0f, 2.0f, 3.0f,
+                                                 10.0f, 20.0f, 30.0f, 2.0f);
+            EXPECT_NEAR(out[i].x, expected.x, kTolerance);
+        } else {
+            EXPECT_EQ(out[i].x, -7.0f);
+            EXPECT_EQ(out[i].y, -7.0f);
+            EXPECT_EQ(out[i].z, -7.0f);
+        }
+    }
+}
+
+// Decoding is folded into the transform, so the result matches
+// transforming the decoded positions.
+TEST_P(TransformKernelTest, QuantizedMatchesDecodedPositions) {
+    const TransformIsa isa = GetParam();
+    if (!IsTransformIsaSupported(isa)) {
+        GTEST_SKIP() << "instruction set not supported by this CPU";
+    }
+
+    const VertexTransform transform =
+        VertexTransform::Make(1.5f, -1.5f, 3.0f, 30.0f, -45.0f, 90.0f, 2.5f);
+    for (std::size_t count : {0u, 1u, 3u, 4u, 5u, 8u, 9u, 17u, 100u}) {
+        PositionsSoA positions;
+        positions.Assign(MakeVertices(count));
+        QuantizedPositions quantized;
+        quantized.Encode(positions, {-3.0f, -3.0f, -3.0f}, {3.0f, 1.0f, 3.0f});
+        PositionsSoA decoded;
+        quantized.Decode(decoded);
+
+        std::vector<Vertex> expected(count + 1);
+        TransformVertices(decoded, 0, count, transform, expected.data(),
+                          TransformIsa::kScalar);
+        std::vector<Vertex> out(count + 1);
+        out[count] = Vertex{-7.0f, -7.0f, -7.0f};
+        TransformVertices(quantized, 0, count, transform, out.data(), isa);
+
+        for (std::size_t i = 0; i < count; ++i) {
+            EXPECT_NEAR(out[i].x, expected[i].x, kTolerance);
+            EXPECT_NEAR(out[i].y, expected[i].y, kTolerance);
+            EXPECT_NEAR(out[i].z, expected[i].z, kTolerance);
+        }
+        EXPECT_EQ(out[count].x, -7.0f);
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(AllIsas, TransformKernelTest,
+                         ::testing::Values(TransformIsa::kScalar,
+                                           TransformIsa::kSse2,
+                                           TransformIsa::kAvx2));
+
+TEST(VertexTransformTest, Flags) {
+    VertexTransform identity =
+        VertexTransform::Make(0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f);
+    EXPECT_FALSE(identity.has_scale);
+    EXPECT_FALSE(identity.has_rotation);
+    EXPECT_FALSE(identity.has_translation);
+
+    VertexTransform full =
+        VertexTransform::Make(1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 5.0f, 2.0f);
+    EXPECT_TRUE(full.has_scale);
+    EXPECT_TRUE(full.has_rotation);
+    EXPECT_TRUE(full.has_translation);
+}
+
+TEST(QuantizedPositionsTest, ErrorStaysWithinHalfAStep) {
+    PositionsSoA positions;
+    positions.Assign(MakeVertices(1000));
+    QuantizedPositions quantized;
+    quantized.Encode(positions, {-3.0f, -3.0f, -3.0f}, {3.0f, 1.0f, 3.0f});
+    ASSERT_EQ(quantized.size(), 1000);
+    EXPECT_EQ(quantized.MemoryBytes(), 1000 * 3 * sizeof(std::uint16_t));
+
+    const QuantizationError error = quantized.MeasureError(positions);
+    EXPECT_NEAR(error.bound,
+                0.5f * std::sqrt(2 * std::pow(6.0f / 65535.0f, 2.0f) +
+                                 std::pow(4.0f / 65535.0f, 2.0f)),
+                1e-7f);
+    EXPECT_GT(error.max, 0.0f);
+    EXPECT_LE(error.max, error.bound * 1.001f);
+    EXPECT_LE(error.rms, error.max);
+
+    // A flat axis has no grid and decodes exactly.
+    PositionsSoA flat;
+    flat.Assign({{0.0f, 2.0f, 0.0f}, {1.0f, 2.0f, 0.5f}});
+    quantized.Encode(flat, {0.0f, 2.0f, 0.0f}, {1.0f, 2.0f, 0.5f});
+    EXPECT_EQ(quantized.Decode(1).y, 2.0f);
+    EXPECT_EQ(quantized.Decode(1).x, 1.0f);
+    EXPECT_EQ(quantized.Decode(0).z, 0.0f);
+}
+
+TEST(QuantizedPositionsTest, DecodeMatrixMatchesDecode) {
+    PositionsSoA positions;
+    positions.Assign(MakeVertices(10));
+    QuantizedPositions quantized;
+    quantized.Encode(positions, {-3.0f, -3.0f, -3.0f}, {3.0f, 1.0f, 3.0f});
+
+    const std::array<float, 16> m = quantized.DecodeMatrix();
+    for (std::size_t i = 0; i < quantized.size(); ++i) {
+        const float q[3] = {static_cast<float>(quantized.x[i]),
+                            static_cast<float>(quantized.y[i]),
+                            static_cast<float>(quantized.z[i])};
+        const Vertex v = quantized.Decode(i);
+        EXPECT_FLOAT_EQ(m[0] * q[0] + m[1] * q[1] + m[2] * q[2] + m[3], v.x);
+        EXPECT_FLOAT_EQ(m[4] * q[0] + m[5] * q[1] + m[6] * q[2] + m[7], v.y);
+        EXPECT_FLOAT_EQ(m[8] * q[0] + m[9] * q[1] + m[10] * q[2] + m[11],
+                        v.z);
+    }
+    EXPECT_EQ(m[15], 1.0f);
+}
+
+TEST(VertexTransformTest, BestIsaIsSupported) {
+    EXPECT_TRUE(IsTransformIsaSupported(BestTransformIsa()));
+}
+
+}  // namespace
+}  // namespace viewer3d
\ No newline at end of file
@@ -0,0 +1,100 @@
+#include "controller/transform_scheduler.hpp"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+
+#include "model/model.hpp"
+
+namespace viewer3d {
+namespace {
+
+using std::chrono::milliseconds;
+
+constexpr const char* kModelFile = "test_scheduler.obj";
+
+class TransformSchedulerTest : public ::testing::Test {
+   protected:
+    void SetUp() override {
+        std::ofstream file(kModelFile);
+        file << "v 1 0 0\nv 0 1 0\nv 0 0 1\nf 1 2 3\n";
+        file.close();
+        ASSERT_TRUE(controller_.LoadModel(kModelFile));
+    }
+
+    void TearDown() override { std::remove(kModelFile); }
+
+    Model model_;
+    Controller controller_{model_};
+    TransformScheduler scheduler_{controller_};
+    TransformScheduler::Clock::time_point start_;
+};
+
+TransformParams Translation(float x) {
+    TransformParams params;
+    params.translate = {x, 0.0f, 0.0f};
+    return params;
+}
+
+TEST_F(TransformSchedulerTest, FlushWithoutRequestsDoesNothing) {
+    const std::uint64_t revision = controller_.GetTransformRevision();
+    EXPECT_FALSE(scheduler_.Flush());
+    EXPECT_FALSE(scheduler_.HasPending());
+    EXPECT_EQ(controller_.GetTransformRevision(), revision);
+    EXPECT_EQ(scheduler_.GetStats().applied, 0);
+}
+
+TEST_F(TransformSchedulerTest, AppliesOnlyTheLastRequestOfAFrame) {
+    EXPECT_TRUE(scheduler_.Request(Translation(1.0f), start_));
+    for (int i = 2; i <= 100; ++i) {
+        EXPECT_FALSE(scheduler_.Request(Translation(i), start_));
+    }
+    EXPECT_TRUE(scheduler_.HasPending());
+    EXPECT_TRUE(scheduler_.Flush(start_ + milliseconds(10)));
+    EXPECT_FALSE(scheduler_.HasPending());
+
+    EXPECT_NEAR(controller_.GetVertices()[0].x, 101.0f, 1e-4f);
+    EXPECT_EQ(model_.GetMaterializationCount(), 1);
+    const TransformSchedulerStats& stats = scheduler_.GetStats();
+    EXPECT_EQ(stats.requests, 100);
+    EXPECT_EQ(stats.coalesced, 99);
+    EXPECT_EQ(stats.applied, 1);
+    EXPECT_EQ(stats.dropped_frames, 0);
+
+    // The next request needs a new frame.
+    EXPECT_TRUE(scheduler_.Request(Translation(2.0f), start_));
+}
+
+TEST_F(TransformSchedulerTest, CountsRefreshesAnUpdateWaitedFor) {
+    scheduler_.SetFrameInterval(milliseconds(10));
+    scheduler_.Request(Translation(1.0f), start_);
+    scheduler_.Flush(start_ + milliseconds(35));
+    EXPECT_EQ(scheduler_.GetStats().dropped_frames, 3);
+
+    scheduler_.ResetStats();
+    EXPECT_EQ(scheduler_.GetStats().requests, 0);
+    EXPECT_EQ(scheduler_.GetStats().dropped_frames, 0);
+}
+
+TEST_F(TransformSchedulerTest, RejectedTransformsLeaveTheModelAlone) {
+    scheduler_.Request(Translation(1.0f));
+    scheduler_.Flush();
+    const std::uint64_t revision = controller_.GetTransformRevision();
+
+    TransformParams params;
+    params.scale = 0.01f;
+    scheduler_.Request(params);
+    EXPECT_FALSE(scheduler_.Flush());
+    EXPECT_EQ(controller_.GetTransformRevision(), revision);
+    EXPECT_EQ(scheduler_.GetStats().rejected, 1);
+    EXPECT_EQ(scheduler_.GetStats().applied, 1);
+
+    scheduler_.Request(Translation(3.0f));
+    scheduler_.Cancel();
+    EXPECT_FALSE(scheduler_.Flush());
+}
+
+}  // namespace
+}  // namespace viewer3d
\ No newline at end of file
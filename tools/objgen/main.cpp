@@ -0,0 +1,135 @@
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "obj_generator.hpp"
+
+namespace {
+
+void PrintUsage(const char* program) {
+    std::cout
+        << "Usage: " << program << " [options] <output.obj | ->\n"
+        << "Writes a deterministic synthetic OBJ mesh.\n\n"
+        << "  --vertices <n>         vertex count (default 1000)\n"
+        << "  --faces <n>            face count (default twice the vertices)\n"
+        << "  --seed <n>             random seed (default 1)\n"
+        << "  --polygons <mix>       polygon sizes and weights, e.g. "
+           "3:0.7,4:0.2,6:0.1\n"
+        << "                         (default 3:1)\n"
+        << "  --negative-ratio <r>   share of relative (negative) indices\n"
+        << "  --full-token-ratio <r> share of indices written as v/vt/vn\n"
+        << "  -h, --help             shows this help\n";
+}
+
+bool ParseCount(const char* text, std::uint64_t& value) {
+    if (*text == '\0' || *text == '-') {
+        return false;
+    }
+    char* end = nullptr;
+    errno = 0;
+    const unsigned long long parsed = std::strtoull(text, &end, 10);
+    if (errno != 0 || *end != '\0') {
+        return false;
+    }
+    value = parsed;
+    return true;
+}
+
+bool ParseRatio(const char* text, double& value) {
+    char* end = nullptr;
+    value = std::strtod(text, &end);
+    return *text != '\0' && *end == '\0';
+}
+
+// "3:0.7,4:0.2,6:0.1"
+bool ParsePolygons(const std::string& text,
+                   std::vector<viewer3d::PolygonWeight>& polygons) {
+    polygons.clear();
+    std::size_t start = 0;
+    while (start <= text.size()) {
+        std::size_t end = text.find(',', start);
+        if (end == std::string::npos) {
+            end = text.size();
+        }
+        const std::string item = text.substr(start, end - start);
+        const std::size_t colon = item.find(':');
+        std::uint64_t sides = 0;
+        double weight = 0.0;
+        if (colon == std::string::npos ||
+            !ParseCount(item.substr(0, colon).c_str(), sides) ||
+            !ParseRatio(item.c_str() + colon + 1, weight) || sides > 1000) {
+            return false;
+        }
+        polygons.push_back({static_cast<int>(sides), weight});
+        start = end + 1;
+    }
+    return true;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    viewer3d::ObjGenOptions options;
+    std::string output;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "-h" || arg == "--help") {
+            PrintUsage(argv[0]);
+            return 0;
+        }
+        if (arg.rfind("--", 0) != 0) {
+            if (!output.empty()) {
+                std::cerr << "Error: more than one output file" << std::endl;
+                return 1;
+            }
+            output = arg;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            std::cerr << "Error: " << arg << " needs a value" << std::endl;
+            return 1;
+        }
+        const char* value = argv[++i];
+        bool valid = true;
+        if (arg == "--vertices") {
+            valid = ParseCount(value, options.vertex_count);
+        } else if (arg == "--faces") {
+            valid = ParseCount(value, options.face_count);
+        } else if (arg == "--seed") {
+            valid = ParseCount(value, options.seed);
+        } else if (arg == "--polygons") {
+            valid = ParsePolygons(value, options.polygons);
+        } else if (arg == "--negative-ratio") {
+            valid = ParseRatio(value, options.negative_index_ratio);
+        } else if (arg == "--full-token-ratio") {
+            valid = ParseRatio(value, options.full_token_ratio);
+        } else {
+            std::cerr << "Error: unknown option " << arg << std::endl;
+            return 1;
+        }
+        if (!valid) {
+            std::cerr << "Error: invalid value for " << arg << ": " << value
+                      << std::endl;
+            return 1;
+        }
+    }
+
+    if (output.empty()) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+    std::string error;
+    if (!viewer3d::ValidateObjGenOptions(options, error)) {
+        std::cerr << "Error: " << error << std::endl;
+        return 1;
+    }
+
+    const bool written = output == "-"
+                             ? viewer3d::WriteGeneratedObj(stdout, options) &&
+                                   std::fflush(stdout) == 0
+                             : viewer3d::WriteGeneratedObj(output, options);
+    return written ? 0 : 1;
+}
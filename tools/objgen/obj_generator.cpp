@@ -0,0 +1,318 @@
+#include "obj_generator.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <iostream>
+#include <limits>
+
+namespace viewer3d {
+
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+constexpr double kNoiseAmplitude = 0.05;
+constexpr std::size_t kWriteBufferBytes = 1 << 20;
+
+// Seeds of the independent random streams, so that changing how indices
+// are written does not change the mesh, and the face options do not move
+// the vertices.
+constexpr std::uint64_t kVertexStream = 0x7665727469636573ull;
+constexpr std::uint64_t kFaceStream = 0x6661636573666163ull;
+constexpr std::uint64_t kTokenStream = 0x746f6b656e737472ull;
+
+// SplitMix64. Unlike the std distributions its output is specified, so the
+// files are identical across standard libraries.
+class Random {
+   public:
+    explicit Random(std::uint64_t seed) : state_(seed) {}
+
+    std::uint64_t Next() {
+        std::uint64_t z = (state_ += 0x9e3779b97f4a7c15ull);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+        return z ^ (z >> 31);
+    }
+
+    // Uniform in [0, 1).
+    double NextDouble() { return (Next() >> 11) * 0x1.0p-53; }
+
+    bool Chance(double ratio) { return ratio > 0.0 && NextDouble() < ratio; }
+
+   private:
+    std::uint64_t state_;
+};
+
+class Writer {
+   public:
+    explicit Writer(std::FILE* file) : file_(file) {
+        buffer_.reserve(kWriteBufferBytes + 256);
+    }
+
+    void Put(char c) { buffer_.push_back(c); }
+    void Put(const char* text) { buffer_.append(text); }
+
+    void Put(std::int64_t value) {
+        char digits[24];
+        const auto result =
+            std::to_chars(digits, digits + sizeof(digits), value);
+        buffer_.append(digits, result.ptr);
+    }
+
+    void Put(double value) {
+        char digits[32];
+        const auto result = std::to_chars(digits, digits + sizeof(digits),
+                                          value, std::chars_format::fixed, 6);
+        buffer_.append(digits, result.ptr);
+    }
+
+    void EndLine() {
+        buffer_.push_back('\n');
+        if (buffer_.size() >= kWriteBufferBytes) {
+            Flush();
+        }
+    }
+
+    bool Flush() {
+        if (!buffer_.empty() &&
+            std::fwrite(buffer_.data(), 1, buffer_.size(), file_) !=
+                buffer_.size()) {
+            failed_ = true;
+        }
+        buffer_.clear();
+        return !failed_;
+    }
+
+   private:
+    std::FILE* file_;
+    std::string buffer_;
+    bool failed_{false};
+};
+
+// Vertices form a grid of `columns` wrapped around a sphere, row by row.
+struct GridShape {
+    std::uint64_t columns;
+    std::uint64_t rows;
+};
+
+GridShape ComputeGrid(std::uint64_t vertex_count) {
+    GridShape grid;
+    grid.columns = static_cast<std::uint64_t>(
+        std::ceil(std::sqrt(static_cast<double>(vertex_count))));
+    grid.rows = (vertex_count + grid.columns - 1) / grid.columns;
+    return grid;
+}
+
+// A polygon spans two grid rows: ceil(sides / 2) columns in one of them and
+// the remaining vertices in the other.
+std::uint64_t PolygonSpan(int sides) { return (sides + 1) / 2; }
+
+int MaxSides(const std::vector<PolygonWeight>& polygons) {
+    int sides = 0;
+    for (const PolygonWeight& polygon : polygons) {
+        sides = std::max(sides, polygon.sides);
+    }
+    return sides;
+}
+
+void WriteVertex(Writer& writer, std::uint64_t index, const GridShape& grid,
+                 std::uint64_t seed, bool attributes) {
+    const std::uint64_t row = index / grid.columns;
+    const std::uint64_t column = index % grid.columns;
+    const double theta = kPi * (row + 0.5) / grid.rows;
+    const double phi = 2.0 * kPi * column / grid.columns;
+    const double nx = std::sin(theta) * std::cos(phi);
+    const double ny = std::cos(theta);
+    const double nz = std::sin(theta) * std::sin(phi);
+
+    Random noise(seed ^ kVertexStream ^ (index * 0x9e3779b97f4a7c15ull));
+    const double radius =
+        1.0 + kNoiseAmplitude * (2.0 * noise.NextDouble() - 1.0);
+
+    writer.Put("v ");
+    writer.Put(nx * radius);
+    writer.Put(' ');
+    writer.Put(ny * radius);
+    writer.Put(' ');
+    writer.Put(nz * radius);
+    writer.EndLine();
+    if (attributes) {
+        writer.Put("vt ");
+        writer.Put(static_cast<double>(column) / grid.columns);
+        writer.Put(' ');
+        writer.Put(theta / kPi);
+        writer.EndLine();
+        writer.Put("vn ");
+        writer.Put(nx);
+        writer.Put(' ');
+        writer.Put(ny);
+        writer.Put(' ');
+        writer.Put(nz);
+        writer.EndLine();
+    }
+}
+
+}  // namespace
+
+bool ValidateObjGenOptions(const ObjGenOptions& options, std::string& error) {
+    if (options.vertex_count == 0) {
+        error = "the vertex count must be positive";
+        return false;
+    }
+    if (options.vertex_count >
+        static_cast<std::uint64_t>(std::numeric_limits<int>::max())) {
+        error = "the vertex count must fit a 32-bit index";
+        return false;
+    }
+    if (options.polygons.empty()) {
+        error = "the polygon mix is empty";
+        return false;
+    }
+    double total_weight = 0.0;
+    for (const PolygonWeight& polygon : options.polygons) {
+        if (polygon.sides < 3 || !(polygon.weight >= 0.0)) {
+            error = "polygons need at least 3 sides and a non-negative weight";
+            return false;
+        }
+        total_weight += polygon.weight;
+    }
+    if (!(total_weight > 0.0)) {
+        error = "the polygon weights add up to zero";
+        return false;
+    }
+    if (!(options.negative_index_ratio >= 0.0 &&
+          options.negative_index_ratio <= 1.0) ||
+        !(options.full_token_ratio >= 0.0 && options.full_token_ratio <= 1.0)) {
+        error = "ratios must be between 0 and 1";
+        return false;
+    }
+    const GridShape grid = ComputeGrid(options.vertex_count);
+    const int max_sides = MaxSides(options.polygons);
+    if (grid.columns + PolygonSpan(max_sides) > options.vertex_count) {
+        error = "too few vertices for " + std::to_string(max_sides) +
+                "-sided polygons";
+        return false;
+    }
+    return true;
+}
+
+bool WriteGeneratedObj(std::FILE* file, const ObjGenOptions& options) {
+    std::string error;
+    if (!ValidateObjGenOptions(options, error)) {
+        std::cerr << "Error: " << error << std::endl;
+        return false;
+    }
+
+    const std::uint64_t vertex_count = options.vertex_count;
+    const std::uint64_t face_count =
+        options.face_count != 0 ? options.face_count : 2 * vertex_count;
+    const bool attributes = options.full_token_ratio > 0.0;
+    const GridShape grid = ComputeGrid(vertex_count);
+    // Polygons start at cells [0, cell_count) so that the widest one still
+    // ends inside the mesh.
+    const std::uint64_t cell_count =
+        vertex_count - grid.columns - PolygonSpan(MaxSides(options.polygons)) +
+        1;
+    const std::uint64_t pair_count = (face_count + 1) / 2;
+
+    std::vector<double> cumulative;
+    for (const PolygonWeight& polygon : options.polygons) {
+        cumulative.push_back(
+            (cumulative.empty() ? 0.0 : cumulative.back()) + polygon.weight);
+    }
+
+    Writer writer(file);
+    writer.Put("# objgen seed ");
+    writer.Put(static_cast<std::int64_t>(options.seed));
+    writer.EndLine();
+
+    Random random(options.seed ^ kFaceStream);
+    Random tokens(options.seed ^ kTokenStream);
+    std::uint64_t written = 0;
+    std::vector<std::uint64_t> polygon;
+    for (std::uint64_t face = 0; face < face_count; ++face) {
+        const double pick = random.NextDouble() * cumulative.back();
+        const std::size_t kind = std::min<std::size_t>(
+            std::upper_bound(cumulative.begin(), cumulative.end(), pick) -
+                cumulative.begin(),
+            cumulative.size() - 1);
+        const int sides = options.polygons[kind].sides;
+        const std::uint64_t span = PolygonSpan(sides);
+        const std::uint64_t other = sides - span;
+
+        // Faces come in pairs spread evenly over the cells.
+        const std::uint64_t base = std::min(
+            cell_count - 1,
+            static_cast<std::uint64_t>(static_cast<double>(face / 2) *
+                                           cell_count / pair_count +
+                                       0.5));
+        const std::uint64_t below = base + grid.columns;
+        // Neighbouring faces alternate which row holds the wider run, so two
+        // triangles on the same cell tile it instead of overlapping.
+        polygon.clear();
+        if (face % 2 == 0) {
+            for (std::uint64_t i = 0; i < span; ++i) {
+                polygon.push_back(base + i);
+            }
+            for (std::uint64_t i = 0; i < other; ++i) {
+                polygon.push_back(below + span - 1 - i);
+            }
+        } else {
+            for (std::uint64_t i = 0; i < other; ++i) {
+                polygon.push_back(base + i);
+            }
+            for (std::uint64_t i = 0; i < span; ++i) {
+                polygon.push_back(below + span - 1 - i);
+            }
+        }
+
+        const std::uint64_t needed = below + span;
+        while (written < needed) {
+            WriteVertex(writer, written++, grid, options.seed, attributes);
+        }
+
+        writer.Put('f');
+        for (const std::uint64_t index : polygon) {
+            const std::int64_t value =
+                tokens.Chance(options.negative_index_ratio)
+                    ? -static_cast<std::int64_t>(written - index)
+                    : static_cast<std::int64_t>(index + 1);
+            writer.Put(' ');
+            writer.Put(value);
+            if (tokens.Chance(options.full_token_ratio)) {
+                writer.Put('/');
+                writer.Put(value);
+                writer.Put('/');
+                writer.Put(value);
+            }
+        }
+        writer.EndLine();
+    }
+    while (written < vertex_count) {
+        WriteVertex(writer, written++, grid, options.seed, attributes);
+    }
+    return writer.Flush();
+}
+
+bool WriteGeneratedObj(const std::string& path, const ObjGenOptions& options) {
+    const std::string temp_path = path + ".tmp";
+    std::FILE* file = std::fopen(temp_path.c_str(), "wb");
+    if (file == nullptr) {
+        std::cerr << "Error: cannot write " << temp_path << std::endl;
+        return false;
+    }
+
+    const bool generated = WriteGeneratedObj(file, options);
+    const bool closed = std::fclose(file) == 0;
+    if (!generated || !closed ||
+        std::rename(temp_path.c_str(), path.c_str()) != 0) {
+        if (generated) {
+            std::cerr << "Error: cannot write " << path << std::endl;
+        }
+        std::remove(temp_path.c_str());
+        return false;
+    }
+    return true;
+}
+
+}  // namespace viewer3d
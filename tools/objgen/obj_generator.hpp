@@ -0,0 +1,44 @@
+#ifndef OBJ_GENERATOR_H
+#define OBJ_GENERATOR_H
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace viewer3d {
+
+struct PolygonWeight {
+    int sides;
+    double weight;
+};
+
+struct ObjGenOptions {
+    std::uint64_t vertex_count{1000};
+    // 0 writes about two faces per vertex, like a closed triangle mesh.
+    std::uint64_t face_count{0};
+    std::uint64_t seed{1};
+    // Relative frequency of each polygon size, sides >= 3.
+    std::vector<PolygonWeight> polygons{{3, 1.0}};
+    // Share of face indices written relative to the end ("-3").
+    double negative_index_ratio{0.0};
+    // Share of face indices written as "v/vt/vn". Any non-zero share also
+    // writes one "vt" and one "vn" record per vertex.
+    double full_token_ratio{0.0};
+};
+
+// Fails with a message in `error` for empty meshes, invalid ratios or
+// polygon weights, or polygons with more sides than there are vertices.
+bool ValidateObjGenOptions(const ObjGenOptions& options, std::string& error);
+
+// Writes a deterministic mesh: the same options, seed included, always give
+// the same bytes. Vertices lie on a noisy sphere in spiral order and every
+// face uses a run of neighbouring vertices, so faces share edges and have
+// the index locality of a real mesh. Vertices are interleaved with the faces
+// so that relative indices only ever refer to vertices written before them.
+bool WriteGeneratedObj(std::FILE* file, const ObjGenOptions& options);
+bool WriteGeneratedObj(const std::string& path, const ObjGenOptions& options);
+
+}  // namespace viewer3d
+
+#endif